@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BlockTickScheduler.h"
+#include "Chunk.h"
+#include "ChunkGenerator.h"
+#include "TradecraftStats.h"
+#include "HAL/PlatformTime.h"
+
+using namespace VoxelCore;
+
+void FBlockTickScheduler::Initialize(int32 Seed, int32 InWidthOfChunk, int32 InHeightOfChunk, FGetBlock InGetBlock, FSetBlock InSetBlock)
+{
+	GetBlockFunction = InGetBlock;
+	SetBlockFunction = InSetBlock;
+	Scheduler.Initialize(*this, Seed, ChunkLayout(InWidthOfChunk, InHeightOfChunk));
+}
+
+void FBlockTickScheduler::AddChunk(int32 ChunkX, int32 ChunkY, const TArray<FChunk_Block_Properties>& ChunkData)
+{
+	Scheduler.AddChunk(ChunkX, ChunkY, FChunkGenerator::MakeBlockIdView(ChunkData));
+}
+
+void FBlockTickScheduler::RemoveChunk(int32 ChunkX, int32 ChunkY)
+{
+	Scheduler.RemoveChunk(ChunkX, ChunkY);
+}
+
+void FBlockTickScheduler::NotifyBlockChanged(const FIntVector& Block, int32 OldId, int32 NewId)
+{
+	Scheduler.NotifyBlockChanged({ Block.X, Block.Y, Block.Z }, OldId, NewId);
+}
+
+void FBlockTickScheduler::Update(float DeltaTime, double BudgetSeconds)
+{
+	const int64 TicksRunBefore = Scheduler.GetNumScheduledTicksRun() + Scheduler.GetNumRandomTicksRun();
+	Deadline = FPlatformTime::Seconds() + BudgetSeconds;
+	Scheduler.Update(DeltaTime);
+	TRADECRAFT_INC_COUNTER(BlockTicksRun, (int32)(Scheduler.GetNumScheduledTicksRun() + Scheduler.GetNumRandomTicksRun() - TicksRunBefore));
+}
+
+BlockId FBlockTickScheduler::GetBlock(const BlockPos& Block) const
+{
+	return GetBlockFunction(FIntVector(Block.X, Block.Y, Block.Z));
+}
+
+void FBlockTickScheduler::SetBlock(const BlockPos& Block, BlockId Id)
+{
+	SetBlockFunction(FIntVector(Block.X, Block.Y, Block.Z), Id);
+}
+
+bool FBlockTickScheduler::IsOutOfTime() const
+{
+	return FPlatformTime::Seconds() > Deadline;
+}
+
+FString FBlockTickScheduler::GetStatsString() const
+{
+	return FString::Printf(TEXT("Block ticks: game tick %lld, %d scheduled, %d of %d sections random tickable, %lld scheduled and %lld random ticks run, %lld updates over budget"),
+		(int64)Scheduler.GetCurrentTick(), Scheduler.GetNumScheduledTicks(), Scheduler.GetNumActiveSections(), Scheduler.GetNumSections(),
+		(int64)Scheduler.GetNumScheduledTicksRun(), (int64)Scheduler.GetNumRandomTicksRun(), (int64)Scheduler.GetNumOverBudgetUpdates());
+}
@@ -5,17 +5,11 @@
 #include "Math/UnrealMathUtility.h"
 #include "SimplexNoiseLibrary.h"
 #include "MinecraftWorld.h"
-
-
-const TArray<int32> bTriangles = { 2, 1, 0, 0, 3, 2 };
-const FVector NormalsUp[] = { FVector::UpVector, FVector::UpVector, FVector::UpVector, FVector::UpVector };
-const FVector NormalsDown[] = { -FVector::UpVector, -FVector::UpVector, -FVector::UpVector, -FVector::UpVector };
-const FVector NormalsForward[] = { FVector::ForwardVector, FVector::ForwardVector, FVector::ForwardVector, FVector::ForwardVector };
-const FVector NormalsBack[] = { -FVector::ForwardVector, -FVector::ForwardVector, -FVector::ForwardVector, -FVector::ForwardVector };
-const FVector NormalsRight[] = { FVector::RightVector, FVector::RightVector, FVector::RightVector, FVector::RightVector };
-const FVector NormalsLeft[] = { -FVector::RightVector, -FVector::RightVector, -FVector::RightVector, -FVector::RightVector };
-const FVector2D bUVs[] = { FVector2D(0., 0.), FVector2D(0., 1.), FVector2D(1., 1.), FVector2D(1., 0.) };
-const FVector bMask[] = { FVector(0., 0., 1.), FVector(0., 0., -1.), FVector(0., 1., 0.), FVector(0., -1., 0.), FVector(1., 0., 0.), FVector(-1., 0., 0) };
+#include "ChunkGenerator.h"
+#include "TradecraftStats.h"
+#include "DynamicMeshBuilder.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "HAL/PlatformTime.h"
 
 // Sets default values
 AChunk::AChunk()
@@ -49,7 +43,6 @@ void AChunk::OnConstruction(const FTransform & Transform)
 
 void AChunk::GenerateChunkInWorld()
 {
-	NoiseData = CalculateNoise();
 	GenerateData();
 	UpdateMesh();
 	ApplyMaterials();
@@ -80,6 +73,7 @@ void AChunk::SetLocation(FVector position, int32 seed)
 	SetActorLocation(position);
 	USimplexNoiseLibrary::setNoiseSeed(seed);
 	RandomStream.Initialize(seed);
+	Seed = seed;
 	FString NewName = AMinecraftWorld::BuildChunkName(FVector(position.X / 100, position.Y / 100, position.Z / 100));
 	Rename(*NewName);
 }
@@ -89,8 +83,16 @@ void AChunk::MakeOwner(AActor* Parent)
 	this->SetOwner(Parent);
 }
 
+void AChunk::SetCookCollisionAsync(bool Async)
+{
+	mesh->bUseAsyncCooking = Async;
+}
+
 void AChunk::ApplyMaterials()
 {
+	if (!bRenderMesh)
+		return;
+
 	int s = 0;
 	while (s < Materials.Num())
 	{
@@ -99,7 +101,7 @@ void AChunk::ApplyMaterials()
 	}
 }
 
-void AChunk::LoadChunkValues(TArray<int32> ids) 
+void AChunk::LoadChunkValues(const TArray<int32>& ids) 
 {
 	for (int32 i = 0; i < ChunkData.Num(); i++) 
 	{
@@ -114,282 +116,122 @@ void AChunk::LoadChunkValues(TArray<int32> ids)
 
 void AChunk::UpdateMesh()
 {
-	TArray<FMeshSection> MeshSections;
-	MeshSections.SetNum(Materials.Num());
-	int Triangle_Num = 0;
-	int TotalTriangles = 0;
-
-	for (int x = 0; x < WidthOfChunk; x++) {
-
-		for (int y = 0; y < WidthOfChunk; y++) {
-
-			for (int z = 0; z < HeightOfChunk; z++) {
+	TRADECRAFT_SCOPE_CYCLE(UpdateMesh);
+	MeshIsDirty = false;
 
+	// Blocks get their full health back whenever the chunk is rebuilt.
+	for (int x = 0; x < WidthOfChunk; x++)
+	{
+		for (int y = 0; y < WidthOfChunk; y++)
+		{
+			for (int z = 0; z < HeightOfChunk; z++)
+			{
 				int32 index = z + ((y + 1) * HeightOfChunk) + ((x + 1) * WidthOfChunkExt * HeightOfChunk);
-
-				if (index >= ChunkData.Num() || index < 0)
-				{
-					UE_LOG(LogTemp, Error, TEXT("Index out of bounds: %d. Chunk Size is: %d"), index, ChunkData.Num());
-					break;
-				}
-
 				int32 CurrentBlock = ChunkData[index].id;
-				int32 meshIndex = CurrentBlock;
-
-				if (meshIndex >= MeshSections.Num() || meshIndex < 0) 
-				{
-					UE_LOG(LogTemp, Warning, TEXT("There are no materials in Minecraft World."), meshIndex, MeshSections.Num());
-					break;
-				}
-
-				TArray<FVector> &Vertices = MeshSections[meshIndex].Vertices;
-				TArray<int32> &Triangles = MeshSections[meshIndex].Triangles;
-				TArray<FVector> &Normals = MeshSections[meshIndex].Normals;
-				TArray<FVector2D> &UVs = MeshSections[meshIndex].UVs;
-				TArray<FProcMeshTangent> &Tangents = MeshSections[meshIndex].Tangents;
-				TArray<FColor> &VertexColors = MeshSections[meshIndex].VertexColors;
-				int32 elementID = MeshSections[meshIndex].elem_id;
-
-				//All possible vertices
-				FVector p0 = FVector((x * 100) - 50.f, (y * 100) - 50.f, (z * 100) + 50.f);
-				FVector p1 = FVector((x * 100) + 50.f, (y * 100) - 50.f, (z * 100) + 50.f);
-				FVector p2 = FVector((x * 100) + 50.f, (y * 100) - 50.f, (z * 100) - 50.f);
-				FVector p3 = FVector((x * 100) - 50.f, (y * 100) - 50.f, (z * 100) - 50.f);
-				FVector p4 = FVector((x * 100) - 50.f, (y * 100) + 50.f, (z * 100) + 50.f);
-				FVector p5 = FVector((x * 100) + 50.f, (y * 100) + 50.f, (z * 100) + 50.f);
-				FVector p6 = FVector((x * 100) + 50.f, (y * 100) + 50.f, (z * 100) - 50.f);
-				FVector p7 = FVector((x * 100) - 50.f, (y * 100) + 50.f, (z * 100) - 50.f);
-
-				if(CurrentBlock >= 0 && CurrentBlock < Block_Health_Values.Num())
-					ChunkData[index].Current_Health = Block_Health_Values[CurrentBlock];
 
-				// Triangle Number helps us keep track of which triangle we are on
-				int Triangle_Num = 0;
-
-				if (CurrentBlock != 0)
-				{
-					for (int i = 0; i < 6; i++)
-					{
-						int newIndex = (z + bMask[i].Z) + ((y + bMask[i].Y + 1) * HeightOfChunk) + ((x + bMask[i].X + 1) * WidthOfChunkExt * HeightOfChunk);
-
-						bool flag = false;
-						if (newIndex < ChunkData.Num() && newIndex >= 0)
-							if (ChunkData[newIndex].id == 0 || ChunkData[newIndex].id == 5) flag = true;	// if see through or none
-
-						if (flag)
-						{
-							Triangles.Add(bTriangles[0] + Triangle_Num + elementID);
-							Triangles.Add(bTriangles[1] + Triangle_Num + elementID);
-							Triangles.Add(bTriangles[2] + Triangle_Num + elementID);
-							Triangles.Add(bTriangles[3] + Triangle_Num + elementID);
-							Triangles.Add(bTriangles[4] + Triangle_Num + elementID);
-							Triangles.Add(bTriangles[5] + Triangle_Num + elementID);
-							Triangle_Num += 4; // Increment the Triangle Number by four since we have just added four vertices, hence the triangles on this side
-
-							switch (i)
-							{
-							case 0: // Top Face of cube 
-							{
-								Vertices.Add(p4);
-								Vertices.Add(p0);
-								Vertices.Add(p1);
-								Vertices.Add(p5);
-
-								Normals.Append(NormalsUp, ARRAY_COUNT(NormalsUp));
-								break;
-							}
-							case 1: // Bottom Face of Cube
-							{
-								Vertices.Add(p2);
-								Vertices.Add(p3);
-								Vertices.Add(p7);
-								Vertices.Add(p6);
-
-								Normals.Append(NormalsDown, ARRAY_COUNT(NormalsDown));
-								break;
-							}
-							case 2: // Front Face of Cube, Forward
-							{
-								Vertices.Add(p5);
-								Vertices.Add(p6);
-								Vertices.Add(p7);
-								Vertices.Add(p4);
-
-								Normals.Append(NormalsForward, ARRAY_COUNT(NormalsForward));
-								break;
-							}
-							case 3: // Back Face of Cube
-							{
-								Vertices.Add(p0);
-								Vertices.Add(p3);
-								Vertices.Add(p2);
-								Vertices.Add(p1);
-
-								Normals.Append(NormalsBack, ARRAY_COUNT(NormalsBack));
-								break;
-							}
-							case 4:
-							{
-								Vertices.Add(p1);
-								Vertices.Add(p2);
-								Vertices.Add(p6);
-								Vertices.Add(p5);
-
-								Normals.Append(NormalsRight, ARRAY_COUNT(NormalsRight));
-								break;
-							}
-							case 5:
-							{
-								Vertices.Add(p4);
-								Vertices.Add(p7);
-								Vertices.Add(p3);
-								Vertices.Add(p0);
-
-								Normals.Append(NormalsLeft, ARRAY_COUNT(NormalsLeft));
-								break;
-							}
-							}
-							//Finish Switch Statement
-
-							//Add UVs
-							UVs.Append(bUVs, ARRAY_COUNT(bUVs));
-							FColor color = FColor(255, 255, 255, i);
-							VertexColors.Add(color); VertexColors.Add(color); VertexColors.Add(color); VertexColors.Add(color);
-						}
-					}
-					TotalTriangles += Triangle_Num;
-					MeshSections[meshIndex].elem_id += Triangle_Num;
-				}
+				if (CurrentBlock >= 0 && CurrentBlock < Block_Health_Values.Num())
+					ChunkData[index].Current_Health = Block_Health_Values[CurrentBlock];
 			}
 		}
 	}
 
-	mesh->ClearAllMeshSections();
-	for (int i = 0; i < MeshSections.Num(); i++)
+	if (!bRenderMesh)
 	{
-
-		if (MeshSections[i].Vertices.Num() > 0)
-		{
-			mesh->CreateMeshSection(i, MeshSections[i].Vertices, MeshSections[i].Triangles, MeshSections[i].Normals, MeshSections[i].UVs, MeshSections[i].VertexColors, MeshSections[i].Tangents, true);
-		}
+		UpdateCollisionOnly();
+		return;
 	}
-	ApplyMaterials();
-}
 
-void AChunk::GenerateData()
-{
-	for (int x = 0; x < WidthOfChunkExt; x++)
+	double StartTime = FPlatformTime::Seconds();
+	TArray<FMeshSection> MeshSections;
+	FChunkMesher::BuildMeshSections(ChunkData, WidthOfChunk, HeightOfChunk, Materials.Num(), MeshSections, &LightData);
+	if (Trace)
 	{
-		for (int y = 0; y < WidthOfChunkExt; y++)
-		{
-			for (int z = 0; z < HeightOfChunk; z++)
-			{
-				int32 index = z + (y * HeightOfChunk) + (x * WidthOfChunkExt * HeightOfChunk);
-				int32 noiseIndex = y + (x * WidthOfChunkExt);
-
-				if (index >= ChunkData.Num())
-				{
-					UE_LOG(LogTemp, Error, TEXT("Index out of bounds: %d. Chunk Size is: %d"), index, ChunkData.Num());
-					break;
-				}
-
-				if (noiseIndex >= NoiseData.Num())
-				{
-					UE_LOG(LogTemp, Error, TEXT("Index out of bounds: %d. Noise Size is: %d"), noiseIndex, NoiseData.Num());
-					break;
-				}
-
-				if (z == 30 + NoiseData[noiseIndex]) { ChunkData[index].id = 1; } // Grass Block
-				else if (z == 29 + NoiseData[noiseIndex]) { ChunkData[index].id = 2; } // Dirt Block
-				else if (z < 29 + NoiseData[noiseIndex]) { ChunkData[index].id = 3; } // Stone Block
-				else if (z < 15 + NoiseData[noiseIndex] && ChunkData[index].id == 0) { ChunkData[index].id = 7; }
-				else { ChunkData[index].id = 0; }
-			}
-		}
+		const FIntPoint Coordinates = GetChunkCoordinates();
+		Trace->RecordChunk(EStreamingTraceEvent::ChunkMeshed, Coordinates.X, Coordinates.Y, FPlatformTime::Seconds() - StartTime);
 	}
 
-	for (int x = 3; x < WidthOfChunk - 3; x++)
+	StartTime = FPlatformTime::Seconds();
+	int32 NumVertices = 0;
+	int32 NumTriangles = 0;
 	{
-		for (int y = 2; y < WidthOfChunk - 2; y++)
-		{
-			for (int z = 0; z < HeightOfChunk; z++)
-			{
-				int32 index = z + (y * HeightOfChunk) + (x * WidthOfChunkExt * HeightOfChunk);
+		// Collision is cooked inside CreateMeshSection when it isn't cooked in the background.
+		TRADECRAFT_SCOPE_CYCLE(CreateMeshSection);
+		TRADECRAFT_CONDITIONAL_SCOPE_CYCLE(CookCollisionSync, !mesh->bUseAsyncCooking);
 
-				if (y + (x * WidthOfChunkExt) >= NoiseData.Num() || y + (x * WidthOfChunkExt) < 0) 
-				{
-					UE_LOG(LogTemp, Warning, TEXT("ERROR: AT LINE 301"));
-					break;
-				}
+		mesh->ClearAllMeshSections();
+		for (int i = 0; i < MeshSections.Num(); i++)
+		{
 
-				if (z == 31 + NoiseData[y + (x * WidthOfChunkExt)] && RandomStream.FRand() < 0.03) { TreeCenters.Add(FIntVector(x, y, z)); } // Tree
+			if (MeshSections[i].Vertices.Num() > 0)
+			{
+				mesh->CreateMeshSection(i, MeshSections[i].Vertices, MeshSections[i].Triangles, MeshSections[i].Normals, MeshSections[i].UVs, MeshSections[i].VertexColors, MeshSections[i].Tangents, true);
+				NumVertices += MeshSections[i].Vertices.Num();
+				NumTriangles += MeshSections[i].Triangles.Num() / 3;
 			}
 		}
 	}
-
-	for (int i = 0; i < TreeCenters.Num(); i++)
+	if (Trace)
 	{
-		int height = (int)(RandomStream.FRand() * 4) + 4;
-		FIntVector pos = TreeCenters[i];
-
-		int rand_x = (int)(RandomStream.FRand() * 1) + 2;
-		int rand_y = (int)(RandomStream.FRand() * 1) + 2;
-		int rand_z = (int)(RandomStream.FRand() * 1) + 2;
-
-		float radius = FVector(rand_x, rand_y, rand_z).Size();
+		const FIntPoint Coordinates = GetChunkCoordinates();
+		Trace->RecordChunk(EStreamingTraceEvent::ChunkUploaded, Coordinates.X, Coordinates.Y, FPlatformTime::Seconds() - StartTime);
+	}
+	TRADECRAFT_INC_COUNTER(ChunksMeshed, 1);
+	TRADECRAFT_INC_COUNTER(VerticesEmitted, NumVertices);
+	TRADECRAFT_INC_COUNTER(TrianglesEmitted, NumTriangles);
+	ApplyMaterials();
+}
 
-		for (int x = pos.X - radius; x < pos.X + radius; x++)
-		{
-			for (int y = pos.Y - radius; y < pos.Y + radius; y++)
-			{
-				for (int z = pos.Z - radius; z < pos.Z + radius; z++)
-				{
-					int realPosZ = z + height - rand_z;
-
-					if (FVector::Dist(FVector(pos.X, pos.Y, pos.Z + height), FVector(x, y, realPosZ)) <= radius)
-					{
-						int32 index = (realPosZ)+((y + 1) * HeightOfChunk) + ((x + 1) * WidthOfChunkExt * HeightOfChunk);
-
-						if (RandomStream.FRand() < 0.8 && ChunkData[index].id == 0) // Only Add leaves if there is an empty block there
-							ChunkData[index].id = 5;
-					}
-				}
-			}
-		}
+void AChunk::UpdateCollisionOnly()
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	if (bWantsCollision)
+		FChunkMesher::BuildCollisionMesh(ChunkData, WidthOfChunk, HeightOfChunk, Vertices, Triangles);
 
-		if (height + pos.Z < HeightOfChunk - 1)
-		{
-			for (int j = 0; j < height; j++)
-			{
-				int32 index = (pos.Z + j) + (pos.Y * HeightOfChunk) + (pos.X * WidthOfChunkExt * HeightOfChunk);
-				ChunkData[index].id = 4;
-			}
-		}
+	TRADECRAFT_SCOPE_CYCLE(CreateMeshSection);
+	TRADECRAFT_CONDITIONAL_SCOPE_CYCLE(CookCollisionSync, !mesh->bUseAsyncCooking);
+	mesh->ClearAllMeshSections();
+	if (Vertices.Num() > 0)
+	{
+		mesh->CreateMeshSection(0, Vertices, Triangles, TArray<FVector>(), TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>(), true);
+		mesh->SetMeshSectionVisible(0, false);
 	}
 }
 
-TArray<int32> AChunk::CalculateNoise()
+void AChunk::SetWantsCollision(bool Wants)
 {
-	TArray<int32> noises;
-	noises.Init(0, WidthOfChunkExt * WidthOfChunkExt);
-
-	int32 ChunkXIndex = (int)(GetActorLocation().X / 100);
-	int32 ChunkYIndex = (int)(GetActorLocation().Y / 100);
-	for (int32 x = -1; x <= WidthOfChunk; x++)
+	if (bWantsCollision != Wants)
 	{
-		for (int32 y = -1; y <= WidthOfChunk; y++)
-		{
-			float noiseValue =
-				USimplexNoiseLibrary::SimplexNoise2D((ChunkXIndex + x) * 0.01f, (ChunkYIndex + y + 1) * 0.01f) * 4 +
-				USimplexNoiseLibrary::SimplexNoise2D((ChunkXIndex + x) * 0.01f, (ChunkYIndex + y + 1) * 0.01f) * 8 +
-				USimplexNoiseLibrary::SimplexNoise2D((ChunkXIndex + x) * 0.01f, (ChunkYIndex + y + 1) * 0.01f) * 16 +
-				FMath::Clamp(USimplexNoiseLibrary::SimplexNoise2D((ChunkXIndex + x) * 0.05f, (ChunkYIndex + y + 1) * 0.05f), 0.0f, 5.0f) * 4; // clamp 0-5
-
-			if ((y + 1) + ((x + 1) * WidthOfChunkExt) < noises.Num())
-				noises[(y + 1) + ((x + 1) * WidthOfChunkExt)] = (FMath::FloorToInt(noiseValue));
-		}
+		bWantsCollision = Wants;
+		MeshIsDirty = true;
 	}
-	return noises;
+}
+
+FIntPoint AChunk::GetChunkCoordinates() const
+{
+	return FIntPoint((int)(GetActorLocation().X / 100) / WidthOfChunk, (int)(GetActorLocation().Y / 100) / WidthOfChunk);
+}
+
+void AChunk::GenerateData()
+{
+	TRADECRAFT_SCOPE_CYCLE(GenerateData);
+
+	FChunkGenerator Generator(Seed, WidthOfChunk, HeightOfChunk);
+	Generator.TerrainVersion = TerrainVersion;
+	Generator.Biomes = Biomes;
+	Generator.HeightTiles = HeightTiles;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FIntPoint Coordinates = GetChunkCoordinates();
+	FChunkGenerationTimings Timings;
+	Generator.Generate(Coordinates.X, Coordinates.Y, ChunkData, &Timings);
+	if (Trace)
+		Trace->RecordChunk(EStreamingTraceEvent::ChunkGenerated, Coordinates.X, Coordinates.Y, FPlatformTime::Seconds() - StartTime);
+
+	TRADECRAFT_INC_SECONDS(GenerateNoise, Timings.NoiseSeconds);
+	TRADECRAFT_INC_SECONDS(GenerateFill, Timings.FillSeconds);
+	TRADECRAFT_INC_SECONDS(GenerateTrees, Timings.TreeSeconds);
+	TRADECRAFT_INC_COUNTER(ChunksGenerated, 1);
 }
 
 int32 AChunk::DealDamage(int32 x, int32 y, int32 z, int32 damage) 
@@ -413,6 +255,7 @@ int32 AChunk::BreakBlock(int32 x, int32 y, int32 z)
 	{
 		tmp = ChunkData[index].id;
 		ChunkData[index].id = 0;
+		NeedsSaving = true;
 		UpdateMesh();
 	}
 	return tmp;
@@ -425,10 +268,73 @@ void AChunk::AddBlock(int32 x, int32 y, int32 z, int32 id)
 	if (index < ChunkData.Num() && index >= 0)
 	{
 		ChunkData[index].id = id;
+		NeedsSaving = true;
 		UpdateMesh();
 	}
 }
 
+void AChunk::ApplyBlockEdits(const TArray<FBlockEditRecord>& Edits)
+{
+	for (const FBlockEditRecord& Edit : Edits)
+	{
+		int32 index = Edit.BlockZ + (Edit.BlockY * HeightOfChunk) + (Edit.BlockX * HeightOfChunk * WidthOfChunkExt);
+
+		if (index < ChunkData.Num() && index >= 0)
+			ChunkData[index].id = Edit.Id;
+	}
+	NeedsSaving = true;
+	MeshIsDirty = true;
+}
+
+void AChunk::SetBlockDeferred(int32 x, int32 y, int32 z, int32 id)
+{
+	int32 index = z + (y * HeightOfChunk) + (x * HeightOfChunk * WidthOfChunkExt);
+
+	if (index < ChunkData.Num() && index >= 0 && ChunkData[index].id != id)
+	{
+		ChunkData[index].id = id;
+		NeedsSaving = true;
+		MeshIsDirty = true;
+	}
+}
+
+void AChunk::UpdateMeshIfDirty()
+{
+	if (MeshIsDirty)
+		UpdateMesh();
+}
+
+void AChunk::ComputeLight()
+{
+	if (!LightProperties)
+		return;
+
+	TRADECRAFT_SCOPE_CYCLE(ComputeLight);
+	LightData.SetNumUninitialized(ChunkData.Num());
+	VoxelCore::LightEngine Engine(*LightProperties);
+	Engine.ComputeChunk(FChunkGenerator::MakeBlockIdView(ChunkData), VoxelCore::ChunkLayout(WidthOfChunk, HeightOfChunk), LightData.GetData());
+}
+
+void AChunk::GetMemoryUsage(FChunkMemoryUsage& OutUsage) const
+{
+	OutUsage[EChunkMemoryTag::BlockData] += ChunkData.GetAllocatedSize() + LightData.GetAllocatedSize() + Block_Health_Values.GetAllocatedSize();
+	if (!mesh)
+		return;
+
+	for (int32 i = 0; i < mesh->GetNumSections(); i++)
+	{
+		const FProcMeshSection* Section = mesh->GetProcMeshSection(i);
+		if (!Section)
+			continue;
+
+		OutUsage[EChunkMemoryTag::MeshSections] += Section->ProcVertexBuffer.GetAllocatedSize() + Section->ProcIndexBuffer.GetAllocatedSize();
+		OutUsage[EChunkMemoryTag::RenderData] += Section->ProcVertexBuffer.Num() * sizeof(FDynamicMeshVertex) + Section->ProcIndexBuffer.Num() * sizeof(int32);
+	}
+
+	if (UBodySetup* BodySetup = mesh->GetBodySetup())
+		OutUsage[EChunkMemoryTag::Collision] += BodySetup->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
 int32 AChunk::GetBlockId(int32 id) 
 {
 	if (id >= 0 && id < ChunkData.Num())
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkCache.h"
+
+void FChunkCache::SetBudget(int64 InMaxBytes, int32 InMaxEntries)
+{
+	MaxBytes = FMath::Max<int64>(InMaxBytes, 0);
+	MaxEntries = FMath::Max(InMaxEntries, 0);
+	EvictToBudget();
+}
+
+int64 FChunkCache::GetEntrySize(const FString& ChunkName, const FEntry& Entry)
+{
+	return Entry.Data.GetAllocatedSize() + ChunkName.GetAllocatedSize() + sizeof(FEntry) + sizeof(TDoubleLinkedList<FString>::TDoubleLinkedListNode);
+}
+
+void FChunkCache::Add(const FString& ChunkName, TArray<uint8>&& EncodedData, bool bDirty)
+{
+	if (FEntry* Existing = Entries.Find(ChunkName))
+	{
+		BytesInUse -= GetEntrySize(ChunkName, *Existing);
+		Lru.RemoveNode(Existing->Node);
+		Entries.Remove(ChunkName);
+	}
+
+	FEntry& Entry = Entries.Add(ChunkName);
+	Entry.Data = MoveTemp(EncodedData);
+	Entry.Data.Shrink();
+	Entry.bDirty = bDirty;
+	Lru.AddHead(ChunkName);
+	Entry.Node = Lru.GetHead();
+	BytesInUse += GetEntrySize(ChunkName, Entry);
+
+	EvictToBudget();
+}
+
+bool FChunkCache::Take(const FString& ChunkName, TArray<uint8>& OutEncodedData, bool& bOutDirty)
+{
+	FEntry* Entry = Entries.Find(ChunkName);
+	if (!Entry)
+	{
+		Misses++;
+		return false;
+	}
+
+	Hits++;
+	BytesInUse -= GetEntrySize(ChunkName, *Entry);
+	OutEncodedData = MoveTemp(Entry->Data);
+	bOutDirty = Entry->bDirty;
+	Lru.RemoveNode(Entry->Node);
+	Entries.Remove(ChunkName);
+	return true;
+}
+
+void FChunkCache::Flush()
+{
+	for (auto& Elem : Entries)
+	{
+		if (Elem.Value.bDirty)
+			Write(Elem.Key, Elem.Value);
+	}
+}
+
+bool FChunkCache::FlushEntry(const FString& ChunkName)
+{
+	FEntry* Entry = Entries.Find(ChunkName);
+	if (!Entry || !Entry->bDirty)
+		return true;
+	return Write(ChunkName, *Entry);
+}
+
+void FChunkCache::Empty()
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (It.Value().bDirty && !Write(It.Key(), It.Value()))
+			continue;
+
+		BytesInUse -= GetEntrySize(It.Key(), It.Value());
+		Lru.RemoveNode(It.Value().Node);
+		It.RemoveCurrent();
+	}
+}
+
+void FChunkCache::Trim(int64 TargetBytes)
+{
+	while (Entries.Num() > 0 && BytesInUse > TargetBytes && EvictOldest())
+	{
+	}
+}
+
+void FChunkCache::EvictToBudget()
+{
+	while (Entries.Num() > 0 && (BytesInUse > MaxBytes || Entries.Num() > MaxEntries) && EvictOldest())
+	{
+	}
+}
+
+bool FChunkCache::EvictOldest()
+{
+	FLruNode* Oldest = Lru.GetTail();
+	FString ChunkName = Oldest->GetValue();
+	FEntry& Entry = Entries.FindChecked(ChunkName);
+
+	// The edits in a dirty entry only exist here, so it stays until a write succeeds.
+	if (Entry.bDirty && !Write(ChunkName, Entry))
+	{
+		WriteFailures++;
+		return false;
+	}
+
+	BytesInUse -= GetEntrySize(ChunkName, Entry);
+	Lru.RemoveNode(Oldest);
+	Entries.Remove(ChunkName);
+	Evictions++;
+	return true;
+}
+
+bool FChunkCache::Write(const FString& ChunkName, FEntry& Entry)
+{
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Chunk cache has no writer, %s is lost."), *ChunkName);
+		return false;
+	}
+
+	if (!Writer(ChunkName, Entry.Data))
+		return false;
+
+	Entry.bDirty = false;
+	Writes++;
+	return true;
+}
+
+FString FChunkCache::GetStatsString() const
+{
+	const int32 Lookups = Hits + Misses;
+	return FString::Printf(TEXT("Chunk cache: %d entries, %.2f / %.2f MB, %d hits, %d misses (%.1f%% hit rate), %d evictions, %d disk writes, %d failed"),
+		Entries.Num(), BytesInUse / (1024.0 * 1024.0), MaxBytes / (1024.0 * 1024.0),
+		Hits, Misses, Lookups > 0 ? 100.0 * Hits / Lookups : 0.0, Evictions, Writes, WriteFailures);
+}
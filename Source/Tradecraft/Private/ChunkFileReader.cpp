@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkFileReader.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/FileHelper.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+// IPlatformFile::OpenMapped was added in 4.20.
+#define TC_MAPPED_FILES (ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 20)
+
+#if TC_MAPPED_FILES
+#include "GenericPlatform/GenericPlatformFile.h"
+#endif
+
+static TAutoConsoleVariable<int32> CVarChunkFileUseMapping(
+	TEXT("Tradecraft.ChunkFile.UseMapping"),
+	1,
+	TEXT("Memory map saved chunk files when loading them. 0 always reads them into a buffer."));
+
+static FThreadSafeCounter GMappedOpens;
+static FThreadSafeCounter GBufferedOpens;
+
+FChunkFileReader::FChunkFileReader()
+{
+}
+
+FChunkFileReader::~FChunkFileReader()
+{
+	Close();
+}
+
+bool FChunkFileReader::Open(const FString& FullFilePath)
+{
+	Close();
+
+	if (CVarChunkFileUseMapping.GetValueOnAnyThread() != 0 && OpenMapped(FullFilePath))
+	{
+		GMappedOpens.Increment();
+		return true;
+	}
+
+	if (!FFileHelper::LoadFileToArray(Buffer, *FullFilePath))
+		return false;
+
+	Data = Buffer.GetData();
+	Size = Buffer.Num();
+	GBufferedOpens.Increment();
+	return true;
+}
+
+bool FChunkFileReader::OpenMapped(const FString& FullFilePath)
+{
+#if TC_MAPPED_FILES
+	// Returns null on platforms that can't map files, or for files that can't be mapped.
+	MappedHandle = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FullFilePath);
+	if (!MappedHandle)
+		return false;
+
+	const int64 FileSize = MappedHandle->GetFileSize();
+	if (FileSize <= 0 || FileSize > MAX_int32)
+	{
+		Close();
+		return false;
+	}
+
+	MappedRegion = MappedHandle->MapRegion(0, FileSize);
+	if (!MappedRegion)
+	{
+		Close();
+		return false;
+	}
+
+	Data = MappedRegion->GetMappedPtr();
+	Size = (int32)MappedRegion->GetMappedSize();
+	bMapped = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FChunkFileReader::Close()
+{
+#if TC_MAPPED_FILES
+	// The region has to be released before the handle that created it.
+	delete MappedRegion;
+	delete MappedHandle;
+#endif
+	MappedRegion = nullptr;
+	MappedHandle = nullptr;
+
+	// Keep the buffer's allocation around for the next Open.
+	Buffer.Reset();
+	Data = nullptr;
+	Size = 0;
+	bMapped = false;
+}
+
+int32 FChunkFileReader::GetMappedOpenCount()
+{
+	return GMappedOpens.GetValue();
+}
+
+int32 FChunkFileReader::GetBufferedOpenCount()
+{
+	return GBufferedOpens.GetValue();
+}
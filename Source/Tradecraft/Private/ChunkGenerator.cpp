@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkGenerator.h"
+#include "Chunk.h"
+#include "SimplexNoiseLibrary.h"
+
+// The core addresses ids in place, one every two int32s.
+static_assert(sizeof(FChunk_Block_Properties) == 2 * sizeof(int32), "FChunk_Block_Properties layout changed; update MakeBlockIdView.");
+
+FChunkGenerator::FChunkGenerator(int32 InSeed, int32 InWidthOfChunk, int32 InHeightOfChunk)
+	: VoxelCore::ChunkGenerator(InSeed, InWidthOfChunk, InHeightOfChunk)
+{
+}
+
+void FChunkGenerator::PrepareNoise(int32 Seed)
+{
+	check(IsInGameThread());
+	USimplexNoiseLibrary::setNoiseSeed(Seed);
+}
+
+void FChunkGenerator::Generate(int32 ChunkX, int32 ChunkY, TArray<FChunk_Block_Properties>& OutChunkData, FChunkGenerationTimings* Timings) const
+{
+	OutChunkData.Init(FChunk_Block_Properties(), GetNumBlocks());
+	VoxelCore::ChunkGenerator::Generate(ChunkX, ChunkY, MakeBlockIdView(OutChunkData), Timings);
+}
+
+VoxelCore::BlockIdView FChunkGenerator::MakeBlockIdView(TArray<FChunk_Block_Properties>& ChunkData)
+{
+	return ChunkData.Num() > 0 ? VoxelCore::BlockIdView(&ChunkData[0].id, ChunkData.Num(), 2) : VoxelCore::BlockIdView();
+}
+
+VoxelCore::ConstBlockIdView FChunkGenerator::MakeBlockIdView(const TArray<FChunk_Block_Properties>& ChunkData)
+{
+	return ChunkData.Num() > 0 ? VoxelCore::ConstBlockIdView(&ChunkData[0].id, ChunkData.Num(), 2) : VoxelCore::ConstBlockIdView();
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkMemory.h"
+
+void FChunkMemoryUsage::Add(const FChunkMemoryUsage& Other)
+{
+	for (int32 i = 0; i < (int32)EChunkMemoryTag::Num; i++)
+		Bytes[i] += Other.Bytes[i];
+}
+
+int64 FChunkMemoryUsage::GetTotal() const
+{
+	int64 Total = 0;
+	for (int64 Value : Bytes)
+		Total += Value;
+	return Total;
+}
+
+const TCHAR* FChunkMemoryUsage::GetTagName(EChunkMemoryTag Tag)
+{
+	switch (Tag)
+	{
+	case EChunkMemoryTag::BlockData: return TEXT("Block data");
+	case EChunkMemoryTag::MeshSections: return TEXT("Mesh sections");
+	case EChunkMemoryTag::RenderData: return TEXT("Render data (est.)");
+	case EChunkMemoryTag::Collision: return TEXT("Collision");
+	case EChunkMemoryTag::ChunkCache: return TEXT("Chunk cache");
+	case EChunkMemoryTag::HeightTiles: return TEXT("Height tiles");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkMesher.h"
+#include "Chunk.h"
+#include "ChunkGenerator.h"
+#include "TradecraftStats.h"
+#include "VoxelCore/ChunkMesher.h"
+
+void FChunkMesher::BuildMeshSections(const TArray<FChunk_Block_Properties>& ChunkData, int32 WidthOfChunk, int32 HeightOfChunk, int32 NumSections, TArray<FMeshSection>& OutSections, const TArray<uint8>* Light)
+{
+	TRADECRAFT_SCOPE_CYCLE(BuildMeshSections);
+
+	static thread_local std::vector<VoxelCore::MeshSection> CoreSections;
+	const uint8* LightData = Light && Light->Num() == ChunkData.Num() ? Light->GetData() : nullptr;
+	if (!VoxelCore::ChunkMesher::BuildMeshSections(FChunkGenerator::MakeBlockIdView(ChunkData), WidthOfChunk, HeightOfChunk, NumSections, CoreSections, LightData))
+		UE_LOG(LogTemp, Warning, TEXT("Chunk has blocks without a material section (%d materials in Minecraft World) or is smaller than %dx%d; those were skipped."), NumSections, WidthOfChunk, HeightOfChunk);
+
+	OutSections.Reset();
+	OutSections.SetNum(NumSections);
+	for (int32 s = 0; s < NumSections; s++)
+	{
+		const VoxelCore::MeshSection& Source = CoreSections[s];
+		FMeshSection& Section = OutSections[s];
+		const int32 NumVertices = (int32)Source.Vertices.size();
+
+		Section.Vertices.Reserve(NumVertices);
+		Section.Normals.Reserve(NumVertices);
+		Section.UVs.Reserve(NumVertices);
+		Section.VertexColors.Reserve(NumVertices);
+		for (int32 v = 0; v < NumVertices; v++)
+		{
+			Section.Vertices.Add(FVector(Source.Vertices[v].X, Source.Vertices[v].Y, Source.Vertices[v].Z));
+			Section.Normals.Add(FVector(Source.Normals[v].X, Source.Normals[v].Y, Source.Normals[v].Z));
+			Section.UVs.Add(FVector2D(Source.UVs[v].X, Source.UVs[v].Y));
+			Section.VertexColors.Add(FColor(Source.VertexColors[v].R, Source.VertexColors[v].G, Source.VertexColors[v].B, Source.VertexColors[v].A));
+		}
+		Section.Triangles.Append(Source.Triangles.data(), (int32)Source.Triangles.size());
+		Section.elem_id = Source.ElementId;
+	}
+}
+
+void FChunkMesher::BuildCollisionMesh(const TArray<FChunk_Block_Properties>& ChunkData, int32 WidthOfChunk, int32 HeightOfChunk, TArray<FVector>& OutVertices, TArray<int32>& OutTriangles)
+{
+	TRADECRAFT_SCOPE_CYCLE(BuildMeshSections);
+
+	static thread_local std::vector<VoxelCore::Vec3> CoreVertices;
+	static thread_local std::vector<int32_t> CoreTriangles;
+	VoxelCore::ChunkMesher::BuildCollisionMesh(FChunkGenerator::MakeBlockIdView(ChunkData), WidthOfChunk, HeightOfChunk, CoreVertices, CoreTriangles);
+
+	OutVertices.Reset(CoreVertices.size());
+	for (const VoxelCore::Vec3& Vertex : CoreVertices)
+		OutVertices.Add(FVector(Vertex.X, Vertex.Y, Vertex.Z));
+	OutTriangles.Reset(CoreTriangles.size());
+	OutTriangles.Append(CoreTriangles.data(), (int32)CoreTriangles.size());
+}
+
+bool FChunkMesher::ValidateMeshSections(const TArray<FMeshSection>& Sections, const FString& Context)
+{
+	for (int32 i = 0; i < Sections.Num(); i++)
+	{
+		const FMeshSection& Section = Sections[i];
+		const int32 NumVertices = Section.Vertices.Num();
+
+		if (Section.Normals.Num() != NumVertices || Section.UVs.Num() != NumVertices || Section.VertexColors.Num() != NumVertices)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: section %d has %d vertices but %d normals, %d UVs and %d colors."),
+				*Context, i, NumVertices, Section.Normals.Num(), Section.UVs.Num(), Section.VertexColors.Num());
+			return false;
+		}
+
+		if (Section.Triangles.Num() % 3 != 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: section %d has %d triangle indices, not a multiple of 3."), *Context, i, Section.Triangles.Num());
+			return false;
+		}
+
+		for (int32 Index : Section.Triangles)
+		{
+			if (Index < 0 || Index >= NumVertices)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s: section %d references vertex %d of %d."), *Context, i, Index, NumVertices);
+				return false;
+			}
+		}
+	}
+	return true;
+}
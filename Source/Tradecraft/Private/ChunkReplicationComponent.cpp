@@ -0,0 +1,333 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkReplicationComponent.h"
+#include "MinecraftWorld.h"
+#include "ChunkCodec.h"
+#include "TradecraftStats.h"
+#include "EngineUtils.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/UObjectIterator.h"
+#include "VoxelCore/RunLength.h"
+
+using namespace VoxelCore::RunLength;
+
+UChunkReplicationComponent::UChunkReplicationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	bReplicates = true;
+}
+
+void UChunkReplicationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	WindowStart = FPlatformTime::Seconds();
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (World)
+			BlockChangedHandle = World->OnBlockChanged.AddUObject(this, &UChunkReplicationComponent::OnBlockChanged);
+		return;
+	}
+
+	for (TActorIterator<AMinecraftWorld> It(GetWorld()); It; ++It)
+	{
+		World = *It;
+		break;
+	}
+	if (!World)
+		UE_LOG(LogTemp, Warning, TEXT("No Minecraft World to receive chunks into."));
+	ServerReady();
+}
+
+void UChunkReplicationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (World)
+		World->OnBlockChanged.Remove(BlockChangedHandle);
+	Super::EndPlay(EndPlayReason);
+}
+
+void UChunkReplicationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - WindowStart >= 1.0)
+	{
+		BytesPerSecond = (float)(WindowBytes / (Now - WindowStart));
+		WindowBytes = 0;
+		WindowStart = Now;
+	}
+
+	if (GetOwnerRole() != ROLE_Authority || !bClientReady || !World)
+		return;
+
+	const APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	if (Pawn)
+	{
+		const FIntPoint Center = World->GetChunkCoordinatesAt(Pawn->GetActorLocation());
+		if (Center != LastCenter)
+			UpdateInterest(Center);
+	}
+
+	// Edits only ever refer to chunks the client already has, so they can go first.
+	SendEdits();
+	SendSnapshots(DeltaTime);
+}
+
+void UChunkReplicationComponent::UpdateInterest(const FIntPoint& Center)
+{
+	LastCenter = Center;
+	const int32 Range = World->ReplicationRange;
+
+	// One chunk of slack, so walking along a chunk border doesn't resend the same chunks.
+	TArray<FIntPoint> ChunksToForget;
+	for (const FIntPoint& Chunk : ClientChunks)
+	{
+		if (FMath::Max(FMath::Abs(Chunk.X - Center.X), FMath::Abs(Chunk.Y - Center.Y)) > Range + 1)
+			ChunksToForget.Add(Chunk);
+	}
+	if (ChunksToForget.Num() > 0)
+	{
+		for (const FIntPoint& Chunk : ChunksToForget)
+			ClientChunks.Remove(Chunk);
+		ClientForgetChunks(ChunksToForget);
+		CountBytes(ChunksToForget.Num() * sizeof(FIntPoint));
+	}
+
+	WantedChunks.Reset();
+	for (int32 x = -Range; x <= Range; x++)
+	{
+		for (int32 y = -Range; y <= Range; y++)
+		{
+			if (x * x + y * y <= Range * Range)
+				WantedChunks.Add(FIntPoint(Center.X + x, Center.Y + y));
+		}
+	}
+	WantedChunks.Sort([Center](const FIntPoint& A, const FIntPoint& B) { return (A - Center).SizeSquared() < (B - Center).SizeSquared(); });
+	World->RequestChunks(WantedChunks);
+}
+
+void UChunkReplicationComponent::SendSnapshots(float DeltaTime)
+{
+	const float Budget = (float)World->ReplicationBytesPerSecond;
+	ByteAllowance = FMath::Min(ByteAllowance + Budget * DeltaTime, Budget);
+
+	UNetConnection* Connection = GetOwner()->GetNetConnection();
+	int32 Sent = 0;
+	for (const FIntPoint& Chunk : WantedChunks)
+	{
+		// Past the budget or with the connection saturated the rest waits, rather than piling
+		// up in the reliable buffer.
+		if (ByteAllowance <= 0.0f || Sent >= World->MaxSnapshotsPerTick || (Connection && !Connection->IsNetReady(false)))
+			break;
+		if (ClientChunks.Contains(Chunk))
+			continue;
+
+		// Not built on the server yet.
+		AChunk* Found = World->FindChunk(Chunk);
+		if (!Found)
+			continue;
+
+		TArray<uint8> Data;
+		if (!FChunkCodec::EncodeChunk(Found->ChunkData, Data))
+			continue;
+
+		ClientReceiveChunk(Chunk.X, Chunk.Y, Data);
+		ClientChunks.Add(Chunk);
+		ByteAllowance -= Data.Num();
+		SnapshotsSent++;
+		SnapshotBytes += Data.Num();
+		CountBytes(Data.Num());
+		Sent++;
+	}
+}
+
+void UChunkReplicationComponent::OnBlockChanged(const FIntVector& Block, int32 Id)
+{
+	if (!bClientReady || !World)
+		return;
+
+	// The neighbours of a border block keep a copy of it as well.
+	const FIntPoint Chunk = World->GetChunkOfBlock(Block);
+	if (ClientChunks.Contains(Chunk) || ClientChunks.Contains(Chunk + FIntPoint(1, 0)) || ClientChunks.Contains(Chunk - FIntPoint(1, 0))
+		|| ClientChunks.Contains(Chunk + FIntPoint(0, 1)) || ClientChunks.Contains(Chunk - FIntPoint(0, 1)))
+	{
+		FBlockEdit& Edit = PendingEdits[PendingEdits.AddDefaulted()];
+		Edit.Block = Block;
+		Edit.Id = Id;
+	}
+}
+
+void UChunkReplicationComponent::SendEdits()
+{
+	if (PendingEdits.Num() == 0)
+		return;
+
+	TArray<uint8> Data;
+	PackEdits(PendingEdits, Data);
+	ClientReceiveBlockEdits(Data);
+	EditsSent += PendingEdits.Num();
+	EditBytes += Data.Num();
+	CountBytes(Data.Num());
+	PendingEdits.Reset();
+}
+
+void UChunkReplicationComponent::CountBytes(int32 Bytes)
+{
+	WindowBytes += Bytes;
+	TRADECRAFT_INC_COUNTER(BytesReplicated, Bytes);
+}
+
+void UChunkReplicationComponent::PackEdits(const TArray<FBlockEdit>& Edits, TArray<uint8>& OutData)
+{
+	auto PutByte = [&OutData](uint8 Byte) { OutData.Add(Byte); };
+	FIntVector Previous = FIntVector::ZeroValue;
+	for (const FBlockEdit& Edit : Edits)
+	{
+		WriteVarUInt(PutByte, ZigZag(Edit.Block.X - Previous.X));
+		WriteVarUInt(PutByte, ZigZag(Edit.Block.Y - Previous.Y));
+		WriteVarUInt(PutByte, ZigZag(Edit.Block.Z));
+		WriteVarUInt(PutByte, ZigZag(Edit.Id));
+		Previous = Edit.Block;
+	}
+}
+
+bool UChunkReplicationComponent::UnpackEdits(const TArray<uint8>& Data, TArray<FBlockEdit>& OutEdits)
+{
+	const uint8* Cursor = Data.GetData();
+	const uint8* End = Cursor + Data.Num();
+	FIntVector Previous = FIntVector::ZeroValue;
+	while (Cursor < End)
+	{
+		uint32 X, Y, Z, Id;
+		if (!ReadVarUInt(Cursor, End, X) || !ReadVarUInt(Cursor, End, Y) || !ReadVarUInt(Cursor, End, Z) || !ReadVarUInt(Cursor, End, Id))
+			return false;
+
+		FBlockEdit& Edit = OutEdits[OutEdits.AddDefaulted()];
+		Edit.Block = FIntVector(Previous.X + UnZigZag(X), Previous.Y + UnZigZag(Y), UnZigZag(Z));
+		Edit.Id = UnZigZag(Id);
+		Previous = Edit.Block;
+	}
+	return true;
+}
+
+bool UChunkReplicationComponent::ServerReady_Validate()
+{
+	return true;
+}
+
+void UChunkReplicationComponent::ServerReady_Implementation()
+{
+	bClientReady = true;
+}
+
+bool UChunkReplicationComponent::ServerEditBlock_Validate(FIntVector Block, int32 Id, int32 Sequence)
+{
+	// No client of ours asks for these.
+	return Id >= 0 && Block.Z >= 0 && Block.Z < GetDefault<AChunk>()->HeightOfChunk;
+}
+
+void UChunkReplicationComponent::ServerEditBlock_Implementation(FIntVector Block, int32 Id, int32 Sequence)
+{
+	// Only breaks and blocks players can place, e.g. not fluid sources, in chunks the client can
+	// actually see.
+	if (!World || (Id != 0 && !World->IsPlaceableBlockId(Id)) || !ClientChunks.Contains(World->GetChunkOfBlock(Block)))
+	{
+		ClientEditResult(Sequence, false, 0);
+		return;
+	}
+
+	// And within reach of its pawn, with some slack for the pawn having moved on since.
+	const APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	const FVector BlockCenter(Block.X * 100.0f, Block.Y * 100.0f, (Block.Z - GetDefault<AChunk>()->HeightOfChunk / 2) * 100.0f);
+	const int32 OldId = World->GetBlockAt(Block);
+	if (!Pawn || FVector::Dist(Pawn->GetActorLocation(), BlockCenter) > World->MaxClientEditReach || OldId == Id)
+	{
+		ClientEditResult(Sequence, false, 0);
+		return;
+	}
+
+	World->ApplyBlockEdit(Block, Id);
+	ClientEditResult(Sequence, true, OldId);
+}
+
+void UChunkReplicationComponent::ClientEditResult_Implementation(int32 Sequence, bool bAccepted, int32 OldId)
+{
+	if (World)
+		World->OnEditResult(Sequence, bAccepted, OldId);
+}
+
+void UChunkReplicationComponent::ClientReceiveChunk_Implementation(int32 ChunkX, int32 ChunkY, const TArray<uint8>& Data)
+{
+	SnapshotsSent++;
+	SnapshotBytes += Data.Num();
+	CountBytes(Data.Num());
+	ClientChunks.Add(FIntPoint(ChunkX, ChunkY));
+	if (World)
+		World->ReceiveChunk(FIntPoint(ChunkX, ChunkY), Data);
+}
+
+void UChunkReplicationComponent::ClientForgetChunks_Implementation(const TArray<FIntPoint>& ChunksToForget)
+{
+	CountBytes(ChunksToForget.Num() * sizeof(FIntPoint));
+	for (const FIntPoint& Chunk : ChunksToForget)
+	{
+		ClientChunks.Remove(Chunk);
+		if (World)
+			World->ForgetReceivedChunk(Chunk);
+	}
+}
+
+void UChunkReplicationComponent::ClientReceiveBlockEdits_Implementation(const TArray<uint8>& PackedEdits)
+{
+	TArray<FBlockEdit> Edits;
+	if (!UnpackEdits(PackedEdits, Edits))
+		UE_LOG(LogTemp, Warning, TEXT("Received %d bytes of block edits that did not unpack; applying the %d complete ones."), PackedEdits.Num(), Edits.Num());
+
+	EditsSent += Edits.Num();
+	EditBytes += PackedEdits.Num();
+	CountBytes(PackedEdits.Num());
+	for (const FBlockEdit& Edit : Edits)
+	{
+		if (World)
+			World->ApplyReplicatedEdit(Edit.Block, Edit.Id);
+	}
+}
+
+FString UChunkReplicationComponent::GetStatsString() const
+{
+	FString Stats = FString::Printf(TEXT("%s: %s %d snapshots (%.1f KB, %.1f KB avg), %d edits (%.1f KB), %.1f KB/s, %d chunks on the client"),
+		*GetNameSafe(GetOwner()), GetOwnerRole() == ROLE_Authority ? TEXT("sent") : TEXT("received"),
+		SnapshotsSent, SnapshotBytes / 1024.0, SnapshotsSent > 0 ? SnapshotBytes / 1024.0 / SnapshotsSent : 0.0,
+		EditsSent, EditBytes / 1024.0, BytesPerSecond / 1024.0f, ClientChunks.Num());
+
+	if (const UNetConnection* Connection = GetOwner() ? GetOwner()->GetNetConnection() : nullptr)
+		Stats += FString::Printf(TEXT("; connection %.1f KB/s out, %.1f KB/s in"), Connection->OutBytesPerSecond / 1024.0f, Connection->InBytesPerSecond / 1024.0f);
+	return Stats;
+}
+
+static void PrintReplicationStats(UWorld* World)
+{
+	int32 NumClients = 0;
+	int64 TotalBytes = 0;
+	for (TObjectIterator<UChunkReplicationComponent> It; It; ++It)
+	{
+		if (It->GetWorld() != World || It->HasAnyFlags(RF_ClassDefaultObject))
+			continue;
+		UE_LOG(LogTemp, Log, TEXT("%s"), *It->GetStatsString());
+		NumClients++;
+		TotalBytes += It->GetTotalBytes();
+	}
+	UE_LOG(LogTemp, Log, TEXT("%d replicated clients, %.1f KB of chunk payload in total."), NumClients, TotalBytes / 1024.0);
+}
+
+static FAutoConsoleCommandWithWorld ReplicationStatsCommand(
+	TEXT("Tradecraft.Replication.Stats"),
+	TEXT("Log the chunk snapshots and block edits sent to (on a server) or received by (on a client) each player, with bytes per second."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintReplicationStats));
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EditJournal.h"
+#include "HAL/FileManager.h"
+#include "Serialization/Archive.h"
+
+FEditJournal::~FEditJournal()
+{
+	Close();
+}
+
+void FEditJournal::SerializeRecord(FArchive& Ar, FBlockEditRecord& Record)
+{
+	Ar << Record.ChunkX;
+	Ar << Record.ChunkY;
+	Ar << Record.BlockX;
+	Ar << Record.BlockY;
+	Ar << Record.BlockZ;
+	Ar << Record.Id;
+}
+
+bool FEditJournal::Open(const FString& InPath)
+{
+	Close();
+	Path = InPath;
+
+	const int64 ExistingSize = IFileManager::Get().FileSize(*Path);
+	const bool IsNew = ExistingSize < HeaderSize;
+	if (IsNew && ExistingSize >= 0)
+		IFileManager::Get().Delete(*Path);
+
+	Writer = IFileManager::Get().CreateFileWriter(*Path, IsNew ? 0 : FILEWRITE_Append);
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not open edit journal %s"), *Path);
+		return false;
+	}
+
+	if (IsNew)
+	{
+		uint32 FileMagic = Magic;
+		uint32 Version = 1;
+		*Writer << FileMagic;
+		*Writer << Version;
+		NumRecords = 0;
+	}
+	else
+	{
+		NumRecords = (int32)((ExistingSize - HeaderSize) / RecordSize);
+	}
+	Writer->Flush();
+	return true;
+}
+
+void FEditJournal::Close()
+{
+	if (Writer)
+	{
+		Writer->Close();
+		delete Writer;
+		Writer = nullptr;
+	}
+	HasUnflushedRecords = false;
+}
+
+void FEditJournal::Append(const FBlockEditRecord& Record)
+{
+	if (!Writer)
+		return;
+
+	FBlockEditRecord Copy = Record;
+	SerializeRecord(*Writer, Copy);
+	NumRecords++;
+	HasUnflushedRecords = true;
+}
+
+void FEditJournal::Flush()
+{
+	if (Writer && HasUnflushedRecords)
+	{
+		Writer->Flush();
+		HasUnflushedRecords = false;
+	}
+}
+
+bool FEditJournal::Rewrite(const TArray<FBlockEditRecord>& Records)
+{
+	// Written next to the journal and moved over it, so a crash at any point leaves either the
+	// old journal or the new one.
+	const FString TempPath = Path + TEXT(".tmp");
+	FArchive* TempWriter = IFileManager::Get().CreateFileWriter(*TempPath);
+	if (!TempWriter)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not create %s, the edit journal was not compacted."), *TempPath);
+		return false;
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 Version = 1;
+	*TempWriter << FileMagic;
+	*TempWriter << Version;
+	for (const FBlockEditRecord& Record : Records)
+	{
+		FBlockEditRecord Copy = Record;
+		SerializeRecord(*TempWriter, Copy);
+	}
+	TempWriter->Flush();
+	const bool Written = !TempWriter->IsError() && TempWriter->Close();
+	delete TempWriter;
+
+	if (!Written)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write %s, the edit journal was not compacted."), *TempPath);
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+
+	// The old journal has to be closed to be replaced; if the move fails it is opened again.
+	Close();
+	const bool Moved = IFileManager::Get().Move(*Path, *TempPath, true, true);
+	if (!Moved)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not move %s over the edit journal, keeping the old one."), *TempPath);
+		IFileManager::Get().Delete(*TempPath);
+	}
+	return Open(Path) && Moved;
+}
+
+bool FEditJournal::ReadAll(const FString& InPath, TArray<FBlockEditRecord>& OutRecords)
+{
+	FArchive* Reader = IFileManager::Get().CreateFileReader(*InPath);
+	if (!Reader)
+		return false;
+
+	bool IsValid = false;
+	if (Reader->TotalSize() >= HeaderSize)
+	{
+		uint32 FileMagic = 0;
+		uint32 Version = 0;
+		*Reader << FileMagic;
+		*Reader << Version;
+		IsValid = FileMagic == Magic && Version == 1;
+	}
+
+	if (IsValid)
+	{
+		const int64 NumComplete = (Reader->TotalSize() - HeaderSize) / RecordSize;
+		OutRecords.Reserve(OutRecords.Num() + NumComplete);
+		for (int64 i = 0; i < NumComplete; i++)
+		{
+			FBlockEditRecord Record;
+			SerializeRecord(*Reader, Record);
+			OutRecords.Add(Record);
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Edit journal %s has an invalid header and was ignored."), *InPath);
+	}
+
+	Reader->Close();
+	delete Reader;
+	return IsValid;
+}
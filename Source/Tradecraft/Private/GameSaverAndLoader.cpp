@@ -1,11 +1,13 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "GameSaverAndLoader.h"
+#include "TradecraftStats.h"
 
 UGameSaverAndLoader::UGameSaverAndLoader()
 {
 	SaveSlotName = TEXT("Test Save Slot");
 	UserIndex = 0;
+	TerrainVersion = 0;
 }
 
 void UGameSaverAndLoader::SaveLoadChunk(FArchive& Ar, TArray<int32>& ChunkIds)
@@ -59,44 +61,94 @@ bool UGameSaverAndLoader::SaveGameDataToFileCompressed(const FString& FullFilePa
 
 bool UGameSaverAndLoader::SaveGameDataToFileCompressed(const FString& FullFilePath, TArray<int32>&  ChunkIds) 
 {
-	FBufferArchive ToBinary;
-	SaveLoadChunk(ToBinary, ChunkIds);
-
-	// Compress the file
-	TArray<uint8> CompressedData;
-	FArchiveSaveCompressedProxy Compressor = FArchiveSaveCompressedProxy(CompressedData, ECompressionFlags::COMPRESS_ZLIB);
+	TArray<uint8> EncodedData;
+	if (!FChunkCodec::Encode(ChunkIds, EncodedData))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Chunk could not be encoded."));
+		return false;
+	}
 
-	Compressor << ToBinary;
-	Compressor.Flush();
+	if (!FFileHelper::SaveArrayToFile(EncodedData, *FullFilePath)) 
+	{
+		UE_LOG(LogTemp, Warning, TEXT("File Could not be saved."));
+		return false;
+	}
+	return true;
+}
 
-	if (FFileHelper::SaveArrayToFile(CompressedData, *FullFilePath)) 
+bool UGameSaverAndLoader::SaveChunkToFile(const FString& FullFilePath, const TArray<FChunk_Block_Properties>& ChunkData)
+{
+	// Reused across saves so the encoded buffer is only allocated once per thread.
+	static thread_local TArray<uint8> EncodedData;
+	if (!FChunkCodec::EncodeChunk(ChunkData, EncodedData))
 	{
-		Compressor.FlushCache();
-		CompressedData.Empty();
+		UE_LOG(LogTemp, Warning, TEXT("Chunk could not be encoded."));
+		return false;
+	}
 
-		ToBinary.FlushCache();
-		ToBinary.Empty();
+	TRADECRAFT_SCOPE_CYCLE(WriteChunkFile);
+	if (!FFileHelper::SaveArrayToFile(EncodedData, *FullFilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("File Could not be saved."));
+		return false;
+	}
+	TRADECRAFT_INC_COUNTER(ChunksSaved, 1);
+	TRADECRAFT_INC_COUNTER(BytesWritten, EncodedData.Num());
+	return true;
+}
 
-		ToBinary.Close();
+bool UGameSaverAndLoader::LoadChunkFromFile(const FString& FullFilePath, TArray<FChunk_Block_Properties>& ChunkData)
+{
+	TRADECRAFT_SCOPE_CYCLE(ReadChunkFile);
 
-		return true;
-	}
-	else
+	// Decompression reads straight from the file mapping when there is one. The reader is kept
+	// per thread so the buffered fallback reuses its allocation, but it is always closed before
+	// returning so the file can be saved over again.
+	static thread_local FChunkFileReader Reader;
+	if (!Reader.Open(FullFilePath))
 	{
-		Compressor.FlushCache();
-		CompressedData.Empty();
+		UE_LOG(LogTemp, Warning, TEXT("File Helper:: Invalid File"));
+		return false;
+	}
 
-		ToBinary.FlushCache();
-		ToBinary.Empty();
+	if (FChunkCodec::IsEncoded(Reader.GetData(), Reader.GetSize()))
+	{
+		bool bLoaded = FChunkCodec::DecodeChunk(Reader.GetData(), Reader.GetSize(), ChunkData);
+		Reader.Close();
+		return bLoaded;
+	}
+	Reader.Close();
 
-		ToBinary.Close();
-		UE_LOG(LogTemp, Warning, TEXT("File Could not be saved."));
+	// Legacy saves have to go through the archive path and an id array.
+	TArray<int32> ChunkIds;
+	if (!LoadGameDataFromFileCompressed(FullFilePath, ChunkIds))
 		return false;
+
+	for (int32 i = 0; i < ChunkData.Num() && i < ChunkIds.Num(); i++)
+	{
+		ChunkData[i].id = ChunkIds[i];
 	}
+	return true;
 }
 
 bool UGameSaverAndLoader::LoadGameDataFromFileCompressed(const FString& FullFilePath, TArray<int32>&  ChunkIds)
 {
+	{
+		FChunkFileReader Reader;
+		if (!Reader.Open(FullFilePath))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("File Helper:: Invalid File"));
+			return false;
+		}
+
+		if (FChunkCodec::IsEncoded(Reader.GetData(), Reader.GetSize()))
+		{
+			return FChunkCodec::Decode(Reader.GetData(), Reader.GetSize(), ChunkIds);
+		}
+	}
+
+	// Chunks saved before the codec existed are a zlib compressed archive with no header,
+	// which the compression proxy can only read from an array.
 	TArray<uint8> CompressedData;
 	if (!FFileHelper::LoadFileToArray(CompressedData, *FullFilePath)) 
 	{
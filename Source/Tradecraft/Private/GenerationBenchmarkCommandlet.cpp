@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GenerationBenchmarkCommandlet.h"
+#include "ChunkGenerator.h"
+#include "ChunkMesher.h"
+#include "HeightTileCache.h"
+#include "Chunk.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformProperties.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+// Block ids 0 to 7, one mesh section each, independent of the materials set up in the editor.
+static const int32 BenchmarkNumSections = 8;
+
+struct FGenerationBenchmarkResult
+{
+	FChunkGenerationTimings Timings;
+	double MeshSeconds = 0.0;
+	uint32 BlockHash = 0;
+	uint32 MeshHash = 0;
+	int64 NumTriangles = 0;
+};
+
+static FString GetGoldenKey(int32 Seed, int32 Version, int32 Size)
+{
+	return FString::Printf(TEXT("%s %d %d %d"), FPlatformProperties::IniPlatformName(), Seed, Version, Size);
+}
+
+static FGenerationBenchmarkResult RunGenerationBenchmark(int32 Seed, int32 Version, int32 Size)
+{
+	FGenerationBenchmarkResult Result;
+
+	FChunkGenerator::PrepareNoise(Seed);
+	FBiomeMap BiomeMap(Seed);
+	FHeightTileCache HeightTiles(BiomeMap);
+	FChunkGenerator Generator(Seed);
+	Generator.TerrainVersion = Version;
+	Generator.Biomes = &BiomeMap;
+	Generator.HeightTiles = &HeightTiles;
+
+	// A square straddling the origin, so negative coordinates are covered too. Generated in a
+	// fixed order on one thread so the hashes and timings are repeatable.
+	TArray<FChunk_Block_Properties> ChunkData;
+	TArray<uint8> BlockIds;
+	TArray<FMeshSection> Sections;
+	for (int32 x = -Size / 2; x < Size - Size / 2; x++)
+	{
+		for (int32 y = -Size / 2; y < Size - Size / 2; y++)
+		{
+			Generator.Generate(x, y, ChunkData, &Result.Timings);
+
+			BlockIds.SetNumUninitialized(ChunkData.Num());
+			for (int32 i = 0; i < ChunkData.Num(); i++)
+				BlockIds[i] = (uint8)ChunkData[i].id;
+			Result.BlockHash = FCrc::MemCrc32(BlockIds.GetData(), BlockIds.Num(), Result.BlockHash);
+
+			const double MeshStart = FPlatformTime::Seconds();
+			Sections.Reset();
+			FChunkMesher::BuildMeshSections(ChunkData, Generator.WidthOfChunk, Generator.HeightOfChunk, BenchmarkNumSections, Sections);
+			Result.MeshSeconds += FPlatformTime::Seconds() - MeshStart;
+
+			for (const FMeshSection& Section : Sections)
+			{
+				Result.MeshHash = FCrc::MemCrc32(Section.Vertices.GetData(), Section.Vertices.Num() * Section.Vertices.GetTypeSize(), Result.MeshHash);
+				Result.MeshHash = FCrc::MemCrc32(Section.Triangles.GetData(), Section.Triangles.Num() * Section.Triangles.GetTypeSize(), Result.MeshHash);
+				Result.MeshHash = FCrc::MemCrc32(Section.UVs.GetData(), Section.UVs.Num() * Section.UVs.GetTypeSize(), Result.MeshHash);
+				Result.NumTriangles += Section.Triangles.Num() / 3;
+			}
+		}
+	}
+	return Result;
+}
+
+UGenerationBenchmarkCommandlet::UGenerationBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGenerationBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString SeedList = TEXT("1,1337,424242");
+	int32 Size = 8;
+	int32 OnlyVersion = INDEX_NONE;
+	FParse::Value(*Params, TEXT("Seeds="), SeedList);
+	FParse::Value(*Params, TEXT("Size="), Size);
+	FParse::Value(*Params, TEXT("Version="), OnlyVersion);
+	const bool UpdateGolden = FParse::Param(*Params, TEXT("UpdateGolden"));
+
+	TArray<FString> SeedStrings;
+	SeedList.ParseIntoArray(SeedStrings, TEXT(","));
+	if (SeedStrings.Num() == 0 || Size <= 0 || OnlyVersion > FChunkGenerator::CurrentTerrainVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=GenerationBenchmark [-Seeds=1,2,3] [-Size=<Chunks>] [-Version=<N>] [-UpdateGolden]"));
+		return 1;
+	}
+
+	// One "<Platform> <Seed> <Version> <Size> <BlockHash> <MeshHash>" line per run, '#' starts a comment.
+	const FString GoldenPath = FPaths::Combine(FPaths::ProjectConfigDir(), TEXT("GenerationGolden.txt"));
+	TArray<FString> GoldenLines;
+	FFileHelper::LoadFileToStringArray(GoldenLines, *GoldenPath);
+	TMap<FString, FString> Golden;
+	for (const FString& Line : GoldenLines)
+	{
+		TArray<FString> Fields;
+		Line.ParseIntoArrayWS(Fields);
+		if (Fields.Num() == 6 && !Fields[0].StartsWith(TEXT("#")))
+			Golden.Add(FString::Printf(TEXT("%s %s %s %s"), *Fields[0], *Fields[1], *Fields[2], *Fields[3]), Fields[4] + TEXT(" ") + Fields[5]);
+	}
+
+	int32 NumMismatched = 0;
+	int32 NumMissing = 0;
+	for (const FString& SeedString : SeedStrings)
+	{
+		const int32 Seed = FCString::Atoi(*SeedString);
+		for (int32 Version = 0; Version <= FChunkGenerator::CurrentTerrainVersion; Version++)
+		{
+			if (OnlyVersion != INDEX_NONE && Version != OnlyVersion)
+				continue;
+
+			const FGenerationBenchmarkResult Result = RunGenerationBenchmark(Seed, Version, Size);
+			const int32 NumChunks = Result.Timings.NumChunks;
+			const double TotalSeconds = Result.Timings.NoiseSeconds + Result.Timings.FillSeconds + Result.Timings.TreeSeconds + Result.MeshSeconds;
+			UE_LOG(LogTemp, Display, TEXT("Seed %d, version %d: %d chunks in %.3fs (%.1f chunks/sec), per chunk noise %.3fms, fill %.3fms, trees %.3fms, mesh %.3fms, %lld triangles"),
+				Seed, Version, NumChunks, TotalSeconds, TotalSeconds > 0.0 ? NumChunks / TotalSeconds : 0.0,
+				1000.0 * Result.Timings.NoiseSeconds / NumChunks, 1000.0 * Result.Timings.FillSeconds / NumChunks,
+				1000.0 * Result.Timings.TreeSeconds / NumChunks, 1000.0 * Result.MeshSeconds / NumChunks, Result.NumTriangles);
+
+			const FString Key = GetGoldenKey(Seed, Version, Size);
+			const FString Hashes = FString::Printf(TEXT("%08x %08x"), Result.BlockHash, Result.MeshHash);
+			const FString* Expected = Golden.Find(Key);
+			if (UpdateGolden)
+			{
+				Golden.Add(Key, Hashes);
+			}
+			else if (!Expected)
+			{
+				UE_LOG(LogTemp, Error, TEXT("No golden hashes for %s, got %s. Run with -UpdateGolden to record them."), *Key, *Hashes);
+				NumMissing++;
+			}
+			else if (*Expected != Hashes)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Golden mismatch for %s: expected %s, got %s."), *Key, **Expected, *Hashes);
+				NumMismatched++;
+			}
+		}
+	}
+
+	if (UpdateGolden)
+	{
+		Golden.KeySort(TLess<FString>());
+		FString Output = TEXT("# Chunk generation golden hashes, written by -run=GenerationBenchmark -UpdateGolden, or by the\n");
+		Output += TEXT("# native build with VoxelCoreBench -golden <Platform> on that platform.\n");
+		Output += TEXT("# <Platform> <Seed> <TerrainVersion> <Size> <BlockHash> <MeshHash>\n");
+		for (const auto& Elem : Golden)
+			Output += Elem.Key + TEXT(" ") + Elem.Value + TEXT("\n");
+
+		if (!FFileHelper::SaveStringToFile(Output, *GoldenPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not write %s."), *GoldenPath);
+			return 1;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Wrote golden hashes to %s."), *GoldenPath);
+		return 0;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Generation golden check: %d mismatched, %d missing."), NumMismatched, NumMissing);
+	// A run nothing is recorded for can't show that generation is unchanged, so it fails too.
+	return NumMismatched == 0 && NumMissing == 0 ? 0 : 1;
+}
@@ -3,9 +3,20 @@
 #include "MinecraftWorld.h"
 #include "Engine/World.h"
 #include "Components/StaticMeshComponent.h"
+#include "Materials/Material.h"
 #include "UObject/UObjectGlobals.h"
 #include "Camera/CameraComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
 #include "Misc/DateTime.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+#include "ChunkGenerator.h"
+#include "ChunkReplicationComponent.h"
+#include "TradecraftStats.h"
+#include "VoxelCore/VoxelTypes.h"
 
 
 // Sets default values
@@ -20,9 +31,33 @@ AMinecraftWorld::AMinecraftWorld()
 void AMinecraftWorld::BeginPlay()
 {
 	Super::BeginPlay();
+	StartupTime = FPlatformTime::Seconds();
 	ItemCounts.Init(0, 54);
+
+	// Map URL options let tests and tools open a specific world, e.g. PlayGame?TradecraftWorld=Test?TradecraftSeed=1337
+	if (const TCHAR* WorldOption = GetWorld()->URL.GetOption(TEXT("TradecraftWorld="), nullptr))
+		WorldName = WorldOption;
+	if (const TCHAR* SeedOption = GetWorld()->URL.GetOption(TEXT("TradecraftSeed="), nullptr))
+		seed = FCString::Atoi(SeedOption);
 	ItemIds.Init(0, 54);
 
+	Block_Health_Values.Init(0, Block_Props.Num());
+	for (int i = 0; i < Block_Props.Num(); i++) 
+	{
+		Block_Health_Values[i] = Block_Props[i].Current_Health;
+	}
+
+	SetupFluidMaterials();
+
+	// A client's chunks all come from the server, see UChunkReplicationComponent, and it keeps no save.
+	if (GetNetMode() == NM_Client)
+	{
+		bReplicatedClient = true;
+		SetupLighting();
+		WorldIsLoaded = true;
+		return;
+	}
+
 	// Create master file if needed ------------------------------------------------------------------------------------------------
 	UGameSaverAndLoader* SavedGames = nullptr;
 	if (UGameplayStatics::DoesSaveGameExist(TEXT("All_Saved_Games"), 0))
@@ -84,6 +119,7 @@ void AMinecraftWorld::BeginPlay()
 		SaveGameInstance = Cast<UGameSaverAndLoader>(UGameplayStatics::CreateSaveGameObject(UGameSaverAndLoader::StaticClass()));
 		SaveGameInstance->SaveSlotName = WorldName;
 		SaveGameInstance->SavedSeed = seed;
+		SaveGameInstance->TerrainVersion = FChunkGenerator::CurrentTerrainVersion;
 		UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->SaveSlotName, SaveGameInstance->UserIndex);
 		SavedGames->AllSavedGames.Add(SaveGameInstance->SaveSlotName);
 		UGameplayStatics::SaveGameToSlot(SavedGames, TEXT("All_Saved_Games"), 0);
@@ -97,38 +133,74 @@ void AMinecraftWorld::BeginPlay()
 	}
 	// Load Game if we find one ------------------------------------------------------------------------------------------------------------------------------------------------
 
+	FChunkGenerator::PrepareNoise(seed);
+	BiomeMap = MakeShareable(new FBiomeMap(seed));
+	HeightTiles = MakeShareable(new FHeightTileCache(*BiomeMap, HeightTileCacheMaxTiles));
+
+	bServerChunks = (bMeshFreeChunksOnServer && GetNetMode() == NM_DedicatedServer) || FParse::Param(FCommandLine::Get(), TEXT("TradecraftServerChunks"));
+	if (bServerChunks)
+		UE_LOG(LogTemp, Log, TEXT("Chunks keep block data and collision near players only."));
+
+	BlockTicks.Initialize(seed, ChunkWidth, GetDefault<AChunk>()->HeightOfChunk,
+		[this](const FIntVector& Block) { return GetBlockAt(Block); },
+		[this](const FIntVector& Block, int32 Id) { SetBlockAt(Block, Id); });
+	BlockTicks.GetScheduler().TicksPerSecond = BlockTicksPerSecond;
+	BlockTicks.GetScheduler().RandomTicksPerSection = RandomBlockTicksPerSection;
+	RegisterBlockBehaviors();
+	SetupLighting();
+	SetupNavigation();
+
 	WorldDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), FString("SaveGames"), WorldName);
 	UE_LOG(LogTemp, Warning, TEXT("World Directory: %s"), *WorldDirectory);
 	SaveGameInstance->VerifyOrCreateDirectory(WorldDirectory);
 
-	Block_Health_Values.Init(0, Block_Props.Num());
-	for (int i = 0; i < Block_Props.Num(); i++) 
+	ChunkCache.SetWriter([this](const FString& ChunkName, const TArray<uint8>& EncodedData)
 	{
-		Block_Health_Values[i] = Block_Props[i].Current_Health;
-	}
-
-	Player = GetWorld()->GetFirstPlayerController()->GetPawn();
-	if (!Player)
+		TRADECRAFT_SCOPE_CYCLE(WriteChunkFile);
+		const double WriteStart = FPlatformTime::Seconds();
+		if (!FFileHelper::SaveArrayToFile(EncodedData, *FPaths::Combine(WorldDirectory, ChunkName)))
+			return false;
+		TRADECRAFT_INC_COUNTER(ChunksSaved, 1);
+		TRADECRAFT_INC_COUNTER(BytesWritten, EncodedData.Num());
+		TraceChunk(EStreamingTraceEvent::ChunkSaved, ChunkName, FPlatformTime::Seconds() - WriteStart);
+		return true;
+	});
+	ChunkCache.SetBudget((int64)ChunkCacheSizeMB * 1024 * 1024, ChunkCacheMaxChunks);
+
+	if (bRecordStreamingTrace || FParse::Param(FCommandLine::Get(), TEXT("TradecraftTrace")))
+		StartStreamingTrace();
+
+	ReplayEditJournal();
+
+	// A dedicated server has no player of its own; Tick picks up the first one to join.
+	APlayerController* FirstController = GetWorld()->GetFirstPlayerController();
+	Player = FirstController ? FirstController->GetPawn() : nullptr;
+	if (!Player && GetNetMode() != NM_DedicatedServer)
 	{
 		UE_LOG(LogTemp, Error, TEXT("Failed to find player."));
 	}
 
-	LastBuildPosition = Player->GetActorLocation();
+	// A loaded game starts where the player saved, so that is the area to build first.
+	LastBuildPosition = IsSavedWorld ? SaveGameInstance->PlayerPosition : Player ? Player->GetActorLocation() : FVector::ZeroVector;
+	GetPlayerChunks(PlayerChunks);
 
-	FVector FirstChunkPos = FVector((int)((LastBuildPosition.X - 1) / (ChunkWidth * 100)), (int)(LastBuildPosition.Y / (ChunkWidth * 100)), (int)(LastBuildPosition.Z / (ChunkWidth * 100)));
+	FVector FirstChunkPos = GetChunkPosition(LastBuildPosition);
 
 	AChunk* Cube = GetWorld()->SpawnActor<AChunk>();
-	BuildNearPlayer();
+
+	// Only the chunks around the player are built before they get control. Their collision is
+	// cooked synchronously so the player does not fall through the world, and everything else
+	// in range is built over the next frames by BuildPendingChunks.
+	BuildSpawnArea(FirstChunkPos);
+	QueueChunksNear(FirstChunkPos, ChunkRange);
 
 	// Set player's location if we are loading a game and inventory etc.---------------------------
-	// Do it after the world has been built, so that the player does not---------------------------
-	// fall through the world. --------------------------------------------------------------------
-	if (IsSavedWorld)
+	if (Player && IsSavedWorld)
 	{
 		Player->SetActorLocationAndRotation(SaveGameInstance->PlayerPosition, SaveGameInstance->PlayerRotation);
 		UE_LOG(LogTemp, Warning, TEXT("Player Rotation: %s"), *SaveGameInstance->PlayerRotation.ToString());
 	}
-	else
+	else if (Player)
 	{
 		SaveGameInstance->PlayerPosition = Player->GetActorLocation();
 		SaveGameInstance->PlayerRotation = Player->GetActorRotation();
@@ -139,6 +211,15 @@ void AMinecraftWorld::BeginPlay()
 	WorldIsLoaded = true;
 }
 
+void AMinecraftWorld::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Unloaded chunks that were never written out would otherwise be lost.
+	ChunkCache.Empty();
+	EditJournal.Close();
+	StopStreamingTrace();
+	Super::EndPlay(EndPlayReason);
+}
+
 bool AMinecraftWorld::IsWorldLoaded() {
 	return WorldIsLoaded;
 }
@@ -151,60 +232,891 @@ void AMinecraftWorld::SetWorldLoaded(bool loaded) {
 void AMinecraftWorld::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	FVector Movement = LastBuildPosition - Player->GetActorLocation();
 
-	if (FMath::Sqrt(Movement.X * Movement.X + Movement.Y * Movement.Y) > (ChunkWidth * 100))
+	if (TimeToFirstControllableFrame < 0.0f)
+	{
+		TimeToFirstControllableFrame = (float)(FPlatformTime::Seconds() - StartupTime);
+		UE_LOG(LogTemp, Warning, TEXT("First controllable frame after %.3fs, %d chunks still queued."), TimeToFirstControllableFrame, PendingChunkBuilds.Num());
+	}
+
+	if (bReplicatedClient)
 	{
-		LastBuildPosition = Player->GetActorLocation();
-		BuildNearPlayer();
+		RemeshChangedChunks();
+		return;
+	}
+
+	if (GetNetMode() == NM_ListenServer || GetNetMode() == NM_DedicatedServer)
+		AddReplicationComponents();
+
+	if (!Player)
+	{
+		APlayerController* FirstController = GetWorld()->GetFirstPlayerController();
+		Player = FirstController ? FirstController->GetPawn() : nullptr;
+	}
+
+	if (Player)
+	{
+		FVector Movement = LastBuildPosition - Player->GetActorLocation();
+
+		if (FMath::Sqrt(Movement.X * Movement.X + Movement.Y * Movement.Y) > (ChunkWidth * 100))
+		{
+			LastBuildPosition = Player->GetActorLocation();
+			BuildNearPlayer();
+		}
+	}
+
+	if (bServerChunks)
+		UpdateServerCollision();
+
+	BuildPendingChunks();
+
+	if (bEnableBlockTicks)
+		TickBlocks(DeltaTime);
+
+	Navigation.Update(NavigationBudgetMs / 1000.0);
+
+	RemeshChangedChunks();
+
+	RunAutosave();
+
+	EnforceMemoryBudget();
+
+	if (StreamingTrace.IsOpen())
+	{
+		const FVector PlayerPos = Player ? Player->GetActorLocation() : LastTracedPlayerPosition;
+		if (FVector::DistSquared(PlayerPos, LastTracedPlayerPosition) > 50.0f * 50.0f)
+		{
+			LastTracedPlayerPosition = PlayerPos;
+			StreamingTrace.Record(EStreamingTraceEvent::PlayerPosition, FMath::RoundToInt(PlayerPos.X), FMath::RoundToInt(PlayerPos.Y), FMath::RoundToInt(PlayerPos.Z));
+		}
+		StreamingTrace.Record(EStreamingTraceEvent::FrameEnd, 0, 0, 0, DeltaTime);
+		StreamingTrace.Flush();
 	}
 }
 
-void AMinecraftWorld::BuildChunkAt(FVector pos)
+bool AMinecraftWorld::StartStreamingTrace(const FString& Path)
 {
-	FString chunkName = AMinecraftWorld::BuildChunkName(pos);
-	AChunk* Chunk;
+	const FString TracePath = Path.Len() > 0 ? Path : FPaths::Combine(FPaths::ProfilingDir(), FString("Tradecraft"), FString::Printf(TEXT("StreamingTrace-%s.tctrace"), *FDateTime::Now().ToString()));
+
+	FStreamingTraceHeader Header;
+	Header.Seed = seed;
+	Header.TerrainVersion = SaveGameInstance->TerrainVersion;
+	Header.WidthOfChunk = ChunkWidth;
+	Header.StartTicks = FDateTime::Now().GetTicks();
+	Header.WorldName = WorldName;
+	if (!StreamingTrace.Open(TracePath, Header))
+		return false;
+
+	for (auto& Elem : Chunks)
+	{
+		if (Elem.Value)
+			Elem.Value->Trace = &StreamingTrace;
+	}
+	LastTracedPlayerPosition = FVector::ZeroVector;
+	UE_LOG(LogTemp, Log, TEXT("Recording streaming trace to %s"), *TracePath);
+	return true;
+}
+
+void AMinecraftWorld::StopStreamingTrace()
+{
+	if (!StreamingTrace.IsOpen())
+		return;
+
+	for (auto& Elem : Chunks)
+	{
+		if (Elem.Value)
+			Elem.Value->Trace = nullptr;
+	}
+	StreamingTrace.Close();
+	UE_LOG(LogTemp, Log, TEXT("Stopped recording streaming trace %s"), *StreamingTrace.GetPath());
+}
 
-	if (!Chunks.Contains(chunkName) && !SaveGameInstance->CheckIfFileExists(WorldDirectory, chunkName))
+void AMinecraftWorld::TraceChunk(EStreamingTraceEvent Type, const FString& ChunkName, double DurationSeconds)
+{
+	int32 ChunkX, ChunkY;
+	if (StreamingTrace.IsOpen() && ParseChunkName(ChunkName, ChunkX, ChunkY))
+		StreamingTrace.RecordChunk(Type, ChunkX, ChunkY, DurationSeconds);
+}
+
+void AMinecraftWorld::RegisterBlockBehaviors()
+{
+	using namespace VoxelCore;
+
+	// Grass dies under a solid block and spreads to nearby dirt that has air above it.
+	BlockTickBehavior Grass;
+	Grass.OnRandomTick = [](BlockTickScheduler& Ticks, const BlockPos& Block)
 	{
-		Chunk = GetWorld()->SpawnActor<AChunk>();
-		FVector ChunkPos = FVector(pos.X * Chunk->WidthOfChunk * Chunk->VoxelWidth, pos.Y * Chunk->WidthOfChunk * Chunk->VoxelWidth, -Chunk->VoxelWidth * (Chunk->HeightOfChunk / 2));
-		Chunk->SetLocation(ChunkPos, seed);
-		Chunk->SetChunkMaterials(Materials);
-		Chunk->SetBlockHealthValues(Block_Health_Values);
-		Chunk->MakeOwner(this);
+		if (Ticks.GetBlock(Block + BlockPos{ 0, 0, 1 }) != Blocks::Air)
+		{
+			Ticks.SetBlock(Block, Blocks::Dirt);
+			return;
+		}
 
+		RandomStream& Random = Ticks.GetRandom();
+		const BlockPos Target = Block + BlockPos{ Random.RandRange(-1, 1), Random.RandRange(-1, 1), Random.RandRange(-2, 1) };
+		if (Ticks.GetBlock(Target) == Blocks::Dirt && Ticks.GetBlock(Target + BlockPos{ 0, 0, 1 }) == Blocks::Air)
+			Ticks.SetBlock(Target, Blocks::Grass);
+	};
+	BlockTicks.GetScheduler().RegisterBehavior(Blocks::Grass, Grass);
 
-		Chunk->GenerateChunkInWorld();
-		Chunks.Add(chunkName, Chunk);
+	Fluids.Initialize(ChunkLayout(ChunkWidth, GetDefault<AChunk>()->HeightOfChunk));
+	if (WaterSourceBlockId != INDEX_NONE && FlowingWaterBlockId != INDEX_NONE)
+	{
+		FluidType Water;
+		Water.SourceId = WaterSourceBlockId;
+		Water.FlowingId = FlowingWaterBlockId;
+		Water.MaxLevel = 7;
+		Water.TickDelay = 5;
+		if (!Fluids.AddFluid(Water))
+			UE_LOG(LogTemp, Warning, TEXT("Water block ids %d and %d are out of range, water is left out"), WaterSourceBlockId, FlowingWaterBlockId);
 	}
-	else if (SaveGameInstance->CheckIfFileExists(WorldDirectory, chunkName) && !Chunks.Contains(chunkName))
+	if (LavaSourceBlockId != INDEX_NONE && FlowingLavaBlockId != INDEX_NONE)
 	{
-		Chunk = GetWorld()->SpawnActor<AChunk>();
-		FVector ChunkPos = FVector(pos.X * Chunk->WidthOfChunk * Chunk->VoxelWidth, pos.Y * Chunk->WidthOfChunk * Chunk->VoxelWidth, -Chunk->VoxelWidth * (Chunk->HeightOfChunk / 2));
-		Chunk->SetLocation(ChunkPos, seed);
-		Chunk->SetChunkMaterials(Materials);
-		Chunk->SetBlockHealthValues(Block_Health_Values);
-		Chunk->MakeOwner(this);
+		// There is no obsidian, so lava that meets water turns to stone, sources and flowing
+		// cells alike.
+		FluidType Lava;
+		Lava.SourceId = LavaSourceBlockId;
+		Lava.FlowingId = FlowingLavaBlockId;
+		Lava.MaxLevel = 3;
+		Lava.TickDelay = 30;
+		Lava.HardenedSourceId = Blocks::Stone;
+		Lava.HardenedFlowingId = Blocks::Stone;
+		if (!Fluids.AddFluid(Lava))
+			UE_LOG(LogTemp, Warning, TEXT("Lava block ids %d and %d are out of range, lava is left out"), LavaSourceBlockId, FlowingLavaBlockId);
+	}
+	Fluids.RegisterBehaviors(BlockTicks.GetScheduler());
+}
 
-		TArray<int32> ChunkIds;
-		FString PathToSaveData = FPaths::Combine(WorldDirectory, chunkName);
-		SaveGameInstance->LoadGameDataFromFileCompressed(PathToSaveData, ChunkIds);
-		Chunk->LoadChunkValues(ChunkIds);
-		Chunk->GenerateLoadedChunkInWorld();
+void AMinecraftWorld::SetupFluidMaterials()
+{
+	const TPair<int32, UMaterialInterface*> FluidMaterials[] =
+	{
+		TPair<int32, UMaterialInterface*>(WaterSourceBlockId, WaterMaterial),
+		TPair<int32, UMaterialInterface*>(FlowingWaterBlockId, WaterMaterial),
+		TPair<int32, UMaterialInterface*>(LavaSourceBlockId, LavaMaterial),
+		TPair<int32, UMaterialInterface*>(FlowingLavaBlockId, LavaMaterial),
+	};
+	for (const TPair<int32, UMaterialInterface*>& Fluid : FluidMaterials)
+	{
+		// Ids past the end of Materials are left out of the mesh.
+		if (Fluid.Key < 0 || (Materials.IsValidIndex(Fluid.Key) && Materials[Fluid.Key]))
+			continue;
+
+		if (Materials.Num() <= Fluid.Key)
+			Materials.SetNum(Fluid.Key + 1);
+		Materials[Fluid.Key] = Fluid.Value ? Fluid.Value : UMaterial::GetDefaultMaterial(MD_Surface);
+		if (!Fluid.Value)
+			UE_LOG(LogTemp, Warning, TEXT("No material for fluid block id %d, using the default material"), Fluid.Key);
+	}
+}
+
+bool AMinecraftWorld::PlaceFluidSource(FVector pos, bool bLava)
+{
+	const int32 Id = bLava ? LavaSourceBlockId : WaterSourceBlockId;
+	if (Id == INDEX_NONE || GetBlockAtPos(pos) != VoxelCore::Blocks::Air)
+		return false;
 
-		if(Chunk)
-			Chunks.Add(chunkName, Chunk);
+	BreakOrAddBlock(pos, true, Id);
+	return true;
+}
+
+void AMinecraftWorld::SetupLighting()
+{
+	Lighting.Initialize(ChunkWidth, GetDefault<AChunk>()->HeightOfChunk, &ChunksByCoordinates, [this](AChunk* Chunk) { ChunksToRemesh.Add(Chunk); });
+
+	// Water dims light a little with depth; lava lights up its surroundings.
+	VoxelCore::LightProperties& Properties = Lighting.GetProperties();
+	auto IsLightId = [](int32 Id) { return Id >= 0 && Id < VoxelCore::LightProperties::NumIds; };
+	for (int32 Id : { WaterSourceBlockId, FlowingWaterBlockId })
+	{
+		if (IsLightId(Id))
+			Properties.Opacity[Id] = 2;
+	}
+	for (int32 Id : { LavaSourceBlockId, FlowingLavaBlockId })
+	{
+		if (IsLightId(Id))
+			Properties.Emission[Id] = VoxelCore::MaxLight;
+	}
+}
+
+void AMinecraftWorld::SetupNavigation()
+{
+	if (!bEnableNavigation || bReplicatedClient)
+		return;
+
+	// Agents wade through water but never step into lava.
+	VoxelCore::PathProperties& Properties = Navigation.GetProperties();
+	auto IsPathId = [](int32 Id) { return Id >= 0 && Id < VoxelCore::PathProperties::NumIds; };
+	for (int32 Id : { WaterSourceBlockId, FlowingWaterBlockId })
+	{
+		if (IsPathId(Id))
+			Properties.Kinds[Id] = VoxelCore::PathProperties::Open;
+	}
+	for (int32 Id : { LavaSourceBlockId, FlowingLavaBlockId })
+	{
+		if (IsPathId(Id))
+			Properties.Kinds[Id] = VoxelCore::PathProperties::Blocked;
+	}
+	Navigation.Initialize(ChunkWidth, GetDefault<AChunk>()->HeightOfChunk, &ChunksByCoordinates);
+}
+
+bool AMinecraftWorld::FindVoxelPath(FVector Start, FVector Goal, TArray<FVector>& Points)
+{
+	return Navigation.FindPath(Start, Goal, Points);
+}
+
+void AMinecraftWorld::GetPlayerChunks(TArray<FIntPoint>& OutChunks) const
+{
+	OutChunks.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr;
+		if (Pawn)
+		{
+			const FVector ChunkPos = GetChunkPosition(Pawn->GetActorLocation());
+			OutChunks.AddUnique(FIntPoint((int32)ChunkPos.X, (int32)ChunkPos.Y));
+		}
+	}
+}
+
+bool AMinecraftWorld::IsNearPlayer(const FIntPoint& Chunk) const
+{
+	for (const FIntPoint& PlayerChunk : PlayerChunks)
+	{
+		if (FMath::Abs(Chunk.X - PlayerChunk.X) <= ServerCollisionRange && FMath::Abs(Chunk.Y - PlayerChunk.Y) <= ServerCollisionRange)
+			return true;
+	}
+	return false;
+}
+
+void AMinecraftWorld::UpdateServerCollision()
+{
+	TArray<FIntPoint> CurrentChunks;
+	GetPlayerChunks(CurrentChunks);
+	if (CurrentChunks == PlayerChunks)
+		return;
+
+	PlayerChunks = MoveTemp(CurrentChunks);
+	for (const auto& Elem : ChunksByCoordinates)
+	{
+		if (!Elem.Value)
+			continue;
+		Elem.Value->SetWantsCollision(IsNearPlayer(Elem.Key));
+		Elem.Value->UpdateMeshIfDirty();
+	}
+}
+
+float AMinecraftWorld::GetDistanceToNearestPlayer(const FVector& WorldPos) const
+{
+	float Nearest = MAX_flt;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr;
+		if (Pawn)
+			Nearest = FMath::Min(Nearest, FVector::Dist2D(WorldPos, Pawn->GetActorLocation()));
+	}
+	return Nearest;
+}
+
+void AMinecraftWorld::AddReplicationComponents()
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* Controller = It->Get();
+		if (!Controller || Controller->IsLocalController() || Controller->FindComponentByClass<UChunkReplicationComponent>())
+			continue;
+
+		UChunkReplicationComponent* Replication = NewObject<UChunkReplicationComponent>(Controller);
+		Replication->World = this;
+		Replication->SetIsReplicated(true);
+		Replication->RegisterComponent();
+		UE_LOG(LogTemp, Log, TEXT("Replicating chunks to %s."), *Controller->GetName());
+	}
+}
+
+AChunk* AMinecraftWorld::FindChunk(const FIntPoint& Chunk) const
+{
+	AChunk* const* Found = ChunksByCoordinates.Find(Chunk);
+	return Found ? *Found : nullptr;
+}
+
+FIntPoint AMinecraftWorld::GetChunkCoordinatesAt(const FVector& WorldPos) const
+{
+	const FVector ChunkPos = GetChunkPosition(WorldPos);
+	return FIntPoint((int32)ChunkPos.X, (int32)ChunkPos.Y);
+}
+
+FIntPoint AMinecraftWorld::GetChunkOfBlock(const FIntVector& Block) const
+{
+	return FIntPoint(VoxelCore::FloorDiv(Block.X, ChunkWidth), VoxelCore::FloorDiv(Block.Y, ChunkWidth));
+}
+
+void AMinecraftWorld::RequestChunks(const TArray<FIntPoint>& Wanted)
+{
+	// BuildPendingChunks pops from the back.
+	for (int32 i = Wanted.Num() - 1; i >= 0; i--)
+	{
+		if (ChunksByCoordinates.Contains(Wanted[i]))
+			continue;
+
+		RemoteChunkRequests.Remove(Wanted[i]);
+		RemoteChunkRequests.Add(Wanted[i]);
+	}
+}
+
+void AMinecraftWorld::ApplyBlockEdit(const FIntVector& Block, int32 Id)
+{
+	const int32 OldId = GetBlockAt(Block);
+	if (OldId == Id)
+		return;
+
+	SetBlockAt(Block, Id);
+	if (AChunk* Chunk = FindChunk(GetChunkOfBlock(Block)))
+		Chunk->UpdateMeshIfDirty();
+	BlockTicks.NotifyBlockChanged(Block, OldId, Id);
+}
+
+void AMinecraftWorld::ReceiveChunk(const FIntPoint& Coordinates, const TArray<uint8>& Data)
+{
+	// Sent again, e.g. after the player came back into range.
+	if (AChunk* Existing = FindChunk(Coordinates))
+	{
+		if (FChunkCodec::DecodeChunk(Data.GetData(), Data.Num(), Existing->ChunkData))
+		{
+			Existing->ComputeLight();
+			Lighting.StitchChunk(Coordinates.X, Coordinates.Y);
+			Existing->MeshIsDirty = true;
+			Existing->UpdateMeshIfDirty();
+		}
+		return;
+	}
+
+	const FVector pos(Coordinates.X, Coordinates.Y, -16);
+	AChunk* Chunk = SpawnChunkAt(pos);
+	if (!Chunk)
+		return;
+
+	if (!FChunkCodec::DecodeChunk(Data.GetData(), Data.Num(), Chunk->ChunkData))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not decode chunk %d, %d from the server."), Coordinates.X, Coordinates.Y);
+		Chunk->Destroy();
+		return;
+	}
+	Chunk->NeedsSaving = false;
+	AddBuiltChunk(Chunk, BuildChunkName(pos), Coordinates);
+}
+
+void AMinecraftWorld::ForgetReceivedChunk(const FIntPoint& Coordinates)
+{
+	const FString ChunkName = BuildChunkName(FVector(Coordinates.X, Coordinates.Y, -16));
+	ForgetChunk(ChunkName);
+	AChunk* Chunk = nullptr;
+	if (Chunks.RemoveAndCopyValue(ChunkName, Chunk) && Chunk)
+		Chunk->Destroy();
+}
+
+void AMinecraftWorld::ApplyReplicatedEdit(const FIntVector& Block, int32 Id)
+{
+	SetBlockAt(Block, Id);
+	if (AChunk* Chunk = FindChunk(GetChunkOfBlock(Block)))
+		Chunk->UpdateMeshIfDirty();
+}
+
+void AMinecraftWorld::OnEditResult(int32 Sequence, bool bAccepted, int32 OldId)
+{
+	int32 PredictedId = 0;
+	if (!PendingClientBreaks.RemoveAndCopyValue(Sequence, PredictedId))
+		return;
+
+	if (bAccepted && OldId != 0)
+		OnConfirmedBlockBreak.Broadcast(OldId);
+	else
+		OnRejectedBlockBreak.Broadcast(PredictedId);
+}
+
+bool AMinecraftWorld::IsPlaceableBlockId(int32 Id) const
+{
+	return Id > 0 && Block_Props.IsValidIndex(Id)
+		&& Id != WaterSourceBlockId && Id != FlowingWaterBlockId && Id != LavaSourceBlockId && Id != FlowingLavaBlockId;
+}
+
+void AMinecraftWorld::TickBlocks(float DeltaTime)
+{
+	TRADECRAFT_SCOPE_CYCLE(BlockTicks);
+	BlockTicks.Update(DeltaTime, BlockTickBudgetMs / 1000.0);
+}
+
+void AMinecraftWorld::RemeshChangedChunks()
+{
+	int32 Remeshed = 0;
+	for (auto It = ChunksToRemesh.CreateIterator(); It && Remeshed < MaxBlockTickRemeshesPerTick; ++It)
+	{
+		(*It)->UpdateMeshIfDirty();
+		It.RemoveCurrent();
+		Remeshed++;
+	}
+}
+
+int32 AMinecraftWorld::GetBlockAt(const FIntVector& Block)
+{
+	const int32 ChunkX = VoxelCore::FloorDiv(Block.X, ChunkWidth);
+	const int32 ChunkY = VoxelCore::FloorDiv(Block.Y, ChunkWidth);
+	AChunk** Chunk = ChunksByCoordinates.Find(FIntPoint(ChunkX, ChunkY));
+	if (!Chunk || !*Chunk || Block.Z < 0 || Block.Z >= (*Chunk)->HeightOfChunk)
+		return 0;
+
+	const int32 x = Block.X - ChunkX * ChunkWidth + 1;
+	const int32 y = Block.Y - ChunkY * ChunkWidth + 1;
+	return (*Chunk)->GetBlockId(Block.Z + (y * (*Chunk)->HeightOfChunk) + (x * (*Chunk)->HeightOfChunk * (*Chunk)->WidthOfChunkExt));
+}
+
+void AMinecraftWorld::SetBlockAt(const FIntVector& Block, int32 Id)
+{
+	const int32 ChunkX = VoxelCore::FloorDiv(Block.X, ChunkWidth);
+	const int32 ChunkY = VoxelCore::FloorDiv(Block.Y, ChunkWidth);
+	const int32 x = Block.X - ChunkX * ChunkWidth + 1;
+	const int32 y = Block.Y - ChunkY * ChunkWidth + 1;
+	SetBlockInChunk(ChunkX, ChunkY, x, y, Block.Z, Id);
+
+	// Neighbours keep a copy of the blocks along their border, as in BreakOrAddBlock.
+	if (x == ChunkWidth)
+		SetBlockInChunk(ChunkX + 1, ChunkY, 0, y, Block.Z, Id);
+	else if (x == 1)
+		SetBlockInChunk(ChunkX - 1, ChunkY, ChunkWidth + 1, y, Block.Z, Id);
+
+	if (y == ChunkWidth)
+		SetBlockInChunk(ChunkX, ChunkY + 1, x, 0, Block.Z, Id);
+	else if (y == 1)
+		SetBlockInChunk(ChunkX, ChunkY - 1, x, ChunkWidth + 1, Block.Z, Id);
+
+	Lighting.OnBlockChanged(Block);
+	if (!bReplicatedClient)
+		Navigation.MarkBlockChanged(Block);
+	OnBlockChanged.Broadcast(Block, Id);
+}
+
+void AMinecraftWorld::SetBlockInChunk(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, int32 Id)
+{
+	AChunk** Chunk = ChunksByCoordinates.Find(FIntPoint(ChunkX, ChunkY));
+	if (!Chunk || !*Chunk)
+		return;
+
+	(*Chunk)->SetBlockDeferred(x, y, z, Id);
+	ChunksToRemesh.Add(*Chunk);
+	if (!bReplicatedClient)
+		RecordBlockEdit(ChunkX, ChunkY, x, y, z, Id);
+}
+
+void AMinecraftWorld::ForgetChunk(const FString& ChunkName)
+{
+	int32 ChunkX, ChunkY;
+	if (!ParseChunkName(ChunkName, ChunkX, ChunkY))
+		return;
+
+	AChunk* Chunk = nullptr;
+	if (ChunksByCoordinates.RemoveAndCopyValue(FIntPoint(ChunkX, ChunkY), Chunk))
+		ChunksToRemesh.Remove(Chunk);
+	BlockTicks.RemoveChunk(ChunkX, ChunkY);
+	Fluids.RemoveChunk(ChunkX, ChunkY);
+	Navigation.RemoveChunk(ChunkX, ChunkY);
+}
+
+void AMinecraftWorld::RecordBlockEdit(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, int32 id)
+{
+	FBlockEditRecord Record;
+	Record.ChunkX = ChunkX;
+	Record.ChunkY = ChunkY;
+	Record.BlockX = (uint8)x;
+	Record.BlockY = (uint8)y;
+	Record.BlockZ = (uint16)z;
+	Record.Id = id;
+	EditJournal.Append(Record);
+
+	DirtyChunks.Add(BuildChunkName(FVector(ChunkX, ChunkY, -16.0)), FPlatformTime::Seconds());
+}
+
+void AMinecraftWorld::ReplayEditJournal()
+{
+	// Anything still in the journal was edited after its chunk was last saved. Those edits are
+	// applied when the chunk is next built, and stay in the journal until the chunk is saved.
+	FString JournalPath = FPaths::Combine(WorldDirectory, FString("Edits.journal"));
+	TArray<FBlockEditRecord> Records;
+	FEditJournal::ReadAll(JournalPath, Records);
+
+	PendingJournalEdits.Empty();
+	for (const FBlockEditRecord& Record : Records)
+	{
+		FString chunkName = BuildChunkName(FVector(Record.ChunkX, Record.ChunkY, -16.0));
+		PendingJournalEdits.FindOrAdd(chunkName).Add(Record);
+	}
+
+	if (Records.Num() > 0)
+		UE_LOG(LogTemp, Warning, TEXT("Recovering %d block edits in %d chunks from the edit journal."), Records.Num(), PendingJournalEdits.Num());
+
+	// Rewriting also drops a record that was cut short by a crash.
+	EditJournal.Open(JournalPath);
+	EditJournal.Rewrite(Records);
+}
+
+bool AMinecraftWorld::SaveChunkNow(const FString& ChunkName)
+{
+	if (AChunk** Found = Chunks.Find(ChunkName))
+	{
+		AChunk* Chunk = *Found;
+		if (!Chunk->NeedsSaving)
+			return true;
+
+		const double SaveStart = FPlatformTime::Seconds();
+		if (!SaveGameInstance->SaveChunkToFile(FPaths::Combine(WorldDirectory, ChunkName), Chunk->ChunkData))
+			return false;
+		Chunk->NeedsSaving = false;
+		TraceChunk(EStreamingTraceEvent::ChunkSaved, ChunkName, FPlatformTime::Seconds() - SaveStart);
+		return true;
+	}
+
+	// Unloaded chunks are either cached or were already written when they left the cache.
+	return ChunkCache.FlushEntry(ChunkName);
+}
+
+bool AMinecraftWorld::SavePendingJournalEdits(const FString& ChunkName, const TArray<FBlockEditRecord>& Edits)
+{
+	if (Edits.Num() == 0 || Chunks.Contains(ChunkName))
+		return true;
+
+	const int32 HeightOfChunk = GetDefault<AChunk>()->HeightOfChunk;
+	const int32 WidthOfChunkExt = ChunkWidth + 2;
+	TArray<FChunk_Block_Properties> ChunkData;
+	ChunkData.SetNum(WidthOfChunkExt * WidthOfChunkExt * HeightOfChunk);
+
+	const FString Path = FPaths::Combine(WorldDirectory, ChunkName);
+	if (SaveGameInstance->CheckIfFileExists(WorldDirectory, ChunkName))
+	{
+		if (!SaveGameInstance->LoadChunkFromFile(Path, ChunkData))
+			return false;
 	}
 	else
-		Chunk = Chunks[chunkName];
+	{
+		FChunkGenerator Generator(seed, ChunkWidth, HeightOfChunk);
+		Generator.TerrainVersion = SaveGameInstance->TerrainVersion;
+		Generator.Biomes = BiomeMap.Get();
+		Generator.HeightTiles = HeightTiles.Get();
+		Generator.Generate(Edits[0].ChunkX, Edits[0].ChunkY, ChunkData);
+	}
+
+	// Same layout as AChunk::ApplyBlockEdits.
+	for (const FBlockEditRecord& Edit : Edits)
+	{
+		const int32 Index = Edit.BlockZ + (Edit.BlockY * HeightOfChunk) + (Edit.BlockX * HeightOfChunk * WidthOfChunkExt);
+		if (Index >= 0 && Index < ChunkData.Num())
+			ChunkData[Index].id = Edit.Id;
+	}
 
+	const double SaveStart = FPlatformTime::Seconds();
+	if (!SaveGameInstance->SaveChunkToFile(Path, ChunkData))
+		return false;
+	TraceChunk(EStreamingTraceEvent::ChunkSaved, ChunkName, FPlatformTime::Seconds() - SaveStart);
+	return true;
+}
+
+void AMinecraftWorld::RunAutosave()
+{
+	TRADECRAFT_SCOPE_CYCLE(Autosave);
+
+	EditJournal.Flush();
+
+	if (DirtyChunks.Num() > 0)
+	{
+		const double Now = FPlatformTime::Seconds();
+		const double Deadline = Now + AutosaveBudgetMs / 1000.0;
+		int32 Saved = 0;
+
+		for (auto It = DirtyChunks.CreateIterator(); It; ++It)
+		{
+			if (Saved >= AutosaveMaxChunksPerTick || FPlatformTime::Seconds() > Deadline)
+				break;
+
+			if (Now - It.Value() < AutosaveDelaySeconds)
+				continue;
+
+			if (SaveChunkNow(It.Key()))
+				It.RemoveCurrent();
+			Saved++;
+		}
+	}
+
+	// Recovered edits to chunks the player hasn't come back to go straight to their files, so
+	// they don't hold the journal back for the rest of the session.
+	if (DirtyChunks.Num() == 0)
+	{
+		const double Deadline = FPlatformTime::Seconds() + AutosaveBudgetMs / 1000.0;
+		int32 Saved = 0;
+		for (auto It = PendingJournalEdits.CreateIterator(); It; ++It)
+		{
+			if (Saved >= AutosaveMaxChunksPerTick || FPlatformTime::Seconds() > Deadline)
+				break;
+
+			if (SavePendingJournalEdits(It.Key(), It.Value()))
+				It.RemoveCurrent();
+			Saved++;
+		}
+	}
+
+	// Once every journaled edit is on disk, only the not yet replayed ones need to stay.
+	int32 NumPending = 0;
+	for (const auto& Elem : PendingJournalEdits)
+		NumPending += Elem.Value.Num();
+
+	if (DirtyChunks.Num() == 0 && EditJournal.GetNumRecords() > NumPending)
+	{
+		TArray<FBlockEditRecord> Pending;
+		Pending.Reserve(NumPending);
+		for (const auto& Elem : PendingJournalEdits)
+			Pending.Append(Elem.Value);
+		EditJournal.Rewrite(Pending);
+	}
+}
+
+FChunkMemoryUsage AMinecraftWorld::GetMemoryUsage() const
+{
+	FChunkMemoryUsage Usage;
+	for (const auto& Elem : Chunks)
+	{
+		if (Elem.Value)
+			Elem.Value->GetMemoryUsage(Usage);
+	}
+	Usage[EChunkMemoryTag::BlockData] += Fluids.GetAllocatedSize();
+	Usage[EChunkMemoryTag::ChunkCache] = ChunkCache.GetBytesInUse();
+	if (HeightTiles.IsValid())
+		Usage[EChunkMemoryTag::HeightTiles] = HeightTiles->GetNumCachedTiles() * (int64)sizeof(FHeightTile);
+	return Usage;
+}
+
+void AMinecraftWorld::EnforceMemoryBudget()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastMemoryCheckTime < MemoryCheckIntervalSeconds)
+		return;
+	LastMemoryCheckTime = Now;
+
+	const FChunkMemoryUsage Usage = GetMemoryUsage();
+	SET_MEMORY_STAT(STAT_Tradecraft_BlockDataMemory, Usage[EChunkMemoryTag::BlockData]);
+	SET_MEMORY_STAT(STAT_Tradecraft_MeshSectionMemory, Usage[EChunkMemoryTag::MeshSections]);
+	SET_MEMORY_STAT(STAT_Tradecraft_RenderDataMemory, Usage[EChunkMemoryTag::RenderData]);
+	SET_MEMORY_STAT(STAT_Tradecraft_CollisionMemory, Usage[EChunkMemoryTag::Collision]);
+	SET_MEMORY_STAT(STAT_Tradecraft_ChunkCacheMemory, Usage[EChunkMemoryTag::ChunkCache]);
+	SET_MEMORY_STAT(STAT_Tradecraft_HeightTileMemory, Usage[EChunkMemoryTag::HeightTiles]);
+
+	if (WorldMemoryBudgetMB <= 0 || !Player)
+	{
+		MemoryLimitedRange = 0;
+		return;
+	}
+
+	const int64 Budget = (int64)WorldMemoryBudgetMB * 1024 * 1024;
+	int64 Total = Usage.GetTotal();
+	const FVector ChunkPos = GetChunkPosition(Player->GetActorLocation());
+
+	if (Total <= Budget)
+	{
+		// Streaming comes back a ring at a time, with some headroom so it doesn't bounce on the limit.
+		if (MemoryLimitedRange > 0 && Total < Budget * 8 / 10)
+		{
+			MemoryLimitedRange++;
+			if (MemoryLimitedRange >= ChunkRange)
+				MemoryLimitedRange = 0;
+			QueueChunksNear(ChunkPos, ChunkRange);
+		}
+		return;
+	}
+
+	// Cached saves are the cheapest to lose: the dirty ones are written out on the way.
+	const int64 CacheBytes = ChunkCache.GetBytesInUse();
+	ChunkCache.Trim(FMath::Max<int64>(0, CacheBytes - (Total - Budget)));
+	Total -= CacheBytes - ChunkCache.GetBytesInUse();
+
+	if (Total > Budget && HeightTiles.IsValid())
+	{
+		Total -= Usage[EChunkMemoryTag::HeightTiles];
+		HeightTiles->Empty();
+	}
+
+	if (Total <= Budget)
+		return;
+
+	// Then whole chunks, farthest from every player first.
+	const float ChunkSize = ChunkWidth * 100.0f;
+	TArray<TPair<float, FString>> ByDistance;
+	for (const auto& Elem : Chunks)
+	{
+		if (Elem.Value)
+			ByDistance.Add(TPair<float, FString>(GetDistanceToNearestPlayer(Elem.Value->GetActorLocation()) / ChunkSize, Elem.Key));
+	}
+	ByDistance.Sort([](const TPair<float, FString>& A, const TPair<float, FString>& B) { return A.Key > B.Key; });
+
+	int32 Unloaded = 0;
+	for (const TPair<float, FString>& Elem : ByDistance)
+	{
+		if (Total <= Budget || Elem.Key <= MemoryBudgetMinChunkRange)
+			break;
+
+		FChunkMemoryUsage ChunkUsage;
+		Chunks[Elem.Value]->GetMemoryUsage(ChunkUsage);
+		if (!UnloadChunkToDisk(Elem.Value))
+			continue;
+
+		Total -= ChunkUsage.GetTotal();
+		MemoryLimitedRange = FMath::Max(MemoryBudgetMinChunkRange, FMath::FloorToInt(Elem.Key));
+		Unloaded++;
+	}
+
+	if (Unloaded > 0)
+	{
+		QueueChunksNear(ChunkPos, ChunkRange);
+		UE_LOG(LogTemp, Warning, TEXT("Over the %d MB world memory budget: unloaded %d chunks, streaming limited to %d chunks."), WorldMemoryBudgetMB, Unloaded, MemoryLimitedRange);
+	}
+}
+
+bool AMinecraftWorld::UnloadChunkToDisk(const FString& ChunkName)
+{
+	// Written straight to disk rather than into the chunk cache, which is being kept small.
+	if (!SaveChunkNow(ChunkName))
+		return false;
+	DirtyChunks.Remove(ChunkName);
+
+	ForgetChunk(ChunkName);
+	AChunk* Chunk = nullptr;
+	if (Chunks.RemoveAndCopyValue(ChunkName, Chunk) && Chunk)
+	{
+		Chunk->Destroy();
+		TraceChunk(EStreamingTraceEvent::ChunkDestroyed, ChunkName);
+	}
+	return true;
+}
+
+AChunk* AMinecraftWorld::SpawnChunkAt(FVector pos)
+{
+	AChunk* Chunk = GetWorld()->SpawnActor<AChunk>();
 	if (!Chunk)
+		return nullptr;
+
+	FVector ChunkPos = FVector(pos.X * Chunk->WidthOfChunk * Chunk->VoxelWidth, pos.Y * Chunk->WidthOfChunk * Chunk->VoxelWidth, -Chunk->VoxelWidth * (Chunk->HeightOfChunk / 2));
+	Chunk->SetLocation(ChunkPos, seed);
+	Chunk->TerrainVersion = SaveGameInstance ? SaveGameInstance->TerrainVersion : FChunkGenerator::CurrentTerrainVersion;
+	Chunk->Biomes = BiomeMap.Get();
+	Chunk->HeightTiles = HeightTiles.Get();
+	Chunk->SetChunkMaterials(Materials);
+	Chunk->SetBlockHealthValues(Block_Health_Values);
+	Chunk->MakeOwner(this);
+	Chunk->SetCookCollisionAsync(!BuildingSpawnArea);
+	Chunk->Trace = StreamingTrace.IsOpen() ? &StreamingTrace : nullptr;
+	Chunk->LightProperties = bEnableLighting && !bServerChunks ? &Lighting.GetProperties() : nullptr;
+	Chunk->bRenderMesh = !bServerChunks;
+	Chunk->SetWantsCollision(!bServerChunks || IsNearPlayer(FIntPoint((int32)pos.X, (int32)pos.Y)));
+	return Chunk;
+}
+
+void AMinecraftWorld::BuildChunkAt(FVector pos)
+{
+	FString chunkName = AMinecraftWorld::BuildChunkName(pos);
+
+	if (Chunks.Contains(chunkName))
+		return;
+
+	AChunk* Chunk = SpawnChunkAt(pos);
+	if (!Chunk)
+	{
 		UE_LOG(LogTemp, Error, TEXT("CHUNK NOT FOUND OR CREATED!!"));
+		return;
+	}
+
+	// Recently unloaded chunks come back from RAM, then from disk, and are generated otherwise.
+	TArray<uint8> CachedData;
+	bool CachedDirty = false;
+	const double LoadStart = FPlatformTime::Seconds();
+	if (ChunkCache.Take(chunkName, CachedData, CachedDirty) && FChunkCodec::DecodeChunk(CachedData.GetData(), CachedData.Num(), Chunk->ChunkData))
+	{
+		TraceChunk(EStreamingTraceEvent::ChunkLoaded, chunkName, FPlatformTime::Seconds() - LoadStart);
+		// A dirty entry was never written, so the chunk still owes a save.
+		Chunk->NeedsSaving = CachedDirty;
+		TRADECRAFT_INC_COUNTER(ChunksLoaded, 1);
+	}
+	else if (SaveGameInstance->CheckIfFileExists(WorldDirectory, chunkName))
+	{
+		FString PathToSaveData = FPaths::Combine(WorldDirectory, chunkName);
+		SaveGameInstance->LoadChunkFromFile(PathToSaveData, Chunk->ChunkData);
+		TraceChunk(EStreamingTraceEvent::ChunkLoaded, chunkName, FPlatformTime::Seconds() - LoadStart);
+		Chunk->NeedsSaving = false;
+		TRADECRAFT_INC_COUNTER(ChunksLoaded, 1);
+	}
+	else
+	{
+		Chunk->GenerateData();
+	}
+
+	TArray<FBlockEditRecord> RecoveredEdits;
+	if (PendingJournalEdits.RemoveAndCopyValue(chunkName, RecoveredEdits))
+	{
+		Chunk->ApplyBlockEdits(RecoveredEdits);
+		DirtyChunks.Add(chunkName, FPlatformTime::Seconds());
+	}
+
+	CopyBordersFromNeighbours(Chunk, FIntPoint((int32)pos.X, (int32)pos.Y));
+	AddBuiltChunk(Chunk, chunkName, FIntPoint((int32)pos.X, (int32)pos.Y));
+}
+
+void AMinecraftWorld::CopyBordersFromNeighbours(AChunk* Chunk, const FIntPoint& Coordinates)
+{
+	const int32 Height = Chunk->HeightOfChunk;
+	const int32 WidthExt = Chunk->WidthOfChunkExt;
+	auto Index = [Height, WidthExt](int32 x, int32 y) { return (y * Height) + (x * Height * WidthExt); };
+
+	// The border row on each side takes the neighbour's nearest interior row, as in SetBlockAt.
+	struct FSide { FIntPoint Offset; bool bAlongX; int32 Border; int32 Edge; };
+	const FSide Sides[] =
+	{
+		{ FIntPoint(-1, 0), true, 0, ChunkWidth },
+		{ FIntPoint(1, 0), true, ChunkWidth + 1, 1 },
+		{ FIntPoint(0, -1), false, 0, ChunkWidth },
+		{ FIntPoint(0, 1), false, ChunkWidth + 1, 1 },
+	};
+	for (const FSide& Side : Sides)
+	{
+		AChunk* Neighbour = FindChunk(Coordinates + Side.Offset);
+		if (!Neighbour || Neighbour->ChunkData.Num() != Chunk->ChunkData.Num())
+			continue;
+
+		for (int32 i = 1; i <= ChunkWidth; i++)
+		{
+			const int32 To = Side.bAlongX ? Index(Side.Border, i) : Index(i, Side.Border);
+			const int32 From = Side.bAlongX ? Index(Side.Edge, i) : Index(i, Side.Edge);
+			for (int32 z = 0; z < Height; z++)
+				Chunk->ChunkData[To + z].id = Neighbour->ChunkData[From + z].id;
+		}
+	}
+}
+
+void AMinecraftWorld::AddBuiltChunk(AChunk* Chunk, const FString& ChunkName, const FIntPoint& Coordinates)
+{
+	Chunks.Add(ChunkName, Chunk);
+	ChunksByCoordinates.Add(Coordinates, Chunk);
+
+	// Lit and stitched to its neighbours before the first mesh, so it is only meshed once.
+	Chunk->ComputeLight();
+	Lighting.StitchChunk(Coordinates.X, Coordinates.Y);
+	Chunk->GenerateLoadedChunkInWorld();
+
+	// Blocks only tick, and agents only find paths, on the server.
+	if (!bReplicatedClient)
+	{
+		BlockTicks.AddChunk(Coordinates.X, Coordinates.Y, Chunk->ChunkData);
+		Navigation.AddChunk(Coordinates.X, Coordinates.Y);
+	}
 }
 
 void AMinecraftWorld::RemoveOldChunks()
 {
+	TRADECRAFT_SCOPE_CYCLE(RemoveOldChunks);
+
 	removingChunks = true;
 	for (int i = 0; i < ToRemove.Num(); i++)
 	{
@@ -222,16 +1134,24 @@ void AMinecraftWorld::RemoveOldChunks()
 			
 			if (!ChunkToRemove->IsPendingKill())
 			{
-				TArray<int32> ChunkIds;
-				for (int i = 0; i < ChunkToRemove->ChunkData.Num(); i++) 
+				// The cache writes the chunk to disk if it is evicted before it is needed again.
+				TArray<uint8> EncodedData;
+				if (FChunkCodec::EncodeChunk(ChunkToRemove->ChunkData, EncodedData))
+				{
+					ChunkCache.Add(name, MoveTemp(EncodedData), ChunkToRemove->NeedsSaving);
+				}
+				else if (ChunkToRemove->NeedsSaving)
 				{
-					ChunkIds.Add(ChunkToRemove->ChunkData[i].id);
+					FString Path = FPaths::Combine(WorldDirectory, name);
+					const double SaveStart = FPlatformTime::Seconds();
+					if (SaveGameInstance->SaveChunkToFile(Path, ChunkToRemove->ChunkData))
+						TraceChunk(EStreamingTraceEvent::ChunkSaved, name, FPlatformTime::Seconds() - SaveStart);
 				}
-				FString Path = FPaths::Combine(WorldDirectory, name);
-				SaveGameInstance->SaveGameDataToFileCompressed(Path, ChunkIds);
 
+				ForgetChunk(name);
 				Chunks.Remove(name);
 				ChunkToRemove->Destroy();
+				TraceChunk(EStreamingTraceEvent::ChunkDestroyed, name);
 				if (Chunks.Contains(name))
 					UE_LOG(LogTemp, Warning, TEXT("Does chunk still exist? Apparently"));
 			}
@@ -261,8 +1181,7 @@ void AMinecraftWorld::BuildNearPlayer()
 {
 	FVector PlayerPos = Player->GetActorLocation();
 
-	FVector PlayerChunkPos = FVector((int)((PlayerPos.X - 1) / (ChunkWidth * 100)), (int)(PlayerPos.Y / (ChunkWidth * 100)), (int)(PlayerPos.Z / (ChunkWidth * 100)));
-	RecursivelyBuildWorld(PlayerChunkPos, ChunkRange);
+	QueueChunksNear(GetChunkPosition(PlayerPos), ChunkRange);
 
 	if (!removingChunks)
 	{
@@ -271,13 +1190,9 @@ void AMinecraftWorld::BuildNearPlayer()
 			FString chunkName = Elem.Key;
 
 			AChunk* Chunk = Elem.Value;
-			FVector PlayerPos = Player->GetActorLocation();
-			FVector ChunkPos = Chunk->GetActorLocation();
 
-			float xVal = (PlayerPos.X - ChunkPos.X) * (PlayerPos.X - ChunkPos.X);
-			float yVal = (PlayerPos.Y - ChunkPos.Y) * (PlayerPos.Y - ChunkPos.Y);
-
-			if (FMath::Sqrt(xVal + yVal) > ((ChunkRange * Chunk->WidthOfChunk * 100)))
+			// Other players keep the chunks around them loaded too.
+			if (GetDistanceToNearestPlayer(Chunk->GetActorLocation()) > ((ChunkRange * Chunk->WidthOfChunk * 100)))
 			{
 				ToRemove.Add(chunkName);
 			}
@@ -287,6 +1202,94 @@ void AMinecraftWorld::BuildNearPlayer()
 	}
 }
 
+FVector AMinecraftWorld::GetChunkPosition(FVector WorldPos) const
+{
+	return FVector((int)((WorldPos.X - 1) / (ChunkWidth * 100)), (int)(WorldPos.Y / (ChunkWidth * 100)), (int)(WorldPos.Z / (ChunkWidth * 100)));
+}
+
+void AMinecraftWorld::BuildSpawnArea(FVector ChunkPos)
+{
+	BuildingSpawnArea = true;
+	for (int32 x = ChunkPos.X - SpawnAreaRings; x <= ChunkPos.X + SpawnAreaRings; x++)
+	{
+		for (int32 y = ChunkPos.Y - SpawnAreaRings; y <= ChunkPos.Y + SpawnAreaRings; y++)
+		{
+			FVector pos = FVector(x, y, -16);
+			BuildChunkAt(pos);
+
+			// Later edits to these chunks can cook in the background like everywhere else.
+			AChunk** Chunk = Chunks.Find(BuildChunkName(pos));
+			if (Chunk && *Chunk)
+				(*Chunk)->SetCookCollisionAsync(true);
+		}
+	}
+	BuildingSpawnArea = false;
+}
+
+void AMinecraftWorld::QueueChunksNear(FVector pos, int32 radius)
+{
+	// Covers the same square as RecursivelyBuildWorld.
+	int32 NXRange = pos.X - (radius / 2);
+	int32 NYRange = pos.Y - (radius / 2);
+
+	PendingChunkBuilds.Reset();
+	for (int32 x = NXRange; x < NXRange + radius; x++)
+	{
+		for (int32 y = NYRange; y < NYRange + radius; y++)
+		{
+			if (MemoryLimitedRange > 0 && FVector2D(x - pos.X, y - pos.Y).Size() > MemoryLimitedRange)
+				continue;
+
+			if (!Chunks.Contains(BuildChunkName(FVector(x, y, -16))))
+			{
+				PendingChunkBuilds.Add(FIntPoint(x, y));
+				StreamingTrace.RecordChunk(EStreamingTraceEvent::ChunkRequested, x, y);
+			}
+		}
+	}
+
+	const FIntPoint Center((int32)pos.X, (int32)pos.Y);
+	PendingChunkBuilds.Sort([Center](const FIntPoint& A, const FIntPoint& B)
+	{
+		return (A - Center).SizeSquared() > (B - Center).SizeSquared();
+	});
+}
+
+void AMinecraftWorld::BuildPendingChunks()
+{
+	if (PendingChunkBuilds.Num() == 0 && RemoteChunkRequests.Num() == 0)
+		return;
+
+	TRADECRAFT_SCOPE_CYCLE(BuildPendingChunks);
+
+	const double Deadline = FPlatformTime::Seconds() + ChunkBuildBudgetMs / 1000.0;
+	const float UnloadDistance = ChunkRange * ChunkWidth * 100.0f;
+	int32 Built = 0;
+	bool bRemoteTurn = false;
+	while ((PendingChunkBuilds.Num() > 0 || RemoteChunkRequests.Num() > 0) && Built < MaxChunkBuildsPerTick)
+	{
+		if (Built > 0 && FPlatformTime::Seconds() > Deadline)
+			break;
+
+		// Turns about, so neither this player's nor the remote players' chunks starve.
+		bRemoteTurn = RemoteChunkRequests.Num() > 0 && (!bRemoteTurn || PendingChunkBuilds.Num() == 0);
+		const FIntPoint ChunkPos = bRemoteTurn ? RemoteChunkRequests.Pop(false) : PendingChunkBuilds.Pop(false);
+
+		// A request whose player has moved on would only be unloaded again by BuildNearPlayer.
+		if (bRemoteTurn && GetDistanceToNearestPlayer(FVector(ChunkPos.X, ChunkPos.Y, 0.0f) * ChunkWidth * 100.0f) > UnloadDistance)
+			continue;
+
+		BuildChunkAt(FVector(ChunkPos.X, ChunkPos.Y, -16));
+		Built++;
+	}
+
+	if (PendingChunkBuilds.Num() == 0 && RemoteChunkRequests.Num() == 0 && TimeToFullyBuiltRadius < 0.0f)
+	{
+		TimeToFullyBuiltRadius = (float)(FPlatformTime::Seconds() - StartupTime);
+		UE_LOG(LogTemp, Warning, TEXT("All %d chunks in range built after %.3fs."), Chunks.Num(), TimeToFullyBuiltRadius);
+	}
+}
+
 FString AMinecraftWorld::BuildChunkName(FVector pos)
 {
 	FString name = "";
@@ -294,6 +1297,18 @@ FString AMinecraftWorld::BuildChunkName(FVector pos)
 	return name;
 }
 
+bool AMinecraftWorld::ParseChunkName(const FString& ChunkName, int32& OutX, int32& OutY)
+{
+	TArray<FString> Parts;
+	ChunkName.ParseIntoArray(Parts, TEXT("_"));
+	if (Parts.Num() != 4 || Parts[0] != TEXT("Chunk"))
+		return false;
+
+	OutX = FMath::RoundToInt(FCString::Atof(*Parts[1]));
+	OutY = FMath::RoundToInt(FCString::Atof(*Parts[2]));
+	return true;
+}
+
 int32 AMinecraftWorld::BreakBlock(FVector pos)
 {
 	int32 BlockBroken = BreakOrAddBlock(pos, false, 0);
@@ -345,6 +1360,25 @@ int32 AMinecraftWorld::BreakOrAddBlock(FVector pos, bool addBlock, int32 id)
 	FString name = BuildChunkName(FVector(ChunkCalcX, ChunkCalcY, -16.0));
 	AChunk* HitChunk = nullptr;
 
+	// The server makes the edit and sends it back with everyone else's.
+	if (bReplicatedClient)
+	{
+		const FIntVector WorldBlock(BlockX, BlockY, BlockZ + GetDefault<AChunk>()->HeightOfChunk / 2);
+		const int32 OldId = GetBlockAt(WorldBlock);
+		APlayerController* Controller = GetWorld()->GetFirstPlayerController();
+		UChunkReplicationComponent* Replication = Controller ? Controller->FindComponentByClass<UChunkReplicationComponent>() : nullptr;
+		if (!Replication || !Chunks.Contains(name))
+			return 0;
+
+		const int32 Sequence = NextEditSequence++;
+		Replication->ServerEditBlock(WorldBlock, addBlock ? id : 0, Sequence);
+		if (addBlock || OldId == 0)
+			return 0;
+
+		PendingClientBreaks.Add(Sequence, OldId);
+		return OldId;
+	}
+
 	if (AMinecraftWorld::Chunks.Contains(name))
 	{
 		HitChunk = AMinecraftWorld::Chunks[name];
@@ -355,33 +1389,36 @@ int32 AMinecraftWorld::BreakOrAddBlock(FVector pos, bool addBlock, int32 id)
 		BlockY = FMath::Abs(BlockY - ChunkYIndex) + 1;
 		BlockX = FMath::Abs(BlockX - ChunkXIndex) + 1;
 
-		// This is all the possible chunks I may need to update
-		int32 FrontChunkCalcX = FMath::FloorToFloat(FMath::CeilToFloat(((pos.X + 100) / 100) - 0.5) / ChunkWidth);
-		int32 BackChunkCalcX = FMath::FloorToFloat(FMath::CeilToFloat(((pos.X - 100) / 100) - 0.5) / ChunkWidth);
-		int32 RightChunkCalcY = FMath::FloorToFloat(FMath::CeilToFloat(((pos.Y + 100) / 100) - 0.5) / ChunkWidth);
-		int32 LeftChunkCalcY = FMath::FloorToFloat(FMath::CeilToFloat(((pos.Y - 100) / 100) - 0.5) / ChunkWidth);
-		AChunk* FrontChunk = AMinecraftWorld::Chunks[BuildChunkName(FVector(FrontChunkCalcX, ChunkCalcY, -16.0))];
-		AChunk* BackChunk = AMinecraftWorld::Chunks[BuildChunkName(FVector(BackChunkCalcX, ChunkCalcY, -16.0))];
-		AChunk* RightChunk = AMinecraftWorld::Chunks[BuildChunkName(FVector(ChunkCalcX, RightChunkCalcY, -16.0))];
-		AChunk* LeftChunk = AMinecraftWorld::Chunks[BuildChunkName(FVector(ChunkCalcX, LeftChunkCalcY, -16.0))];
+		const int32 NewId = addBlock ? id : 0;
 
+		// Neighbours keep a copy of the blocks along their border. One that is still queued copies
+		// them when it is built, see CopyBordersFromNeighbours.
 		if (BlockX == ChunkWidth)
-			FrontChunk->BreakBlock(0, BlockY, BlockZ);
+			SetBlockInChunk(ChunkCalcX + 1, ChunkCalcY, 0, BlockY, BlockZ, NewId);
 		else if (BlockX == 1)
-			BackChunk->BreakBlock(ChunkWidth + 1, BlockY, BlockZ);
+			SetBlockInChunk(ChunkCalcX - 1, ChunkCalcY, ChunkWidth + 1, BlockY, BlockZ, NewId);
 
 		if (BlockY == ChunkWidth)
-			RightChunk->BreakBlock(BlockX, 0, BlockZ);
+			SetBlockInChunk(ChunkCalcX, ChunkCalcY + 1, BlockX, 0, BlockZ, NewId);
 		else if (BlockY == 1)
-			LeftChunk->BreakBlock(BlockX, ChunkWidth + 1, BlockZ);
+			SetBlockInChunk(ChunkCalcX, ChunkCalcY - 1, BlockX, ChunkWidth + 1, BlockZ, NewId);
 
-		if (addBlock)
-			HitChunk->AddBlock(BlockX, BlockY, BlockZ, id);
-		else
-		{
-			int32 newId = HitChunk->BreakBlock(BlockX, BlockY, BlockZ);
-			return newId;
-		}
+		RecordBlockEdit(ChunkCalcX, ChunkCalcY, BlockX, BlockY, BlockZ, NewId);
+
+		const FIntVector WorldBlock(ChunkCalcX * ChunkWidth + BlockX - 1, ChunkCalcY * ChunkWidth + BlockY - 1, BlockZ);
+		const int32 OldId = GetBlockAt(WorldBlock);
+
+		// Relit before the edited chunk is meshed; neighbours whose light changed are remeshed
+		// over the next frames.
+		HitChunk->SetBlockDeferred(BlockX, BlockY, BlockZ, NewId);
+		Lighting.OnBlockChanged(WorldBlock);
+		Navigation.MarkBlockChanged(WorldBlock);
+		HitChunk->UpdateMeshIfDirty();
+
+		// Wakes the blocks around the edit, e.g. to let them fall or flow.
+		BlockTicks.NotifyBlockChanged(WorldBlock, OldId, NewId);
+		OnBlockChanged.Broadcast(WorldBlock, NewId);
+		return addBlock ? 0 : OldId;
 	}
 	return 0;
 }
@@ -390,7 +1427,7 @@ int32 AMinecraftWorld::GetTotalHealth(FVector pos)
 {
 	int32 id = GetBlockAtPos(pos);
 
-	if (id != 0)
+	if (id != 0 && Block_Props.IsValidIndex(id))
 	{
 		return Block_Props[id].Current_Health;
 	}
@@ -428,8 +1465,15 @@ int32 AMinecraftWorld::GetBlockAtPos(FVector pos)
 
 void AMinecraftWorld::ExitAndSave(TArray<int32> ItemIds, TArray<int32> ItemCounts)
 {
-	SaveGameInstance->PlayerPosition = Player->GetActorLocation();
-	SaveGameInstance->PlayerRotation = Player->GetActorRotation();
+	// The server owns the world; a client has nothing to save.
+	if (bReplicatedClient)
+		return;
+
+	if (Player)
+	{
+		SaveGameInstance->PlayerPosition = Player->GetActorLocation();
+		SaveGameInstance->PlayerRotation = Player->GetActorRotation();
+	}
 	// TODO figure out a way to save camera rotation
 	//SaveGameInstance->CameraRotation = GetComponentByClass<UCameraComponent>().GetActorRotation();
 	UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->SaveSlotName, SaveGameInstance->UserIndex);
@@ -440,14 +1484,17 @@ void AMinecraftWorld::ExitAndSave(TArray<int32> ItemIds, TArray<int32> ItemCount
 		FString CurrentChunkName = i.Key;
 		FString PathToChunkName = FPaths::Combine(WorldDirectory, CurrentChunkName);
 
-		TArray<int32> ChunkIds;
-		for (int i = 0; i < CurrentChunk->ChunkData.Num(); i++) 
+		const double SaveStart = FPlatformTime::Seconds();
+		if (SaveGameInstance->SaveChunkToFile(PathToChunkName, CurrentChunk->ChunkData))
 		{
-			ChunkIds.Add(CurrentChunk->ChunkData[i].id);
+			CurrentChunk->NeedsSaving = false;
+			TraceChunk(EStreamingTraceEvent::ChunkSaved, CurrentChunkName, FPlatformTime::Seconds() - SaveStart);
 		}
-
-		SaveGameInstance->SaveGameDataToFileCompressed(PathToChunkName, ChunkIds);
 	}
+	ChunkCache.Flush();
+
+	// Everything edited so far is on disk now; the next RunAutosave trims the journal.
+	DirtyChunks.Empty();
 
 	FString PlayerDat = FPaths::Combine(WorldDirectory, FString("Player"));
 	SaveGameInstance->SaveGameDataToFileCompressed(PlayerDat, ItemIds, ItemCounts);
@@ -459,6 +1506,9 @@ TArray<int32> AMinecraftWorld::LoadItemCounts()
 }
 TArray<int32> AMinecraftWorld::LoadItemIds() 
 { 
+	if (bReplicatedClient)
+		return ItemIds;
+
 	FString PlayerDat = FPaths::Combine(WorldDirectory, FString("Player"));
 	UE_LOG(LogTemp, Warning, TEXT("Player Dat path: %s"), *PlayerDat);
 
@@ -467,4 +1517,155 @@ TArray<int32> AMinecraftWorld::LoadItemIds()
 	bool exists = SaveGameInstance->LoadGameDataFromFileCompressed(PlayerDat, ItemIds, ItemCounts);
 
 	return ItemIds;
-}
\ No newline at end of file
+}
+
+static void PrintChunkCacheStats(UWorld* World)
+{
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s"), *It->GetChunkCache().GetStatsString());
+		if (It->GetHeightTiles())
+			UE_LOG(LogTemp, Log, TEXT("%s"), UTF8_TO_TCHAR(It->GetHeightTiles()->GetStatsString().c_str()));
+	}
+}
+
+static FAutoConsoleCommandWithWorld ChunkCacheStatsCommand(
+	TEXT("Tradecraft.ChunkCacheStats"),
+	TEXT("Log the unloaded chunk cache's and height tile cache's sizes and hit/miss counters."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintChunkCacheStats));
+
+static void PrintBiomeAtPlayer(UWorld* World)
+{
+	APlayerController* Controller = World->GetFirstPlayerController();
+	APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		const FBiomeMap* Biomes = It->GetBiomeMap();
+		if (!Biomes || !Pawn)
+			continue;
+
+		const int32 BlockX = FMath::FloorToInt(Pawn->GetActorLocation().X / 100.0f);
+		const int32 BlockY = FMath::FloorToInt(Pawn->GetActorLocation().Y / 100.0f);
+		const FBiomeSample Sample = Biomes->Sample(BlockX, BlockY);
+		UE_LOG(LogTemp, Log, TEXT("Biome at (%d, %d): %s, temperature %.2f, humidity %.2f, %d regions cached"),
+			BlockX, BlockY, ANSI_TO_TCHAR(FBiomeMap::GetBiomeName(Sample.Dominant)), Sample.Temperature, Sample.Humidity, Biomes->GetNumCachedRegions());
+	}
+}
+
+static FAutoConsoleCommandWithWorld BiomeAtPlayerCommand(
+	TEXT("Tradecraft.BiomeAtPlayer"),
+	TEXT("Log the biome and climate under the player."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintBiomeAtPlayer));
+
+static void PrintMemoryReport(UWorld* World)
+{
+	const double MB = 1024.0 * 1024.0;
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		const FChunkMemoryUsage Usage = It->GetMemoryUsage();
+		const int32 NumChunks = It->GetNumLoadedChunks();
+		UE_LOG(LogTemp, Log, TEXT("Voxel world memory: %.2f MB for %d loaded chunks, budget %s, streaming %s"),
+			Usage.GetTotal() / MB, NumChunks,
+			It->WorldMemoryBudgetMB > 0 ? *FString::Printf(TEXT("%d MB"), It->WorldMemoryBudgetMB) : TEXT("none"),
+			It->GetMemoryLimitedRange() > 0 ? *FString::Printf(TEXT("limited to %d chunks"), It->GetMemoryLimitedRange()) : TEXT("unlimited"));
+
+		for (int32 i = 0; i < (int32)EChunkMemoryTag::Num; i++)
+		{
+			const EChunkMemoryTag Tag = (EChunkMemoryTag)i;
+			UE_LOG(LogTemp, Log, TEXT("  %-20s %9.2f MB  %8.1f KB per chunk"), FChunkMemoryUsage::GetTagName(Tag), Usage[Tag] / MB, NumChunks > 0 ? Usage[Tag] / 1024.0 / NumChunks : 0.0);
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorld MemoryReportCommand(
+	TEXT("Tradecraft.MemoryReport"),
+	TEXT("Log how much memory the voxel world uses, by subsystem, against its memory budget."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintMemoryReport));
+
+static void StartStreamingTrace(const TArray<FString>& Args, UWorld* World)
+{
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+		It->StartStreamingTrace(Args.Num() > 0 ? Args[0] : FString());
+}
+
+static void StopStreamingTrace(UWorld* World)
+{
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+		It->StopStreamingTrace();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs StartStreamingTraceCommand(
+	TEXT("Tradecraft.Trace.Start"),
+	TEXT("Tradecraft.Trace.Start [Path]: record the world's chunk streaming events to a trace file for -run=ReplayStreamingTrace."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartStreamingTrace));
+
+static FAutoConsoleCommandWithWorld StopStreamingTraceCommand(
+	TEXT("Tradecraft.Trace.Stop"),
+	TEXT("Close the trace opened by Tradecraft.Trace.Start."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&StopStreamingTrace));
+
+static void PrintBlockTickStats(UWorld* World)
+{
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s"), *It->GetBlockTicks().GetStatsString());
+		UE_LOG(LogTemp, Log, TEXT("Fluids: %d flowing cells, %.1f KB of levels"), It->GetFluids().GetNumFlowingCells(), It->GetFluids().GetAllocatedSize() / 1024.0);
+		UE_LOG(LogTemp, Log, TEXT("Light: %lld cells visited"), It->GetLighting().GetNumCellsVisited());
+	}
+}
+
+static FAutoConsoleCommandWithWorld BlockTickStatsCommand(
+	TEXT("Tradecraft.BlockTickStats"),
+	TEXT("Log the block tick scheduler's queue size, active sections and tick counts, and the number of flowing fluid cells."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintBlockTickStats));
+
+static void PlaceFluid(const TArray<FString>& Args, UWorld* World)
+{
+	APlayerController* Controller = World->GetFirstPlayerController();
+	if (!Controller)
+		return;
+
+	// Three blocks ahead of where the player looks.
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	const FVector Target = ViewLocation + ViewRotation.Vector() * 300.0f;
+	const bool bLava = Args.Num() > 0 && Args[0].Equals(TEXT("Lava"), ESearchCase::IgnoreCase);
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		if (!It->PlaceFluidSource(Target, bLava))
+			UE_LOG(LogTemp, Log, TEXT("Could not place %s: the block is taken or the fluid is left out"), bLava ? TEXT("lava") : TEXT("water"));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PlaceFluidCommand(
+	TEXT("Tradecraft.PlaceFluid"),
+	TEXT("Tradecraft.PlaceFluid [Water|Lava]: place a fluid source three blocks ahead of the player."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&PlaceFluid));
+
+static void PrintPathStats(UWorld* World)
+{
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+		UE_LOG(LogTemp, Log, TEXT("%s"), *It->GetNavigation().GetStatsString());
+}
+
+static FAutoConsoleCommandWithWorld PathStatsCommand(
+	TEXT("Tradecraft.Path.Stats"),
+	TEXT("Log the size of the navigation graph and the cost of path queries and updates so far."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&PrintPathStats));
+
+static void RunPathBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	const int32 NumQueries = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+	const int32 NumUpdates = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+	for (TActorIterator<AMinecraftWorld> It(World); It; ++It)
+	{
+		const FIntPoint Center = It->Player ? It->GetChunkCoordinatesAt(It->Player->GetActorLocation()) : FIntPoint(0, 0);
+		UE_LOG(LogTemp, Log, TEXT("%s"), *It->GetNavigation().RunBenchmark(Center, It->ChunkRange / 2, NumQueries, NumUpdates));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PathBenchmarkCommand(
+	TEXT("Tradecraft.Path.Benchmark"),
+	TEXT("Tradecraft.Path.Benchmark [Queries] [Updates]: time paths between random cells around the player, and graph updates."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunPathBenchmark));
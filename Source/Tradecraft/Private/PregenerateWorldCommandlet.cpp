@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PregenerateWorldCommandlet.h"
+#include "ChunkGenerator.h"
+#include "ChunkMesher.h"
+#include "HeightTileCache.h"
+#include "GameSaverAndLoader.h"
+#include "MinecraftWorld.h"
+#include "Kismet/GameplayStatics.h"
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+UPregenerateWorldCommandlet::UPregenerateWorldCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPregenerateWorldCommandlet::Main(const FString& Params)
+{
+	FString WorldName;
+	int32 Seed = 0;
+	int32 Radius = 8;
+	FParse::Value(*Params, TEXT("World="), WorldName);
+	const bool HasSeed = FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Radius="), Radius);
+	const bool Validate = FParse::Param(*Params, TEXT("Validate"));
+	const bool Overwrite = FParse::Param(*Params, TEXT("Overwrite"));
+
+	// An existing world keeps the seed it was saved with; a new one needs one given.
+	const bool IsExistingWorld = !WorldName.IsEmpty() && UGameplayStatics::DoesSaveGameExist(WorldName, 0);
+	if (WorldName.IsEmpty() || Radius < 0 || (!IsExistingWorld && !HasSeed))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=PregenerateWorld -World=<Name> -Seed=<N> -Radius=<Chunks> [-Validate] [-Overwrite]; -Seed may only be left out for an existing world."));
+		return 1;
+	}
+
+	// Use the same save slots the game does, so the world shows up in the world list.
+	UGameSaverAndLoader* SaveGameInstance = nullptr;
+	if (IsExistingWorld)
+	{
+		SaveGameInstance = Cast<UGameSaverAndLoader>(UGameplayStatics::LoadGameFromSlot(WorldName, 0));
+		if (SaveGameInstance && HasSeed && Seed != SaveGameInstance->SavedSeed)
+			UE_LOG(LogTemp, Warning, TEXT("World %s already exists with seed %d, ignoring -Seed=%d."), *WorldName, SaveGameInstance->SavedSeed, Seed);
+	}
+	else
+	{
+		SaveGameInstance = Cast<UGameSaverAndLoader>(UGameplayStatics::CreateSaveGameObject(UGameSaverAndLoader::StaticClass()));
+		if (SaveGameInstance)
+		{
+			SaveGameInstance->SaveSlotName = WorldName;
+			SaveGameInstance->SavedSeed = Seed;
+			SaveGameInstance->TerrainVersion = FChunkGenerator::CurrentTerrainVersion;
+		}
+	}
+
+	if (!SaveGameInstance)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open the save game for world %s."), *WorldName);
+		return 1;
+	}
+	Seed = SaveGameInstance->SavedSeed;
+
+	const FString WorldDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), FString("SaveGames"), WorldName);
+	if (!SaveGameInstance->VerifyOrCreateDirectory(WorldDirectory))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not create world directory %s."), *WorldDirectory);
+		return 1;
+	}
+
+	FChunkGenerator::PrepareNoise(Seed);
+	FBiomeMap BiomeMap(Seed);
+	FChunkGenerator Generator(Seed);
+	Generator.TerrainVersion = SaveGameInstance->TerrainVersion;
+	Generator.Biomes = &BiomeMap;
+	FHeightTileCache HeightTiles(BiomeMap);
+	Generator.HeightTiles = &HeightTiles;
+
+	// Nearest chunks first, so an interrupted run still leaves a usable area around spawn.
+	TArray<FIntPoint> ChunksToGenerate;
+	for (int32 x = -Radius; x <= Radius; x++)
+	{
+		for (int32 y = -Radius; y <= Radius; y++)
+		{
+			if (x * x + y * y > Radius * Radius)
+				continue;
+
+			if (!Overwrite && SaveGameInstance->CheckIfFileExists(WorldDirectory, AMinecraftWorld::BuildChunkName(FVector(x, y, -16.0))))
+				continue;
+
+			ChunksToGenerate.Add(FIntPoint(x, y));
+		}
+	}
+	ChunksToGenerate.Sort([](const FIntPoint& A, const FIntPoint& B) { return A.SizeSquared() < B.SizeSquared(); });
+
+	UE_LOG(LogTemp, Display, TEXT("Pregenerating %d chunks for world %s (seed %d, radius %d)%s."),
+		ChunksToGenerate.Num(), *WorldName, Seed, Radius, Validate ? TEXT(" with mesh validation") : TEXT(""));
+
+	FThreadSafeCounter NumDone;
+	FThreadSafeCounter NumFailed;
+	const int32 ReportEvery = FMath::Max(ChunksToGenerate.Num() / 20, 1);
+	const double StartTime = FPlatformTime::Seconds();
+
+	ParallelFor(ChunksToGenerate.Num(), [&](int32 Index)
+	{
+		const FIntPoint Chunk = ChunksToGenerate[Index];
+		const FString ChunkName = AMinecraftWorld::BuildChunkName(FVector(Chunk.X, Chunk.Y, -16.0));
+
+		TArray<FChunk_Block_Properties> ChunkData;
+		Generator.Generate(Chunk.X, Chunk.Y, ChunkData);
+
+		bool Succeeded = true;
+		if (Validate)
+		{
+			int32 MaxId = 0;
+			for (const FChunk_Block_Properties& Block : ChunkData)
+				MaxId = FMath::Max(MaxId, Block.id);
+
+			TArray<FMeshSection> Sections;
+			FChunkMesher::BuildMeshSections(ChunkData, Generator.WidthOfChunk, Generator.HeightOfChunk, MaxId + 1, Sections);
+			Succeeded = FChunkMesher::ValidateMeshSections(Sections, ChunkName);
+		}
+
+		if (Succeeded)
+			Succeeded = UGameSaverAndLoader::SaveChunkToFile(FPaths::Combine(WorldDirectory, ChunkName), ChunkData);
+
+		if (!Succeeded)
+			NumFailed.Increment();
+
+		const int32 Done = NumDone.Increment();
+		if (Done % ReportEvery == 0 || Done == ChunksToGenerate.Num())
+		{
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			UE_LOG(LogTemp, Display, TEXT("%d / %d chunks (%.0f%%), %.1f chunks/sec"),
+				Done, ChunksToGenerate.Num(), 100.0 * Done / ChunksToGenerate.Num(), Elapsed > 0.0 ? Done / Elapsed : 0.0);
+		}
+	});
+
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	// Spawn the player on top of the spawn chunk, the same way a loaded world places them.
+	if (!IsExistingWorld)
+	{
+		TArray<FChunk_Block_Properties> SpawnChunk;
+		Generator.Generate(0, 0, SpawnChunk);
+
+		const int32 Center = Generator.WidthOfChunk / 2;
+		int32 SurfaceZ = 0;
+		for (int32 z = Generator.HeightOfChunk - 1; z >= 0; z--)
+		{
+			int32 index = z + ((Center + 1) * Generator.HeightOfChunk) + ((Center + 1) * Generator.WidthOfChunkExt * Generator.HeightOfChunk);
+			if (SpawnChunk[index].id != 0)
+			{
+				SurfaceZ = z;
+				break;
+			}
+		}
+
+		SaveGameInstance->PlayerPosition = FVector(Center * 100.f, Center * 100.f, -100.f * 64 + (SurfaceZ + 3) * 100.f);
+		SaveGameInstance->PlayerRotation = FRotator::ZeroRotator;
+		UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->SaveSlotName, SaveGameInstance->UserIndex);
+
+		UGameSaverAndLoader* SavedGames = nullptr;
+		if (UGameplayStatics::DoesSaveGameExist(TEXT("All_Saved_Games"), 0))
+			SavedGames = Cast<UGameSaverAndLoader>(UGameplayStatics::LoadGameFromSlot(TEXT("All_Saved_Games"), 0));
+		else
+			SavedGames = Cast<UGameSaverAndLoader>(UGameplayStatics::CreateSaveGameObject(UGameSaverAndLoader::StaticClass()));
+
+		if (SavedGames)
+		{
+			SavedGames->AllSavedGames.AddUnique(WorldName);
+			UGameplayStatics::SaveGameToSlot(SavedGames, TEXT("All_Saved_Games"), 0);
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Pregenerated %d chunks in %.2fs (%.1f chunks/sec), %d failed."),
+		ChunksToGenerate.Num(), Elapsed, Elapsed > 0.0 ? ChunksToGenerate.Num() / Elapsed : 0.0, NumFailed.GetValue());
+	UE_LOG(LogTemp, Display, TEXT("%s"), UTF8_TO_TCHAR(HeightTiles.GetStatsString().c_str()));
+
+	return NumFailed.GetValue() == 0 ? 0 : 1;
+}
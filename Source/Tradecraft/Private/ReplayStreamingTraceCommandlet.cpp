@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ReplayStreamingTraceCommandlet.h"
+#include "StreamingTrace.h"
+#include "ChunkGenerator.h"
+#include "ChunkMesher.h"
+#include "ChunkCodec.h"
+#include "HeightTileCache.h"
+#include "GameSaverAndLoader.h"
+#include "MinecraftWorld.h"
+#include "TradecraftStats.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+// Same as the benchmark: one mesh section per block id, independent of the editor's materials.
+static const int32 ReplayNumSections = 8;
+
+static const int32 ReplayWorstFrames = 10;
+
+struct FReplayEventStats
+{
+	int32 Count = 0;
+	double RecordedMs = 0.0;
+	double ReplayMs = 0.0;
+	TArray<float> ReplaySamplesMs;
+};
+
+struct FReplayFrame
+{
+	int32 Index = 0;
+	float RecordedMs = 0.0f;
+	float RecordedWorkMs = 0.0f;
+	float ReplayWorkMs = 0.0f;
+	int32 NumEvents = 0;
+};
+
+template <typename WriterType>
+static void WriteReplayPercentiles(WriterType& Writer, const TCHAR* Prefix, TArray<float>& Values)
+{
+	Values.Sort();
+	Writer->WriteValue(FString::Printf(TEXT("%sP50Ms"), Prefix), FTradecraftFrameStats::GetPercentile(Values, 0.50f));
+	Writer->WriteValue(FString::Printf(TEXT("%sP95Ms"), Prefix), FTradecraftFrameStats::GetPercentile(Values, 0.95f));
+	Writer->WriteValue(FString::Printf(TEXT("%sMaxMs"), Prefix), Values.Num() > 0 ? Values.Last() : 0.0f);
+}
+
+UReplayStreamingTraceCommandlet::UReplayStreamingTraceCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UReplayStreamingTraceCommandlet::Main(const FString& Params)
+{
+	FString TracePath;
+	FString WorldName;
+	FString ReportPath;
+	FParse::Value(*Params, TEXT("Trace="), TracePath);
+	FParse::Value(*Params, TEXT("World="), WorldName);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+	if (TracePath.Len() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=ReplayStreamingTrace -Trace=<Path> [-World=<Name>] [-Report=<Json>]"));
+		return 1;
+	}
+
+	FStreamingTraceHeader Header;
+	TArray<FStreamingTraceEvent> Events;
+	if (!FStreamingTrace::ReadAll(TracePath, Header, Events))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not read streaming trace %s."), *TracePath);
+		return 1;
+	}
+	if (Header.TerrainVersion > FChunkGenerator::CurrentTerrainVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Trace uses terrain version %d, this build only has up to %d."), Header.TerrainVersion, FChunkGenerator::CurrentTerrainVersion);
+		return 1;
+	}
+	if (WorldName.Len() == 0)
+		WorldName = Header.WorldName;
+
+	UE_LOG(LogTemp, Display, TEXT("Replaying %d events from %s: world %s, seed %d, terrain version %d, recorded %s."),
+		Events.Num(), *TracePath, *WorldName, Header.Seed, Header.TerrainVersion, *FDateTime(Header.StartTicks).ToString());
+
+	FChunkGenerator::PrepareNoise(Header.Seed);
+	FBiomeMap BiomeMap(Header.Seed);
+	FHeightTileCache HeightTiles(BiomeMap);
+	FChunkGenerator Generator(Header.Seed);
+	Generator.TerrainVersion = Header.TerrainVersion;
+	Generator.Biomes = &BiomeMap;
+	Generator.HeightTiles = &HeightTiles;
+
+	UGameSaverAndLoader* Saver = GetMutableDefault<UGameSaverAndLoader>();
+	const FString WorldDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), FString("SaveGames"), WorldName);
+	const FString SaveDirectory = FPaths::Combine(FPaths::ProjectIntermediateDir(), FString("ReplayStreamingTrace"));
+	Saver->VerifyOrCreateDirectory(SaveDirectory);
+
+	// The chunks the game had in memory at this point of the trace.
+	TMap<FIntPoint, TArray<FChunk_Block_Properties>> LiveChunks;
+	auto GenerateChunk = [&](const FIntPoint& Coordinates, TArray<FChunk_Block_Properties>& ChunkData)
+	{
+		Generator.Generate(Coordinates.X, Coordinates.Y, ChunkData, nullptr);
+	};
+
+	FReplayEventStats EventStats[(int32)EStreamingTraceEvent::Num];
+	TArray<FReplayFrame> Frames;
+	FReplayFrame Frame;
+	TArray<FMeshSection> Sections;
+	TArray<uint8> EncodedData;
+	int32 NumLoadedFromDisk = 0;
+	int32 NumLoadFailures = 0;
+
+	for (const FStreamingTraceEvent& Event : Events)
+	{
+		if (Event.Type == EStreamingTraceEvent::FrameEnd)
+		{
+			Frame.RecordedMs = Event.DurationUs / 1000.0f;
+			Frames.Add(Frame);
+			Frame = FReplayFrame();
+			Frame.Index = Frames.Num();
+			continue;
+		}
+		if (Event.Type == EStreamingTraceEvent::PlayerPosition)
+			continue;
+
+		const FIntPoint Coordinates(Event.X, Event.Y);
+		const FString ChunkName = AMinecraftWorld::BuildChunkName(FVector(Event.X, Event.Y, -16.0));
+		double ReplaySeconds = 0.0;
+		double StartTime = FPlatformTime::Seconds();
+		switch (Event.Type)
+		{
+		case EStreamingTraceEvent::ChunkGenerated:
+			GenerateChunk(Coordinates, LiveChunks.FindOrAdd(Coordinates));
+			ReplaySeconds = FPlatformTime::Seconds() - StartTime;
+			break;
+
+		case EStreamingTraceEvent::ChunkLoaded:
+		{
+			// Sized like the world's chunks, since the decode will not grow it.
+			TArray<FChunk_Block_Properties>& ChunkData = LiveChunks.FindOrAdd(Coordinates);
+			ChunkData.SetNum((Generator.WidthOfChunk + 2) * (Generator.WidthOfChunk + 2) * Generator.HeightOfChunk);
+			bool bLoaded = false;
+			if (WorldName.Len() > 0 && Saver->CheckIfFileExists(WorldDirectory, ChunkName))
+			{
+				bLoaded = Saver->LoadChunkFromFile(FPaths::Combine(WorldDirectory, ChunkName), ChunkData);
+				if (bLoaded)
+				{
+					ReplaySeconds = FPlatformTime::Seconds() - StartTime;
+					NumLoadedFromDisk++;
+				}
+				else
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Could not load %s from %s, replaying it as a generated chunk."), *ChunkName, *WorldDirectory);
+					NumLoadFailures++;
+				}
+			}
+			if (!bLoaded)
+			{
+				// Only the decode is timed, like a load from the chunk cache.
+				GenerateChunk(Coordinates, ChunkData);
+				FChunkCodec::EncodeChunk(ChunkData, EncodedData);
+				StartTime = FPlatformTime::Seconds();
+				FChunkCodec::DecodeChunk(EncodedData.GetData(), EncodedData.Num(), ChunkData);
+				ReplaySeconds = FPlatformTime::Seconds() - StartTime;
+			}
+			break;
+		}
+
+		case EStreamingTraceEvent::ChunkMeshed:
+		{
+			TArray<FChunk_Block_Properties>* ChunkData = LiveChunks.Find(Coordinates);
+			if (!ChunkData)
+			{
+				// Started recording after this chunk was built.
+				ChunkData = &LiveChunks.Add(Coordinates);
+				GenerateChunk(Coordinates, *ChunkData);
+				StartTime = FPlatformTime::Seconds();
+			}
+			Sections.Reset();
+			FChunkMesher::BuildMeshSections(*ChunkData, Generator.WidthOfChunk, Generator.HeightOfChunk, ReplayNumSections, Sections);
+			ReplaySeconds = FPlatformTime::Seconds() - StartTime;
+			break;
+		}
+
+		case EStreamingTraceEvent::ChunkSaved:
+		{
+			TArray<FChunk_Block_Properties>* ChunkData = LiveChunks.Find(Coordinates);
+			if (!ChunkData)
+			{
+				// Saved from the chunk cache, or built before recording started.
+				ChunkData = &LiveChunks.Add(Coordinates);
+				GenerateChunk(Coordinates, *ChunkData);
+				StartTime = FPlatformTime::Seconds();
+			}
+			Saver->SaveChunkToFile(FPaths::Combine(SaveDirectory, ChunkName), *ChunkData);
+			ReplaySeconds = FPlatformTime::Seconds() - StartTime;
+			break;
+		}
+
+		case EStreamingTraceEvent::ChunkDestroyed:
+			LiveChunks.Remove(Coordinates);
+			break;
+
+		default:
+			break;
+		}
+
+		FReplayEventStats& Stats = EventStats[(int32)Event.Type];
+		Stats.Count++;
+		Stats.RecordedMs += Event.DurationUs / 1000.0;
+		Stats.ReplayMs += ReplaySeconds * 1000.0;
+		Stats.ReplaySamplesMs.Add((float)(ReplaySeconds * 1000.0));
+
+		Frame.RecordedWorkMs += Event.DurationUs / 1000.0f;
+		Frame.ReplayWorkMs += (float)(ReplaySeconds * 1000.0);
+		Frame.NumEvents++;
+	}
+	IFileManager::Get().DeleteDirectory(*SaveDirectory, false, true);
+
+	UE_LOG(LogTemp, Display, TEXT("%-12s %8s %14s %14s %10s %10s %10s"), TEXT("Event"), TEXT("Count"), TEXT("Recorded ms"), TEXT("Replay ms"), TEXT("p50 ms"), TEXT("p95 ms"), TEXT("max ms"));
+	for (int32 i = 0; i < (int32)EStreamingTraceEvent::PlayerPosition; i++)
+	{
+		FReplayEventStats& Stats = EventStats[i];
+		Stats.ReplaySamplesMs.Sort();
+		UE_LOG(LogTemp, Display, TEXT("%-12s %8d %14.2f %14.2f %10.3f %10.3f %10.3f"),
+			FStreamingTrace::GetEventName((EStreamingTraceEvent)i), Stats.Count, Stats.RecordedMs, Stats.ReplayMs,
+			FTradecraftFrameStats::GetPercentile(Stats.ReplaySamplesMs, 0.50f), FTradecraftFrameStats::GetPercentile(Stats.ReplaySamplesMs, 0.95f),
+			Stats.ReplaySamplesMs.Num() > 0 ? Stats.ReplaySamplesMs.Last() : 0.0f);
+	}
+	if (NumLoadedFromDisk < EventStats[(int32)EStreamingTraceEvent::ChunkLoaded].Count)
+		UE_LOG(LogTemp, Display, TEXT("%d of %d loads were replayed as decodes of generated chunks."),
+			EventStats[(int32)EStreamingTraceEvent::ChunkLoaded].Count - NumLoadedFromDisk, EventStats[(int32)EStreamingTraceEvent::ChunkLoaded].Count);
+	if (NumLoadFailures > 0)
+		UE_LOG(LogTemp, Error, TEXT("%d chunk files of %s could not be loaded, so the load timings are not from disk."), NumLoadFailures, *WorldName);
+
+	TArray<float> RecordedFrameMs;
+	TArray<float> ReplayWorkMs;
+	for (const FReplayFrame& Each : Frames)
+	{
+		RecordedFrameMs.Add(Each.RecordedMs);
+		ReplayWorkMs.Add(Each.ReplayWorkMs);
+	}
+	RecordedFrameMs.Sort();
+	ReplayWorkMs.Sort();
+	UE_LOG(LogTemp, Display, TEXT("%d frames. Recorded frame ms p50 %.2f, p95 %.2f, max %.2f; replayed streaming work per frame p50 %.2f, p95 %.2f, max %.2f."),
+		Frames.Num(), FTradecraftFrameStats::GetPercentile(RecordedFrameMs, 0.50f), FTradecraftFrameStats::GetPercentile(RecordedFrameMs, 0.95f), RecordedFrameMs.Num() > 0 ? RecordedFrameMs.Last() : 0.0f,
+		FTradecraftFrameStats::GetPercentile(ReplayWorkMs, 0.50f), FTradecraftFrameStats::GetPercentile(ReplayWorkMs, 0.95f), ReplayWorkMs.Num() > 0 ? ReplayWorkMs.Last() : 0.0f);
+
+	TArray<FReplayFrame> WorstFrames = Frames;
+	WorstFrames.Sort([](const FReplayFrame& A, const FReplayFrame& B) { return A.RecordedMs > B.RecordedMs; });
+	WorstFrames.SetNum(FMath::Min(WorstFrames.Num(), ReplayWorstFrames));
+	for (const FReplayFrame& Each : WorstFrames)
+		UE_LOG(LogTemp, Display, TEXT("  Frame %6d: %7.2f ms recorded, %7.2f ms recorded streaming work, %7.2f ms replayed, %d events"),
+			Each.Index, Each.RecordedMs, Each.RecordedWorkMs, Each.ReplayWorkMs, Each.NumEvents);
+
+	if (ReportPath.Len() == 0)
+		return NumLoadFailures > 0 ? 1 : 0;
+
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Trace"), TracePath);
+	Writer->WriteValue(TEXT("World"), WorldName);
+	Writer->WriteValue(TEXT("Seed"), Header.Seed);
+	Writer->WriteValue(TEXT("TerrainVersion"), Header.TerrainVersion);
+	Writer->WriteValue(TEXT("Recorded"), FDateTime(Header.StartTicks).ToIso8601());
+	Writer->WriteValue(TEXT("LoadedFromDisk"), NumLoadedFromDisk);
+	Writer->WriteValue(TEXT("LoadFailures"), NumLoadFailures);
+
+	Writer->WriteArrayStart(TEXT("Events"));
+	for (int32 i = 0; i < (int32)EStreamingTraceEvent::PlayerPosition; i++)
+	{
+		FReplayEventStats& Stats = EventStats[i];
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Name"), FString(FStreamingTrace::GetEventName((EStreamingTraceEvent)i)));
+		Writer->WriteValue(TEXT("Count"), Stats.Count);
+		Writer->WriteValue(TEXT("RecordedMs"), Stats.RecordedMs);
+		Writer->WriteValue(TEXT("ReplayMs"), Stats.ReplayMs);
+		WriteReplayPercentiles(Writer, TEXT("Replay"), Stats.ReplaySamplesMs);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectStart(TEXT("Frames"));
+	Writer->WriteValue(TEXT("Count"), Frames.Num());
+	WriteReplayPercentiles(Writer, TEXT("Recorded"), RecordedFrameMs);
+	WriteReplayPercentiles(Writer, TEXT("ReplayWork"), ReplayWorkMs);
+	Writer->WriteArrayStart(TEXT("Worst"));
+	for (const FReplayFrame& Each : WorstFrames)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Frame"), Each.Index);
+		Writer->WriteValue(TEXT("RecordedMs"), Each.RecordedMs);
+		Writer->WriteValue(TEXT("RecordedWorkMs"), Each.RecordedWorkMs);
+		Writer->WriteValue(TEXT("ReplayWorkMs"), Each.ReplayWorkMs);
+		Writer->WriteValue(TEXT("Events"), Each.NumEvents);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(Json, *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not write %s."), *ReportPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Replay report written to %s."), *ReportPath);
+	return NumLoadFailures > 0 ? 1 : 0;
+}
@@ -2,13 +2,14 @@
 
 #include "SimplexNoiseLibrary.h"
 #include "Tradecraft.h"
+#include "VoxelCore/SimplexNoise.h"
 
 
 // USimplexNoiseLibrary
 #define FASTFLOOR(x) ( ((x)>0) ? ((int)x) : (((int)x)-1) )
 
 
-unsigned char USimplexNoiseLibrary::perm[512] = { 151,160,137,91,90,15,
+unsigned char USimplexNoiseLibrary::perm[512 + 3] = { 151,160,137,91,90,15,
 131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
 190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
 88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
@@ -38,19 +39,9 @@ unsigned char USimplexNoiseLibrary::perm[512] = { 151,160,137,91,90,15,
 
 void USimplexNoiseLibrary::setNoiseSeed(const int32& newSeed)
 {
-	TArray<bool> availableSeeds;
-	availableSeeds.Init(true, 256);
-	FMath::RandInit(newSeed);
-	for (uint16 it = 0; it < 256; ++it)
-	{
-		uint8 nextNum;
-		do
-		{
-			nextNum = FMath::RandRange(0, 255);
-		} while (!availableSeeds[nextNum]);
-		USimplexNoiseLibrary::perm[it] = (unsigned char)nextNum;
-		USimplexNoiseLibrary::perm[it + 256] = (unsigned char)nextNum;
-	}
+	// The voxel core owns the shuffle, so batched and scalar noise always agree on the table.
+	VoxelCore::SimplexNoise::SetSeed(newSeed);
+	FMemory::Memcpy(USimplexNoiseLibrary::perm, VoxelCore::SimplexNoise::GetPermutationTable(), 512);
 }
 
 static unsigned char simplex[64][4] = {
@@ -123,7 +114,6 @@ int USimplexNoiseLibrary::GenerateHeight(int32 x, int32 y, int oct, float pers,
 	float result = total / maxValue;
 
 	result *= maxHeight;
-	UE_LOG(LogTemp, Warning, TEXT("Result: %d"), (int)result);
 	return (int)result;
 }
 
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SimplexNoiseSIMD.h"
+#include "SimplexNoiseLibrary.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+static int32 GNoiseMaxISA = 2;
+
+static void OnNoiseMaxISAChanged(IConsoleVariable* Variable)
+{
+	VoxelCore::SimplexNoise::SetMaxISA((ESimplexNoiseISA)FMath::Clamp(GNoiseMaxISA, 0, 2));
+}
+
+static FAutoConsoleVariableRef CVarNoiseMaxISA(
+	TEXT("Tradecraft.Noise.MaxISA"),
+	GNoiseMaxISA,
+	TEXT("Widest instruction set used for batched simplex noise: 0 = scalar, 1 = SSE2, 2 = AVX2."),
+	FConsoleVariableDelegate::CreateStatic(&OnNoiseMaxISAChanged));
+
+bool FSimplexNoiseSIMD::IsSupported(ESimplexNoiseISA ISA)
+{
+	return VoxelCore::SimplexNoise::IsSupported(ISA);
+}
+
+ESimplexNoiseISA FSimplexNoiseSIMD::GetActiveISA()
+{
+	return VoxelCore::SimplexNoise::GetActiveISA();
+}
+
+const TCHAR* FSimplexNoiseSIMD::GetISAName(ESimplexNoiseISA ISA)
+{
+	switch (ISA)
+	{
+	case ESimplexNoiseISA::SSE2: return TEXT("SSE2");
+	case ESimplexNoiseISA::AVX2: return TEXT("AVX2");
+	default: return TEXT("Scalar");
+	}
+}
+
+int32 FSimplexNoiseSIMD::GetWidth(ESimplexNoiseISA ISA)
+{
+	return VoxelCore::SimplexNoise::GetWidth(ISA);
+}
+
+void FSimplexNoiseSIMD::Noise2D(const float* X, const float* Y, float* Out, int32 Count)
+{
+	VoxelCore::SimplexNoise::Noise2D(X, Y, Out, Count);
+}
+
+void FSimplexNoiseSIMD::Noise3D(const float* X, const float* Y, const float* Z, float* Out, int32 Count)
+{
+	VoxelCore::SimplexNoise::Noise3D(X, Y, Z, Out, Count);
+}
+
+void FSimplexNoiseSIMD::Noise2D(ESimplexNoiseISA ISA, const float* X, const float* Y, float* Out, int32 Count)
+{
+	VoxelCore::SimplexNoise::Noise2D(ISA, X, Y, Out, Count);
+}
+
+void FSimplexNoiseSIMD::Noise3D(ESimplexNoiseISA ISA, const float* X, const float* Y, const float* Z, float* Out, int32 Count)
+{
+	VoxelCore::SimplexNoise::Noise3D(ISA, X, Y, Z, Out, Count);
+}
+
+static void BenchmarkNoiseSIMD(const TArray<FString>& Args)
+{
+	const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 64) : 1 << 20;
+	const float Tolerance = 1e-5f;
+
+	// Terrain-like coordinates, including negatives and exact integers where FASTFLOOR differs from floor.
+	FRandomStream Random(1234);
+	TArray<float> X, Y, Z, Reference, Result;
+	X.SetNumUninitialized(NumPoints);
+	Y.SetNumUninitialized(NumPoints);
+	Z.SetNumUninitialized(NumPoints);
+	Reference.SetNumUninitialized(NumPoints);
+	Result.SetNumUninitialized(NumPoints);
+	for (int32 i = 0; i < NumPoints; i++)
+	{
+		const bool OnLattice = (i % 16) == 0;
+		X[i] = OnLattice ? (float)Random.RandRange(-300, 300) : Random.FRandRange(-300.0f, 300.0f);
+		Y[i] = OnLattice ? (float)Random.RandRange(-300, 300) : Random.FRandRange(-300.0f, 300.0f);
+		Z[i] = Random.FRandRange(-2.0f, 2.0f);
+	}
+
+	bool AllPassed = true;
+	for (int32 Dimensions = 2; Dimensions <= 3; Dimensions++)
+	{
+		for (int32 i = 0; i < NumPoints; i++)
+			Reference[i] = Dimensions == 2 ? USimplexNoiseLibrary::SimplexNoise2D(X[i], Y[i]) : USimplexNoiseLibrary::SimplexNoise3D(X[i], Y[i], Z[i]);
+
+		for (ESimplexNoiseISA ISA : { ESimplexNoiseISA::Scalar, ESimplexNoiseISA::SSE2, ESimplexNoiseISA::AVX2 })
+		{
+			if (!FSimplexNoiseSIMD::IsSupported(ISA))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%dD %s: not supported on this CPU"), Dimensions, FSimplexNoiseSIMD::GetISAName(ISA));
+				continue;
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+			if (Dimensions == 2)
+				FSimplexNoiseSIMD::Noise2D(ISA, X.GetData(), Y.GetData(), Result.GetData(), NumPoints);
+			else
+				FSimplexNoiseSIMD::Noise3D(ISA, X.GetData(), Y.GetData(), Z.GetData(), Result.GetData(), NumPoints);
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+			float MaxError = 0.0f;
+			int32 NumExact = 0;
+			for (int32 i = 0; i < NumPoints; i++)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Result[i] - Reference[i]));
+				NumExact += Result[i] == Reference[i] ? 1 : 0;
+			}
+
+			const bool Passed = MaxError <= Tolerance;
+			AllPassed &= Passed;
+			UE_LOG(LogTemp, Warning, TEXT("%dD %s: %.1f Mpoints/sec, max error %g, %d/%d exact, %s"),
+				Dimensions, FSimplexNoiseSIMD::GetISAName(ISA), Elapsed > 0.0 ? NumPoints / Elapsed / 1e6 : 0.0,
+				MaxError, NumExact, NumPoints, Passed ? TEXT("PASS") : TEXT("FAIL"));
+		}
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("Batched noise uses %s. Self-check %s."),
+		FSimplexNoiseSIMD::GetISAName(FSimplexNoiseSIMD::GetActiveISA()), AllPassed ? TEXT("passed") : TEXT("FAILED"));
+}
+
+static FAutoConsoleCommand BenchmarkNoiseSIMDCommand(
+	TEXT("Tradecraft.BenchmarkNoise"),
+	TEXT("Tradecraft.BenchmarkNoise [Points]: check every batched simplex noise path against the scalar functions and report points/sec."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkNoiseSIMD));
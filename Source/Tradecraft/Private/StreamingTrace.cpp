@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StreamingTrace.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryReader.h"
+#include "VoxelCore/RunLength.h"
+
+using namespace VoxelCore::RunLength;
+
+FStreamingTrace::~FStreamingTrace()
+{
+	Close();
+}
+
+bool FStreamingTrace::Open(const FString& InPath, const FStreamingTraceHeader& Header)
+{
+	Close();
+	Path = InPath;
+
+	Writer = IFileManager::Get().CreateFileWriter(*Path);
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not open streaming trace %s"), *Path);
+		return false;
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	FStreamingTraceHeader Copy = Header;
+	*Writer << FileMagic;
+	*Writer << FileVersion;
+	*Writer << Copy.Seed;
+	*Writer << Copy.TerrainVersion;
+	*Writer << Copy.WidthOfChunk;
+	*Writer << Copy.HeightOfChunk;
+	*Writer << Copy.StartTicks;
+	*Writer << Copy.WorldName;
+	Writer->Flush();
+
+	StartTime = FPlatformTime::Seconds();
+	LastTimeUs = 0;
+	Buffer.Reset();
+	return true;
+}
+
+void FStreamingTrace::Close()
+{
+	if (Writer)
+	{
+		Flush();
+		Writer->Close();
+		delete Writer;
+		Writer = nullptr;
+	}
+}
+
+void FStreamingTrace::Record(EStreamingTraceEvent Type, int32 X, int32 Y, int32 Z, double DurationSeconds)
+{
+	if (!Writer)
+		return;
+
+	const uint64 TimeUs = (uint64)((FPlatformTime::Seconds() - StartTime) * 1000000.0);
+	const uint64 DeltaUs = TimeUs - LastTimeUs;
+	LastTimeUs = TimeUs;
+
+	auto PutByte = [this](uint8 Byte) { Buffer.Add(Byte); };
+	PutByte((uint8)Type);
+	WriteVarUInt(PutByte, (uint32)FMath::Min<uint64>(DeltaUs, MAX_uint32));
+	WriteVarUInt(PutByte, ZigZag(X));
+	WriteVarUInt(PutByte, ZigZag(Y));
+	WriteVarUInt(PutByte, ZigZag(Z));
+	WriteVarUInt(PutByte, (uint32)FMath::Clamp(DurationSeconds * 1000000.0, 0.0, (double)MAX_uint32));
+}
+
+void FStreamingTrace::Flush()
+{
+	if (Writer && Buffer.Num() > 0)
+	{
+		Writer->Serialize(Buffer.GetData(), Buffer.Num());
+		Writer->Flush();
+		Buffer.Reset();
+	}
+}
+
+bool FStreamingTrace::ReadAll(const FString& InPath, FStreamingTraceHeader& OutHeader, TArray<FStreamingTraceEvent>& OutEvents)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *InPath))
+		return false;
+
+	FMemoryReader Reader(Data);
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	if (Data.Num() >= 8)
+	{
+		Reader << FileMagic;
+		Reader << FileVersion;
+	}
+	const bool IsValid = FileMagic == Magic && FileVersion == Version;
+	if (IsValid)
+	{
+		Reader << OutHeader.Seed;
+		Reader << OutHeader.TerrainVersion;
+		Reader << OutHeader.WidthOfChunk;
+		Reader << OutHeader.HeightOfChunk;
+		Reader << OutHeader.StartTicks;
+		Reader << OutHeader.WorldName;
+	}
+	const int64 EventsOffset = Reader.Tell();
+	const bool IsHeaderComplete = !Reader.IsError();
+
+	if (!IsValid || !IsHeaderComplete)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Streaming trace %s has an invalid header."), *InPath);
+		return false;
+	}
+
+	const uint8* Cursor = Data.GetData() + EventsOffset;
+	const uint8* End = Data.GetData() + Data.Num();
+	uint64 TimeUs = 0;
+	while (Cursor < End)
+	{
+		const uint8 Type = *Cursor++;
+		uint32 DeltaUs, X, Y, Z, DurationUs;
+		if (Type >= (uint8)EStreamingTraceEvent::Num
+			|| !ReadVarUInt(Cursor, End, DeltaUs) || !ReadVarUInt(Cursor, End, X) || !ReadVarUInt(Cursor, End, Y)
+			|| !ReadVarUInt(Cursor, End, Z) || !ReadVarUInt(Cursor, End, DurationUs))
+			break;
+
+		TimeUs += DeltaUs;
+		FStreamingTraceEvent& Event = OutEvents[OutEvents.AddDefaulted()];
+		Event.Type = (EStreamingTraceEvent)Type;
+		Event.TimeUs = TimeUs;
+		Event.X = UnZigZag(X);
+		Event.Y = UnZigZag(Y);
+		Event.Z = UnZigZag(Z);
+		Event.DurationUs = DurationUs;
+	}
+	return true;
+}
+
+const TCHAR* FStreamingTrace::GetEventName(EStreamingTraceEvent Type)
+{
+	switch (Type)
+	{
+	case EStreamingTraceEvent::ChunkRequested: return TEXT("Requested");
+	case EStreamingTraceEvent::ChunkGenerated: return TEXT("Generated");
+	case EStreamingTraceEvent::ChunkLoaded: return TEXT("Loaded");
+	case EStreamingTraceEvent::ChunkMeshed: return TEXT("Meshed");
+	case EStreamingTraceEvent::ChunkUploaded: return TEXT("Uploaded");
+	case EStreamingTraceEvent::ChunkSaved: return TEXT("Saved");
+	case EStreamingTraceEvent::ChunkDestroyed: return TEXT("Destroyed");
+	case EStreamingTraceEvent::PlayerPosition: return TEXT("PlayerPosition");
+	case EStreamingTraceEvent::FrameEnd: return TEXT("FrameEnd");
+	default: return TEXT("Unknown");
+	}
+}
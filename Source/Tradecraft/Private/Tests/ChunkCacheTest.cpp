@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ChunkCache.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTradecraftChunkCacheWriteFailureTest, "Tradecraft.ChunkCache.WriteFailure", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+bool FTradecraftChunkCacheWriteFailureTest::RunTest(const FString& Parameters)
+{
+	bool bDiskFull = true;
+	TArray<FString> Written;
+	FChunkCache Cache;
+	Cache.SetWriter([&](const FString& ChunkName, const TArray<uint8>& EncodedData)
+	{
+		if (bDiskFull)
+			return false;
+		Written.Add(ChunkName);
+		return true;
+	});
+	Cache.SetBudget(64 * 1024 * 1024, 2);
+
+	auto MakeData = [](uint8 Value) { TArray<uint8> Data; Data.Init(Value, 32); return Data; };
+	Cache.Add(TEXT("Chunk_0_0"), MakeData(1), true);
+	Cache.Add(TEXT("Chunk_1_0"), MakeData(2), false);
+	Cache.Add(TEXT("Chunk_2_0"), MakeData(3), false);
+
+	// The dirty oldest entry can't be written, so nothing is evicted past it.
+	TestTrue(TEXT("Dirty entry kept after a failed write"), Cache.Contains(TEXT("Chunk_0_0")));
+	TestEqual(TEXT("Eviction stops at the failed entry"), Cache.Num(), 3);
+	TestEqual(TEXT("Write failures"), Cache.GetWriteFailures(), 1);
+
+	Cache.Trim(0);
+	TestTrue(TEXT("Dirty entry kept after trimming"), Cache.Contains(TEXT("Chunk_0_0")));
+
+	Cache.Empty();
+	TestEqual(TEXT("Only the dirty entry survives Empty"), Cache.Num(), 1);
+
+	// Once writes succeed the edits reach the writer and the entry goes.
+	bDiskFull = false;
+	Cache.Trim(0);
+	TestEqual(TEXT("Entry written once the writer recovers"), Written.Num(), 1);
+	TestEqual(TEXT("Cache empty after the write"), Cache.Num(), 0);
+
+	TArray<uint8> Data;
+	bool bDirty = false;
+	TestFalse(TEXT("Entry gone after eviction"), Cache.Take(TEXT("Chunk_0_0"), Data, bDirty));
+	return true;
+}
+
+#endif
@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MinecraftWorld.h"
+#include "TradecraftStats.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GenericPlatform/GenericPlatformMemory.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProperties.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A fixed seed in a world of its own, which is deleted and created again on every run.
+static const int32 FlythroughSeed = 1337;
+static const TCHAR* FlythroughWorldName = TEXT("TradecraftFlythrough");
+static const TCHAR* FlythroughMap = TEXT("/Game/Maps/PlayGame");
+
+static const double FlythroughLoadTimeout = 60.0;
+static const double FlythroughWarmupTimeout = 120.0;
+static const double FlythroughDrainTimeout = 60.0;
+static const double FlythroughMemorySampleInterval = 0.5;
+
+struct FFlythroughLeg
+{
+	const TCHAR* Name;
+	float Speed;
+	FVector2D Direction;
+	int32 Chunks;
+	float Altitude;
+};
+
+// Streaming only depends on where the pawn is horizontally, so walking and sprinting keep the
+// spawn height and differ in speed alone. Speeds are Minecraft's, in cm/s.
+static const FFlythroughLeg FlythroughLegs[] =
+{
+	{ TEXT("Walk"), 430.0f, FVector2D(1.0f, 0.0f), 6, 0.0f },
+	{ TEXT("Sprint"), 560.0f, FVector2D(0.0f, 1.0f), 8, 0.0f },
+	{ TEXT("Fly"), 1100.0f, FVector2D(-0.7071068f, 0.7071068f), 16, 3000.0f },
+};
+
+struct FFlythroughLegResult
+{
+	TArray<float> FrameMs;
+	int32 MaxBacklog = 0;
+	double Seconds = 0.0;
+};
+
+static UWorld* FindGameWorld()
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World())
+			return Context.World();
+	}
+	return nullptr;
+}
+
+// Keeps the test world out of the main menu's list of saved games.
+static void RemoveFromSavedGames()
+{
+	if (UGameplayStatics::DoesSaveGameExist(TEXT("All_Saved_Games"), 0))
+	{
+		UGameSaverAndLoader* SavedGames = Cast<UGameSaverAndLoader>(UGameplayStatics::LoadGameFromSlot(TEXT("All_Saved_Games"), 0));
+		if (SavedGames && SavedGames->AllSavedGames.Remove(FlythroughWorldName) > 0)
+			UGameplayStatics::SaveGameToSlot(SavedGames, TEXT("All_Saved_Games"), 0);
+	}
+}
+
+static void DeleteFlythroughWorld()
+{
+	UGameplayStatics::DeleteGameInSlot(FlythroughWorldName, 0);
+	IFileManager::Get().DeleteDirectory(*FPaths::Combine(FPaths::ProjectSavedDir(), FString("SaveGames"), FString(FlythroughWorldName)), false, true);
+	RemoveFromSavedGames();
+}
+
+template <typename WriterType>
+static void WriteFrameTimes(WriterType& Writer, TArray<float> FrameMs)
+{
+	FrameMs.Sort();
+	double Total = 0.0;
+	for (float Ms : FrameMs)
+		Total += Ms;
+
+	Writer->WriteValue(TEXT("Frames"), FrameMs.Num());
+	Writer->WriteValue(TEXT("MeanMs"), FrameMs.Num() > 0 ? Total / FrameMs.Num() : 0.0);
+	Writer->WriteValue(TEXT("P50Ms"), FTradecraftFrameStats::GetPercentile(FrameMs, 0.50f));
+	Writer->WriteValue(TEXT("P95Ms"), FTradecraftFrameStats::GetPercentile(FrameMs, 0.95f));
+	Writer->WriteValue(TEXT("P99Ms"), FTradecraftFrameStats::GetPercentile(FrameMs, 0.99f));
+	Writer->WriteValue(TEXT("MaxMs"), FrameMs.Num() > 0 ? FrameMs.Last() : 0.0f);
+}
+
+/**
+ * Drives the player along FlythroughLegs once the world has built its starting area, recording
+ * every frame's time, the chunk build backlog and memory, then writes the JSON report.
+ */
+class FTradecraftFlythroughCommand : public IAutomationLatentCommand
+{
+public:
+	explicit FTradecraftFlythroughCommand(FAutomationTestBase* InTest)
+		: Test(InTest)
+	{
+	}
+
+	virtual bool Update() override
+	{
+		const double Now = FPlatformTime::Seconds();
+		const double FrameSeconds = LastFrameTime > 0.0 ? Now - LastFrameTime : 0.0;
+		LastFrameTime = Now;
+		if (PhaseStartTime == 0.0)
+			PhaseStartTime = Now;
+
+		switch (Phase)
+		{
+		case EPhase::FindWorld:
+			return UpdateFindWorld(Now);
+		case EPhase::Warmup:
+			if (World->GetNumPendingChunkBuilds() == 0 || Now - PhaseStartTime > FlythroughWarmupTimeout)
+			{
+				WarmupSeconds = Now - PhaseStartTime;
+				StartPhase(EPhase::Fly, Now);
+				bSmoothFrameRate = GEngine->bSmoothFrameRate;
+				GEngine->bSmoothFrameRate = false;
+			}
+			return false;
+		case EPhase::Fly:
+			return UpdateFly(Now, FrameSeconds);
+		case EPhase::Drain:
+			SampleMemory(Now);
+			if (World->GetNumPendingChunkBuilds() == 0 || Now - PhaseStartTime > FlythroughDrainTimeout)
+			{
+				DrainSeconds = Now - PhaseStartTime;
+				BacklogAfterDrain = World->GetNumPendingChunkBuilds();
+				GEngine->bSmoothFrameRate = bSmoothFrameRate;
+				WriteReport();
+				return true;
+			}
+			return false;
+		}
+		return true;
+	}
+
+private:
+	enum class EPhase : uint8
+	{
+		FindWorld,
+		Warmup,
+		Fly,
+		Drain
+	};
+
+	void StartPhase(EPhase NewPhase, double Now)
+	{
+		Phase = NewPhase;
+		PhaseStartTime = Now;
+	}
+
+	bool UpdateFindWorld(double Now)
+	{
+		if (UWorld* GameWorld = FindGameWorld())
+		{
+			for (TActorIterator<AMinecraftWorld> It(GameWorld); It; ++It)
+			{
+				if (It->IsWorldLoaded() && It->Player)
+					World = *It;
+			}
+		}
+
+		if (!World)
+		{
+			if (Now - PhaseStartTime > FlythroughLoadTimeout)
+			{
+				Test->AddError(FString::Printf(TEXT("No Minecraft World finished loading in %s within %.0fs."), FlythroughMap, FlythroughLoadTimeout));
+				return true;
+			}
+			return false;
+		}
+
+		if (World->seed != FlythroughSeed)
+			Test->AddWarning(FString::Printf(TEXT("World has seed %d instead of %d; results won't compare with other runs."), World->seed, FlythroughSeed));
+		RemoveFromSavedGames();
+
+		// The path moves the pawn directly, so keep its movement component from adding gravity.
+		if (ACharacter* Character = Cast<ACharacter>(World->Player))
+			Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+
+		const FVector Start = World->Player->GetActorLocation();
+		LegStart = FVector2D(Start.X, Start.Y);
+		BaseHeight = Start.Z;
+		StartPhase(EPhase::Warmup, Now);
+		return false;
+	}
+
+	bool UpdateFly(double Now, double FrameSeconds)
+	{
+		const FFlythroughLeg& Leg = FlythroughLegs[LegIndex];
+		FFlythroughLegResult& Result = LegResults[LegIndex];
+
+		if (FrameSeconds > 0.0)
+			Result.FrameMs.Add((float)(FrameSeconds * 1000.0));
+		Result.MaxBacklog = FMath::Max(Result.MaxBacklog, World->GetNumPendingChunkBuilds());
+		SampleMemory(Now);
+
+		const float LegLength = Leg.Chunks * 16.0f * 100.0f;
+		LegDistance = FMath::Min(LegDistance + Leg.Speed * (float)FrameSeconds, LegLength);
+		const FVector2D Position = LegStart + Leg.Direction * LegDistance;
+		World->Player->SetActorLocation(FVector(Position.X, Position.Y, BaseHeight + Leg.Altitude), false, nullptr, ETeleportType::TeleportPhysics);
+		if (ACharacter* Character = Cast<ACharacter>(World->Player))
+			Character->GetCharacterMovement()->Velocity = FVector::ZeroVector;
+
+		if (LegDistance >= LegLength)
+		{
+			Result.Seconds = Now - PhaseStartTime;
+			LegStart = Position;
+			LegDistance = 0.0f;
+			if (++LegIndex == (int32)ARRAY_COUNT(FlythroughLegs))
+				StartPhase(EPhase::Drain, Now);
+			else
+				PhaseStartTime = Now;
+		}
+		return false;
+	}
+
+	void SampleMemory(double Now)
+	{
+		if (Now - LastMemorySampleTime < FlythroughMemorySampleInterval)
+			return;
+		LastMemorySampleTime = Now;
+		const FPlatformMemoryStats Stats = FPlatformMemory::GetStats();
+		MaxUsedPhysical = FMath::Max<uint64>(MaxUsedPhysical, Stats.UsedPhysical);
+		MaxUsedVirtual = FMath::Max<uint64>(MaxUsedVirtual, Stats.UsedVirtual);
+	}
+
+	void WriteReport()
+	{
+		const FPlatformMemoryStats Stats = FPlatformMemory::GetStats();
+		const double MB = 1024.0 * 1024.0;
+
+		FString Json;
+		TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Test"), FString(TEXT("Flythrough")));
+		Writer->WriteValue(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+		Writer->WriteValue(TEXT("Platform"), FString(FPlatformProperties::IniPlatformName()));
+		Writer->WriteValue(TEXT("BuildConfiguration"), FString(EBuildConfigurations::ToString(FApp::GetBuildConfiguration())));
+		Writer->WriteValue(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+		Writer->WriteValue(TEXT("Seed"), World->seed);
+		Writer->WriteValue(TEXT("ChunkRange"), World->ChunkRange);
+		Writer->WriteValue(TEXT("ChunkBuildBudgetMs"), World->ChunkBuildBudgetMs);
+		Writer->WriteValue(TEXT("WarmupSeconds"), WarmupSeconds);
+
+		TArray<float> AllFrameMs;
+		int32 MaxBacklog = 0;
+		Writer->WriteArrayStart(TEXT("Legs"));
+		for (int32 i = 0; i < (int32)ARRAY_COUNT(FlythroughLegs); i++)
+		{
+			const FFlythroughLegResult& Result = LegResults[i];
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("Name"), FString(FlythroughLegs[i].Name));
+			Writer->WriteValue(TEXT("Speed"), FlythroughLegs[i].Speed);
+			Writer->WriteValue(TEXT("Chunks"), FlythroughLegs[i].Chunks);
+			Writer->WriteValue(TEXT("Seconds"), Result.Seconds);
+			WriteFrameTimes(Writer, Result.FrameMs);
+			Writer->WriteValue(TEXT("MaxBacklog"), Result.MaxBacklog);
+			Writer->WriteObjectEnd();
+
+			AllFrameMs.Append(Result.FrameMs);
+			MaxBacklog = FMath::Max(MaxBacklog, Result.MaxBacklog);
+		}
+		Writer->WriteArrayEnd();
+
+		Writer->WriteObjectStart(TEXT("Overall"));
+		WriteFrameTimes(Writer, AllFrameMs);
+		Writer->WriteValue(TEXT("MaxBacklog"), MaxBacklog);
+		Writer->WriteValue(TEXT("DrainSeconds"), DrainSeconds);
+		Writer->WriteValue(TEXT("BacklogAfterDrain"), BacklogAfterDrain);
+		Writer->WriteValue(TEXT("LoadedChunks"), World->GetNumLoadedChunks());
+		Writer->WriteValue(TEXT("MaxUsedPhysicalMB"), MaxUsedPhysical / MB);
+		Writer->WriteValue(TEXT("MaxUsedVirtualMB"), MaxUsedVirtual / MB);
+		Writer->WriteValue(TEXT("PeakUsedPhysicalMB"), Stats.PeakUsedPhysical / MB);
+		Writer->WriteValue(TEXT("PeakUsedVirtualMB"), Stats.PeakUsedVirtual / MB);
+		Writer->WriteObjectEnd();
+
+		Writer->WriteObjectEnd();
+		Writer->Close();
+
+		FString ReportPath;
+		if (!FParse::Value(FCommandLine::Get(), TEXT("FlythroughReport="), ReportPath))
+			ReportPath = FPaths::Combine(FPaths::AutomationDir(), TEXT("Tradecraft"), FString::Printf(TEXT("Flythrough-%s.json"), *FDateTime::Now().ToString()));
+
+		if (FFileHelper::SaveStringToFile(Json, *ReportPath))
+			Test->AddInfo(FString::Printf(TEXT("Flythrough report written to %s"), *ReportPath));
+		else
+			Test->AddError(FString::Printf(TEXT("Could not write %s"), *ReportPath));
+
+		AllFrameMs.Sort();
+		Test->AddInfo(FString::Printf(TEXT("Frame ms p50 %.2f, p95 %.2f, p99 %.2f, max %.2f; max backlog %d, drained in %.2fs; max used physical %.0fMB"),
+			FTradecraftFrameStats::GetPercentile(AllFrameMs, 0.50f), FTradecraftFrameStats::GetPercentile(AllFrameMs, 0.95f), FTradecraftFrameStats::GetPercentile(AllFrameMs, 0.99f), AllFrameMs.Num() > 0 ? AllFrameMs.Last() : 0.0f,
+			MaxBacklog, DrainSeconds, MaxUsedPhysical / MB));
+	}
+
+	FAutomationTestBase* Test;
+	EPhase Phase = EPhase::FindWorld;
+	AMinecraftWorld* World = nullptr;
+
+	double LastFrameTime = 0.0;
+	double PhaseStartTime = 0.0;
+	double LastMemorySampleTime = 0.0;
+	bool bSmoothFrameRate = false;
+
+	int32 LegIndex = 0;
+	float LegDistance = 0.0f;
+	FVector2D LegStart;
+	float BaseHeight = 0.0f;
+	FFlythroughLegResult LegResults[ARRAY_COUNT(FlythroughLegs)];
+
+	double WarmupSeconds = 0.0;
+	double DrainSeconds = 0.0;
+	int32 BacklogAfterDrain = 0;
+	uint64 MaxUsedPhysical = 0;
+	uint64 MaxUsedVirtual = 0;
+};
+
+/**
+ * Headless streaming benchmark: opens PlayGame on a fresh world with a fixed seed, walks, sprints
+ * and flies across a few dozen chunk borders and writes frame time percentiles, the chunk build
+ * backlog and memory to Saved/Automation/Tradecraft/Flythrough-<date>.json (or -FlythroughReport=).
+ *
+ * UE4Editor Tradecraft.uproject -game -nullrhi -unattended -ExecCmds="Automation RunTests Tradecraft.Performance.Flythrough; Quit"
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTradecraftFlythroughTest, "Tradecraft.Performance.Flythrough", EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FTradecraftFlythroughTest::RunTest(const FString& Parameters)
+{
+	DeleteFlythroughWorld();
+	AutomationOpenMap(FString::Printf(TEXT("%s?TradecraftWorld=%s?TradecraftSeed=%d"), FlythroughMap, FlythroughWorldName, FlythroughSeed));
+	ADD_LATENT_AUTOMATION_COMMAND(FTradecraftFlythroughCommand(this));
+	return true;
+}
+
+#endif
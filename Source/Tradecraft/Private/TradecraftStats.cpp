@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TradecraftStats.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+DEFINE_STAT(STAT_Tradecraft_BuildPendingChunks);
+DEFINE_STAT(STAT_Tradecraft_RemoveOldChunks);
+DEFINE_STAT(STAT_Tradecraft_Autosave);
+DEFINE_STAT(STAT_Tradecraft_GenerateData);
+DEFINE_STAT(STAT_Tradecraft_UpdateMesh);
+DEFINE_STAT(STAT_Tradecraft_BuildMeshSections);
+DEFINE_STAT(STAT_Tradecraft_CreateMeshSection);
+DEFINE_STAT(STAT_Tradecraft_CookCollisionSync);
+DEFINE_STAT(STAT_Tradecraft_EncodeChunk);
+DEFINE_STAT(STAT_Tradecraft_DecodeChunk);
+DEFINE_STAT(STAT_Tradecraft_WriteChunkFile);
+DEFINE_STAT(STAT_Tradecraft_ReadChunkFile);
+DEFINE_STAT(STAT_Tradecraft_BlockTicks);
+DEFINE_STAT(STAT_Tradecraft_ComputeLight);
+DEFINE_STAT(STAT_Tradecraft_UpdateLight);
+DEFINE_STAT(STAT_Tradecraft_FindPath);
+DEFINE_STAT(STAT_Tradecraft_UpdateNavigation);
+
+DEFINE_STAT(STAT_Tradecraft_GenerateNoise);
+DEFINE_STAT(STAT_Tradecraft_GenerateFill);
+DEFINE_STAT(STAT_Tradecraft_GenerateTrees);
+
+DEFINE_STAT(STAT_Tradecraft_ChunksGenerated);
+DEFINE_STAT(STAT_Tradecraft_ChunksLoaded);
+DEFINE_STAT(STAT_Tradecraft_ChunksSaved);
+DEFINE_STAT(STAT_Tradecraft_ChunksMeshed);
+DEFINE_STAT(STAT_Tradecraft_VerticesEmitted);
+DEFINE_STAT(STAT_Tradecraft_TrianglesEmitted);
+DEFINE_STAT(STAT_Tradecraft_BytesWritten);
+DEFINE_STAT(STAT_Tradecraft_BlockTicksRun);
+DEFINE_STAT(STAT_Tradecraft_LightCellsVisited);
+DEFINE_STAT(STAT_Tradecraft_BytesReplicated);
+DEFINE_STAT(STAT_Tradecraft_PathNodesExpanded);
+
+DEFINE_STAT(STAT_Tradecraft_BlockDataMemory);
+DEFINE_STAT(STAT_Tradecraft_MeshSectionMemory);
+DEFINE_STAT(STAT_Tradecraft_RenderDataMemory);
+DEFINE_STAT(STAT_Tradecraft_CollisionMemory);
+DEFINE_STAT(STAT_Tradecraft_ChunkCacheMemory);
+DEFINE_STAT(STAT_Tradecraft_HeightTileMemory);
+
+static const TCHAR* GStatNames[] =
+{
+	TEXT("BuildPendingChunksMs"),
+	TEXT("RemoveOldChunksMs"),
+	TEXT("AutosaveMs"),
+	TEXT("GenerateDataMs"),
+	TEXT("GenerateNoiseMs"),
+	TEXT("GenerateFillMs"),
+	TEXT("GenerateTreesMs"),
+	TEXT("UpdateMeshMs"),
+	TEXT("BuildMeshSectionsMs"),
+	TEXT("CreateMeshSectionMs"),
+	TEXT("CookCollisionSyncMs"),
+	TEXT("EncodeChunkMs"),
+	TEXT("DecodeChunkMs"),
+	TEXT("WriteChunkFileMs"),
+	TEXT("ReadChunkFileMs"),
+	TEXT("BlockTicksMs"),
+	TEXT("ComputeLightMs"),
+	TEXT("UpdateLightMs"),
+	TEXT("FindPathMs"),
+	TEXT("UpdateNavigationMs"),
+
+	TEXT("ChunksGenerated"),
+	TEXT("ChunksLoaded"),
+	TEXT("ChunksSaved"),
+	TEXT("ChunksMeshed"),
+	TEXT("VerticesEmitted"),
+	TEXT("TrianglesEmitted"),
+	TEXT("BytesWritten"),
+	TEXT("BlockTicksRun"),
+	TEXT("LightCellsVisited"),
+	TEXT("BytesReplicated"),
+	TEXT("PathNodesExpanded"),
+};
+static_assert(ARRAY_COUNT(GStatNames) == (int32)ETradecraftStat::Num, "Every Tradecraft stat needs a CSV column.");
+
+// Times are kept in cycles while the frame runs.
+static const ETradecraftStat FirstCountStat = ETradecraftStat::ChunksGenerated;
+
+static FThreadSafeCounter64 GFrameValues[(int32)ETradecraftStat::Num];
+static FArchive* GCsvWriter = nullptr;
+static FDelegateHandle GEndFrameHandle;
+
+FThreadSafeBool FTradecraftFrameStats::bRecording(false);
+
+bool FTradecraftFrameStats::StartCsv(const FString& Path)
+{
+	check(IsInGameThread());
+	StopCsv();
+
+	const FString CsvPath = Path.Len() > 0 ? Path : FPaths::Combine(FPaths::ProfilingDir(), FString::Printf(TEXT("TradecraftStats-%s.csv"), *FDateTime::Now().ToString()));
+	GCsvWriter = IFileManager::Get().CreateFileWriter(*CsvPath);
+	if (!GCsvWriter)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not open stats file %s"), *CsvPath);
+		return false;
+	}
+
+	FString Header = TEXT("Frame,FrameMs");
+	for (int32 i = 0; i < (int32)ETradecraftStat::Num; i++)
+		Header += FString::Printf(TEXT(",%s"), GStatNames[i]);
+	Header += TEXT("\n");
+	FTCHARToUTF8 Utf8(*Header);
+	GCsvWriter->Serialize((void*)Utf8.Get(), Utf8.Length());
+
+	for (FThreadSafeCounter64& Value : GFrameValues)
+		Value.Reset();
+
+	GEndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FTradecraftFrameStats::WriteFrame);
+	bRecording = true;
+	UE_LOG(LogTemp, Log, TEXT("Recording Tradecraft stats to %s"), *CsvPath);
+	return true;
+}
+
+void FTradecraftFrameStats::StopCsv()
+{
+	check(IsInGameThread());
+	if (!GCsvWriter)
+		return;
+
+	bRecording = false;
+	FCoreDelegates::OnEndFrame.Remove(GEndFrameHandle);
+	GCsvWriter->Close();
+	delete GCsvWriter;
+	GCsvWriter = nullptr;
+	UE_LOG(LogTemp, Log, TEXT("Stopped recording Tradecraft stats."));
+}
+
+void FTradecraftFrameStats::Add(ETradecraftStat Stat, int64 Amount)
+{
+	if (bRecording)
+		GFrameValues[(int32)Stat].Add(Amount);
+}
+
+void FTradecraftFrameStats::AddSeconds(ETradecraftStat Stat, double Seconds)
+{
+	if (bRecording)
+		GFrameValues[(int32)Stat].Add((int64)(Seconds / FPlatformTime::GetSecondsPerCycle64()));
+}
+
+const TCHAR* FTradecraftFrameStats::GetStatName(ETradecraftStat Stat)
+{
+	return Stat < ETradecraftStat::Num ? GStatNames[(int32)Stat] : TEXT("");
+}
+
+void FTradecraftFrameStats::WriteFrame()
+{
+	if (!GCsvWriter)
+		return;
+
+	FString Row = FString::Printf(TEXT("%llu,%.3f"), (uint64)GFrameCounter, FApp::GetDeltaTime() * 1000.0);
+	for (int32 i = 0; i < (int32)ETradecraftStat::Num; i++)
+	{
+		const int64 Value = GFrameValues[i].Reset();
+		if (i < (int32)FirstCountStat)
+			Row += FString::Printf(TEXT(",%.3f"), Value * FPlatformTime::GetSecondsPerCycle64() * 1000.0);
+		else
+			Row += FString::Printf(TEXT(",%lld"), Value);
+	}
+	Row += TEXT("\n");
+
+	FTCHARToUTF8 Utf8(*Row);
+	GCsvWriter->Serialize((void*)Utf8.Get(), Utf8.Length());
+}
+
+static void StartStatsCsv(const TArray<FString>& Args)
+{
+	FTradecraftFrameStats::StartCsv(Args.Num() > 0 ? Args[0] : FString());
+}
+
+static void StopStatsCsv()
+{
+	FTradecraftFrameStats::StopCsv();
+}
+
+static FAutoConsoleCommand StartStatsCsvCommand(
+	TEXT("Tradecraft.StatsCsv.Start"),
+	TEXT("Tradecraft.StatsCsv.Start [Path]: write the Tradecraft stats to a CSV file, one row per frame."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StartStatsCsv));
+
+static FAutoConsoleCommand StopStatsCsvCommand(
+	TEXT("Tradecraft.StatsCsv.Stop"),
+	TEXT("Close the file opened by Tradecraft.StatsCsv.Start."),
+	FConsoleCommandDelegate::CreateStatic(&StopStatsCsv));
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/BiomeMap.h"
+#include "VoxelCore/FractalNoise.h"
+
+namespace VoxelCore
+{
+
+// Where each biome sits in (temperature, humidity) space. Climate values stay roughly within [-1, 1].
+static const float BiomeClimateCenters[(int32_t)BiomeType::Count][2] =
+{
+	{ 0.1f, -0.05f },	// Plains
+	{ 0.0f, 0.45f },	// Forest
+	{ 0.45f, -0.4f },	// Desert
+	{ -0.45f, 0.0f }	// Mountains
+};
+
+// How far past the nearest biome's center another biome may be and still get some weight.
+static const float BiomeBlendWidth = 0.12f;
+
+static BiomeSettings MakeBiomeSettings(float HeightScale, float HeightOffset, BlockId TopBlock, BlockId FillerBlock, int32_t RockLine, float TreeChance)
+{
+	BiomeSettings Settings;
+	Settings.HeightScale = HeightScale;
+	Settings.HeightOffset = HeightOffset;
+	Settings.TopBlock = TopBlock;
+	Settings.FillerBlock = FillerBlock;
+	Settings.RockLine = RockLine;
+	Settings.TreeChance = TreeChance;
+	return Settings;
+}
+
+// There are no sand or snow blocks yet, so deserts are bare dirt and mountain tops bare stone.
+static const BiomeSettings AllBiomeSettings[(int32_t)BiomeType::Count] =
+{
+	MakeBiomeSettings(0.5f, 0.0f, Blocks::Grass, Blocks::Dirt, INT32_MAX, 0.01f),	// Plains
+	MakeBiomeSettings(1.0f, 2.0f, Blocks::Grass, Blocks::Dirt, INT32_MAX, 0.12f),	// Forest
+	MakeBiomeSettings(0.6f, -2.0f, Blocks::Dirt, Blocks::Dirt, INT32_MAX, 0.0f),	// Desert
+	MakeBiomeSettings(2.4f, 8.0f, Blocks::Grass, Blocks::Dirt, 62, 0.02f)			// Mountains
+};
+
+static const FractalNoise2D<3> TemperatureNoise = FractalNoise2D<3>::MakeFBm(0.001f, 1.0f / 1.75f);
+static const FractalNoise2D<3> HumidityNoise = FractalNoise2D<3>::MakeFBm(0.0013f, 1.0f / 1.75f);
+
+BiomeMap::BiomeMap(int32_t InSeed, int32_t InMaxRegions)
+	: Seed(InSeed)
+	, MaxRegions(InMaxRegions > 1 ? InMaxRegions : 1)
+	, NumRegionsBuilt(0)
+{
+}
+
+const BiomeSettings& BiomeMap::GetSettings(BiomeType Biome)
+{
+	return AllBiomeSettings[Clamp((int32_t)Biome, 0, (int32_t)BiomeType::Count - 1)];
+}
+
+const char* BiomeMap::GetBiomeName(BiomeType Biome)
+{
+	switch (Biome)
+	{
+	case BiomeType::Forest: return "Forest";
+	case BiomeType::Desert: return "Desert";
+	case BiomeType::Mountains: return "Mountains";
+	default: return "Plains";
+	}
+}
+
+BiomeMap::RegionPtr BiomeMap::FindOrBuildRegion(int32_t RegionX, int32_t RegionY) const
+{
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+
+	const uint64_t Key = MakeGridKey(RegionX, RegionY);
+	auto Cached = Regions.find(Key);
+	if (Cached != Regions.end())
+	{
+		Cached->second.LastUsed = ++UseCounter;
+		return Cached->second.Data;
+	}
+
+	// A region is 9x9 samples per field, cheap enough to build while holding the lock.
+	std::shared_ptr<Region> NewRegion = std::make_shared<Region>();
+	const float OriginX = (float)RegionX * RegionSize;
+	const float OriginY = (float)RegionY * RegionSize;
+	TemperatureNoise.SampleGrid(OriginX, OriginY, CellSize, PointsPerSide, PointsPerSide, NewRegion->Temperature);
+	HumidityNoise.SampleGrid(OriginX + 40000.0f, OriginY - 40000.0f, CellSize, PointsPerSide, PointsPerSide, NewRegion->Humidity);
+	NumRegionsBuilt++;
+
+	if ((int32_t)Regions.size() >= MaxRegions)
+	{
+		auto Oldest = Regions.begin();
+		for (auto It = Regions.begin(); It != Regions.end(); ++It)
+		{
+			if (It->second.LastUsed < Oldest->second.LastUsed)
+				Oldest = It;
+		}
+		Regions.erase(Oldest);
+	}
+
+	CachedRegion& NewEntry = Regions[Key];
+	NewEntry.Data = NewRegion;
+	NewEntry.LastUsed = ++UseCounter;
+	return NewEntry.Data;
+}
+
+void BiomeMap::ClassifyClimate(BiomeSample& Sample)
+{
+	float Distances[(int32_t)BiomeType::Count];
+	float Nearest = 3.4e+38f;
+	for (int32_t b = 0; b < (int32_t)BiomeType::Count; b++)
+	{
+		const float DX = BiomeClimateCenters[b][0] - Sample.Temperature;
+		const float DY = BiomeClimateCenters[b][1] - Sample.Humidity;
+		Distances[b] = std::sqrt(DX * DX + DY * DY);
+		if (Distances[b] < Nearest)
+		{
+			Nearest = Distances[b];
+			Sample.Dominant = (BiomeType)b;
+		}
+	}
+
+	float TotalWeight = 0.0f;
+	for (int32_t b = 0; b < (int32_t)BiomeType::Count; b++)
+	{
+		const float Weight = 1.0f - (Distances[b] - Nearest) / BiomeBlendWidth;
+		Sample.Weights[b] = Weight > 0.0f ? Weight : 0.0f;
+		TotalWeight += Sample.Weights[b];
+	}
+
+	Sample.HeightScale = 0.0f;
+	Sample.HeightOffset = 0.0f;
+	Sample.TreeChance = 0.0f;
+	for (int32_t b = 0; b < (int32_t)BiomeType::Count; b++)
+	{
+		Sample.Weights[b] /= TotalWeight;
+		Sample.HeightScale += AllBiomeSettings[b].HeightScale * Sample.Weights[b];
+		Sample.HeightOffset += AllBiomeSettings[b].HeightOffset * Sample.Weights[b];
+		Sample.TreeChance += AllBiomeSettings[b].TreeChance * Sample.Weights[b];
+	}
+}
+
+BiomeSample BiomeMap::SampleRegion(const Region& Source, int32_t LocalX, int32_t LocalY)
+{
+	const int32_t CellX = LocalX / CellSize;
+	const int32_t CellY = LocalY / CellSize;
+	const float FracX = (float)(LocalX % CellSize) / CellSize;
+	const float FracY = (float)(LocalY % CellSize) / CellSize;
+
+	const int32_t P00 = CellY + (CellX * PointsPerSide);
+	const int32_t P01 = P00 + 1;
+	const int32_t P10 = P00 + PointsPerSide;
+	const int32_t P11 = P10 + 1;
+
+	BiomeSample Sample;
+	Sample.Temperature = BiLerp(Source.Temperature[P00], Source.Temperature[P10], Source.Temperature[P01], Source.Temperature[P11], FracX, FracY);
+	Sample.Humidity = BiLerp(Source.Humidity[P00], Source.Humidity[P10], Source.Humidity[P01], Source.Humidity[P11], FracX, FracY);
+	ClassifyClimate(Sample);
+	return Sample;
+}
+
+BiomeSample BiomeMap::Sample(int32_t WorldX, int32_t WorldY) const
+{
+	const int32_t RegionX = FloorDiv(WorldX, RegionSize);
+	const int32_t RegionY = FloorDiv(WorldY, RegionSize);
+	RegionPtr Source = FindOrBuildRegion(RegionX, RegionY);
+	return SampleRegion(*Source, WorldX - RegionX * RegionSize, WorldY - RegionY * RegionSize);
+}
+
+void BiomeMap::SampleArea(int32_t OriginX, int32_t OriginY, int32_t Step, int32_t SizeX, int32_t SizeY, BiomeSample* Out) const
+{
+	// Neighbouring samples nearly always share a region, so only go through the cache when it changes.
+	int32_t CurrentX = INT32_MAX;
+	int32_t CurrentY = INT32_MAX;
+	RegionPtr Source;
+
+	for (int32_t x = 0; x < SizeX; x++)
+	{
+		const int32_t WorldX = OriginX + x * Step;
+		for (int32_t y = 0; y < SizeY; y++)
+		{
+			const int32_t WorldY = OriginY + y * Step;
+			const int32_t RegionX = FloorDiv(WorldX, RegionSize);
+			const int32_t RegionY = FloorDiv(WorldY, RegionSize);
+			if (RegionX != CurrentX || RegionY != CurrentY)
+			{
+				Source = FindOrBuildRegion(RegionX, RegionY);
+				CurrentX = RegionX;
+				CurrentY = RegionY;
+			}
+
+			Out[y + (x * SizeY)] = SampleRegion(*Source, WorldX - RegionX * RegionSize, WorldY - RegionY * RegionSize);
+		}
+	}
+}
+
+void BiomeMap::Empty()
+{
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+	Regions.clear();
+}
+
+int32_t BiomeMap::GetNumCachedRegions() const
+{
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+	return (int32_t)Regions.size();
+}
+
+}
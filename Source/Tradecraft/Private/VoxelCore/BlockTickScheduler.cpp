@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/BlockTickScheduler.h"
+#include <algorithm>
+
+namespace VoxelCore
+{
+	static const BlockPos BlockNeighbors[] =
+	{
+		{ 1, 0, 0 }, { -1, 0, 0 },
+		{ 0, 1, 0 }, { 0, -1, 0 },
+		{ 0, 0, 1 }, { 0, 0, -1 },
+	};
+
+	void BlockTickScheduler::Initialize(BlockTickAccess& InAccess, int32_t Seed, const ChunkLayout& InLayout)
+	{
+		Access = &InAccess;
+		Layout = InLayout;
+		Random.Initialize(Seed);
+
+		Sections.clear();
+		RandomTickOrder.clear();
+		RandomTickCursor = 0;
+		RandomTickOrderDirty = false;
+		Scheduled.clear();
+		ScheduledBlocks.clear();
+		CurrentTick = 0;
+		TickAccumulator = 0.0f;
+		RandomChunksLeft = 0;
+	}
+
+	void BlockTickScheduler::RegisterBehavior(BlockId Id, const BlockTickBehavior& Behavior)
+	{
+		if (Id < 0)
+			return;
+
+		Behaviors[Id] = Behavior;
+		if ((int32_t)RandomTickable.size() <= Id)
+		{
+			RandomTickable.resize(Id + 1, false);
+			ScheduledOnLoad.resize(Id + 1, false);
+		}
+		RandomTickable[Id] = (bool)Behavior.OnRandomTick;
+		ScheduledOnLoad[Id] = Behavior.bScheduleOnLoad && Behavior.OnScheduledTick;
+	}
+
+	const BlockTickBehavior* BlockTickScheduler::FindBehavior(BlockId Id) const
+	{
+		auto Found = Behaviors.find(Id);
+		return Found != Behaviors.end() ? &Found->second : nullptr;
+	}
+
+	void BlockTickScheduler::AddChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView ChunkData)
+	{
+		std::vector<uint16_t>& Counts = Sections[MakeKey(ChunkX, ChunkY)];
+		Counts.assign((Layout.Height + SectionHeight - 1) / SectionHeight, 0);
+
+		// The border holds copies of the neighbours' blocks: those are not counted, but are woken
+		// since they may now have somewhere to go.
+		if (ChunkData.Num >= Layout.NumBlocks())
+		{
+			for (int32_t x = 0; x < Layout.WidthExt; x++)
+			{
+				for (int32_t y = 0; y < Layout.WidthExt; y++)
+				{
+					const bool IsBorder = x == 0 || y == 0 || x == Layout.WidthExt - 1 || y == Layout.WidthExt - 1;
+					const int32_t Column = Layout.Index(x, y, 0);
+					for (int32_t z = 0; z < Layout.Height; z++)
+					{
+						const BlockId Id = ChunkData[Column + z];
+						if (!IsBorder && IsRandomTickable(Id))
+							Counts[z / SectionHeight]++;
+						if (IsScheduledOnLoad(Id))
+							ScheduleTick({ ChunkX * Layout.Width + x - 1, ChunkY * Layout.Width + y - 1, z }, IndexNone);
+					}
+				}
+			}
+		}
+		RandomTickOrderDirty = true;
+	}
+
+	void BlockTickScheduler::RemoveChunk(int32_t ChunkX, int32_t ChunkY)
+	{
+		// Scheduled ticks in the chunk are dropped when they come due.
+		if (Sections.erase(MakeKey(ChunkX, ChunkY)) > 0)
+			RandomTickOrderDirty = true;
+	}
+
+	bool BlockTickScheduler::IsBlockLoaded(const BlockPos& Block) const
+	{
+		return Block.Z >= 0 && Block.Z < Layout.Height && Sections.count(GetChunkKey(Block)) > 0;
+	}
+
+	BlockId BlockTickScheduler::GetBlock(const BlockPos& Block) const
+	{
+		return IsBlockLoaded(Block) ? Access->GetBlock(Block) : Blocks::Air;
+	}
+
+	void BlockTickScheduler::SetBlock(const BlockPos& Block, BlockId Id)
+	{
+		if (!IsBlockLoaded(Block))
+			return;
+
+		const BlockId OldId = Access->GetBlock(Block);
+		if (OldId == Id)
+			return;
+
+		Access->SetBlock(Block, Id);
+		NotifyBlockChanged(Block, OldId, Id);
+	}
+
+	void BlockTickScheduler::NotifyBlockChanged(const BlockPos& Block, BlockId OldId, BlockId NewId)
+	{
+		auto Found = Sections.find(GetChunkKey(Block));
+		const int32_t Section = Block.Z >= 0 ? Block.Z / SectionHeight : IndexNone;
+		if (Found != Sections.end() && Section != IndexNone && Section < (int32_t)Found->second.size())
+		{
+			// A caller with a stale OldId must not wrap the count around, which would keep an
+			// empty section ticking forever.
+			uint16_t& Count = Found->second[Section];
+			if (IsRandomTickable(OldId) && Count > 0)
+				Count--;
+			if (IsRandomTickable(NewId) && Count < UINT16_MAX)
+				Count++;
+		}
+
+		ScheduleTick(Block, IndexNone);
+		WakeNeighbors(Block);
+	}
+
+	void BlockTickScheduler::WakeNeighbors(const BlockPos& Block)
+	{
+		for (const BlockPos& Offset : BlockNeighbors)
+			ScheduleTick(Block + Offset, IndexNone);
+	}
+
+	void BlockTickScheduler::ScheduleTick(const BlockPos& Block, int32_t Delay)
+	{
+		if (!IsBlockLoaded(Block))
+			return;
+
+		// A tick queued for the block's old id would be dropped when it comes due.
+		const BlockId Id = Access->GetBlock(Block);
+		auto Queued = ScheduledBlocks.find(Block);
+		if (Queued != ScheduledBlocks.end() && Queued->second.Id == Id)
+			return;
+
+		const BlockTickBehavior* Behavior = FindBehavior(Id);
+		if (!Behavior || !Behavior->OnScheduledTick)
+			return;
+
+		if (Delay == IndexNone)
+		{
+			if (Behavior->NeighborChangeDelay == IndexNone)
+				return;
+			Delay = Behavior->NeighborChangeDelay;
+		}
+
+		ScheduledTick Tick;
+		Tick.Tick = CurrentTick + std::max(Delay, 1);
+		Tick.Sequence = NextSequence++;
+		Tick.Block = Block;
+		Tick.Id = Id;
+		Scheduled.push_back(Tick);
+		std::push_heap(Scheduled.begin(), Scheduled.end(), ScheduledTickOrder());
+		ScheduledBlocks[Block] = Tick;
+	}
+
+	bool BlockTickScheduler::Update(float DeltaTime)
+	{
+		TickAccumulator += DeltaTime * TicksPerSecond;
+		int32_t NumTicks = FloorToInt(TickAccumulator);
+		TickAccumulator -= NumTicks;
+		NumTicks = std::min(NumTicks, MaxTicksPerUpdate);
+
+		if (RandomTickOrderDirty)
+		{
+			RandomTickOrder.clear();
+			for (const auto& Elem : Sections)
+				RandomTickOrder.push_back(Elem.first);
+			const int32_t NumChunks = (int32_t)RandomTickOrder.size();
+			RandomTickCursor = NumChunks > 0 ? RandomTickCursor % NumChunks : 0;
+			RandomChunksLeft = std::min(RandomChunksLeft, NumChunks);
+			RandomTickOrderDirty = false;
+		}
+
+		// Whatever the last update had no time for goes first.
+		bool InBudget = RunScheduledTicks() && RunRandomTicks();
+		for (int32_t i = 0; i < NumTicks && InBudget; i++)
+		{
+			CurrentTick++;
+			RandomChunksLeft = (int32_t)RandomTickOrder.size();
+			InBudget = RunScheduledTicks() && RunRandomTicks();
+		}
+
+		if (!InBudget)
+			OverBudgetUpdates++;
+		return InBudget;
+	}
+
+	bool BlockTickScheduler::RunScheduledTicks()
+	{
+		while (!Scheduled.empty() && Scheduled.front().Tick <= CurrentTick)
+		{
+			if (Access->IsOutOfTime())
+				return false;
+
+			std::pop_heap(Scheduled.begin(), Scheduled.end(), ScheduledTickOrder());
+			const ScheduledTick Tick = Scheduled.back();
+			Scheduled.pop_back();
+
+			auto Live = ScheduledBlocks.find(Tick.Block);
+			if (Live == ScheduledBlocks.end() || Live->second.Sequence != Tick.Sequence)
+				continue;
+			ScheduledBlocks.erase(Live);
+
+			if (!IsBlockLoaded(Tick.Block) || Access->GetBlock(Tick.Block) != Tick.Id)
+				continue;
+
+			FindBehavior(Tick.Id)->OnScheduledTick(*this, Tick.Block);
+			ScheduledTicksRun++;
+		}
+		return true;
+	}
+
+	bool BlockTickScheduler::RunRandomTicks()
+	{
+		for (; RandomChunksLeft > 0; RandomChunksLeft--)
+		{
+			if (Access->IsOutOfTime())
+				return false;
+
+			const uint64_t Key = RandomTickOrder[RandomTickCursor];
+			RandomTickCursor = (RandomTickCursor + 1) % (int32_t)RandomTickOrder.size();
+
+			const int32_t ChunkX = (int32_t)(uint32_t)(Key >> 32);
+			const int32_t ChunkY = (int32_t)(uint32_t)Key;
+			const std::vector<uint16_t>& Counts = Sections[Key];
+			for (int32_t Section = 0; Section < (int32_t)Counts.size(); Section++)
+			{
+				if (Counts[Section] == 0)
+					continue;
+
+				for (int32_t i = 0; i < RandomTicksPerSection; i++)
+				{
+					const BlockPos Block =
+					{
+						ChunkX * Layout.Width + Random.RandHelper(Layout.Width),
+						ChunkY * Layout.Width + Random.RandHelper(Layout.Width),
+						std::min(Section * SectionHeight + Random.RandHelper(SectionHeight), Layout.Height - 1)
+					};
+
+					const BlockId Id = Access->GetBlock(Block);
+					if (!IsRandomTickable(Id))
+						continue;
+
+					FindBehavior(Id)->OnRandomTick(*this, Block);
+					RandomTicksRun++;
+
+					// The tick may have emptied the section.
+					if (Counts[Section] == 0)
+						break;
+				}
+			}
+		}
+		return true;
+	}
+
+	int32_t BlockTickScheduler::GetSectionCount(int32_t ChunkX, int32_t ChunkY, int32_t Section) const
+	{
+		auto Found = Sections.find(MakeKey(ChunkX, ChunkY));
+		if (Found == Sections.end() || Section < 0 || Section >= (int32_t)Found->second.size())
+			return 0;
+		return Found->second[Section];
+	}
+
+	int32_t BlockTickScheduler::GetNumSections() const
+	{
+		int32_t Count = 0;
+		for (const auto& Elem : Sections)
+			Count += (int32_t)Elem.second.size();
+		return Count;
+	}
+
+	int32_t BlockTickScheduler::GetNumActiveSections() const
+	{
+		int32_t Count = 0;
+		for (const auto& Elem : Sections)
+		{
+			for (uint16_t SectionCount : Elem.second)
+				Count += SectionCount > 0 ? 1 : 0;
+		}
+		return Count;
+	}
+}
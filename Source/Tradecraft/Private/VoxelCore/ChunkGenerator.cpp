@@ -0,0 +1,505 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/ChunkGenerator.h"
+#include "VoxelCore/FractalNoise.h"
+#include "VoxelCore/HeightTileCache.h"
+#include "VoxelCore/SimplexNoise.h"
+#include "VoxelCore/StructurePlacer.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace VoxelCore
+{
+
+static double GetSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ChunkGenerator::ChunkGenerator(int32_t InSeed, int32_t InWidthOfChunk, int32_t InHeightOfChunk)
+	: Seed(InSeed)
+	, WidthOfChunk(InWidthOfChunk)
+	, HeightOfChunk(InHeightOfChunk)
+	, WidthOfChunkExt(InWidthOfChunk + 2)
+{
+}
+
+void ChunkGenerator::PrepareNoise(int32_t Seed)
+{
+	SimplexNoise::SetSeed(Seed);
+}
+
+void ChunkGenerator::Generate(int32_t ChunkX, int32_t ChunkY, std::vector<BlockId>& OutChunkData, ChunkGenerationTimings* Timings) const
+{
+	OutChunkData.resize(GetNumBlocks());
+	Generate(ChunkX, ChunkY, BlockIdView(OutChunkData.data(), (int32_t)OutChunkData.size()), Timings);
+}
+
+void ChunkGenerator::Generate(int32_t ChunkX, int32_t ChunkY, BlockIdView OutChunkData, ChunkGenerationTimings* Timings) const
+{
+	assert(OutChunkData.Num == GetNumBlocks());
+	const int32_t ChunkXIndex = ChunkX * WidthOfChunk;
+	const int32_t ChunkYIndex = ChunkY * WidthOfChunk;
+
+	const BiomeMap* Map = Biomes;
+	std::unique_ptr<BiomeMap> LocalBiomes;
+	if (!Map && TerrainVersion >= 2)
+	{
+		LocalBiomes.reset(new BiomeMap(Seed, 4));
+		Map = LocalBiomes.get();
+	}
+
+	double StageStart = GetSeconds();
+	auto EndStage = [&](double ChunkGenerationTimings::* Stage)
+	{
+		const double Now = GetSeconds();
+		if (Timings)
+			Timings->*Stage += Now - StageStart;
+		StageStart = Now;
+	};
+
+	std::vector<int32_t> NoiseData;
+	std::vector<BiomeSample> ColumnBiomes;
+	if (HeightTiles && WidthOfChunk == HeightTile::Size)
+		HeightTiles->GatherColumns(ChunkXIndex - 1, ChunkYIndex - 1, WidthOfChunkExt, WidthOfChunkExt, TerrainVersion >= 2, NoiseData, TerrainVersion >= 2 ? &ColumnBiomes : nullptr);
+	else if (TerrainVersion >= 2)
+		CalculateBiomeNoise(ChunkXIndex, ChunkYIndex, *Map, NoiseData, ColumnBiomes);
+	else
+		CalculateNoise(ChunkXIndex, ChunkYIndex, NoiseData);
+	EndStage(&ChunkGenerationTimings::NoiseSeconds);
+
+	for (int32_t i = 0; i < OutChunkData.Num; i++)
+		OutChunkData[i] = Blocks::Air;
+	std::vector<int32_t> TreeBases;
+	if (TerrainVersion >= 1)
+		FillBlocksWithDensity(ChunkXIndex, ChunkYIndex, NoiseData, TerrainVersion >= 2 ? &ColumnBiomes : nullptr, OutChunkData, TreeBases);
+	else
+		FillBlocks(NoiseData, OutChunkData, TreeBases);
+	EndStage(&ChunkGenerationTimings::FillSeconds);
+
+	// From version 3 trees are structures that can cross chunk borders.
+	if (TerrainVersion >= 3)
+	{
+		PlaceStructures(ChunkXIndex, ChunkYIndex, *Map, OutChunkData);
+	}
+	else
+	{
+		std::vector<float> TreeChances;
+		TreeChances.reserve(ColumnBiomes.size());
+		for (const BiomeSample& Biome : ColumnBiomes)
+			TreeChances.push_back(Biome.TreeChance);
+
+		RandomStream Random(Seed);
+		PlaceTrees(TreeBases, TerrainVersion >= 2 ? &TreeChances : nullptr, Random, OutChunkData);
+	}
+	EndStage(&ChunkGenerationTimings::TreeSeconds);
+
+	if (Timings)
+		Timings->NumChunks++;
+}
+
+void ChunkGenerator::SampleHeightmap(int32_t BlockX, int32_t BlockY, int32_t SizeX, int32_t SizeY, float* Out)
+{
+	// Broad hills plus a small bump layer that only adds height where it is positive.
+	static const FractalNoise2D<2> HeightNoise = []()
+	{
+		FractalNoise2D<2> Noise;
+		Noise.Octaves[0].Frequency = 0.01f;
+		Noise.Octaves[0].Amplitude = 28.0f;
+		Noise.Octaves[1].Frequency = 0.05f;
+		Noise.Octaves[1].Amplitude = 4.0f;
+		Noise.Octaves[1].Min = 0.0f;
+		Noise.Octaves[1].Max = 5.0f;
+		return Noise;
+	}();
+
+	// Each column's height is sampled one block further along y; kept so existing worlds generate the same terrain.
+	HeightNoise.SampleGrid((float)BlockX, (float)(BlockY + 1), 1.0f, SizeX, SizeY, Out);
+}
+
+void ChunkGenerator::CalculateHeights(int32_t ChunkXIndex, int32_t ChunkYIndex, float* OutHeights) const
+{
+	SampleHeightmap(ChunkXIndex - 1, ChunkYIndex - 1, WidthOfChunkExt, WidthOfChunkExt, OutHeights);
+}
+
+void ChunkGenerator::CalculateNoise(int32_t ChunkXIndex, int32_t ChunkYIndex, std::vector<int32_t>& OutNoise) const
+{
+	float Heights[MaxNoiseSamples];
+	const int32_t NumSamples = WidthOfChunkExt * WidthOfChunkExt;
+	assert(NumSamples <= MaxNoiseSamples);
+	CalculateHeights(ChunkXIndex, ChunkYIndex, Heights);
+
+	OutNoise.resize(NumSamples);
+	for (int32_t i = 0; i < NumSamples; i++)
+		OutNoise[i] = FloorToInt(Heights[i]);
+}
+
+void ChunkGenerator::CalculateBiomeNoise(int32_t ChunkXIndex, int32_t ChunkYIndex, const BiomeMap& Map, std::vector<int32_t>& OutNoise, std::vector<BiomeSample>& OutBiomes) const
+{
+	float Heights[MaxNoiseSamples];
+	const int32_t NumSamples = WidthOfChunkExt * WidthOfChunkExt;
+	assert(NumSamples <= MaxNoiseSamples);
+	CalculateHeights(ChunkXIndex, ChunkYIndex, Heights);
+
+	OutBiomes.resize(NumSamples);
+	Map.SampleArea(ChunkXIndex - 1, ChunkYIndex - 1, 1, WidthOfChunkExt, WidthOfChunkExt, OutBiomes.data());
+
+	OutNoise.resize(NumSamples);
+	for (int32_t i = 0; i < NumSamples; i++)
+		OutNoise[i] = FloorToInt(Heights[i] * OutBiomes[i].HeightScale + OutBiomes[i].HeightOffset);
+}
+
+void ChunkGenerator::FillBlocks(const std::vector<int32_t>& NoiseData, BlockIdView ChunkData, std::vector<int32_t>& OutTreeBases) const
+{
+	const ChunkLayout Layout = GetLayout();
+	for (int x = 0; x < WidthOfChunkExt; x++)
+	{
+		for (int y = 0; y < WidthOfChunkExt; y++)
+		{
+			const int32_t Noise = NoiseData[Layout.ColumnIndex(x, y)];
+			for (int z = 0; z < HeightOfChunk; z++)
+			{
+				const int32_t Index = Layout.Index(x, y, z);
+				if (z == 30 + Noise) { ChunkData[Index] = Blocks::Grass; }
+				else if (z == 29 + Noise) { ChunkData[Index] = Blocks::Dirt; }
+				else if (z < 29 + Noise) { ChunkData[Index] = Blocks::Stone; }
+				else if (z < 15 + Noise && ChunkData[Index] == Blocks::Air) { ChunkData[Index] = Blocks::Planks; }
+				else { ChunkData[Index] = Blocks::Air; }
+			}
+		}
+	}
+
+	OutTreeBases.resize(NoiseData.size());
+	for (size_t i = 0; i < NoiseData.size(); i++)
+		OutTreeBases[i] = 31 + NoiseData[i];
+}
+
+void ChunkGenerator::PlaceTrees(const std::vector<int32_t>& TreeBases, const std::vector<float>* TreeChances, RandomStream& Random, BlockIdView ChunkData) const
+{
+	struct TreeCenter
+	{
+		int32_t X, Y, Z;
+	};
+
+	std::vector<TreeCenter> TreeCenters;
+	for (int x = 3; x < WidthOfChunk - 3; x++)
+	{
+		for (int y = 2; y < WidthOfChunk - 2; y++)
+		{
+			int32_t Base = TreeBases[y + (x * WidthOfChunkExt)];
+			double Chance = TreeChances ? (*TreeChances)[y + (x * WidthOfChunkExt)] : 0.03;
+			if (Base >= 0 && Base < HeightOfChunk && Random.FRand() < Chance) { TreeCenters.push_back({ x, y, Base }); } // Tree
+		}
+	}
+
+	for (size_t i = 0; i < TreeCenters.size(); i++)
+	{
+		int height = (int)(Random.FRand() * 4) + 4;
+		const TreeCenter pos = TreeCenters[i];
+
+		int rand_x = (int)(Random.FRand() * 1) + 2;
+		int rand_y = (int)(Random.FRand() * 1) + 2;
+		int rand_z = (int)(Random.FRand() * 1) + 2;
+
+		float radius = std::sqrt((float)rand_x * rand_x + (float)rand_y * rand_y + (float)rand_z * rand_z);
+
+		for (int x = pos.X - radius; x < pos.X + radius; x++)
+		{
+			for (int y = pos.Y - radius; y < pos.Y + radius; y++)
+			{
+				for (int z = pos.Z - radius; z < pos.Z + radius; z++)
+				{
+					int realPosZ = z + height - rand_z;
+
+					const float DX = (float)x - (float)pos.X;
+					const float DY = (float)y - (float)pos.Y;
+					const float DZ = (float)realPosZ - (float)(pos.Z + height);
+					if (std::sqrt(DX * DX + DY * DY + DZ * DZ) <= radius)
+					{
+						int32_t index = (realPosZ)+((y + 1) * HeightOfChunk) + ((x + 1) * WidthOfChunkExt * HeightOfChunk);
+
+						if (Random.FRand() < 0.8 && ChunkData.IsValidIndex(index) && ChunkData[index] == Blocks::Air) // Only Add leaves if there is an empty block there
+							ChunkData[index] = Blocks::Leaves;
+					}
+				}
+			}
+		}
+
+		if (height + pos.Z < HeightOfChunk - 1)
+		{
+			for (int j = 0; j < height; j++)
+			{
+				int32_t index = (pos.Z + j) + (pos.Y * HeightOfChunk) + (pos.X * WidthOfChunkExt * HeightOfChunk);
+				ChunkData[index] = Blocks::Trunk;
+			}
+		}
+	}
+}
+
+// Density terrain. The shape field moves the surface up to ShapeAmplitude blocks either way,
+// which is what lets it overhang. A cave is wherever both cave fields are within CaveWidth of zero,
+// the intersection of two noise sheets, which gives long winding tunnels.
+static const float ShapeFrequency = 0.03f;
+static const float ShapeAmplitude = 6.0f;
+static const float CaveFrequency = 0.045f;
+static const float CaveWidth = 0.12f;
+static const float CaveOffset = 71.3f;
+
+// Noise stays within [-1, 1], so more than ShapeReach blocks above the surface the density is
+// negative, and more than ShapeReach below it positive, whatever the shape field does there.
+static const int32_t ShapeReach = (int32_t)ShapeAmplitude + 2;
+
+void ChunkGenerator::FillBlocksWithDensity(int32_t ChunkXIndex, int32_t ChunkYIndex, const std::vector<int32_t>& NoiseData, const std::vector<BiomeSample>* ColumnBiomes, BlockIdView ChunkData, std::vector<int32_t>& OutTreeBases) const
+{
+	const int32_t Cell = DensityCellSize;
+	const ChunkLayout Layout = GetLayout();
+
+	// World block coordinates of extended index 0. The lattice sits on world multiples of Cell,
+	// so neighbouring chunks interpolate exactly the same values along their shared border.
+	const int32_t BaseX = ChunkXIndex - 1;
+	const int32_t BaseY = ChunkYIndex - 1;
+	const int32_t LatticeX = FloorDiv(BaseX, Cell) * Cell;
+	const int32_t LatticeY = FloorDiv(BaseY, Cell) * Cell;
+	const int32_t NumX = (BaseX + WidthOfChunkExt - 1 - LatticeX) / Cell + 2;
+	const int32_t NumY = (BaseY + WidthOfChunkExt - 1 - LatticeY) / Cell + 2;
+	const int32_t NumZ = (HeightOfChunk - 1) / Cell + 2;
+
+	// The shape field only decides blocks within ShapeReach of the surface, and caves only matter
+	// below the highest block that can be solid, so the lattice is only sampled over those layers.
+	int32_t MinSurface = NoiseData[0], MaxSurface = NoiseData[0];
+	for (int32_t Noise : NoiseData)
+	{
+		MinSurface = std::min(MinSurface, Noise);
+		MaxSurface = std::max(MaxSurface, Noise);
+	}
+	MinSurface += 30;
+	MaxSurface += 30;
+	const int32_t Highest = std::min(HeightOfChunk - 1, MaxSurface + ShapeReach);
+	const int32_t ShapeFirstK = std::min(std::max(MinSurface - ShapeReach, 0) / Cell, NumZ - 1);
+	const int32_t ShapeNumK = std::max(std::max(Highest, 0) / Cell + 2 - ShapeFirstK, 1);
+	const int32_t CaveNumK = std::max(Highest, 0) / Cell + 2;
+
+	// Lattice index = (k - FirstK) + (j * NumK) + (i * NumY * NumK), z innermost like the chunk.
+	std::vector<float> PointX, PointY, PointZ;
+	std::vector<float> Shape(NumX * NumY * ShapeNumK), CaveA(NumX * NumY * CaveNumK), CaveB(NumX * NumY * CaveNumK);
+
+	auto SampleField = [&](float Frequency, float Offset, int32_t FirstK, int32_t NumK, std::vector<float>& Out)
+	{
+		const int32_t NumPoints = NumX * NumY * NumK;
+		PointX.resize(NumPoints);
+		PointY.resize(NumPoints);
+		PointZ.resize(NumPoints);
+		int32_t p = 0;
+		for (int32_t i = 0; i < NumX; i++)
+			for (int32_t j = 0; j < NumY; j++)
+				for (int32_t k = FirstK; k < FirstK + NumK; k++, p++)
+				{
+					PointX[p] = (LatticeX + i * Cell) * Frequency + Offset;
+					PointY[p] = (LatticeY + j * Cell) * Frequency;
+					PointZ[p] = (k * Cell) * Frequency - Offset;
+				}
+		SimplexNoise::Noise3D(PointX.data(), PointY.data(), PointZ.data(), Out.data(), NumPoints);
+	};
+	SampleField(ShapeFrequency, 0.0f, ShapeFirstK, ShapeNumK, Shape);
+	SampleField(CaveFrequency, CaveOffset, 0, CaveNumK, CaveA);
+	SampleField(CaveFrequency, -CaveOffset, 0, CaveNumK, CaveB);
+
+	OutTreeBases.assign(WidthOfChunkExt * WidthOfChunkExt, IndexNone);
+
+	// Version 1 terrain is plains-like everywhere: grass over dirt.
+	static const BiomeSettings DefaultSurface;
+
+	// Each column first blends the four lattice columns around it, then interpolates along z.
+	std::vector<float> ColumnShape(ShapeNumK), ColumnCaveA(CaveNumK), ColumnCaveB(CaveNumK);
+
+	for (int x = 0; x < WidthOfChunkExt; x++)
+	{
+		const int32_t LocalX = BaseX + x - LatticeX;
+		const int32_t i = LocalX / Cell;
+		const float FX = (float)(LocalX % Cell) / Cell;
+
+		for (int y = 0; y < WidthOfChunkExt; y++)
+		{
+			const int32_t LocalY = BaseY + y - LatticeY;
+			const int32_t j = LocalY / Cell;
+			const float FY = (float)(LocalY % Cell) / Cell;
+
+			const int32_t S00 = (j * ShapeNumK) + (i * NumY * ShapeNumK);
+			const int32_t S01 = S00 + ShapeNumK;
+			const int32_t S10 = S00 + NumY * ShapeNumK;
+			const int32_t S11 = S10 + ShapeNumK;
+			for (int32_t k = 0; k < ShapeNumK; k++)
+				ColumnShape[k] = BiLerp(Shape[S00 + k], Shape[S10 + k], Shape[S01 + k], Shape[S11 + k], FX, FY);
+
+			const int32_t C00 = (j * CaveNumK) + (i * NumY * CaveNumK);
+			const int32_t C01 = C00 + CaveNumK;
+			const int32_t C10 = C00 + NumY * CaveNumK;
+			const int32_t C11 = C10 + CaveNumK;
+			for (int32_t k = 0; k < CaveNumK; k++)
+			{
+				ColumnCaveA[k] = BiLerp(CaveA[C00 + k], CaveA[C10 + k], CaveA[C01 + k], CaveA[C11 + k], FX, FY);
+				ColumnCaveB[k] = BiLerp(CaveB[C00 + k], CaveB[C10 + k], CaveB[C01 + k], CaveB[C11 + k], FX, FY);
+			}
+
+			// Same surface as the heightmap terrain, before shaping.
+			const int32_t Surface = 30 + NoiseData[Layout.ColumnIndex(x, y)];
+			const int32_t TopsoilFrom = Surface - (int32_t)ShapeAmplitude - 2;
+			const int32_t ShapedFrom = Surface - ShapeReach;
+			const int32_t Top = std::min(HeightOfChunk - 1, Surface + ShapeReach);
+			const BiomeSettings& Biome = ColumnBiomes ? BiomeMap::GetSettings((*ColumnBiomes)[Layout.ColumnIndex(x, y)].Dominant) : DefaultSurface;
+
+			for (int z = HeightOfChunk - 1; z > Top && z > 0; z--)
+				ChunkData[Layout.Index(x, y, z)] = Blocks::Air;
+
+			// Solid blocks seen since the last air block going down; 0 is the one exposed to the sky or a cave.
+			int32_t Depth = -1;
+			int32_t TopSolid = IndexNone;
+
+			for (int z = std::max(Top, 0); z >= 0; z--)
+			{
+				const int32_t k = z / Cell;
+				const float FZ = (float)(z % Cell) / Cell;
+				bool IsSolid = z == 0;
+				if (!IsSolid)
+				{
+					const float Density = z < ShapedFrom ? 1.0f
+						: (Surface - z) + Lerp(ColumnShape[k - ShapeFirstK], ColumnShape[k - ShapeFirstK + 1], FZ) * ShapeAmplitude;
+					IsSolid = Density >= 0.0f
+						&& !(std::fabs(Lerp(ColumnCaveA[k], ColumnCaveA[k + 1], FZ)) < CaveWidth
+							&& std::fabs(Lerp(ColumnCaveB[k], ColumnCaveB[k + 1], FZ)) < CaveWidth);
+				}
+
+				const int32_t Index = Layout.Index(x, y, z);
+				if (!IsSolid)
+				{
+					ChunkData[Index] = Blocks::Air;
+					Depth = -1;
+					continue;
+				}
+
+				Depth++;
+				if (z >= TopsoilFrom && Depth == 0) { ChunkData[Index] = z >= Biome.RockLine ? Blocks::Stone : Biome.TopBlock; }
+				else if (z >= TopsoilFrom && Depth == 1) { ChunkData[Index] = Biome.FillerBlock; }
+				else { ChunkData[Index] = Blocks::Stone; }
+
+				if (TopSolid == IndexNone)
+					TopSolid = z;
+			}
+
+			if (TopSolid != IndexNone && ChunkData[Layout.Index(x, y, TopSolid)] == Blocks::Grass)
+				OutTreeBases[Layout.ColumnIndex(x, y)] = TopSolid + 1;
+		}
+	}
+}
+
+void ChunkGenerator::GetColumn(int32_t BlockX, int32_t BlockY, const BiomeMap& Map, int32_t& OutNoise, BiomeSample& OutBiome) const
+{
+	if (HeightTiles)
+	{
+		OutNoise = HeightTiles->GetColumnHeight(BlockX, BlockY, true);
+		OutBiome = HeightTiles->GetColumnBiome(BlockX, BlockY);
+		return;
+	}
+
+	float Height;
+	SampleHeightmap(BlockX, BlockY, 1, 1, &Height);
+	OutBiome = Map.Sample(BlockX, BlockY);
+	OutNoise = FloorToInt(Height * OutBiome.HeightScale + OutBiome.HeightOffset);
+}
+
+int32_t ChunkGenerator::FindStructureBase(int32_t BlockX, int32_t BlockY, int32_t Noise, BiomeType Biome) const
+{
+	const BiomeSettings& Settings = BiomeMap::GetSettings(Biome);
+	if (Settings.TopBlock != Blocks::Grass)
+		return IndexNone;
+
+	// Above Top the density is negative whatever the shape field does, and a top block below
+	// TopsoilFrom is stone, so only that band needs evaluating.
+	const int32_t Cell = DensityCellSize;
+	const int32_t Surface = 30 + Noise;
+	const int32_t TopsoilFrom = Surface - (int32_t)ShapeAmplitude - 2;
+	const int32_t Top = std::min(HeightOfChunk - 1, Surface + (int32_t)ShapeAmplitude + 1);
+	const int32_t Bottom = std::max(TopsoilFrom, 1);
+	if (Top < Bottom)
+		return IndexNone;
+
+	// The same lattice points, weights and operations as FillBlocksWithDensity, so the result is bit for bit the same.
+	const int32_t LatticeX = FloorDiv(BlockX, Cell) * Cell;
+	const int32_t LatticeY = FloorDiv(BlockY, Cell) * Cell;
+	const float FX = (float)(BlockX - LatticeX) / Cell;
+	const float FY = (float)(BlockY - LatticeY) / Cell;
+	const int32_t FirstK = Bottom / Cell;
+	const int32_t NumK = Top / Cell + 2 - FirstK;
+	const int32_t NumPoints = 4 * NumK;
+
+	// Point index = k + (Corner * NumK), corners ordered 00, 10, 01, 11.
+	std::vector<float> PointX(NumPoints), PointY(NumPoints), PointZ(NumPoints), Shape(NumPoints), CaveA(NumPoints), CaveB(NumPoints);
+
+	auto SampleField = [&](float Frequency, float Offset, std::vector<float>& Out)
+	{
+		for (int32_t Corner = 0; Corner < 4; Corner++)
+			for (int32_t k = 0; k < NumK; k++)
+			{
+				const int32_t p = k + (Corner * NumK);
+				PointX[p] = (LatticeX + (Corner & 1) * Cell) * Frequency + Offset;
+				PointY[p] = (LatticeY + (Corner >> 1) * Cell) * Frequency;
+				PointZ[p] = ((FirstK + k) * Cell) * Frequency - Offset;
+			}
+		SimplexNoise::Noise3D(PointX.data(), PointY.data(), PointZ.data(), Out.data(), NumPoints);
+	};
+	SampleField(ShapeFrequency, 0.0f, Shape);
+	SampleField(CaveFrequency, CaveOffset, CaveA);
+	SampleField(CaveFrequency, -CaveOffset, CaveB);
+
+	std::vector<float> ColumnShape(NumK), ColumnCaveA(NumK), ColumnCaveB(NumK);
+	for (int32_t k = 0; k < NumK; k++)
+	{
+		ColumnShape[k] = BiLerp(Shape[k], Shape[k + NumK], Shape[k + 2 * NumK], Shape[k + 3 * NumK], FX, FY);
+		ColumnCaveA[k] = BiLerp(CaveA[k], CaveA[k + NumK], CaveA[k + 2 * NumK], CaveA[k + 3 * NumK], FX, FY);
+		ColumnCaveB[k] = BiLerp(CaveB[k], CaveB[k + NumK], CaveB[k + 2 * NumK], CaveB[k + 3 * NumK], FX, FY);
+	}
+
+	for (int32_t z = Top; z >= Bottom; z--)
+	{
+		const int32_t k = z / Cell - FirstK;
+		const float FZ = (float)(z % Cell) / Cell;
+		const float Density = (Surface - z) + Lerp(ColumnShape[k], ColumnShape[k + 1], FZ) * ShapeAmplitude;
+		const bool IsCave = std::fabs(Lerp(ColumnCaveA[k], ColumnCaveA[k + 1], FZ)) < CaveWidth
+			&& std::fabs(Lerp(ColumnCaveB[k], ColumnCaveB[k + 1], FZ)) < CaveWidth;
+		if (Density >= 0.0f && !IsCave)
+			return z >= Settings.RockLine ? IndexNone : z + 1;
+	}
+	return IndexNone;
+}
+
+void ChunkGenerator::PlaceStructures(int32_t ChunkXIndex, int32_t ChunkYIndex, const BiomeMap& Map, BlockIdView ChunkData) const
+{
+	// Anything rooted within MaxShapeRadius of the extended chunk can reach into it.
+	const int32_t BaseX = ChunkXIndex - 1;
+	const int32_t BaseY = ChunkYIndex - 1;
+	const int32_t Reach = StructurePlacer::MaxShapeRadius;
+	const ChunkLayout Layout = GetLayout();
+
+	std::vector<StructureCandidate> Candidates;
+	StructurePlacer::GatherCandidates(Seed, BaseX - Reach, BaseY - Reach, BaseX + WidthOfChunkExt - 1 + Reach, BaseY + WidthOfChunkExt - 1 + Reach, Candidates);
+
+	for (const StructureCandidate& Candidate : Candidates)
+	{
+		int32_t Noise;
+		BiomeSample Biome;
+		GetColumn(Candidate.X, Candidate.Y, Map, Noise, Biome);
+
+		// One candidate per cell, so the per column chance is scaled up to the cell.
+		if (Candidate.Roll >= Biome.TreeChance * StructurePlacer::CandidateArea)
+			continue;
+
+		const int32_t Base = FindStructureBase(Candidate.X, Candidate.Y, Noise, Biome.Dominant);
+		if (Base == IndexNone)
+			continue;
+
+		StructurePlacer::Stamp(StructurePlacer::GetShape(Candidate.Shape), Candidate.X, Candidate.Y, Base, BaseX, BaseY, Layout, ChunkData);
+	}
+}
+
+}
@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/ChunkMesher.h"
+#include <cstdio>
+#include <vector>
+
+namespace VoxelCore
+{
+
+static const int32_t FaceTriangles[] = { 2, 1, 0, 0, 3, 2 };
+static const Vec3 FaceNormals[6] = { { 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+static const Vec2 FaceUVs[4] = { { 0.f, 0.f }, { 0.f, 1.f }, { 1.f, 1.f }, { 1.f, 0.f } };
+
+// Neighbour offset of each face: up, down, +y, -y, +x, -x.
+static const int32_t FaceMask[6][3] = { { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 }, { 0, -1, 0 }, { 1, 0, 0 }, { -1, 0, 0 } };
+
+// Corners of each face as indices into the eight cube corners p0 to p7.
+static const int32_t FaceCorners[6][4] = { { 4, 0, 1, 5 }, { 2, 3, 7, 6 }, { 5, 6, 7, 4 }, { 0, 3, 2, 1 }, { 1, 2, 6, 5 }, { 4, 7, 3, 0 } };
+
+bool ChunkMesher::BuildMeshSections(ConstBlockIdView ChunkData, int32_t WidthOfChunk, int32_t HeightOfChunk, int32_t NumSections, std::vector<MeshSection>& OutSections, const uint8_t* Light)
+{
+	const int32_t WidthOfChunkExt = WidthOfChunk + 2;
+	bool bComplete = true;
+
+	OutSections.clear();
+	OutSections.resize(NumSections);
+
+	for (int x = 0; x < WidthOfChunk; x++)
+	{
+		for (int y = 0; y < WidthOfChunk; y++)
+		{
+			for (int z = 0; z < HeightOfChunk; z++)
+			{
+				const int32_t Index = z + ((y + 1) * HeightOfChunk) + ((x + 1) * WidthOfChunkExt * HeightOfChunk);
+				if (!ChunkData.IsValidIndex(Index))
+				{
+					bComplete = false;
+					break;
+				}
+
+				const BlockId CurrentBlock = ChunkData[Index];
+				if (CurrentBlock < 0 || CurrentBlock >= NumSections)
+				{
+					bComplete = false;
+					break;
+				}
+
+				if (CurrentBlock == Blocks::Air)
+					continue;
+
+				MeshSection& Section = OutSections[CurrentBlock];
+				const Vec3 Corners[8] =
+				{
+					{ (x * 100) - 50.f, (y * 100) - 50.f, (z * 100) + 50.f },
+					{ (x * 100) + 50.f, (y * 100) - 50.f, (z * 100) + 50.f },
+					{ (x * 100) + 50.f, (y * 100) - 50.f, (z * 100) - 50.f },
+					{ (x * 100) - 50.f, (y * 100) - 50.f, (z * 100) - 50.f },
+					{ (x * 100) - 50.f, (y * 100) + 50.f, (z * 100) + 50.f },
+					{ (x * 100) + 50.f, (y * 100) + 50.f, (z * 100) + 50.f },
+					{ (x * 100) + 50.f, (y * 100) + 50.f, (z * 100) - 50.f },
+					{ (x * 100) - 50.f, (y * 100) + 50.f, (z * 100) - 50.f }
+				};
+
+				// Quads added for this block so far, four vertices each.
+				int32_t NumFaceVertices = 0;
+				for (int32_t i = 0; i < 6; i++)
+				{
+					const int32_t Neighbour = (z + FaceMask[i][2]) + ((y + FaceMask[i][1] + 1) * HeightOfChunk) + ((x + FaceMask[i][0] + 1) * WidthOfChunkExt * HeightOfChunk);
+					if (!ChunkData.IsValidIndex(Neighbour))
+						continue;
+
+					// Faces are only hidden by opaque blocks; leaves are see through.
+					const BlockId NeighbourBlock = ChunkData[Neighbour];
+					if (NeighbourBlock != Blocks::Air && NeighbourBlock != Blocks::Leaves)
+						continue;
+
+					for (int32_t t = 0; t < 6; t++)
+						Section.Triangles.push_back(FaceTriangles[t] + NumFaceVertices + Section.ElementId);
+					NumFaceVertices += 4;
+
+					Color FaceColor = { 255, 255, 255, (uint8_t)i };
+					if (Light)
+					{
+						const int32_t Sky = Light[Neighbour] >> 4;
+						const int32_t BlockLight = Light[Neighbour] & 15;
+						FaceColor = { (uint8_t)(Sky * 17), (uint8_t)(BlockLight * 17), (uint8_t)((Sky > BlockLight ? Sky : BlockLight) * 17), (uint8_t)i };
+					}
+					for (int32_t c = 0; c < 4; c++)
+					{
+						Section.Vertices.push_back(Corners[FaceCorners[i][c]]);
+						Section.Normals.push_back(FaceNormals[i]);
+						Section.UVs.push_back(FaceUVs[c]);
+						Section.VertexColors.push_back(FaceColor);
+					}
+				}
+				Section.ElementId += NumFaceVertices;
+			}
+		}
+	}
+	return bComplete;
+}
+
+bool ChunkMesher::BuildCollisionMesh(ConstBlockIdView ChunkData, int32_t WidthOfChunk, int32_t HeightOfChunk, std::vector<Vec3>& OutVertices, std::vector<int32_t>& OutTriangles)
+{
+	const int32_t WidthOfChunkExt = WidthOfChunk + 2;
+	OutVertices.clear();
+	OutTriangles.clear();
+	if (ChunkData.Num < WidthOfChunkExt * WidthOfChunkExt * HeightOfChunk)
+		return false;
+
+	auto GetBlock = [&](int32_t x, int32_t y, int32_t z) -> BlockId
+	{
+		if (z < 0 || z >= HeightOfChunk)
+			return Blocks::Air;
+		return ChunkData[z + ((y + 1) * HeightOfChunk) + ((x + 1) * WidthOfChunkExt * HeightOfChunk)];
+	};
+
+	// Each face direction is swept slice by slice along its own axis; a slice's visible faces
+	// form a 2D mask over the other two axes, which is covered greedily with rectangles.
+	std::vector<uint8_t> Mask;
+	for (int32_t Face = 0; Face < 6; Face++)
+	{
+		const int32_t Axis = FaceMask[Face][2] != 0 ? 2 : FaceMask[Face][1] != 0 ? 1 : 0;
+		const int32_t AxisU = Axis == 0 ? 1 : 0;
+		const int32_t AxisV = Axis == 2 ? 1 : 2;
+		const int32_t Size[3] = { WidthOfChunk, WidthOfChunk, HeightOfChunk };
+		const int32_t SizeU = Size[AxisU];
+		const int32_t SizeV = Size[AxisV];
+		Mask.assign(SizeU * SizeV, 0);
+
+		for (int32_t Slice = 0; Slice < Size[Axis]; Slice++)
+		{
+			for (int32_t v = 0; v < SizeV; v++)
+			{
+				for (int32_t u = 0; u < SizeU; u++)
+				{
+					int32_t Block[3];
+					Block[Axis] = Slice;
+					Block[AxisU] = u;
+					Block[AxisV] = v;
+					const BlockId Id = GetBlock(Block[0], Block[1], Block[2]);
+					const BlockId Neighbour = GetBlock(Block[0] + FaceMask[Face][0], Block[1] + FaceMask[Face][1], Block[2] + FaceMask[Face][2]);
+					Mask[u + v * SizeU] = Id != Blocks::Air && (Neighbour == Blocks::Air || Neighbour == Blocks::Leaves) ? 1 : 0;
+				}
+			}
+
+			for (int32_t v = 0; v < SizeV; v++)
+			{
+				for (int32_t u = 0; u < SizeU; u++)
+				{
+					if (!Mask[u + v * SizeU])
+						continue;
+
+					int32_t Width = 1;
+					while (u + Width < SizeU && Mask[u + Width + v * SizeU])
+						Width++;
+
+					int32_t Height = 1;
+					for (bool RowIsFull = true; v + Height < SizeV && RowIsFull; )
+					{
+						for (int32_t i = 0; i < Width && RowIsFull; i++)
+							RowIsFull = Mask[u + i + (v + Height) * SizeU] != 0;
+						if (RowIsFull)
+							Height++;
+					}
+
+					for (int32_t j = 0; j < Height; j++)
+						for (int32_t i = 0; i < Width; i++)
+							Mask[u + i + (v + j) * SizeU] = 0;
+
+					// The rectangle is one side of the box of blocks it covers, so its corners
+					// are picked the same way as a single block's.
+					int32_t Min[3], Max[3];
+					Min[Axis] = Max[Axis] = Slice;
+					Min[AxisU] = u;
+					Max[AxisU] = u + Width - 1;
+					Min[AxisV] = v;
+					Max[AxisV] = v + Height - 1;
+					const float X0 = Min[0] * 100 - 50.f, X1 = Max[0] * 100 + 50.f;
+					const float Y0 = Min[1] * 100 - 50.f, Y1 = Max[1] * 100 + 50.f;
+					const float Z0 = Min[2] * 100 - 50.f, Z1 = Max[2] * 100 + 50.f;
+					const Vec3 Corners[8] =
+					{
+						{ X0, Y0, Z1 }, { X1, Y0, Z1 }, { X1, Y0, Z0 }, { X0, Y0, Z0 },
+						{ X0, Y1, Z1 }, { X1, Y1, Z1 }, { X1, Y1, Z0 }, { X0, Y1, Z0 }
+					};
+
+					const int32_t FirstVertex = (int32_t)OutVertices.size();
+					for (int32_t t = 0; t < 6; t++)
+						OutTriangles.push_back(FaceTriangles[t] + FirstVertex);
+					for (int32_t c = 0; c < 4; c++)
+						OutVertices.push_back(Corners[FaceCorners[Face][c]]);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool ChunkMesher::ValidateMeshSections(const std::vector<MeshSection>& Sections, std::string& OutError)
+{
+	char Buffer[256];
+	for (size_t i = 0; i < Sections.size(); i++)
+	{
+		const MeshSection& Section = Sections[i];
+		const size_t NumVertices = Section.Vertices.size();
+
+		if (Section.Normals.size() != NumVertices || Section.UVs.size() != NumVertices || Section.VertexColors.size() != NumVertices)
+		{
+			snprintf(Buffer, sizeof(Buffer), "section %d has %d vertices but %d normals, %d UVs and %d colors.",
+				(int)i, (int)NumVertices, (int)Section.Normals.size(), (int)Section.UVs.size(), (int)Section.VertexColors.size());
+			OutError = Buffer;
+			return false;
+		}
+
+		if (Section.Triangles.size() % 3 != 0)
+		{
+			snprintf(Buffer, sizeof(Buffer), "section %d has %d triangle indices, not a multiple of 3.", (int)i, (int)Section.Triangles.size());
+			OutError = Buffer;
+			return false;
+		}
+
+		for (int32_t Index : Section.Triangles)
+		{
+			if (Index < 0 || Index >= (int32_t)NumVertices)
+			{
+				snprintf(Buffer, sizeof(Buffer), "section %d references vertex %d of %d.", (int)i, Index, (int)NumVertices);
+				OutError = Buffer;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+}
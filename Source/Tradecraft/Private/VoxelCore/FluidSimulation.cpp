@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/FluidSimulation.h"
+#include <algorithm>
+
+namespace VoxelCore
+{
+	static const BlockPos FluidUp = { 0, 0, 1 };
+
+	static const BlockPos FluidSideways[] =
+	{
+		{ 1, 0, 0 }, { -1, 0, 0 },
+		{ 0, 1, 0 }, { 0, -1, 0 },
+	};
+
+	void FluidSimulation::Initialize(const ChunkLayout& InLayout)
+	{
+		Layout = InLayout;
+		Fluids.clear();
+		Levels.clear();
+	}
+
+	bool FluidSimulation::AddFluid(const FluidType& Fluid)
+	{
+		if (Fluid.SourceId < 0 || Fluid.FlowingId < 0 || Fluid.MaxLevel <= 0 || Fluid.MaxLevel >= 255)
+			return false;
+
+		Fluids.push_back(Fluid);
+		return true;
+	}
+
+	void FluidSimulation::RegisterBehaviors(BlockTickScheduler& Scheduler)
+	{
+		for (int32_t i = 0; i < (int32_t)Fluids.size(); i++)
+		{
+			BlockTickBehavior Behavior;
+			Behavior.OnScheduledTick = [this, i](BlockTickScheduler& Ticks, const BlockPos& Block)
+			{
+				UpdateCell(Ticks, Block, i);
+			};
+			Behavior.NeighborChangeDelay = Fluids[i].TickDelay;
+			Behavior.bScheduleOnLoad = true;
+			Scheduler.RegisterBehavior(Fluids[i].SourceId, Behavior);
+			Scheduler.RegisterBehavior(Fluids[i].FlowingId, Behavior);
+		}
+	}
+
+	void FluidSimulation::RemoveChunk(int32_t ChunkX, int32_t ChunkY)
+	{
+		Levels.erase(MakeKey(ChunkX, ChunkY));
+	}
+
+	int32_t FluidSimulation::GetLevel(const BlockTickScheduler& Ticks, const BlockPos& Block) const
+	{
+		const int32_t FluidIndex = FindFluid(Ticks.GetBlock(Block));
+		return FluidIndex != IndexNone ? GetFluidLevel(Ticks, Block, Fluids[FluidIndex]) : 0;
+	}
+
+	int32_t FluidSimulation::GetNumFlowingCells() const
+	{
+		int32_t Count = 0;
+		for (const auto& Elem : Levels)
+			Count += (int32_t)Elem.second.size();
+		return Count;
+	}
+
+	int64_t FluidSimulation::GetAllocatedSize() const
+	{
+		// Buckets plus one node per entry, which is close for the common implementations.
+		const int64_t OuterNode = sizeof(void*) + sizeof(std::pair<const uint64_t, ChunkLevels>);
+		const int64_t InnerNode = sizeof(void*) + sizeof(std::pair<const int32_t, uint8_t>);
+		int64_t Size = (int64_t)Levels.bucket_count() * sizeof(void*) + (int64_t)Levels.size() * OuterNode;
+		for (const auto& Elem : Levels)
+			Size += (int64_t)Elem.second.bucket_count() * sizeof(void*) + (int64_t)Elem.second.size() * InnerNode;
+		return Size;
+	}
+
+	int32_t FluidSimulation::FindFluid(BlockId Id) const
+	{
+		for (int32_t i = 0; i < (int32_t)Fluids.size(); i++)
+		{
+			if (Fluids[i].SourceId == Id || Fluids[i].FlowingId == Id)
+				return i;
+		}
+		return IndexNone;
+	}
+
+	int32_t FluidSimulation::GetLocalIndex(const BlockPos& Block) const
+	{
+		const int32_t LocalX = Block.X - FloorDiv(Block.X, Layout.Width) * Layout.Width;
+		const int32_t LocalY = Block.Y - FloorDiv(Block.Y, Layout.Width) * Layout.Width;
+		return Block.Z + LocalY * Layout.Height + LocalX * Layout.Width * Layout.Height;
+	}
+
+	int32_t FluidSimulation::GetFluidLevel(const BlockTickScheduler& Ticks, const BlockPos& Block, const FluidType& Fluid) const
+	{
+		const BlockId Id = Ticks.GetBlock(Block);
+		if (Id == Fluid.SourceId)
+			return Fluid.MaxLevel + 1;
+		if (Id != Fluid.FlowingId)
+			return 0;
+
+		// A flowing cell whose level was lost with its chunk starts from the bottom and is raised
+		// by its own tick.
+		auto Chunk = Levels.find(GetChunkKey(Block));
+		if (Chunk == Levels.end())
+			return 1;
+		auto Level = Chunk->second.find(GetLocalIndex(Block));
+		return Level != Chunk->second.end() ? Level->second : 1;
+	}
+
+	void FluidSimulation::SetLevel(const BlockPos& Block, int32_t Level)
+	{
+		Levels[GetChunkKey(Block)][GetLocalIndex(Block)] = (uint8_t)Level;
+	}
+
+	void FluidSimulation::ClearLevel(const BlockPos& Block)
+	{
+		auto Chunk = Levels.find(GetChunkKey(Block));
+		if (Chunk == Levels.end())
+			return;
+
+		Chunk->second.erase(GetLocalIndex(Block));
+		if (Chunk->second.empty())
+			Levels.erase(Chunk);
+	}
+
+	bool FluidSimulation::FlowInto(BlockTickScheduler& Ticks, const BlockPos& Block, const FluidType& Fluid, int32_t Level)
+	{
+		if (!Ticks.IsBlockLoaded(Block) || Ticks.GetBlock(Block) != Blocks::Air)
+			return false;
+
+		// The level has to be there before the new cell's first tick.
+		SetLevel(Block, Level);
+		Ticks.SetBlock(Block, Fluid.FlowingId);
+		return true;
+	}
+
+	void FluidSimulation::UpdateCell(BlockTickScheduler& Ticks, const BlockPos& Block, int32_t FluidIndex)
+	{
+		const FluidType& Fluid = Fluids[FluidIndex];
+		const bool IsSource = Ticks.GetBlock(Block) == Fluid.SourceId;
+
+		const BlockId HardenedId = IsSource ? Fluid.HardenedSourceId : Fluid.HardenedFlowingId;
+		if (HardenedId != IndexNone)
+		{
+			const BlockPos Touching[] = { Block + FluidUp, Block - FluidUp, Block + FluidSideways[0], Block + FluidSideways[1], Block + FluidSideways[2], Block + FluidSideways[3] };
+			for (const BlockPos& Neighbor : Touching)
+			{
+				const int32_t Other = FindFluid(Ticks.GetBlock(Neighbor));
+				if (Other != IndexNone && Other != FluidIndex)
+				{
+					ClearLevel(Block);
+					Ticks.SetBlock(Block, HardenedId);
+					return;
+				}
+			}
+		}
+
+		int32_t Level = Fluid.MaxLevel + 1;
+		if (!IsSource)
+		{
+			// Falling fluid is full; otherwise a cell is one level below its highest neighbour.
+			int32_t Wanted = 0;
+			if (FindFluid(Ticks.GetBlock(Block + FluidUp)) == FluidIndex)
+			{
+				Wanted = Fluid.MaxLevel;
+			}
+			else
+			{
+				for (const BlockPos& Offset : FluidSideways)
+					Wanted = std::max(Wanted, GetFluidLevel(Ticks, Block + Offset, Fluid) - 1);
+			}
+
+			if (Wanted <= 0)
+			{
+				ClearLevel(Block);
+				Ticks.SetBlock(Block, Blocks::Air);
+				return;
+			}
+
+			Level = GetFluidLevel(Ticks, Block, Fluid);
+			if (Wanted != Level)
+			{
+				Level = Wanted;
+				SetLevel(Block, Level);
+				Ticks.WakeNeighbors(Block);
+			}
+		}
+
+		// Down first, and only sideways once it has landed on something other than itself.
+		const BlockPos Below = Block - FluidUp;
+		if (FlowInto(Ticks, Below, Fluid, Fluid.MaxLevel) || FindFluid(Ticks.GetBlock(Below)) == FluidIndex)
+			return;
+
+		if (Level <= 1)
+			return;
+
+		for (const BlockPos& Offset : FluidSideways)
+			FlowInto(Ticks, Block + Offset, Fluid, std::min(Level - 1, Fluid.MaxLevel));
+	}
+}
@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/HeightTileCache.h"
+#include "VoxelCore/ChunkGenerator.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace VoxelCore
+{
+
+HeightTileCache::HeightTileCache(const BiomeMap& InBiomes, int32_t InMaxTiles)
+	: Biomes(InBiomes)
+	, MaxTiles(InMaxTiles > 1 ? InMaxTiles : 1)
+	, NumHits(0)
+	, NumMisses(0)
+{
+}
+
+HeightTileCache::TilePtr HeightTileCache::BuildTile(int32_t ChunkX, int32_t ChunkY) const
+{
+	std::shared_ptr<HeightTile> Tile = std::make_shared<HeightTile>();
+	const int32_t BlockX = ChunkX * HeightTile::Size;
+	const int32_t BlockY = ChunkY * HeightTile::Size;
+	ChunkGenerator::SampleHeightmap(BlockX, BlockY, HeightTile::Size, HeightTile::Size, Tile->Heights);
+
+	Biomes.SampleArea(BlockX, BlockY, 1, HeightTile::Size, HeightTile::Size, Tile->Biomes);
+	for (int32_t i = 0; i < HeightTile::Size * HeightTile::Size; i++)
+		Tile->BiomeHeights[i] = FloorToInt(Tile->Heights[i] * Tile->Biomes[i].HeightScale + Tile->Biomes[i].HeightOffset);
+	return Tile;
+}
+
+HeightTileCache::TilePtr HeightTileCache::GetTile(int32_t ChunkX, int32_t ChunkY) const
+{
+	const uint64_t Key = MakeGridKey(ChunkX, ChunkY);
+	{
+		std::lock_guard<std::mutex> ScopeLock(Lock);
+		auto Cached = Tiles.find(Key);
+		if (Cached != Tiles.end())
+		{
+			Cached->second.LastUsed = ++UseCounter;
+			NumHits++;
+			return Cached->second.Tile;
+		}
+	}
+
+	// Built without the lock so workers generating different areas don't wait on each other.
+	// Two threads may race to build the same tile; the first one in wins and the other is dropped.
+	TilePtr Tile = BuildTile(ChunkX, ChunkY);
+	NumMisses++;
+
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+	auto Existing = Tiles.find(Key);
+	if (Existing != Tiles.end())
+	{
+		Existing->second.LastUsed = ++UseCounter;
+		return Existing->second.Tile;
+	}
+
+	if ((int32_t)Tiles.size() >= MaxTiles)
+	{
+		auto Oldest = Tiles.begin();
+		for (auto It = Tiles.begin(); It != Tiles.end(); ++It)
+		{
+			if (It->second.LastUsed < Oldest->second.LastUsed)
+				Oldest = It;
+		}
+		Tiles.erase(Oldest);
+	}
+
+	CachedTile& NewEntry = Tiles[Key];
+	NewEntry.Tile = Tile;
+	NewEntry.LastUsed = ++UseCounter;
+	return Tile;
+}
+
+int32_t HeightTileCache::GetColumnHeight(int32_t BlockX, int32_t BlockY, bool bBiomeHeights) const
+{
+	const int32_t ChunkX = FloorDiv(BlockX, HeightTile::Size);
+	const int32_t ChunkY = FloorDiv(BlockY, HeightTile::Size);
+	TilePtr Tile = GetTile(ChunkX, ChunkY);
+
+	const int32_t Index = (BlockY - ChunkY * HeightTile::Size) + ((BlockX - ChunkX * HeightTile::Size) * HeightTile::Size);
+	return bBiomeHeights ? Tile->BiomeHeights[Index] : FloorToInt(Tile->Heights[Index]);
+}
+
+BiomeSample HeightTileCache::GetColumnBiome(int32_t BlockX, int32_t BlockY) const
+{
+	const int32_t ChunkX = FloorDiv(BlockX, HeightTile::Size);
+	const int32_t ChunkY = FloorDiv(BlockY, HeightTile::Size);
+	TilePtr Tile = GetTile(ChunkX, ChunkY);
+
+	return Tile->Biomes[(BlockY - ChunkY * HeightTile::Size) + ((BlockX - ChunkX * HeightTile::Size) * HeightTile::Size)];
+}
+
+void HeightTileCache::GatherColumns(int32_t OriginX, int32_t OriginY, int32_t SizeX, int32_t SizeY, bool bBiomeHeights, std::vector<int32_t>& OutHeights, std::vector<BiomeSample>* OutBiomes) const
+{
+	OutHeights.resize(SizeX * SizeY);
+	if (OutBiomes)
+		OutBiomes->resize(SizeX * SizeY);
+
+	// Copy the overlap with each tile the area touches, fetching every tile once.
+	const int32_t FirstChunkX = FloorDiv(OriginX, HeightTile::Size);
+	const int32_t LastChunkX = FloorDiv(OriginX + SizeX - 1, HeightTile::Size);
+	const int32_t FirstChunkY = FloorDiv(OriginY, HeightTile::Size);
+	const int32_t LastChunkY = FloorDiv(OriginY + SizeY - 1, HeightTile::Size);
+
+	for (int32_t ChunkX = FirstChunkX; ChunkX <= LastChunkX; ChunkX++)
+	{
+		for (int32_t ChunkY = FirstChunkY; ChunkY <= LastChunkY; ChunkY++)
+		{
+			TilePtr Tile = GetTile(ChunkX, ChunkY);
+			const int32_t TileX = ChunkX * HeightTile::Size;
+			const int32_t TileY = ChunkY * HeightTile::Size;
+
+			const int32_t StartX = std::max(OriginX, TileX);
+			const int32_t EndX = std::min(OriginX + SizeX, TileX + HeightTile::Size);
+			const int32_t StartY = std::max(OriginY, TileY);
+			const int32_t EndY = std::min(OriginY + SizeY, TileY + HeightTile::Size);
+
+			for (int32_t BlockX = StartX; BlockX < EndX; BlockX++)
+			{
+				for (int32_t BlockY = StartY; BlockY < EndY; BlockY++)
+				{
+					const int32_t TileIndex = (BlockY - TileY) + ((BlockX - TileX) * HeightTile::Size);
+					const int32_t OutIndex = (BlockY - OriginY) + ((BlockX - OriginX) * SizeY);
+					OutHeights[OutIndex] = bBiomeHeights ? Tile->BiomeHeights[TileIndex] : FloorToInt(Tile->Heights[TileIndex]);
+					if (OutBiomes)
+						(*OutBiomes)[OutIndex] = Tile->Biomes[TileIndex];
+				}
+			}
+		}
+	}
+}
+
+void HeightTileCache::Empty()
+{
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+	Tiles.clear();
+}
+
+int32_t HeightTileCache::GetNumCachedTiles() const
+{
+	std::lock_guard<std::mutex> ScopeLock(Lock);
+	return (int32_t)Tiles.size();
+}
+
+std::string HeightTileCache::GetStatsString() const
+{
+	const int32_t Hits = NumHits.load();
+	const int32_t Misses = NumMisses.load();
+	const int32_t Lookups = Hits + Misses;
+	const int32_t NumCached = GetNumCachedTiles();
+
+	char Buffer[256];
+	snprintf(Buffer, sizeof(Buffer), "Height tiles: %d/%d cached (%.1f KB), %d hits, %d misses (%.1f%% hit rate)",
+		NumCached, MaxTiles, NumCached * sizeof(HeightTile) / 1024.0f,
+		Hits, Misses, Lookups > 0 ? 100.0f * Hits / Lookups : 0.0f);
+	return Buffer;
+}
+
+}
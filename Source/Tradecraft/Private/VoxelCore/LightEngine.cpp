@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/LightEngine.h"
+#include <algorithm>
+
+namespace VoxelCore
+{
+
+static const int32_t SkyChannel = 0;
+static const int32_t BlockChannel = 1;
+
+// Down is last, so the sky light rule can tell it apart.
+static const int32_t LightNeighbors[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+static const int32_t DownNeighbor = 5;
+
+static int32_t GetChannel(LightValue Light, int32_t Channel)
+{
+	return Channel == SkyChannel ? GetSkyLight(Light) : GetBlockLight(Light);
+}
+
+static LightValue SetChannel(LightValue Light, int32_t Channel, int32_t Value)
+{
+	return Channel == SkyChannel ? MakeLight(Value, GetBlockLight(Light)) : MakeLight(GetSkyLight(Light), Value);
+}
+
+LightProperties::LightProperties()
+{
+	for (int32_t Id = 0; Id < NumIds; Id++)
+	{
+		Opacity[Id] = MaxLight;
+		Emission[Id] = 0;
+	}
+	Opacity[Blocks::Air] = 0;
+	Opacity[Blocks::Leaves] = 1;
+}
+
+// ComputeChunk's view of one chunk's extended layout, in its own coordinates.
+struct ChunkLightAccess
+{
+	ConstBlockIdView ChunkData;
+	const ChunkLayout& Layout;
+	LightValue* Light;
+
+	bool IsLoaded(int32_t X, int32_t Y, int32_t Z) const
+	{
+		return X >= 0 && Y >= 0 && Z >= 0 && X < Layout.WidthExt && Y < Layout.WidthExt && Z < Layout.Height;
+	}
+	BlockId GetBlock(int32_t X, int32_t Y, int32_t Z) const { return ChunkData[Layout.Index(X, Y, Z)]; }
+	LightValue GetLight(int32_t X, int32_t Y, int32_t Z) const { return Light[Layout.Index(X, Y, Z)]; }
+	void SetLight(int32_t X, int32_t Y, int32_t Z, LightValue Value) { Light[Layout.Index(X, Y, Z)] = Value; }
+};
+
+template <typename AccessType>
+void LightEngine::RunAdd(AccessType& Access, int32_t Channel)
+{
+	std::vector<Node>& Queue = AddQueue[Channel];
+	for (size_t Head = 0; Head < Queue.size(); Head++)
+	{
+		const Node Current = Queue[Head];
+		const int32_t Light = GetChannel(Access.GetLight(Current.X, Current.Y, Current.Z), Channel);
+		if (Light <= 1)
+			continue;
+
+		for (int32_t d = 0; d < 6; d++)
+		{
+			const int32_t X = Current.X + LightNeighbors[d][0];
+			const int32_t Y = Current.Y + LightNeighbors[d][1];
+			const int32_t Z = Current.Z + LightNeighbors[d][2];
+			if (!Access.IsLoaded(X, Y, Z))
+				continue;
+
+			const int32_t Opacity = Properties.GetOpacity(Access.GetBlock(X, Y, Z));
+			if (Opacity >= MaxLight)
+				continue;
+
+			int32_t NewLight = Light - std::max(1, Opacity);
+			if (Channel == SkyChannel && d == DownNeighbor && Light == MaxLight && Opacity == 0)
+				NewLight = MaxLight;
+
+			const LightValue Neighbor = Access.GetLight(X, Y, Z);
+			if (GetChannel(Neighbor, Channel) >= NewLight)
+				continue;
+
+			Access.SetLight(X, Y, Z, SetChannel(Neighbor, Channel, NewLight));
+			Queue.push_back({ X, Y, Z, NewLight });
+		}
+	}
+	LastNumVisited += (int32_t)Queue.size();
+	Queue.clear();
+}
+
+template <typename AccessType>
+void LightEngine::RunRemove(AccessType& Access, int32_t Channel)
+{
+	std::vector<Node>& Queue = RemoveQueue[Channel];
+	for (size_t Head = 0; Head < Queue.size(); Head++)
+	{
+		const Node Current = Queue[Head];
+		for (int32_t d = 0; d < 6; d++)
+		{
+			const int32_t X = Current.X + LightNeighbors[d][0];
+			const int32_t Y = Current.Y + LightNeighbors[d][1];
+			const int32_t Z = Current.Z + LightNeighbors[d][2];
+			if (!Access.IsLoaded(X, Y, Z))
+				continue;
+
+			const LightValue Neighbor = Access.GetLight(X, Y, Z);
+			const int32_t NeighborLight = GetChannel(Neighbor, Channel);
+			if (NeighborLight == 0)
+				continue;
+
+			// Dimmer neighbours, and full sky light below full sky light, were lit from here.
+			const bool LitFromHere = NeighborLight < Current.Light
+				|| (Channel == SkyChannel && d == DownNeighbor && Current.Light == MaxLight && NeighborLight == MaxLight);
+			if (!LitFromHere)
+			{
+				// Lit from elsewhere, so it can light the cells just darkened.
+				AddQueue[Channel].push_back({ X, Y, Z, NeighborLight });
+				continue;
+			}
+
+			Access.SetLight(X, Y, Z, SetChannel(Neighbor, Channel, 0));
+			RemoveQueue[Channel].push_back({ X, Y, Z, NeighborLight });
+
+			const int32_t Emission = Channel == BlockChannel ? Properties.GetEmission(Access.GetBlock(X, Y, Z)) : 0;
+			if (Emission > 0)
+			{
+				Access.SetLight(X, Y, Z, SetChannel(Neighbor, Channel, Emission));
+				AddQueue[Channel].push_back({ X, Y, Z, Emission });
+			}
+		}
+	}
+	LastNumVisited += (int32_t)Queue.size();
+	Queue.clear();
+}
+
+void LightEngine::ComputeChunk(ConstBlockIdView ChunkData, const ChunkLayout& Layout, LightValue* OutLight)
+{
+	ChunkLightAccess Access = { ChunkData, Layout, OutLight };
+	LastNumVisited = 0;
+	std::fill(OutLight, OutLight + Layout.NumBlocks(), (LightValue)0);
+
+	// Sky light straight down each column, by the same rule RunAdd uses going down.
+	for (int32_t x = 0; x < Layout.WidthExt; x++)
+	{
+		for (int32_t y = 0; y < Layout.WidthExt; y++)
+		{
+			int32_t Light = MaxLight;
+			for (int32_t z = Layout.Height - 1; z >= 0 && Light > 0; z--)
+			{
+				const int32_t Index = Layout.Index(x, y, z);
+				const int32_t Opacity = Properties.GetOpacity(ChunkData[Index]);
+				if (Light < MaxLight || Opacity > 0)
+					Light = std::max(0, Light - std::max(1, Opacity));
+				OutLight[Index] = MakeLight(Light, 0);
+			}
+		}
+	}
+
+	for (int32_t x = 0; x < Layout.WidthExt; x++)
+	{
+		for (int32_t y = 0; y < Layout.WidthExt; y++)
+		{
+			for (int32_t z = 0; z < Layout.Height; z++)
+			{
+				const int32_t Index = Layout.Index(x, y, z);
+				const int32_t Emission = Properties.GetEmission(ChunkData[Index]);
+				if (Emission > 0)
+				{
+					OutLight[Index] = SetChannel(OutLight[Index], BlockChannel, Emission);
+					AddQueue[BlockChannel].push_back({ x, y, z, Emission });
+				}
+
+				// Sky light only has to spread from where it meets a darker cell beside it.
+				const int32_t Sky = GetSkyLight(OutLight[Index]);
+				if (Sky <= 1)
+					continue;
+				for (int32_t d = 0; d < 4; d++)
+				{
+					const int32_t NeighborX = x + LightNeighbors[d][0];
+					const int32_t NeighborY = y + LightNeighbors[d][1];
+					if (Access.IsLoaded(NeighborX, NeighborY, z) && GetSkyLight(OutLight[Layout.Index(NeighborX, NeighborY, z)]) < Sky - 1)
+					{
+						AddQueue[SkyChannel].push_back({ x, y, z, Sky });
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	RunAdd(Access, SkyChannel);
+	RunAdd(Access, BlockChannel);
+}
+
+void LightEngine::OnBlockChanged(LightAccess& Access, int32_t X, int32_t Y, int32_t Z)
+{
+	if (!Access.IsLoaded(X, Y, Z))
+		return;
+
+	LastNumVisited = 0;
+	const LightValue Old = Access.GetLight(X, Y, Z);
+	Access.SetLight(X, Y, Z, 0);
+	RemoveQueue[SkyChannel].push_back({ X, Y, Z, GetSkyLight(Old) });
+	RemoveQueue[BlockChannel].push_back({ X, Y, Z, GetBlockLight(Old) });
+	RunRemove(Access, SkyChannel);
+	RunRemove(Access, BlockChannel);
+
+	const int32_t Emission = Properties.GetEmission(Access.GetBlock(X, Y, Z));
+	if (Emission > 0)
+	{
+		Access.SetLight(X, Y, Z, MakeLight(GetSkyLight(Access.GetLight(X, Y, Z)), Emission));
+		AddQueue[BlockChannel].push_back({ X, Y, Z, Emission });
+	}
+
+	// Whatever is still lit around the block may now shine into or through it.
+	for (int32_t d = 0; d < 6; d++)
+	{
+		const int32_t NeighborX = X + LightNeighbors[d][0];
+		const int32_t NeighborY = Y + LightNeighbors[d][1];
+		const int32_t NeighborZ = Z + LightNeighbors[d][2];
+		if (!Access.IsLoaded(NeighborX, NeighborY, NeighborZ))
+			continue;
+		const LightValue Neighbor = Access.GetLight(NeighborX, NeighborY, NeighborZ);
+		AddQueue[SkyChannel].push_back({ NeighborX, NeighborY, NeighborZ, GetSkyLight(Neighbor) });
+		AddQueue[BlockChannel].push_back({ NeighborX, NeighborY, NeighborZ, GetBlockLight(Neighbor) });
+	}
+
+	RunAdd(Access, SkyChannel);
+	RunAdd(Access, BlockChannel);
+}
+
+void LightEngine::AddSeed(int32_t X, int32_t Y, int32_t Z)
+{
+	AddQueue[SkyChannel].push_back({ X, Y, Z, 0 });
+	AddQueue[BlockChannel].push_back({ X, Y, Z, 0 });
+}
+
+void LightEngine::Propagate(LightAccess& Access)
+{
+	LastNumVisited = 0;
+	RunAdd(Access, SkyChannel);
+	RunAdd(Access, BlockChannel);
+}
+
+}
@@ -0,0 +1,690 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/SimplexNoise.h"
+#include <atomic>
+#include <cstdlib>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define VC_SIMPLEX_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define VC_SIMPLEX_X86 0
+#endif
+
+#if defined(_MSC_VER)
+#define VC_FORCEINLINE __forceinline
+#else
+#define VC_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+// MSVC allows AVX2 intrinsics anywhere; clang and gcc need the functions using them marked.
+#if VC_SIMPLEX_X86 && (defined(__clang__) || defined(__GNUC__))
+#define VC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VC_TARGET_AVX2
+#endif
+
+namespace VoxelCore
+{
+
+
+static std::atomic<int> MaxISA(2);
+
+// Ken Perlin's reference permutation, repeated, plus zeroed padding for vector gathers.
+static unsigned char Perm[512 + 3] = { 151,160,137,91,90,15,
+131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
+88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
+77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
+102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
+135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
+5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
+223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
+129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
+251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
+49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
+138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180,
+151,160,137,91,90,15,
+131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
+88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
+77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
+102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
+135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
+5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
+223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
+129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
+251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
+49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
+138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+static const float SimplexF2 = 0.366025403f;
+static const float SimplexG2 = 0.211324865f;
+static const float SimplexF3 = 0.333333333f;
+static const float SimplexG3 = 0.166666667f;
+
+static VC_FORCEINLINE int FastFloor(float X)
+{
+	return X > 0 ? (int)X : ((int)X) - 1;
+}
+
+static VC_FORCEINLINE float Grad(int Hash, float X, float Y)
+{
+	int h = Hash & 7;
+	float u = h < 4 ? X : Y;
+	float v = h < 4 ? Y : X;
+	return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f*v : 2.0f*v);
+}
+
+static VC_FORCEINLINE float Grad(int Hash, float X, float Y, float Z)
+{
+	int h = Hash & 15;
+	float u = h < 8 ? X : Y;
+	float v = h < 4 ? Y : h == 12 || h == 14 ? X : Z;
+	return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+void SimplexNoise::SetSeed(int32_t Seed)
+{
+	// RandInit/RandRange(0, 255) as the engine implements them on top of the C runtime.
+	srand((unsigned int)Seed);
+	for (int i = 0; i < 256; ++i)
+	{
+		const float Fraction = rand() / (float)RAND_MAX;
+		int Next = (int)(Fraction * 256);
+		Next = Next < 255 ? Next : 255;
+		Perm[i] = (unsigned char)Next;
+		Perm[i + 256] = (unsigned char)Next;
+	}
+}
+
+const unsigned char* SimplexNoise::GetPermutationTable()
+{
+	return Perm;
+}
+
+float SimplexNoise::Noise2D(float x, float y)
+{
+	float n0, n1, n2;
+
+	float s = (x + y)*SimplexF2;
+	float xs = x + s;
+	float ys = y + s;
+	int i = FastFloor(xs);
+	int j = FastFloor(ys);
+
+	float t = (float)(i + j)*SimplexG2;
+	float X0 = i - t;
+	float Y0 = j - t;
+	float x0 = x - X0;
+	float y0 = y - Y0;
+
+	int i1, j1;
+	if (x0 > y0) { i1 = 1; j1 = 0; }
+	else { i1 = 0; j1 = 1; }
+
+	float x1 = x0 - i1 + SimplexG2;
+	float y1 = y0 - j1 + SimplexG2;
+	float x2 = x0 - 1.0f + 2.0f * SimplexG2;
+	float y2 = y0 - 1.0f + 2.0f * SimplexG2;
+
+	int ii = i & 0xff;
+	int jj = j & 0xff;
+
+	float t0 = 0.5f - x0*x0 - y0*y0;
+	if (t0 < 0.0f) n0 = 0.0f;
+	else {
+		t0 *= t0;
+		n0 = t0 * t0 * Grad(Perm[ii + Perm[jj]], x0, y0);
+	}
+
+	float t1 = 0.5f - x1*x1 - y1*y1;
+	if (t1 < 0.0f) n1 = 0.0f;
+	else {
+		t1 *= t1;
+		n1 = t1 * t1 * Grad(Perm[ii + i1 + Perm[jj + j1]], x1, y1);
+	}
+
+	float t2 = 0.5f - x2*x2 - y2*y2;
+	if (t2 < 0.0f) n2 = 0.0f;
+	else {
+		t2 *= t2;
+		n2 = t2 * t2 * Grad(Perm[ii + 1 + Perm[jj + 1]], x2, y2);
+	}
+
+	return 40.0f * (n0 + n1 + n2);
+}
+
+float SimplexNoise::Noise3D(float x, float y, float z)
+{
+	float n0, n1, n2, n3;
+
+	float s = (x + y + z)*SimplexF3;
+	float xs = x + s;
+	float ys = y + s;
+	float zs = z + s;
+	int i = FastFloor(xs);
+	int j = FastFloor(ys);
+	int k = FastFloor(zs);
+
+	float t = (float)(i + j + k)*SimplexG3;
+	float X0 = i - t;
+	float Y0 = j - t;
+	float Z0 = k - t;
+	float x0 = x - X0;
+	float y0 = y - Y0;
+	float z0 = z - Z0;
+
+	int i1, j1, k1;
+	int i2, j2, k2;
+	if (x0 >= y0) {
+		if (y0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+		else if (x0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1; }
+		else { i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1; }
+	}
+	else {
+		if (y0 < z0) { i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1; }
+		else if (x0 < z0) { i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1; }
+		else { i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+	}
+
+	float x1 = x0 - i1 + SimplexG3;
+	float y1 = y0 - j1 + SimplexG3;
+	float z1 = z0 - k1 + SimplexG3;
+	float x2 = x0 - i2 + 2.0f*SimplexG3;
+	float y2 = y0 - j2 + 2.0f*SimplexG3;
+	float z2 = z0 - k2 + 2.0f*SimplexG3;
+	float x3 = x0 - 1.0f + 3.0f*SimplexG3;
+	float y3 = y0 - 1.0f + 3.0f*SimplexG3;
+	float z3 = z0 - 1.0f + 3.0f*SimplexG3;
+
+	int ii = i & 0xff;
+	int jj = j & 0xff;
+	int kk = k & 0xff;
+
+	float t0 = 0.6f - x0*x0 - y0*y0 - z0*z0;
+	if (t0 < 0.0f) n0 = 0.0f;
+	else {
+		t0 *= t0;
+		n0 = t0 * t0 * Grad(Perm[ii + Perm[jj + Perm[kk]]], x0, y0, z0);
+	}
+
+	float t1 = 0.6f - x1*x1 - y1*y1 - z1*z1;
+	if (t1 < 0.0f) n1 = 0.0f;
+	else {
+		t1 *= t1;
+		n1 = t1 * t1 * Grad(Perm[ii + i1 + Perm[jj + j1 + Perm[kk + k1]]], x1, y1, z1);
+	}
+
+	float t2 = 0.6f - x2*x2 - y2*y2 - z2*z2;
+	if (t2 < 0.0f) n2 = 0.0f;
+	else {
+		t2 *= t2;
+		n2 = t2 * t2 * Grad(Perm[ii + i2 + Perm[jj + j2 + Perm[kk + k2]]], x2, y2, z2);
+	}
+
+	float t3 = 0.6f - x3*x3 - y3*y3 - z3*z3;
+	if (t3 < 0.0f) n3 = 0.0f;
+	else {
+		t3 *= t3;
+		n3 = t3 * t3 * Grad(Perm[ii + 1 + Perm[jj + 1 + Perm[kk + 1]]], x3, y3, z3);
+	}
+
+	return 32.0f * (n0 + n1 + n2 + n3);
+}
+
+#if VC_SIMPLEX_X86
+
+namespace SSE
+{
+	VC_FORCEINLINE __m128 Select(__m128 Mask, __m128 A, __m128 B)
+	{
+		return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+	}
+
+	VC_FORCEINLINE __m128 MaskToOne(__m128 Mask)
+	{
+		return _mm_and_ps(Mask, _mm_set1_ps(1.0f));
+	}
+
+	VC_FORCEINLINE __m128i MaskToInt(__m128 Mask)
+	{
+		return _mm_and_si128(_mm_castps_si128(Mask), _mm_set1_epi32(1));
+	}
+
+	// FASTFLOOR: truncate, then step down for anything not above zero.
+	VC_FORCEINLINE __m128i FastFloor(__m128 V)
+	{
+		return _mm_add_epi32(_mm_cvttps_epi32(V), _mm_castps_si128(_mm_cmple_ps(V, _mm_setzero_ps())));
+	}
+
+	// SSE2 has no gather, so the table lookups stay scalar.
+	VC_FORCEINLINE __m128i Lookup(const unsigned char* Perm, __m128i Index)
+	{
+		alignas(16) int32_t I[4];
+		_mm_store_si128((__m128i*)I, Index);
+		return _mm_setr_epi32(Perm[I[0]], Perm[I[1]], Perm[I[2]], Perm[I[3]]);
+	}
+
+	// Sign bit set in every lane whose hash has Bit set.
+	VC_FORCEINLINE __m128 SignFromBit(__m128i H, int32_t Bit)
+	{
+		const __m128i Set = _mm_cmpeq_epi32(_mm_and_si128(H, _mm_set1_epi32(Bit)), _mm_set1_epi32(Bit));
+		return _mm_castsi128_ps(_mm_and_si128(Set, _mm_set1_epi32(0x80000000)));
+	}
+
+	VC_FORCEINLINE __m128 Grad2(__m128i Hash, __m128 X, __m128 Y)
+	{
+		const __m128i H = _mm_and_si128(Hash, _mm_set1_epi32(7));
+		const __m128 Low = _mm_castsi128_ps(_mm_cmplt_epi32(H, _mm_set1_epi32(4)));
+		const __m128 U = Select(Low, X, Y);
+		__m128 V = Select(Low, Y, X);
+		V = _mm_mul_ps(_mm_set1_ps(2.0f), V);
+		return _mm_add_ps(_mm_xor_ps(U, SignFromBit(H, 1)), _mm_xor_ps(V, SignFromBit(H, 2)));
+	}
+
+	VC_FORCEINLINE __m128 Grad3(__m128i Hash, __m128 X, __m128 Y, __m128 Z)
+	{
+		const __m128i H = _mm_and_si128(Hash, _mm_set1_epi32(15));
+		const __m128 Below8 = _mm_castsi128_ps(_mm_cmplt_epi32(H, _mm_set1_epi32(8)));
+		const __m128 Below4 = _mm_castsi128_ps(_mm_cmplt_epi32(H, _mm_set1_epi32(4)));
+		const __m128 Is12Or14 = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(H, _mm_set1_epi32(12)), _mm_cmpeq_epi32(H, _mm_set1_epi32(14))));
+		const __m128 U = Select(Below8, X, Y);
+		const __m128 V = Select(Below4, Y, Select(Is12Or14, X, Z));
+		return _mm_add_ps(_mm_xor_ps(U, SignFromBit(H, 1)), _mm_xor_ps(V, SignFromBit(H, 2)));
+	}
+
+	VC_FORCEINLINE __m128 Corner2(__m128i Hash, __m128 X, __m128 Y)
+	{
+		__m128 T = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(X, X)), _mm_mul_ps(Y, Y));
+		const __m128 Inside = _mm_cmpge_ps(T, _mm_setzero_ps());
+		T = _mm_mul_ps(T, T);
+		return _mm_and_ps(Inside, _mm_mul_ps(_mm_mul_ps(T, T), Grad2(Hash, X, Y)));
+	}
+
+	VC_FORCEINLINE __m128 Corner3(__m128i Hash, __m128 X, __m128 Y, __m128 Z)
+	{
+		__m128 T = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.6f), _mm_mul_ps(X, X)), _mm_mul_ps(Y, Y)), _mm_mul_ps(Z, Z));
+		const __m128 Inside = _mm_cmpge_ps(T, _mm_setzero_ps());
+		T = _mm_mul_ps(T, T);
+		return _mm_and_ps(Inside, _mm_mul_ps(_mm_mul_ps(T, T), Grad3(Hash, X, Y, Z)));
+	}
+
+	static void Noise2D(const unsigned char* Perm, const float* InX, const float* InY, float* Out)
+	{
+		const __m128 X = _mm_loadu_ps(InX);
+		const __m128 Y = _mm_loadu_ps(InY);
+		const __m128i One = _mm_set1_epi32(1);
+		const __m128i Wrap = _mm_set1_epi32(0xff);
+
+		const __m128 S = _mm_mul_ps(_mm_add_ps(X, Y), _mm_set1_ps(SimplexF2));
+		const __m128i I = FastFloor(_mm_add_ps(X, S));
+		const __m128i J = FastFloor(_mm_add_ps(Y, S));
+
+		const __m128 T = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(I, J)), _mm_set1_ps(SimplexG2));
+		const __m128 X0 = _mm_sub_ps(X, _mm_sub_ps(_mm_cvtepi32_ps(I), T));
+		const __m128 Y0 = _mm_sub_ps(Y, _mm_sub_ps(_mm_cvtepi32_ps(J), T));
+
+		const __m128 Lower = _mm_cmpgt_ps(X0, Y0);
+		const __m128 Upper = _mm_cmple_ps(X0, Y0);
+
+		const __m128 X1 = _mm_add_ps(_mm_sub_ps(X0, MaskToOne(Lower)), _mm_set1_ps(SimplexG2));
+		const __m128 Y1 = _mm_add_ps(_mm_sub_ps(Y0, MaskToOne(Upper)), _mm_set1_ps(SimplexG2));
+		const __m128 X2 = _mm_add_ps(_mm_sub_ps(X0, _mm_set1_ps(1.0f)), _mm_set1_ps(2.0f * SimplexG2));
+		const __m128 Y2 = _mm_add_ps(_mm_sub_ps(Y0, _mm_set1_ps(1.0f)), _mm_set1_ps(2.0f * SimplexG2));
+
+		const __m128i II = _mm_and_si128(I, Wrap);
+		const __m128i JJ = _mm_and_si128(J, Wrap);
+
+		const __m128i H0 = Lookup(Perm, _mm_add_epi32(II, Lookup(Perm, JJ)));
+		const __m128i H1 = Lookup(Perm, _mm_add_epi32(_mm_add_epi32(II, MaskToInt(Lower)), Lookup(Perm, _mm_add_epi32(JJ, MaskToInt(Upper)))));
+		const __m128i H2 = Lookup(Perm, _mm_add_epi32(_mm_add_epi32(II, One), Lookup(Perm, _mm_add_epi32(JJ, One))));
+
+		const __m128 N = _mm_add_ps(_mm_add_ps(Corner2(H0, X0, Y0), Corner2(H1, X1, Y1)), Corner2(H2, X2, Y2));
+		_mm_storeu_ps(Out, _mm_mul_ps(_mm_set1_ps(40.0f), N));
+	}
+
+	static void Noise3D(const unsigned char* Perm, const float* InX, const float* InY, const float* InZ, float* Out)
+	{
+		const __m128 X = _mm_loadu_ps(InX);
+		const __m128 Y = _mm_loadu_ps(InY);
+		const __m128 Z = _mm_loadu_ps(InZ);
+		const __m128i One = _mm_set1_epi32(1);
+		const __m128i Wrap = _mm_set1_epi32(0xff);
+		const __m128 AllBits = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		const __m128 S = _mm_mul_ps(_mm_add_ps(_mm_add_ps(X, Y), Z), _mm_set1_ps(SimplexF3));
+		const __m128i I = FastFloor(_mm_add_ps(X, S));
+		const __m128i J = FastFloor(_mm_add_ps(Y, S));
+		const __m128i K = FastFloor(_mm_add_ps(Z, S));
+
+		const __m128 T = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(I, J), K)), _mm_set1_ps(SimplexG3));
+		const __m128 X0 = _mm_sub_ps(X, _mm_sub_ps(_mm_cvtepi32_ps(I), T));
+		const __m128 Y0 = _mm_sub_ps(Y, _mm_sub_ps(_mm_cvtepi32_ps(J), T));
+		const __m128 Z0 = _mm_sub_ps(Z, _mm_sub_ps(_mm_cvtepi32_ps(K), T));
+
+		// The scalar branch tree over x0 >= y0, y0 >= z0 and x0 >= z0, flattened into masks.
+		const __m128 A = _mm_cmpge_ps(X0, Y0);
+		const __m128 B = _mm_cmpge_ps(Y0, Z0);
+		const __m128 C = _mm_cmpge_ps(X0, Z0);
+		const __m128 I1 = _mm_and_ps(A, C);
+		const __m128 J1 = _mm_andnot_ps(A, B);
+		const __m128 K1 = _mm_andnot_ps(_mm_or_ps(B, C), AllBits);
+		const __m128 I2 = _mm_or_ps(A, C);
+		const __m128 J2 = _mm_or_ps(_mm_andnot_ps(A, AllBits), B);
+		const __m128 K2 = _mm_andnot_ps(_mm_and_ps(B, C), AllBits);
+
+		const __m128 X1 = _mm_add_ps(_mm_sub_ps(X0, MaskToOne(I1)), _mm_set1_ps(SimplexG3));
+		const __m128 Y1 = _mm_add_ps(_mm_sub_ps(Y0, MaskToOne(J1)), _mm_set1_ps(SimplexG3));
+		const __m128 Z1 = _mm_add_ps(_mm_sub_ps(Z0, MaskToOne(K1)), _mm_set1_ps(SimplexG3));
+		const __m128 X2 = _mm_add_ps(_mm_sub_ps(X0, MaskToOne(I2)), _mm_set1_ps(2.0f * SimplexG3));
+		const __m128 Y2 = _mm_add_ps(_mm_sub_ps(Y0, MaskToOne(J2)), _mm_set1_ps(2.0f * SimplexG3));
+		const __m128 Z2 = _mm_add_ps(_mm_sub_ps(Z0, MaskToOne(K2)), _mm_set1_ps(2.0f * SimplexG3));
+		const __m128 X3 = _mm_add_ps(_mm_sub_ps(X0, _mm_set1_ps(1.0f)), _mm_set1_ps(3.0f * SimplexG3));
+		const __m128 Y3 = _mm_add_ps(_mm_sub_ps(Y0, _mm_set1_ps(1.0f)), _mm_set1_ps(3.0f * SimplexG3));
+		const __m128 Z3 = _mm_add_ps(_mm_sub_ps(Z0, _mm_set1_ps(1.0f)), _mm_set1_ps(3.0f * SimplexG3));
+
+		const __m128i II = _mm_and_si128(I, Wrap);
+		const __m128i JJ = _mm_and_si128(J, Wrap);
+		const __m128i KK = _mm_and_si128(K, Wrap);
+
+		const __m128i H0 = Lookup(Perm, _mm_add_epi32(II, Lookup(Perm, _mm_add_epi32(JJ, Lookup(Perm, KK)))));
+		const __m128i H1 = Lookup(Perm, _mm_add_epi32(_mm_add_epi32(II, MaskToInt(I1)),
+			Lookup(Perm, _mm_add_epi32(_mm_add_epi32(JJ, MaskToInt(J1)), Lookup(Perm, _mm_add_epi32(KK, MaskToInt(K1)))))));
+		const __m128i H2 = Lookup(Perm, _mm_add_epi32(_mm_add_epi32(II, MaskToInt(I2)),
+			Lookup(Perm, _mm_add_epi32(_mm_add_epi32(JJ, MaskToInt(J2)), Lookup(Perm, _mm_add_epi32(KK, MaskToInt(K2)))))));
+		const __m128i H3 = Lookup(Perm, _mm_add_epi32(_mm_add_epi32(II, One),
+			Lookup(Perm, _mm_add_epi32(_mm_add_epi32(JJ, One), Lookup(Perm, _mm_add_epi32(KK, One))))));
+
+		const __m128 N = _mm_add_ps(_mm_add_ps(_mm_add_ps(Corner3(H0, X0, Y0, Z0), Corner3(H1, X1, Y1, Z1)), Corner3(H2, X2, Y2, Z2)), Corner3(H3, X3, Y3, Z3));
+		_mm_storeu_ps(Out, _mm_mul_ps(_mm_set1_ps(32.0f), N));
+	}
+}
+
+namespace AVX2
+{
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 MaskToOne(__m256 Mask)
+	{
+		return _mm256_and_ps(Mask, _mm256_set1_ps(1.0f));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256i MaskToInt(__m256 Mask)
+	{
+		return _mm256_and_si256(_mm256_castps_si256(Mask), _mm256_set1_epi32(1));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256i FastFloor(__m256 V)
+	{
+		return _mm256_add_epi32(_mm256_cvttps_epi32(V), _mm256_castps_si256(_mm256_cmp_ps(V, _mm256_setzero_ps(), _CMP_LE_OQ)));
+	}
+
+	// Gathers 4 bytes per lane and keeps the first; the table is padded so the last entry can be read this way.
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256i Lookup(const unsigned char* Perm, __m256i Index)
+	{
+		return _mm256_and_si256(_mm256_i32gather_epi32((const int*)Perm, Index, 1), _mm256_set1_epi32(0xff));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 SignFromBit(__m256i H, int32_t Bit)
+	{
+		const __m256i Set = _mm256_cmpeq_epi32(_mm256_and_si256(H, _mm256_set1_epi32(Bit)), _mm256_set1_epi32(Bit));
+		return _mm256_castsi256_ps(_mm256_and_si256(Set, _mm256_set1_epi32(0x80000000)));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 Grad2(__m256i Hash, __m256 X, __m256 Y)
+	{
+		const __m256i H = _mm256_and_si256(Hash, _mm256_set1_epi32(7));
+		const __m256 Low = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), H));
+		const __m256 U = _mm256_blendv_ps(Y, X, Low);
+		__m256 V = _mm256_blendv_ps(X, Y, Low);
+		V = _mm256_mul_ps(_mm256_set1_ps(2.0f), V);
+		return _mm256_add_ps(_mm256_xor_ps(U, SignFromBit(H, 1)), _mm256_xor_ps(V, SignFromBit(H, 2)));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 Grad3(__m256i Hash, __m256 X, __m256 Y, __m256 Z)
+	{
+		const __m256i H = _mm256_and_si256(Hash, _mm256_set1_epi32(15));
+		const __m256 Below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), H));
+		const __m256 Below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), H));
+		const __m256 Is12Or14 = _mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(H, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(H, _mm256_set1_epi32(14))));
+		const __m256 U = _mm256_blendv_ps(Y, X, Below8);
+		const __m256 V = _mm256_blendv_ps(_mm256_blendv_ps(Z, X, Is12Or14), Y, Below4);
+		return _mm256_add_ps(_mm256_xor_ps(U, SignFromBit(H, 1)), _mm256_xor_ps(V, SignFromBit(H, 2)));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 Corner2(__m256i Hash, __m256 X, __m256 Y)
+	{
+		__m256 T = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(X, X)), _mm256_mul_ps(Y, Y));
+		const __m256 Inside = _mm256_cmp_ps(T, _mm256_setzero_ps(), _CMP_GE_OQ);
+		T = _mm256_mul_ps(T, T);
+		return _mm256_and_ps(Inside, _mm256_mul_ps(_mm256_mul_ps(T, T), Grad2(Hash, X, Y)));
+	}
+
+	VC_TARGET_AVX2 VC_FORCEINLINE __m256 Corner3(__m256i Hash, __m256 X, __m256 Y, __m256 Z)
+	{
+		__m256 T = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.6f), _mm256_mul_ps(X, X)), _mm256_mul_ps(Y, Y)), _mm256_mul_ps(Z, Z));
+		const __m256 Inside = _mm256_cmp_ps(T, _mm256_setzero_ps(), _CMP_GE_OQ);
+		T = _mm256_mul_ps(T, T);
+		return _mm256_and_ps(Inside, _mm256_mul_ps(_mm256_mul_ps(T, T), Grad3(Hash, X, Y, Z)));
+	}
+
+	VC_TARGET_AVX2 static void Noise2D(const unsigned char* Perm, const float* InX, const float* InY, float* Out)
+	{
+		const __m256 X = _mm256_loadu_ps(InX);
+		const __m256 Y = _mm256_loadu_ps(InY);
+		const __m256i One = _mm256_set1_epi32(1);
+		const __m256i Wrap = _mm256_set1_epi32(0xff);
+
+		const __m256 S = _mm256_mul_ps(_mm256_add_ps(X, Y), _mm256_set1_ps(SimplexF2));
+		const __m256i I = FastFloor(_mm256_add_ps(X, S));
+		const __m256i J = FastFloor(_mm256_add_ps(Y, S));
+
+		const __m256 T = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(I, J)), _mm256_set1_ps(SimplexG2));
+		const __m256 X0 = _mm256_sub_ps(X, _mm256_sub_ps(_mm256_cvtepi32_ps(I), T));
+		const __m256 Y0 = _mm256_sub_ps(Y, _mm256_sub_ps(_mm256_cvtepi32_ps(J), T));
+
+		const __m256 Lower = _mm256_cmp_ps(X0, Y0, _CMP_GT_OQ);
+		const __m256 Upper = _mm256_cmp_ps(X0, Y0, _CMP_LE_OQ);
+
+		const __m256 X1 = _mm256_add_ps(_mm256_sub_ps(X0, MaskToOne(Lower)), _mm256_set1_ps(SimplexG2));
+		const __m256 Y1 = _mm256_add_ps(_mm256_sub_ps(Y0, MaskToOne(Upper)), _mm256_set1_ps(SimplexG2));
+		const __m256 X2 = _mm256_add_ps(_mm256_sub_ps(X0, _mm256_set1_ps(1.0f)), _mm256_set1_ps(2.0f * SimplexG2));
+		const __m256 Y2 = _mm256_add_ps(_mm256_sub_ps(Y0, _mm256_set1_ps(1.0f)), _mm256_set1_ps(2.0f * SimplexG2));
+
+		const __m256i II = _mm256_and_si256(I, Wrap);
+		const __m256i JJ = _mm256_and_si256(J, Wrap);
+
+		const __m256i H0 = Lookup(Perm, _mm256_add_epi32(II, Lookup(Perm, JJ)));
+		const __m256i H1 = Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(II, MaskToInt(Lower)), Lookup(Perm, _mm256_add_epi32(JJ, MaskToInt(Upper)))));
+		const __m256i H2 = Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(II, One), Lookup(Perm, _mm256_add_epi32(JJ, One))));
+
+		const __m256 N = _mm256_add_ps(_mm256_add_ps(Corner2(H0, X0, Y0), Corner2(H1, X1, Y1)), Corner2(H2, X2, Y2));
+		_mm256_storeu_ps(Out, _mm256_mul_ps(_mm256_set1_ps(40.0f), N));
+	}
+
+	VC_TARGET_AVX2 static void Noise3D(const unsigned char* Perm, const float* InX, const float* InY, const float* InZ, float* Out)
+	{
+		const __m256 X = _mm256_loadu_ps(InX);
+		const __m256 Y = _mm256_loadu_ps(InY);
+		const __m256 Z = _mm256_loadu_ps(InZ);
+		const __m256i One = _mm256_set1_epi32(1);
+		const __m256i Wrap = _mm256_set1_epi32(0xff);
+		const __m256 AllBits = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		const __m256 S = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(X, Y), Z), _mm256_set1_ps(SimplexF3));
+		const __m256i I = FastFloor(_mm256_add_ps(X, S));
+		const __m256i J = FastFloor(_mm256_add_ps(Y, S));
+		const __m256i K = FastFloor(_mm256_add_ps(Z, S));
+
+		const __m256 T = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_add_epi32(I, J), K)), _mm256_set1_ps(SimplexG3));
+		const __m256 X0 = _mm256_sub_ps(X, _mm256_sub_ps(_mm256_cvtepi32_ps(I), T));
+		const __m256 Y0 = _mm256_sub_ps(Y, _mm256_sub_ps(_mm256_cvtepi32_ps(J), T));
+		const __m256 Z0 = _mm256_sub_ps(Z, _mm256_sub_ps(_mm256_cvtepi32_ps(K), T));
+
+		const __m256 A = _mm256_cmp_ps(X0, Y0, _CMP_GE_OQ);
+		const __m256 B = _mm256_cmp_ps(Y0, Z0, _CMP_GE_OQ);
+		const __m256 C = _mm256_cmp_ps(X0, Z0, _CMP_GE_OQ);
+		const __m256 I1 = _mm256_and_ps(A, C);
+		const __m256 J1 = _mm256_andnot_ps(A, B);
+		const __m256 K1 = _mm256_andnot_ps(_mm256_or_ps(B, C), AllBits);
+		const __m256 I2 = _mm256_or_ps(A, C);
+		const __m256 J2 = _mm256_or_ps(_mm256_andnot_ps(A, AllBits), B);
+		const __m256 K2 = _mm256_andnot_ps(_mm256_and_ps(B, C), AllBits);
+
+		const __m256 X1 = _mm256_add_ps(_mm256_sub_ps(X0, MaskToOne(I1)), _mm256_set1_ps(SimplexG3));
+		const __m256 Y1 = _mm256_add_ps(_mm256_sub_ps(Y0, MaskToOne(J1)), _mm256_set1_ps(SimplexG3));
+		const __m256 Z1 = _mm256_add_ps(_mm256_sub_ps(Z0, MaskToOne(K1)), _mm256_set1_ps(SimplexG3));
+		const __m256 X2 = _mm256_add_ps(_mm256_sub_ps(X0, MaskToOne(I2)), _mm256_set1_ps(2.0f * SimplexG3));
+		const __m256 Y2 = _mm256_add_ps(_mm256_sub_ps(Y0, MaskToOne(J2)), _mm256_set1_ps(2.0f * SimplexG3));
+		const __m256 Z2 = _mm256_add_ps(_mm256_sub_ps(Z0, MaskToOne(K2)), _mm256_set1_ps(2.0f * SimplexG3));
+		const __m256 X3 = _mm256_add_ps(_mm256_sub_ps(X0, _mm256_set1_ps(1.0f)), _mm256_set1_ps(3.0f * SimplexG3));
+		const __m256 Y3 = _mm256_add_ps(_mm256_sub_ps(Y0, _mm256_set1_ps(1.0f)), _mm256_set1_ps(3.0f * SimplexG3));
+		const __m256 Z3 = _mm256_add_ps(_mm256_sub_ps(Z0, _mm256_set1_ps(1.0f)), _mm256_set1_ps(3.0f * SimplexG3));
+
+		const __m256i II = _mm256_and_si256(I, Wrap);
+		const __m256i JJ = _mm256_and_si256(J, Wrap);
+		const __m256i KK = _mm256_and_si256(K, Wrap);
+
+		const __m256i H0 = Lookup(Perm, _mm256_add_epi32(II, Lookup(Perm, _mm256_add_epi32(JJ, Lookup(Perm, KK)))));
+		const __m256i H1 = Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(II, MaskToInt(I1)),
+			Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(JJ, MaskToInt(J1)), Lookup(Perm, _mm256_add_epi32(KK, MaskToInt(K1)))))));
+		const __m256i H2 = Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(II, MaskToInt(I2)),
+			Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(JJ, MaskToInt(J2)), Lookup(Perm, _mm256_add_epi32(KK, MaskToInt(K2)))))));
+		const __m256i H3 = Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(II, One),
+			Lookup(Perm, _mm256_add_epi32(_mm256_add_epi32(JJ, One), Lookup(Perm, _mm256_add_epi32(KK, One))))));
+
+		const __m256 N = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(Corner3(H0, X0, Y0, Z0), Corner3(H1, X1, Y1, Z1)), Corner3(H2, X2, Y2, Z2)), Corner3(H3, X3, Y3, Z3));
+		_mm256_storeu_ps(Out, _mm256_mul_ps(_mm256_set1_ps(32.0f), N));
+	}
+}
+
+static bool CpuSupportsAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int Info[4];
+	__cpuid(Info, 0);
+	if (Info[0] < 7)
+		return false;
+
+	// AVX state also has to be enabled by the OS.
+	__cpuid(Info, 1);
+	const bool HasOSXSave = (Info[2] & (1 << 27)) != 0;
+	const bool HasAVX = (Info[2] & (1 << 28)) != 0;
+	if (!HasOSXSave || !HasAVX || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(Info, 7, 0);
+	return (Info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // VC_SIMPLEX_X86
+
+bool SimplexNoise::IsSupported(NoiseISA ISA)
+{
+#if VC_SIMPLEX_X86
+	static const bool HasAVX2 = CpuSupportsAVX2();
+	switch (ISA)
+	{
+	case NoiseISA::AVX2: return HasAVX2;
+	case NoiseISA::SSE2: return true;
+	default: return true;
+	}
+#else
+	return ISA == NoiseISA::Scalar;
+#endif
+}
+
+void SimplexNoise::SetMaxISA(NoiseISA ISA)
+{
+	MaxISA.store((int)ISA, std::memory_order_relaxed);
+}
+
+NoiseISA SimplexNoise::GetActiveISA()
+{
+	const int Max = MaxISA.load(std::memory_order_relaxed);
+	if (Max >= 2 && IsSupported(NoiseISA::AVX2))
+		return NoiseISA::AVX2;
+	if (Max >= 1 && IsSupported(NoiseISA::SSE2))
+		return NoiseISA::SSE2;
+	return NoiseISA::Scalar;
+}
+
+const char* SimplexNoise::GetISAName(NoiseISA ISA)
+{
+	switch (ISA)
+	{
+	case NoiseISA::SSE2: return "SSE2";
+	case NoiseISA::AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
+
+int32_t SimplexNoise::GetWidth(NoiseISA ISA)
+{
+	switch (ISA)
+	{
+	case NoiseISA::SSE2: return 4;
+	case NoiseISA::AVX2: return 8;
+	default: return 1;
+	}
+}
+
+void SimplexNoise::Noise2D(const float* X, const float* Y, float* Out, int32_t Count)
+{
+	Noise2D(GetActiveISA(), X, Y, Out, Count);
+}
+
+void SimplexNoise::Noise3D(const float* X, const float* Y, const float* Z, float* Out, int32_t Count)
+{
+	Noise3D(GetActiveISA(), X, Y, Z, Out, Count);
+}
+
+void SimplexNoise::Noise2D(NoiseISA ISA, const float* X, const float* Y, float* Out, int32_t Count)
+{
+	int32_t i = 0;
+#if VC_SIMPLEX_X86
+	if (ISA == NoiseISA::AVX2 && IsSupported(ISA))
+	{
+		for (; i + 8 <= Count; i += 8)
+			AVX2::Noise2D(Perm, X + i, Y + i, Out + i);
+	}
+	else if (ISA == NoiseISA::SSE2)
+	{
+		for (; i + 4 <= Count; i += 4)
+			SSE::Noise2D(Perm, X + i, Y + i, Out + i);
+	}
+#endif
+
+	// Whatever doesn't fill a whole vector goes through the reference implementation.
+	for (; i < Count; i++)
+		Out[i] = Noise2D(X[i], Y[i]);
+}
+
+void SimplexNoise::Noise3D(NoiseISA ISA, const float* X, const float* Y, const float* Z, float* Out, int32_t Count)
+{
+	int32_t i = 0;
+#if VC_SIMPLEX_X86
+	if (ISA == NoiseISA::AVX2 && IsSupported(ISA))
+	{
+		for (; i + 8 <= Count; i += 8)
+			AVX2::Noise3D(Perm, X + i, Y + i, Z + i, Out + i);
+	}
+	else if (ISA == NoiseISA::SSE2)
+	{
+		for (; i + 4 <= Count; i += 4)
+			SSE::Noise3D(Perm, X + i, Y + i, Z + i, Out + i);
+	}
+#endif
+
+	for (; i < Count; i++)
+		Out[i] = Noise3D(X[i], Y[i], Z[i]);
+}
+
+}
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/StructurePlacer.h"
+#include "VoxelCore/RandomStream.h"
+
+namespace VoxelCore
+{
+
+static const int32_t MinTreeHeight = 4;
+static const int32_t NumTreeHeights = 4;
+static const int32_t NumLeafVariants = 4;
+
+// Trees as the old per-chunk pass grew them: a 4 to 7 block trunk under a bowl of leaves with
+// about one leaf in five missing. The missing leaves are picked once here, not per chunk, so
+// both sides of a border agree on them.
+static std::vector<StructureShape> BuildShapes()
+{
+	const int32_t LeafRadiusSquared = 12;
+
+	std::vector<StructureShape> Shapes;
+	for (int32_t h = 0; h < NumTreeHeights; h++)
+	{
+		const int32_t Height = MinTreeHeight + h;
+		for (int32_t v = 0; v < NumLeafVariants; v++)
+		{
+			RandomStream LeafStream(h * NumLeafVariants + v);
+			Shapes.emplace_back();
+			StructureShape& Shape = Shapes.back();
+
+			for (int32_t x = -StructurePlacer::MaxShapeRadius; x <= StructurePlacer::MaxShapeRadius; x++)
+				for (int32_t y = -StructurePlacer::MaxShapeRadius; y <= StructurePlacer::MaxShapeRadius; y++)
+					for (int32_t z = -3; z <= 0; z++)
+					{
+						if (x * x + y * y + z * z > LeafRadiusSquared || LeafStream.FRand() >= 0.8f)
+							continue;
+						StructureBlock Leaf = { (int8_t)x, (int8_t)y, (int16_t)(Height + z), (uint8_t)Blocks::Leaves, false };
+						Shape.Blocks.push_back(Leaf);
+					}
+
+			for (int32_t z = 0; z < Height; z++)
+			{
+				StructureBlock Trunk = { 0, 0, (int16_t)z, (uint8_t)Blocks::Trunk, true };
+				Shape.Blocks.push_back(Trunk);
+			}
+		}
+	}
+	return Shapes;
+}
+
+static const std::vector<StructureShape>& GetShapes()
+{
+	static const std::vector<StructureShape> Shapes = BuildShapes();
+	return Shapes;
+}
+
+const StructureShape& StructurePlacer::GetShape(int32_t Index)
+{
+	return GetShapes()[Index];
+}
+
+int32_t StructurePlacer::GetNumShapes()
+{
+	return (int32_t)GetShapes().size();
+}
+
+uint32_t StructurePlacer::HashRegion(int32_t Seed, int32_t RegionX, int32_t RegionY)
+{
+	uint32_t Hash = (uint32_t)Seed * 0x9E3779B1u;
+	Hash ^= (uint32_t)RegionX * 0x85EBCA77u;
+	Hash = ((Hash << 13) | (Hash >> 19)) * 0xC2B2AE3Du;
+	Hash ^= (uint32_t)RegionY * 0x27D4EB2Fu;
+
+	// Murmur3 finalizer, so neighbouring regions get unrelated streams.
+	Hash ^= Hash >> 16;
+	Hash *= 0x85EBCA6Bu;
+	Hash ^= Hash >> 13;
+	Hash *= 0xC2B2AE35u;
+	Hash ^= Hash >> 16;
+	return Hash;
+}
+
+void StructurePlacer::GatherCandidates(int32_t Seed, int32_t MinX, int32_t MinY, int32_t MaxX, int32_t MaxY, std::vector<StructureCandidate>& OutCandidates)
+{
+	const int32_t CellsPerSide = RegionSize / CandidateCellSize;
+	const int32_t NumShapes = GetNumShapes();
+
+	for (int32_t RegionX = FloorDiv(MinX, RegionSize); RegionX <= FloorDiv(MaxX, RegionSize); RegionX++)
+	{
+		for (int32_t RegionY = FloorDiv(MinY, RegionSize); RegionY <= FloorDiv(MaxY, RegionSize); RegionY++)
+		{
+			// Every cell draws the same numbers in the same order whether or not it is wanted.
+			RandomStream RegionStream((int32_t)HashRegion(Seed, RegionX, RegionY));
+			for (int32_t CellX = 0; CellX < CellsPerSide; CellX++)
+			{
+				for (int32_t CellY = 0; CellY < CellsPerSide; CellY++)
+				{
+					StructureCandidate Candidate;
+					Candidate.X = RegionX * RegionSize + CellX * CandidateCellSize + RegionStream.RandHelper(CandidateCellSize);
+					Candidate.Y = RegionY * RegionSize + CellY * CandidateCellSize + RegionStream.RandHelper(CandidateCellSize);
+					Candidate.Roll = RegionStream.GetFraction();
+					Candidate.Shape = RegionStream.RandHelper(NumShapes);
+
+					if (Candidate.X >= MinX && Candidate.X <= MaxX && Candidate.Y >= MinY && Candidate.Y <= MaxY)
+						OutCandidates.push_back(Candidate);
+				}
+			}
+		}
+	}
+}
+
+void StructurePlacer::Stamp(const StructureShape& Shape, int32_t RootX, int32_t RootY, int32_t RootZ, int32_t BaseX, int32_t BaseY, const ChunkLayout& Layout, BlockIdView ChunkData)
+{
+	for (const StructureBlock& Block : Shape.Blocks)
+	{
+		const int32_t x = RootX + Block.X - BaseX;
+		const int32_t y = RootY + Block.Y - BaseY;
+		const int32_t z = RootZ + Block.Z;
+		if (x < 0 || x >= Layout.WidthExt || y < 0 || y >= Layout.WidthExt || z < 0 || z >= Layout.Height)
+			continue;
+
+		const int32_t Index = Layout.Index(x, y, z);
+		if (Block.bReplace || ChunkData[Index] == Blocks::Air)
+			ChunkData[Index] = Block.Id;
+	}
+}
+
+}
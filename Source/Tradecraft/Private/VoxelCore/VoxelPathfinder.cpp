@@ -0,0 +1,629 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VoxelCore/VoxelPathfinder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+namespace VoxelCore
+{
+
+static const int32_t PathNeighbors[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+typedef std::pair<int32_t, int32_t> OpenEntry;
+typedef std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> OpenQueue;
+
+PathProperties::PathProperties()
+{
+	for (int32_t Id = 0; Id < NumIds; Id++)
+		Kinds[Id] = Solid;
+	Kinds[Blocks::Air] = Open;
+}
+
+VoxelPathfinder::VoxelPathfinder(const PathProperties& InProperties, const ChunkLayout& InLayout)
+	: Properties(InProperties)
+	, Layout(InLayout)
+{
+}
+
+PathProperties::Kind VoxelPathfinder::GetKind(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z) const
+{
+	if (z < 0)
+		return PathProperties::Blocked;
+	if (z >= Layout.Height)
+		return PathProperties::Open;
+	return Properties.GetKind(Blocks[Layout.Index(x, y, z)]);
+}
+
+bool VoxelPathfinder::IsWalkableLocal(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z) const
+{
+	return GetKind(Blocks, x, y, z) == PathProperties::Open && GetKind(Blocks, x, y, z + 1) == PathProperties::Open
+		&& GetKind(Blocks, x, y, z - 1) == PathProperties::Solid;
+}
+
+int32_t VoxelPathfinder::FindMove(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z, int32_t ToX, int32_t ToY) const
+{
+	if (IsWalkableLocal(Blocks, ToX, ToY, z + 1))
+		return GetKind(Blocks, x, y, z + 2) == PathProperties::Open ? z + 1 : IndexNone;
+
+	// Walking across or off an edge, then falling until something solid.
+	if (GetKind(Blocks, ToX, ToY, z) != PathProperties::Open || GetKind(Blocks, ToX, ToY, z + 1) != PathProperties::Open)
+		return IndexNone;
+
+	for (int32_t Drop = 0; Drop <= Properties.MaxDrop; Drop++)
+	{
+		const PathProperties::Kind Below = GetKind(Blocks, ToX, ToY, z - Drop - 1);
+		if (Below == PathProperties::Solid)
+			return z - Drop;
+		if (Below != PathProperties::Open)
+			return IndexNone;
+	}
+	return IndexNone;
+}
+
+bool VoxelPathfinder::IsWalkable(const PathAccess& Access, const PathCell& Cell) const
+{
+	const int32_t ChunkX = FloorDiv(Cell.X, Layout.Width);
+	const int32_t ChunkY = FloorDiv(Cell.Y, Layout.Width);
+	ConstBlockIdView Blocks;
+	if (Cell.Z < 0 || Cell.Z >= Layout.Height || !Access.GetChunk(ChunkX, ChunkY, Blocks))
+		return false;
+	return IsWalkableLocal(Blocks, Cell.X - ChunkX * Layout.Width + 1, Cell.Y - ChunkY * Layout.Width + 1, Cell.Z);
+}
+
+int32_t VoxelPathfinder::GetNumEdges() const
+{
+	int32_t NumEdges = 0;
+	for (const Node& Current : Nodes)
+	{
+		if (Current.bUsed)
+			NumEdges += (int32_t)Current.Edges.size();
+	}
+	return NumEdges;
+}
+
+int32_t VoxelPathfinder::AllocateNode(const PathCell& Cell, int32_t ChunkX, int32_t ChunkY)
+{
+	int32_t Id;
+	if (!FreeNodes.empty())
+	{
+		Id = FreeNodes.back();
+		FreeNodes.pop_back();
+	}
+	else
+	{
+		Id = (int32_t)Nodes.size();
+		Nodes.push_back(Node());
+	}
+
+	Node& Added = Nodes[Id];
+	Added.Cell = Cell;
+	Added.ChunkX = ChunkX;
+	Added.ChunkY = ChunkY;
+	Added.Edges.clear();
+	Added.bUsed = true;
+	return Id;
+}
+
+void VoxelPathfinder::AddChunk(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY)
+{
+	if (Chunks.count(MakeKey(ChunkX, ChunkY)))
+		RemoveChunk(ChunkX, ChunkY);
+	Chunks[MakeKey(ChunkX, ChunkY)];
+
+	for (int32_t d = 0; d < 4; d++)
+	{
+		const int32_t NeighborX = ChunkX + PathNeighbors[d][0];
+		const int32_t NeighborY = ChunkY + PathNeighbors[d][1];
+		if (!Chunks.count(MakeKey(NeighborX, NeighborY)))
+			continue;
+
+		BuildBorder(Access, std::min(ChunkX, NeighborX), std::min(ChunkY, NeighborY), PathNeighbors[d][0] != 0 ? 0 : 1);
+		BuildChunkEdges(Access, NeighborX, NeighborY);
+	}
+	BuildChunkEdges(Access, ChunkX, ChunkY);
+}
+
+void VoxelPathfinder::RemoveChunk(int32_t ChunkX, int32_t ChunkY)
+{
+	if (!Chunks.count(MakeKey(ChunkX, ChunkY)))
+		return;
+
+	ClearBorder(ChunkX, ChunkY, 0);
+	ClearBorder(ChunkX, ChunkY, 1);
+	ClearBorder(ChunkX - 1, ChunkY, 0);
+	ClearBorder(ChunkX, ChunkY - 1, 1);
+	Chunks.erase(MakeKey(ChunkX, ChunkY));
+}
+
+void VoxelPathfinder::OnBlockChanged(const PathAccess& Access, int32_t X, int32_t Y, int32_t Z)
+{
+	const int32_t ChunkX = FloorDiv(X, Layout.Width);
+	const int32_t ChunkY = FloorDiv(Y, Layout.Width);
+	if (!Chunks.count(MakeKey(ChunkX, ChunkY)) || Z < 0 || Z >= Layout.Height)
+		return;
+
+	// Portals only depend on the columns along a border, so only an edit in one of those moves them.
+	const int32_t x = X - ChunkX * Layout.Width;
+	const int32_t y = Y - ChunkY * Layout.Width;
+	int32_t NeighborX = 0;
+	int32_t NeighborY = 0;
+	if (x == Layout.Width - 1)
+		NeighborX = 1;
+	else if (x == 0)
+		NeighborX = -1;
+	if (y == Layout.Width - 1)
+		NeighborY = 1;
+	else if (y == 0)
+		NeighborY = -1;
+
+	if (NeighborX != 0)
+	{
+		BuildBorder(Access, std::min(ChunkX, ChunkX + NeighborX), ChunkY, 0);
+		BuildChunkEdges(Access, ChunkX + NeighborX, ChunkY);
+	}
+	if (NeighborY != 0)
+	{
+		BuildBorder(Access, ChunkX, std::min(ChunkY, ChunkY + NeighborY), 1);
+		BuildChunkEdges(Access, ChunkX, ChunkY + NeighborY);
+	}
+	BuildChunkEdges(Access, ChunkX, ChunkY);
+}
+
+void VoxelPathfinder::ClearBorder(int32_t ChunkX, int32_t ChunkY, int32_t Axis)
+{
+	auto Found = Borders[Axis].find(MakeKey(ChunkX, ChunkY));
+	if (Found == Borders[Axis].end())
+		return;
+
+	for (int32_t Id : Found->second)
+	{
+		Node& Removed = Nodes[Id];
+		auto Owner = Chunks.find(MakeKey(Removed.ChunkX, Removed.ChunkY));
+		if (Owner != Chunks.end())
+			Owner->second.erase(std::remove(Owner->second.begin(), Owner->second.end(), Id), Owner->second.end());
+		Removed.Edges.clear();
+		Removed.bUsed = false;
+		FreeNodes.push_back(Id);
+	}
+	Borders[Axis].erase(Found);
+
+	// Before the ids are handed out again.
+	RemoveDeadEdges(ChunkX, ChunkY);
+	RemoveDeadEdges(ChunkX + (Axis == 0 ? 1 : 0), ChunkY + (Axis == 1 ? 1 : 0));
+}
+
+void VoxelPathfinder::BuildBorder(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY, int32_t Axis)
+{
+	ClearBorder(ChunkX, ChunkY, Axis);
+
+	const int32_t NeighborX = ChunkX + (Axis == 0 ? 1 : 0);
+	const int32_t NeighborY = ChunkY + (Axis == 1 ? 1 : 0);
+	ConstBlockIdView Blocks;
+	if (!Chunks.count(MakeKey(ChunkX, ChunkY)) || !Chunks.count(MakeKey(NeighborX, NeighborY)) || !Access.GetChunk(ChunkX, ChunkY, Blocks))
+		return;
+
+	// Every move across the border, found in the lower chunk's extended layout, whose border
+	// copy of the neighbour's edge column holds everything the move looks at.
+	struct Transition
+	{
+		int32_t i, FromZ, ToZ;
+		bool bForward, bBackward;
+	};
+	std::vector<Transition> Transitions;
+	const int32_t Width = Layout.Width;
+	for (int32_t i = 0; i < Width; i++)
+	{
+		const int32_t FromX = Axis == 0 ? Width : i + 1;
+		const int32_t FromY = Axis == 0 ? i + 1 : Width;
+		const int32_t ToX = Axis == 0 ? Width + 1 : i + 1;
+		const int32_t ToY = Axis == 0 ? i + 1 : Width + 1;
+
+		const size_t First = Transitions.size();
+		for (int32_t z = 0; z < Layout.Height; z++)
+		{
+			if (!IsWalkableLocal(Blocks, FromX, FromY, z))
+				continue;
+			const int32_t ToZ = FindMove(Blocks, FromX, FromY, z, ToX, ToY);
+			if (ToZ != IndexNone)
+				Transitions.push_back({ i, z, ToZ, true, false });
+		}
+		for (int32_t z = 0; z < Layout.Height; z++)
+		{
+			if (!IsWalkableLocal(Blocks, ToX, ToY, z))
+				continue;
+			const int32_t FromZ = FindMove(Blocks, ToX, ToY, z, FromX, FromY);
+			if (FromZ == IndexNone)
+				continue;
+
+			bool bFound = false;
+			for (size_t t = First; t < Transitions.size(); t++)
+			{
+				if (Transitions[t].FromZ == FromZ && Transitions[t].ToZ == z)
+				{
+					Transitions[t].bBackward = true;
+					bFound = true;
+				}
+			}
+			if (!bFound)
+				Transitions.push_back({ i, FromZ, z, false, true });
+		}
+	}
+
+	// Neighbouring transitions at about the same height make up one entrance, with its portal
+	// pair in the middle.
+	std::vector<std::vector<size_t>> Entrances;
+	for (size_t t = 0; t < Transitions.size(); t++)
+	{
+		const Transition& Current = Transitions[t];
+		bool bJoined = false;
+		for (std::vector<size_t>& Entrance : Entrances)
+		{
+			const Transition& Last = Transitions[Entrance.back()];
+			if (Last.i == Current.i - 1 && std::abs(Last.FromZ - Current.FromZ) <= 1 && std::abs(Last.ToZ - Current.ToZ) <= 1
+				&& Last.bForward == Current.bForward && Last.bBackward == Current.bBackward)
+			{
+				Entrance.push_back(t);
+				bJoined = true;
+				break;
+			}
+		}
+		if (!bJoined)
+			Entrances.push_back(std::vector<size_t>(1, t));
+	}
+
+	std::vector<int32_t>& BorderNodes = Borders[Axis][MakeKey(ChunkX, ChunkY)];
+	for (const std::vector<size_t>& Entrance : Entrances)
+	{
+		const Transition& Portal = Transitions[Entrance[Entrance.size() / 2]];
+		const int32_t FromX = Axis == 0 ? Width - 1 : Portal.i;
+		const int32_t FromY = Axis == 0 ? Portal.i : Width - 1;
+		const PathCell From = { ChunkX * Width + FromX, ChunkY * Width + FromY, Portal.FromZ };
+		const PathCell To = { From.X + (Axis == 0 ? 1 : 0), From.Y + (Axis == 1 ? 1 : 0), Portal.ToZ };
+
+		const int32_t FromNode = AllocateNode(From, ChunkX, ChunkY);
+		const int32_t ToNode = AllocateNode(To, NeighborX, NeighborY);
+		if (Portal.bForward)
+			Nodes[FromNode].Edges.push_back({ ToNode, 1 });
+		if (Portal.bBackward)
+			Nodes[ToNode].Edges.push_back({ FromNode, 1 });
+
+		BorderNodes.push_back(FromNode);
+		BorderNodes.push_back(ToNode);
+		Chunks[MakeKey(ChunkX, ChunkY)].push_back(FromNode);
+		Chunks[MakeKey(NeighborX, NeighborY)].push_back(ToNode);
+	}
+}
+
+void VoxelPathfinder::BuildChunkEdges(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY)
+{
+	auto Found = Chunks.find(MakeKey(ChunkX, ChunkY));
+	ConstBlockIdView Blocks;
+	if (Found == Chunks.end() || !Access.GetChunk(ChunkX, ChunkY, Blocks))
+		return;
+
+	const std::vector<int32_t> ChunkNodes = Found->second;
+	std::vector<LocalCost> Costs;
+	for (int32_t Id : ChunkNodes)
+	{
+		// Edges to other chunks are the border crossings and stay.
+		std::vector<Edge>& Edges = Nodes[Id].Edges;
+		Edges.erase(std::remove_if(Edges.begin(), Edges.end(), [&](const Edge& Current)
+		{
+			return Nodes[Current.To].ChunkX == ChunkX && Nodes[Current.To].ChunkY == ChunkY;
+		}), Edges.end());
+
+		SearchChunk(Blocks, ChunkX, ChunkY, Nodes[Id].Cell, false, ChunkNodes, Costs);
+		for (const LocalCost& Cost : Costs)
+		{
+			if (Cost.Node != Id)
+				Nodes[Id].Edges.push_back({ Cost.Node, Cost.Cost });
+		}
+	}
+}
+
+void VoxelPathfinder::RemoveDeadEdges(int32_t ChunkX, int32_t ChunkY)
+{
+	auto Found = Chunks.find(MakeKey(ChunkX, ChunkY));
+	if (Found == Chunks.end())
+		return;
+
+	for (int32_t Id : Found->second)
+	{
+		std::vector<Edge>& Edges = Nodes[Id].Edges;
+		Edges.erase(std::remove_if(Edges.begin(), Edges.end(), [this](const Edge& Current) { return !Nodes[Current.To].bUsed; }), Edges.end());
+	}
+}
+
+int32_t VoxelPathfinder::LocalIndex(int32_t ChunkX, int32_t ChunkY, const PathCell& Cell) const
+{
+	return Cell.Z + (Cell.Y - ChunkY * Layout.Width) * Layout.Height + (Cell.X - ChunkX * Layout.Width) * Layout.Width * Layout.Height;
+}
+
+PathCell VoxelPathfinder::LocalCell(int32_t ChunkX, int32_t ChunkY, int32_t Index) const
+{
+	const int32_t Column = Index / Layout.Height;
+	return { ChunkX * Layout.Width + Column / Layout.Width, ChunkY * Layout.Width + Column % Layout.Width, Index % Layout.Height };
+}
+
+void VoxelPathfinder::ResetLocal()
+{
+	const size_t NumCells = (size_t)Layout.Width * Layout.Width * Layout.Height;
+	if (LocalStamps.size() != NumCells)
+	{
+		LocalCosts.assign(NumCells, 0);
+		LocalParents.assign(NumCells, IndexNone);
+		LocalStamps.assign(NumCells, 0);
+		LocalStamp = 0;
+	}
+	if (++LocalStamp == 0)
+	{
+		std::fill(LocalStamps.begin(), LocalStamps.end(), 0);
+		LocalStamp = 1;
+	}
+}
+
+void VoxelPathfinder::SearchChunk(ConstBlockIdView Blocks, int32_t ChunkX, int32_t ChunkY, const PathCell& From, bool bReverse, const std::vector<int32_t>& Targets, std::vector<LocalCost>& OutCosts)
+{
+	OutCosts.clear();
+	ResetLocal();
+	LocalQueue.clear();
+
+	const int32_t StartIndex = LocalIndex(ChunkX, ChunkY, From);
+	LocalStamps[StartIndex] = LocalStamp;
+	LocalCosts[StartIndex] = 0;
+	LocalQueue.push_back(StartIndex);
+
+	auto Visit = [&](const PathCell& Cell, int32_t Cost)
+	{
+		const int32_t Index = LocalIndex(ChunkX, ChunkY, Cell);
+		if (LocalStamps[Index] == LocalStamp)
+			return;
+		LocalStamps[Index] = LocalStamp;
+		LocalCosts[Index] = Cost;
+		LocalQueue.push_back(Index);
+	};
+
+	for (size_t Head = 0; Head < LocalQueue.size(); Head++)
+	{
+		const int32_t Index = LocalQueue[Head];
+		const PathCell Cell = LocalCell(ChunkX, ChunkY, Index);
+		const int32_t Cost = LocalCosts[Index];
+		const int32_t x = Cell.X - ChunkX * Layout.Width + 1;
+		const int32_t y = Cell.Y - ChunkY * Layout.Width + 1;
+		LastNumExpanded++;
+
+		for (int32_t d = 0; d < 4; d++)
+		{
+			const int32_t NextX = x + PathNeighbors[d][0];
+			const int32_t NextY = y + PathNeighbors[d][1];
+			if (NextX < 1 || NextY < 1 || NextX > Layout.Width || NextY > Layout.Width)
+				continue;
+
+			if (!bReverse)
+			{
+				const int32_t NextZ = FindMove(Blocks, x, y, Cell.Z, NextX, NextY);
+				if (NextZ != IndexNone)
+					Visit({ Cell.X + PathNeighbors[d][0], Cell.Y + PathNeighbors[d][1], NextZ }, Cost + 1);
+				continue;
+			}
+
+			// Cells whose move into this column lands here: one below stepping up, level, or falling.
+			for (int32_t FromZ = Cell.Z - 1; FromZ <= Cell.Z + Properties.MaxDrop; FromZ++)
+			{
+				if (IsWalkableLocal(Blocks, NextX, NextY, FromZ) && FindMove(Blocks, NextX, NextY, FromZ, x, y) == Cell.Z)
+					Visit({ Cell.X + PathNeighbors[d][0], Cell.Y + PathNeighbors[d][1], FromZ }, Cost + 1);
+			}
+		}
+	}
+
+	for (int32_t Id : Targets)
+	{
+		const int32_t Index = LocalIndex(ChunkX, ChunkY, Nodes[Id].Cell);
+		if (LocalStamps[Index] == LocalStamp)
+			OutCosts.push_back({ Id, LocalCosts[Index] });
+	}
+}
+
+bool VoxelPathfinder::FindLocalPath(ConstBlockIdView Blocks, int32_t ChunkX, int32_t ChunkY, const PathCell& Start, const PathCell& Goal, std::vector<PathCell>& OutPath)
+{
+	ResetLocal();
+	auto Heuristic = [&Goal](const PathCell& Cell) { return std::abs(Cell.X - Goal.X) + std::abs(Cell.Y - Goal.Y); };
+
+	const int32_t StartIndex = LocalIndex(ChunkX, ChunkY, Start);
+	const int32_t GoalIndex = LocalIndex(ChunkX, ChunkY, Goal);
+	LocalStamps[StartIndex] = LocalStamp;
+	LocalCosts[StartIndex] = 0;
+	LocalParents[StartIndex] = IndexNone;
+
+	OpenQueue Open;
+	Open.push(OpenEntry(Heuristic(Start), StartIndex));
+	bool bFound = false;
+	while (!Open.empty())
+	{
+		const OpenEntry Top = Open.top();
+		Open.pop();
+		const int32_t Index = Top.second;
+		if (Index == GoalIndex)
+		{
+			bFound = true;
+			break;
+		}
+
+		const PathCell Cell = LocalCell(ChunkX, ChunkY, Index);
+		const int32_t Cost = LocalCosts[Index];
+		if (Top.first != Cost + Heuristic(Cell))
+			continue;
+		LastNumExpanded++;
+
+		const int32_t x = Cell.X - ChunkX * Layout.Width + 1;
+		const int32_t y = Cell.Y - ChunkY * Layout.Width + 1;
+		for (int32_t d = 0; d < 4; d++)
+		{
+			const int32_t NextX = x + PathNeighbors[d][0];
+			const int32_t NextY = y + PathNeighbors[d][1];
+			if (NextX < 1 || NextY < 1 || NextX > Layout.Width || NextY > Layout.Width)
+				continue;
+
+			const int32_t NextZ = FindMove(Blocks, x, y, Cell.Z, NextX, NextY);
+			if (NextZ == IndexNone)
+				continue;
+
+			const PathCell Next = { Cell.X + PathNeighbors[d][0], Cell.Y + PathNeighbors[d][1], NextZ };
+			const int32_t NextIndex = LocalIndex(ChunkX, ChunkY, Next);
+			if (LocalStamps[NextIndex] == LocalStamp && LocalCosts[NextIndex] <= Cost + 1)
+				continue;
+
+			LocalStamps[NextIndex] = LocalStamp;
+			LocalCosts[NextIndex] = Cost + 1;
+			LocalParents[NextIndex] = Index;
+			Open.push(OpenEntry(Cost + 1 + Heuristic(Next), NextIndex));
+		}
+	}
+
+	if (!bFound)
+		return false;
+
+	const size_t First = OutPath.size();
+	for (int32_t Index = GoalIndex; Index != StartIndex; Index = LocalParents[Index])
+		OutPath.push_back(LocalCell(ChunkX, ChunkY, Index));
+	std::reverse(OutPath.begin() + First, OutPath.end());
+	return true;
+}
+
+bool VoxelPathfinder::FindPath(const PathAccess& Access, const PathCell& Start, const PathCell& Goal, std::vector<PathCell>& OutPath)
+{
+	OutPath.clear();
+	LastNumExpanded = 0;
+	if (!IsWalkable(Access, Start) || !IsWalkable(Access, Goal))
+		return false;
+
+	OutPath.push_back(Start);
+	if (Start == Goal)
+		return true;
+
+	const int32_t StartX = FloorDiv(Start.X, Layout.Width);
+	const int32_t StartY = FloorDiv(Start.Y, Layout.Width);
+	const int32_t GoalX = FloorDiv(Goal.X, Layout.Width);
+	const int32_t GoalY = FloorDiv(Goal.Y, Layout.Width);
+	ConstBlockIdView StartBlocks, GoalBlocks;
+	Access.GetChunk(StartX, StartY, StartBlocks);
+	Access.GetChunk(GoalX, GoalY, GoalBlocks);
+
+	// Within one chunk the direct path usually exists, and is the best one.
+	if (StartX == GoalX && StartY == GoalY && FindLocalPath(StartBlocks, StartX, StartY, Start, Goal, OutPath))
+		return true;
+
+	auto StartChunk = Chunks.find(MakeKey(StartX, StartY));
+	auto GoalChunk = Chunks.find(MakeKey(GoalX, GoalY));
+	if (StartChunk == Chunks.end() || GoalChunk == Chunks.end())
+	{
+		OutPath.clear();
+		return false;
+	}
+
+	// Start and goal join the graph through the portals of their chunks.
+	std::vector<LocalCost> StartCosts, GoalCosts;
+	SearchChunk(StartBlocks, StartX, StartY, Start, false, StartChunk->second, StartCosts);
+	SearchChunk(GoalBlocks, GoalX, GoalY, Goal, true, GoalChunk->second, GoalCosts);
+
+	const int32_t StartId = (int32_t)Nodes.size();
+	const int32_t GoalId = StartId + 1;
+	if (NodeStamps.size() < Nodes.size() + 2)
+	{
+		NodeCosts.resize(Nodes.size() + 2);
+		NodeParents.resize(Nodes.size() + 2);
+		NodeStamps.resize(Nodes.size() + 2, 0);
+	}
+	if (++NodeStamp == 0)
+	{
+		std::fill(NodeStamps.begin(), NodeStamps.end(), 0);
+		NodeStamp = 1;
+	}
+
+	auto Heuristic = [&Goal](const PathCell& Cell) { return std::abs(Cell.X - Goal.X) + std::abs(Cell.Y - Goal.Y); };
+	OpenQueue Open;
+	auto Relax = [&](int32_t Id, int32_t Parent, int32_t Cost, const PathCell& Cell)
+	{
+		if (NodeStamps[Id] == NodeStamp && NodeCosts[Id] <= Cost)
+			return;
+		NodeStamps[Id] = NodeStamp;
+		NodeCosts[Id] = Cost;
+		NodeParents[Id] = Parent;
+		Open.push(OpenEntry(Cost + Heuristic(Cell), Id));
+	};
+
+	NodeStamps[StartId] = NodeStamp;
+	NodeCosts[StartId] = 0;
+	for (const LocalCost& Cost : StartCosts)
+		Relax(Cost.Node, StartId, Cost.Cost, Nodes[Cost.Node].Cell);
+
+	bool bFound = false;
+	while (!Open.empty())
+	{
+		const OpenEntry Top = Open.top();
+		Open.pop();
+		const int32_t Id = Top.second;
+		if (Id == GoalId)
+		{
+			bFound = true;
+			break;
+		}
+
+		const int32_t Cost = NodeCosts[Id];
+		if (Top.first != Cost + Heuristic(Nodes[Id].Cell))
+			continue;
+		LastNumExpanded++;
+
+		for (const Edge& Current : Nodes[Id].Edges)
+			Relax(Current.To, Id, Cost + Current.Cost, Nodes[Current.To].Cell);
+		for (const LocalCost& ToGoal : GoalCosts)
+		{
+			if (ToGoal.Node == Id)
+				Relax(GoalId, Id, Cost + ToGoal.Cost, Goal);
+		}
+	}
+
+	if (!bFound)
+	{
+		OutPath.clear();
+		return false;
+	}
+
+	std::vector<int32_t> Waypoints;
+	for (int32_t Id = NodeParents[GoalId]; Id != StartId; Id = NodeParents[Id])
+		Waypoints.push_back(Id);
+	std::reverse(Waypoints.begin(), Waypoints.end());
+	Waypoints.push_back(GoalId);
+
+	// Steps between portals of the same chunk are searched again inside it; the others cross a border.
+	PathCell Current = Start;
+	int32_t CurrentX = StartX;
+	int32_t CurrentY = StartY;
+	for (int32_t Id : Waypoints)
+	{
+		const PathCell Next = Id == GoalId ? Goal : Nodes[Id].Cell;
+		const int32_t NextX = Id == GoalId ? GoalX : Nodes[Id].ChunkX;
+		const int32_t NextY = Id == GoalId ? GoalY : Nodes[Id].ChunkY;
+		if (NextX != CurrentX || NextY != CurrentY)
+		{
+			OutPath.push_back(Next);
+		}
+		else if (Next != Current)
+		{
+			ConstBlockIdView Blocks;
+			if (!Access.GetChunk(CurrentX, CurrentY, Blocks) || !FindLocalPath(Blocks, CurrentX, CurrentY, Current, Next, OutPath))
+			{
+				OutPath.clear();
+				return false;
+			}
+		}
+		Current = Next;
+		CurrentX = NextX;
+		CurrentY = NextY;
+	}
+	return true;
+}
+
+}
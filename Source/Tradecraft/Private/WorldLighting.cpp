@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorldLighting.h"
+#include "Chunk.h"
+#include "TradecraftStats.h"
+
+using namespace VoxelCore;
+
+FWorldLighting::FWorldLighting()
+	: Engine(Properties)
+{
+}
+
+void FWorldLighting::Initialize(int32 InWidthOfChunk, int32 InHeightOfChunk, const TMap<FIntPoint, AChunk*>* InChunks, TFunction<void(AChunk*)> InOnChunkChanged)
+{
+	WidthOfChunk = InWidthOfChunk;
+	HeightOfChunk = InHeightOfChunk;
+	Chunks = InChunks;
+	OnChunkChanged = MoveTemp(InOnChunkChanged);
+}
+
+void FWorldLighting::StitchChunk(int32 ChunkX, int32 ChunkY)
+{
+	TRADECRAFT_SCOPE_CYCLE(UpdateLight);
+
+	int32 Index;
+	AChunk* Chunk = FindChunk(ChunkX * WidthOfChunk, ChunkY * WidthOfChunk, 0, Index);
+	if (!Chunk)
+		return;
+
+	auto LocalIndex = [this](int32 OwnerX, int32 OwnerY, int32 X, int32 Y, int32 Z)
+	{
+		return Z + (Y - OwnerY * WidthOfChunk + 1) * HeightOfChunk + (X - OwnerX * WidthOfChunk + 1) * (WidthOfChunk + 2) * HeightOfChunk;
+	};
+
+	// Both chunks lit the cells on either side of a seam on their own, so where their copies
+	// disagree the brighter one is right and gets flooded onwards.
+	static const int32 Directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	for (int32 d = 0; d < 4; d++)
+	{
+		const int32 NeighborX = ChunkX + Directions[d][0];
+		const int32 NeighborY = ChunkY + Directions[d][1];
+		AChunk* Neighbor = FindChunk(NeighborX * WidthOfChunk, NeighborY * WidthOfChunk, 0, Index);
+		if (!Neighbor)
+			continue;
+
+		for (int32 Side = 0; Side < 2; Side++)
+		{
+			const int32 OwnerX = Side == 0 ? ChunkX : NeighborX;
+			const int32 OwnerY = Side == 0 ? ChunkY : NeighborY;
+			const int32 OtherX = Side == 0 ? NeighborX : ChunkX;
+			const int32 OtherY = Side == 0 ? NeighborY : ChunkY;
+
+			for (int32 i = 0; i < WidthOfChunk; i++)
+			{
+				// The owner's row of cells along the shared edge.
+				int32 X = OwnerX * WidthOfChunk + i;
+				int32 Y = OwnerY * WidthOfChunk + i;
+				if (OtherX != OwnerX)
+					X = OwnerX * WidthOfChunk + (OtherX > OwnerX ? WidthOfChunk - 1 : 0);
+				else
+					Y = OwnerY * WidthOfChunk + (OtherY > OwnerY ? WidthOfChunk - 1 : 0);
+
+				for (int32 Z = 0; Z < HeightOfChunk; Z++)
+				{
+					const LightValue OwnerLight = (Side == 0 ? Chunk : Neighbor)->LightData[LocalIndex(OwnerX, OwnerY, X, Y, Z)];
+					const LightValue OtherLight = (Side == 0 ? Neighbor : Chunk)->LightData[LocalIndex(OtherX, OtherY, X, Y, Z)];
+					if (OwnerLight == OtherLight)
+						continue;
+
+					SetLight(X, Y, Z, MakeLight(FMath::Max(GetSkyLight(OwnerLight), GetSkyLight(OtherLight)), FMath::Max(GetBlockLight(OwnerLight), GetBlockLight(OtherLight))));
+					Engine.AddSeed(X, Y, Z);
+				}
+			}
+		}
+	}
+
+	Engine.Propagate(*this);
+	NumCellsVisited += Engine.GetLastNumVisited();
+	TRADECRAFT_INC_COUNTER(LightCellsVisited, Engine.GetLastNumVisited());
+}
+
+void FWorldLighting::OnBlockChanged(const FIntVector& Block)
+{
+	TRADECRAFT_SCOPE_CYCLE(UpdateLight);
+	Engine.OnBlockChanged(*this, Block.X, Block.Y, Block.Z);
+	NumCellsVisited += Engine.GetLastNumVisited();
+	TRADECRAFT_INC_COUNTER(LightCellsVisited, Engine.GetLastNumVisited());
+}
+
+AChunk* FWorldLighting::FindChunk(int32 X, int32 Y, int32 Z, int32& OutIndex) const
+{
+	if (!Chunks || Z < 0 || Z >= HeightOfChunk)
+		return nullptr;
+
+	const int32 ChunkX = FloorDiv(X, WidthOfChunk);
+	const int32 ChunkY = FloorDiv(Y, WidthOfChunk);
+	AChunk* const* Chunk = Chunks->Find(FIntPoint(ChunkX, ChunkY));
+
+	// A chunk that is still being built has no light yet.
+	if (!Chunk || !*Chunk || (*Chunk)->LightData.Num() != (*Chunk)->ChunkData.Num())
+		return nullptr;
+
+	const int32 x = X - ChunkX * WidthOfChunk + 1;
+	const int32 y = Y - ChunkY * WidthOfChunk + 1;
+	OutIndex = Z + (y * HeightOfChunk) + (x * (WidthOfChunk + 2) * HeightOfChunk);
+	return *Chunk;
+}
+
+bool FWorldLighting::IsLoaded(int32_t X, int32_t Y, int32_t Z) const
+{
+	int32 Index;
+	return FindChunk(X, Y, Z, Index) != nullptr;
+}
+
+BlockId FWorldLighting::GetBlock(int32_t X, int32_t Y, int32_t Z) const
+{
+	int32 Index;
+	AChunk* Chunk = FindChunk(X, Y, Z, Index);
+	return Chunk ? Chunk->ChunkData[Index].id : Blocks::Air;
+}
+
+LightValue FWorldLighting::GetLight(int32_t X, int32_t Y, int32_t Z) const
+{
+	int32 Index;
+	AChunk* Chunk = FindChunk(X, Y, Z, Index);
+	return Chunk ? Chunk->LightData[Index] : 0;
+}
+
+void FWorldLighting::SetLight(int32_t X, int32_t Y, int32_t Z, LightValue Light)
+{
+	const int32 ChunkX = FloorDiv(X, WidthOfChunk);
+	const int32 ChunkY = FloorDiv(Y, WidthOfChunk);
+	const int32 x = X - ChunkX * WidthOfChunk + 1;
+	const int32 y = Y - ChunkY * WidthOfChunk + 1;
+	SetLightInChunk(ChunkX, ChunkY, x, y, Z, Light);
+
+	// Neighbours mesh the faces that look into this block from their side, so they keep a copy.
+	if (x == WidthOfChunk)
+		SetLightInChunk(ChunkX + 1, ChunkY, 0, y, Z, Light);
+	else if (x == 1)
+		SetLightInChunk(ChunkX - 1, ChunkY, WidthOfChunk + 1, y, Z, Light);
+
+	if (y == WidthOfChunk)
+		SetLightInChunk(ChunkX, ChunkY + 1, x, 0, Z, Light);
+	else if (y == 1)
+		SetLightInChunk(ChunkX, ChunkY - 1, x, WidthOfChunk + 1, Z, Light);
+}
+
+void FWorldLighting::SetLightInChunk(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, LightValue Light)
+{
+	AChunk* const* Found = Chunks ? Chunks->Find(FIntPoint(ChunkX, ChunkY)) : nullptr;
+	if (!Found || !*Found || (*Found)->LightData.Num() != (*Found)->ChunkData.Num())
+		return;
+
+	AChunk* Chunk = *Found;
+	uint8& Value = Chunk->LightData[z + (y * HeightOfChunk) + (x * (WidthOfChunk + 2) * HeightOfChunk)];
+	if (Value == Light)
+		return;
+
+	Value = Light;
+
+	// A chunk that is already dirty is either queued or about to be meshed by whoever edited it.
+	if (!Chunk->MeshIsDirty)
+	{
+		Chunk->MeshIsDirty = true;
+		if (OnChunkChanged)
+			OnChunkChanged(Chunk);
+	}
+}
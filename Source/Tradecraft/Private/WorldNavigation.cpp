@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorldNavigation.h"
+#include "Chunk.h"
+#include "ChunkGenerator.h"
+#include "TradecraftStats.h"
+#include "HAL/PlatformTime.h"
+
+using namespace VoxelCore;
+
+void FWorldNavigation::Initialize(int32 InWidthOfChunk, int32 InHeightOfChunk, const TMap<FIntPoint, AChunk*>* InChunks)
+{
+	WidthOfChunk = InWidthOfChunk;
+	HeightOfChunk = InHeightOfChunk;
+	Chunks = InChunks;
+	Pathfinder.Reset(new VoxelPathfinder(Properties, ChunkLayout(WidthOfChunk, HeightOfChunk)));
+}
+
+bool FWorldNavigation::GetChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView& OutBlocks) const
+{
+	AChunk* const* Chunk = Chunks ? Chunks->Find(FIntPoint(ChunkX, ChunkY)) : nullptr;
+	if (!Chunk || !*Chunk || (*Chunk)->ChunkData.Num() == 0)
+		return false;
+	OutBlocks = FChunkGenerator::MakeBlockIdView((*Chunk)->ChunkData);
+	return true;
+}
+
+void FWorldNavigation::AddChunk(int32 ChunkX, int32 ChunkY)
+{
+	if (Pathfinder.IsValid())
+		PendingChunks.AddUnique(FIntPoint(ChunkX, ChunkY));
+}
+
+void FWorldNavigation::RemoveChunk(int32 ChunkX, int32 ChunkY)
+{
+	if (!Pathfinder.IsValid())
+		return;
+
+	PendingChunks.Remove(FIntPoint(ChunkX, ChunkY));
+	Pathfinder->RemoveChunk(ChunkX, ChunkY);
+}
+
+void FWorldNavigation::MarkBlockChanged(const FIntVector& Block)
+{
+	if (!Pathfinder.IsValid())
+		return;
+
+	// Only which border a block is on decides what its rebuild touches, see
+	// VoxelPathfinder::OnBlockChanged, so every block is folded onto one of nine per chunk.
+	auto Fold = [this](int32 Coordinate)
+	{
+		const int32 Local = Coordinate - VoxelCore::FloorDiv(Coordinate, WidthOfChunk) * WidthOfChunk;
+		const int32 Folded = Local == 0 || Local == WidthOfChunk - 1 ? Local : 1;
+		return Coordinate - Local + Folded;
+	};
+	DirtyBlocks.Add(FIntVector(Fold(Block.X), Fold(Block.Y), 0));
+}
+
+void FWorldNavigation::OnBlockChanged(const FIntVector& Block)
+{
+	if (!Pathfinder.IsValid())
+		return;
+
+	TRADECRAFT_SCOPE_CYCLE(UpdateNavigation);
+	RebuildAround(Block);
+}
+
+void FWorldNavigation::RebuildAround(const FIntVector& Block)
+{
+	const double Start = FPlatformTime::Seconds();
+	Pathfinder->OnBlockChanged(*this, Block.X, Block.Y, Block.Z);
+	UpdateSeconds += FPlatformTime::Seconds() - Start;
+	NumUpdates++;
+}
+
+void FWorldNavigation::Update(double BudgetSeconds)
+{
+	if (!Pathfinder.IsValid() || (PendingChunks.Num() == 0 && DirtyBlocks.Num() == 0))
+		return;
+
+	TRADECRAFT_SCOPE_CYCLE(UpdateNavigation);
+	const double Deadline = FPlatformTime::Seconds() + BudgetSeconds;
+
+	// Oldest first, so the chunks around the player that were built first are ready first.
+	int32 NumAdded = 0;
+	while (NumAdded < PendingChunks.Num() && (NumAdded == 0 || FPlatformTime::Seconds() < Deadline))
+	{
+		Pathfinder->AddChunk(*this, PendingChunks[NumAdded].X, PendingChunks[NumAdded].Y);
+		NumAdded++;
+	}
+	PendingChunks.RemoveAt(0, NumAdded, false);
+
+	bool bFirst = true;
+	for (auto It = DirtyBlocks.CreateIterator(); It && (bFirst || FPlatformTime::Seconds() < Deadline); ++It)
+	{
+		RebuildAround(*It);
+		It.RemoveCurrent();
+		bFirst = false;
+	}
+}
+
+bool FWorldNavigation::FindStandingCell(const FVector& Position, FIntVector& OutCell) const
+{
+	if (!Pathfinder.IsValid())
+		return false;
+
+	// Same rounding as AMinecraftWorld::BreakOrAddBlock.
+	const int32 X = FMath::CeilToInt(Position.X / 100 - 0.5f);
+	const int32 Y = FMath::CeilToInt(Position.Y / 100 - 0.5f);
+	const int32 Z = FMath::CeilToInt(Position.Z / 100 - 0.5f) + HeightOfChunk / 2;
+	for (int32 Offset : { 0, -1, 1, -2, -3 })
+	{
+		if (Pathfinder->IsWalkable(*this, { X, Y, Z + Offset }))
+		{
+			OutCell = FIntVector(X, Y, Z + Offset);
+			return true;
+		}
+	}
+	return false;
+}
+
+FVector FWorldNavigation::GetCellFloor(const FIntVector& Cell) const
+{
+	return FVector(Cell.X * 100.0f, Cell.Y * 100.0f, (Cell.Z - HeightOfChunk / 2) * 100.0f - 50.0f);
+}
+
+bool FWorldNavigation::FindPath(const FIntVector& Start, const FIntVector& Goal, TArray<FIntVector>& OutCells)
+{
+	OutCells.Reset();
+	if (!Pathfinder.IsValid())
+		return false;
+
+	TRADECRAFT_SCOPE_CYCLE(FindPath);
+	std::vector<PathCell> Path;
+	const bool bFound = Pathfinder->FindPath(*this, { Start.X, Start.Y, Start.Z }, { Goal.X, Goal.Y, Goal.Z }, Path);
+	NumQueries++;
+	NumPathsFound += bFound ? 1 : 0;
+	NumNodesExpanded += Pathfinder->GetLastNumExpanded();
+	TRADECRAFT_INC_COUNTER(PathNodesExpanded, Pathfinder->GetLastNumExpanded());
+
+	OutCells.Reserve((int32)Path.size());
+	for (const PathCell& Cell : Path)
+		OutCells.Add(FIntVector(Cell.X, Cell.Y, Cell.Z));
+	return bFound;
+}
+
+bool FWorldNavigation::FindPath(const FVector& Start, const FVector& Goal, TArray<FVector>& OutPoints)
+{
+	OutPoints.Reset();
+	FIntVector StartCell, GoalCell;
+	TArray<FIntVector> Cells;
+	if (!FindStandingCell(Start, StartCell) || !FindStandingCell(Goal, GoalCell) || !FindPath(StartCell, GoalCell, Cells))
+		return false;
+
+	OutPoints.Reserve(Cells.Num());
+	for (const FIntVector& Cell : Cells)
+		OutPoints.Add(GetCellFloor(Cell));
+	return true;
+}
+
+FString FWorldNavigation::RunBenchmark(const FIntPoint& Center, int32 Radius, int32 InNumQueries, int32 InNumUpdates)
+{
+	if (!Pathfinder.IsValid() || !Chunks)
+		return TEXT("Navigation is off.");
+
+	// Everything queued goes into the graph first, so the whole area is there.
+	Update(TNumericLimits<double>::Max());
+
+	TArray<FIntPoint> Area;
+	for (const auto& Elem : *Chunks)
+	{
+		if (FMath::Abs(Elem.Key.X - Center.X) <= Radius && FMath::Abs(Elem.Key.Y - Center.Y) <= Radius)
+			Area.Add(Elem.Key);
+	}
+	if (Area.Num() == 0)
+		return TEXT("No chunks loaded around the center.");
+
+	// The highest cell to stand in of random columns, i.e. mostly the surface.
+	FRandomStream Random(1234);
+	auto RandomCell = [&](FIntVector& OutCell)
+	{
+		const FIntPoint& Chunk = Area[Random.RandRange(0, Area.Num() - 1)];
+		const int32 X = Chunk.X * WidthOfChunk + Random.RandRange(0, WidthOfChunk - 1);
+		const int32 Y = Chunk.Y * WidthOfChunk + Random.RandRange(0, WidthOfChunk - 1);
+		for (int32 Z = HeightOfChunk - 2; Z > 0; Z--)
+		{
+			if (Pathfinder->IsWalkable(*this, { X, Y, Z }))
+			{
+				OutCell = FIntVector(X, Y, Z);
+				return true;
+			}
+		}
+		return false;
+	};
+
+	int32 Queries = 0;
+	int32 Found = 0;
+	int64 Expanded = 0;
+	int64 PathCells = 0;
+	double QuerySeconds = 0.0;
+	TArray<FIntVector> Cells;
+	for (int32 i = 0; i < InNumQueries; i++)
+	{
+		FIntVector Start, Goal;
+		if (!RandomCell(Start) || !RandomCell(Goal))
+			continue;
+
+		const double QueryStart = FPlatformTime::Seconds();
+		const bool bFound = FindPath(Start, Goal, Cells);
+		QuerySeconds += FPlatformTime::Seconds() - QueryStart;
+		Queries++;
+		Found += bFound ? 1 : 0;
+		Expanded += Pathfinder->GetLastNumExpanded();
+		PathCells += Cells.Num();
+	}
+
+	int32 Updates = 0;
+	double UpdateTotal = 0.0;
+	double UpdateMax = 0.0;
+	for (int32 i = 0; i < InNumUpdates; i++)
+	{
+		FIntVector Cell;
+		if (!RandomCell(Cell))
+			continue;
+
+		const double UpdateStart = FPlatformTime::Seconds();
+		OnBlockChanged(Cell - FIntVector(0, 0, 1));
+		const double Seconds = FPlatformTime::Seconds() - UpdateStart;
+		UpdateTotal += Seconds;
+		UpdateMax = FMath::Max(UpdateMax, Seconds);
+		Updates++;
+	}
+
+	return FString::Printf(TEXT("%d chunks: %d queries, %.0f queries/s, %d found, %.1f cells and %.0f nodes expanded per path; %d updates, %.3fms average, %.3fms max. %s"),
+		Area.Num(), Queries, Queries > 0 ? Queries / FMath::Max(QuerySeconds, 1e-9) : 0.0, Found,
+		Found > 0 ? (double)PathCells / Found : 0.0, Queries > 0 ? (double)Expanded / Queries : 0.0,
+		Updates, Updates > 0 ? UpdateTotal * 1000.0 / Updates : 0.0, UpdateMax * 1000.0, *GetStatsString());
+}
+
+FString FWorldNavigation::GetStatsString() const
+{
+	if (!Pathfinder.IsValid())
+		return TEXT("Navigation is off.");
+
+	return FString::Printf(TEXT("Navigation graph: %d chunks, %d portals, %d edges; %lld paths found of %lld queries, %.0f nodes expanded per query; %lld updates, %.3fms average, %d chunks and %d updates queued."),
+		Pathfinder->GetNumChunks(), Pathfinder->GetNumNodes(), Pathfinder->GetNumEdges(), NumPathsFound, NumQueries,
+		NumQueries > 0 ? (double)NumNodesExpanded / NumQueries : 0.0, NumUpdates, NumUpdates > 0 ? UpdateSeconds * 1000.0 / NumUpdates : 0.0,
+		PendingChunks.Num(), DirtyBlocks.Num());
+}
@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelCore/BiomeMap.h"
+
+// The biome map lives in the engine independent voxel core; these are its names on the game side.
+typedef VoxelCore::BiomeType EBiome;
+typedef VoxelCore::BiomeSettings FBiomeSettings;
+typedef VoxelCore::BiomeSample FBiomeSample;
+typedef VoxelCore::BiomeMap FBiomeMap;
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelCore/BlockTickScheduler.h"
+
+struct FChunk_Block_Properties;
+
+/**
+ * Block updates for the loaded chunks, from VoxelCore::BlockTickScheduler, which reads and
+ * changes the blocks through the world and stops an update once its time budget is used.
+ * Block positions are world block coordinates: x and y count blocks from the world origin,
+ * z is the height inside the chunk.
+ */
+class TRADECRAFT_API FBlockTickScheduler : public VoxelCore::BlockTickAccess
+{
+public:
+	// Block access through the world, which owns the chunks and their meshes.
+	typedef TFunction<int32(const FIntVector& Block)> FGetBlock;
+	typedef TFunction<void(const FIntVector& Block, int32 Id)> FSetBlock;
+
+	void Initialize(int32 Seed, int32 InWidthOfChunk, int32 InHeightOfChunk, FGetBlock InGetBlock, FSetBlock InSetBlock);
+
+	// Register block behaviours and set the tick rates here.
+	VoxelCore::BlockTickScheduler& GetScheduler() { return Scheduler; }
+	const VoxelCore::BlockTickScheduler& GetScheduler() const { return Scheduler; }
+
+	void AddChunk(int32 ChunkX, int32 ChunkY, const TArray<FChunk_Block_Properties>& ChunkData);
+	void RemoveChunk(int32 ChunkX, int32 ChunkY);
+
+	// For edits made without the scheduler, e.g. by the player.
+	void NotifyBlockChanged(const FIntVector& Block, int32 OldId, int32 NewId);
+
+	// Advances the game tick clock and runs due ticks until BudgetSeconds have been used.
+	void Update(float DeltaTime, double BudgetSeconds);
+
+	FString GetStatsString() const;
+
+	// VoxelCore::BlockTickAccess
+	virtual VoxelCore::BlockId GetBlock(const VoxelCore::BlockPos& Block) const override;
+	virtual void SetBlock(const VoxelCore::BlockPos& Block, VoxelCore::BlockId Id) override;
+	virtual bool IsOutOfTime() const override;
+
+private:
+	VoxelCore::BlockTickScheduler Scheduler;
+
+	FGetBlock GetBlockFunction;
+	FSetBlock SetBlockFunction;
+
+	double Deadline = 0.0;
+};
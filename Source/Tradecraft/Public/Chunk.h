@@ -5,20 +5,14 @@
 #include "CoreMinimal.h"
 #include "ProceduralMeshComponent.h"
 #include "GameFramework/Actor.h"
+#include "EditJournal.h"
+#include "ChunkMesher.h"
+#include "HeightTileCache.h"
+#include "ChunkMemory.h"
+#include "StreamingTrace.h"
+#include "VoxelCore/LightEngine.h"
 #include "Chunk.generated.h"
 
-struct FMeshSection
-{
-	TArray<FVector> Vertices;
-	TArray<int32> Triangles;
-	TArray<FVector> Normals;
-	TArray<FVector2D> UVs;
-	TArray<FProcMeshTangent> Tangents;
-	TArray<FColor> VertexColors;
-
-	int32 elem_id = 0;
-};
-
 struct FChunk_Block_Properties
 {
 	int32 Current_Health = 0;
@@ -47,7 +41,7 @@ public:
 
 	void SetLocation(FVector position, int32 seed);
 
-	void LoadChunkValues(TArray<int32> ids);
+	void LoadChunkValues(const TArray<int32>& ids);
 
 	void GenerateLoadedChunkInWorld();
 
@@ -59,23 +53,62 @@ public:
 
 	void MakeOwner(AActor* Parent);
 
+	// Collision is cooked in the background by default. Chunks the player has to stand on
+	// straight away cook it synchronously instead.
+	void SetCookCollisionAsync(bool Async);
+
 	void ApplyMaterials();
 
 	int32 BreakBlock(int32 x, int32 y, int32 z);
 
 	void AddBlock(int32 x, int32 y, int32 z, int32 id);
 
+	// Sets many blocks at once without rebuilding the mesh, like SetBlockDeferred.
+	void ApplyBlockEdits(const TArray<FBlockEditRecord>& Edits);
+
+	// Sets a block without rebuilding the mesh; UpdateMeshIfDirty does that once for many edits.
+	void SetBlockDeferred(int32 x, int32 y, int32 z, int32 id);
+
+	void UpdateMeshIfDirty();
+
+	// Whether a collision-only chunk should have collision at all; changing it marks the mesh dirty.
+	void SetWantsCollision(bool Wants);
+	bool WantsCollision() const { return bWantsCollision; }
+
+	// Lights the chunk from its own blocks, border included; the world then stitches it to its
+	// neighbours. Does nothing without LightProperties.
+	void ComputeLight();
+
 	int32 DealDamage(int32 x, int32 y, int32 z, int32 damage);
 
 	int32 GetBlockId(int32 id);
 
+	// Adds this chunk's block data, mesh sections, render buffers and collision to OutUsage.
+	void GetMemoryUsage(FChunkMemoryUsage& OutUsage) const;
+
 	// Variables used in the game
 	FRandomStream RandomStream;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TArray <UMaterialInterface *> Materials;
 
-	TArray<FIntVector> TreeCenters;
+	// World seed passed to SetLocation, used when generating this chunk.
+	int32 Seed = 0;
+
+	// Terrain version of the world this chunk belongs to, see FChunkGenerator::CurrentTerrainVersion.
+	int32 TerrainVersion = 0;
+
+	// The world's biome map, shared by all of its chunks. Set by the world before generating.
+	const FBiomeMap* Biomes = nullptr;
+
+	// The world's height tile cache, shared the same way.
+	const FHeightTileCache* HeightTiles = nullptr;
+
+	// The world's streaming trace, if it is recording one.
+	FStreamingTrace* Trace = nullptr;
+
+	// The world's light properties; faces are drawn unlit without them.
+	const VoxelCore::LightProperties* LightProperties = nullptr;
 
 	int32 WidthOfChunk = 16;
 
@@ -91,15 +124,31 @@ public:
 
 	TArray<FChunk_Block_Properties> ChunkData;
 
+	// Sky and block light in the same layout as ChunkData, see VoxelCore::LightValue.
+	TArray<uint8> LightData;
+
+	// False while ChunkData matches what is saved on disk.
+	bool NeedsSaving = true;
+
+	// Set by SetBlockDeferred until the mesh is rebuilt.
+	bool MeshIsDirty = false;
+
+	// Off for chunks nobody looks at, e.g. on a dedicated server: UpdateMesh then builds just a
+	// hidden, merged collision section while WantsCollision is set, and no materials are applied.
+	bool bRenderMesh = true;
+
 
 private:
 	UProceduralMeshComponent * mesh;
 
 	void UpdateMesh();
 
-	TArray<int32> CalculateNoise();
+	void UpdateCollisionOnly();
+
+	bool bWantsCollision = true;
 
-	TArray<int32> NoiseData;
+	// Chunk grid coordinates, the ones used in chunk names.
+	FIntPoint GetChunkCoordinates() const;
 
 	FVector ChunkPositionInWorld;
 
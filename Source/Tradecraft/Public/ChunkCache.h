@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/List.h"
+
+/**
+ * Size bounded LRU cache of recently unloaded chunks, kept as codec encoded bytes (the same
+ * bytes that would be written to the chunk's file). Entries that differ from what is on disk
+ * are marked dirty and are only written out when they are evicted or flushed. The owner has to
+ * call Empty or Flush before the writer's target goes away; destroying the cache writes nothing.
+ */
+class TRADECRAFT_API FChunkCache
+{
+public:
+	// Writes one encoded chunk to disk. Called for dirty entries on eviction and flush.
+	typedef TFunction<bool(const FString& ChunkName, const TArray<uint8>& EncodedData)> FWriteChunk;
+
+	void SetWriter(FWriteChunk InWriter) { Writer = InWriter; }
+
+	// A budget of zero bytes or entries disables the cache; every Add then writes through.
+	void SetBudget(int64 InMaxBytes, int32 InMaxEntries);
+
+	// Takes ownership of the encoded data and makes the entry the most recently used one.
+	void Add(const FString& ChunkName, TArray<uint8>&& EncodedData, bool bDirty);
+
+	// On a hit the entry is moved out of the cache, since the chunk is about to become live again.
+	// bOutDirty tells the caller the data was never written to disk.
+	bool Take(const FString& ChunkName, TArray<uint8>& OutEncodedData, bool& bOutDirty);
+
+	bool Contains(const FString& ChunkName) const { return Entries.Contains(ChunkName); }
+
+	// Writes every dirty entry; the entries stay cached but become clean.
+	void Flush();
+
+	// Writes one entry if it is cached and dirty. Returns false only if that write failed.
+	bool FlushEntry(const FString& ChunkName);
+
+	// Drops every entry, writing out dirty ones first. Dirty entries that fail to write are kept.
+	void Empty();
+
+	// Evicts least recently used entries until at most TargetBytes are held. Eviction, here and
+	// when over budget, stops at a dirty entry that fails to write, which stays cached.
+	void Trim(int64 TargetBytes);
+
+	int64 GetBytesInUse() const { return BytesInUse; }
+	int32 Num() const { return Entries.Num(); }
+	int32 GetHits() const { return Hits; }
+	int32 GetMisses() const { return Misses; }
+	int32 GetEvictions() const { return Evictions; }
+	int32 GetWrites() const { return Writes; }
+	int32 GetWriteFailures() const { return WriteFailures; }
+
+	FString GetStatsString() const;
+
+private:
+	typedef TDoubleLinkedList<FString>::TDoubleLinkedListNode FLruNode;
+
+	struct FEntry
+	{
+		TArray<uint8> Data;
+		FLruNode* Node = nullptr;
+		bool bDirty = false;
+	};
+
+	static int64 GetEntrySize(const FString& ChunkName, const FEntry& Entry);
+
+	void EvictToBudget();
+	// False if the oldest entry is dirty and could not be written.
+	bool EvictOldest();
+	bool Write(const FString& ChunkName, FEntry& Entry);
+
+	TMap<FString, FEntry> Entries;
+
+	// Most recently used at the head.
+	TDoubleLinkedList<FString> Lru;
+
+	FWriteChunk Writer;
+
+	int64 MaxBytes = 64 * 1024 * 1024;
+	int32 MaxEntries = 4096;
+	int64 BytesInUse = 0;
+
+	int32 Hits = 0;
+	int32 Misses = 0;
+	int32 Evictions = 0;
+	int32 Writes = 0;
+	int32 WriteFailures = 0;
+};
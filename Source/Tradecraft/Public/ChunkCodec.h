@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FChunk_Block_Properties;
+
+// Compression applied after the pre-pass. The value is stored in the chunk header,
+// so never renumber these.
+enum class EChunkCodecBackend : uint8
+{
+	None = 0,
+	Zlib = 1,
+	LZ4 = 2
+};
+
+// Transform applied to the block ids before compression. Chunk data is laid out with z
+// innermost, so a flat run-length pass walks each vertical column in turn.
+enum class EChunkCodecPrepass : uint8
+{
+	None = 0,
+	RLE = 1
+};
+
+struct FChunkCodecHeader
+{
+	static const uint32 MagicValue = 0x4B434354; // "TCCK"
+	static const uint8 CurrentVersion = 1;
+	static const int32 Size = 16;
+
+	// Headers come from disk and the network, so the sizes in them are bounded before anything
+	// is allocated: far more values than any chunk holds, and the longest pre-pass stream they
+	// can take, two five byte varints per value.
+	static const int32 MaxValues = 1 << 20;
+	static const int32 MaxPrepassBytesPerValue = 10;
+
+	uint32 Magic = MagicValue;
+	uint8 Version = CurrentVersion;
+	uint8 Backend = (uint8)EChunkCodecBackend::None;
+	uint8 Prepass = (uint8)EChunkCodecPrepass::None;
+	uint8 Reserved = 0;
+	int32 NumValues = 0;
+	int32 PrepassSize = 0;
+};
+
+/**
+ * Encodes chunk block ids as [header][compressed pre-pass stream]. Files written before the
+ * codec existed have no header and are still read through the legacy zlib proxy path in
+ * UGameSaverAndLoader.
+ */
+class TRADECRAFT_API FChunkCodec
+{
+public:
+	static bool Encode(const TArray<int32>& Values, TArray<uint8>& OutData);
+	static bool Encode(const TArray<int32>& Values, TArray<uint8>& OutData, EChunkCodecBackend Backend, EChunkCodecPrepass Prepass);
+
+	static bool Decode(const uint8* Data, int32 Size, TArray<int32>& OutValues);
+
+	// Read ids straight out of / into a chunk's block storage without an intermediate id array.
+	// Blocks must already be sized; missing values are left untouched, and a stream of more values
+	// than Blocks holds is rejected.
+	static bool EncodeChunk(const TArray<FChunk_Block_Properties>& Blocks, TArray<uint8>& OutData);
+	static bool EncodeChunk(const TArray<FChunk_Block_Properties>& Blocks, TArray<uint8>& OutData, EChunkCodecBackend Backend, EChunkCodecPrepass Prepass);
+	static bool DecodeChunk(const uint8* Data, int32 Size, TArray<FChunk_Block_Properties>& Blocks);
+
+	// True if the buffer starts with a codec header rather than a legacy compressed archive.
+	static bool IsEncoded(const uint8* Data, int32 Size);
+
+	// Fails on an unknown version, backend or pre-pass, or sizes out of bounds.
+	static bool ReadHeader(const uint8* Data, int32 Size, FChunkCodecHeader& OutHeader);
+
+	// Backend/pre-pass selected by the Tradecraft.ChunkCodec.* console variables.
+	static EChunkCodecBackend GetDefaultBackend();
+	static EChunkCodecPrepass GetDefaultPrepass();
+
+	// LZ4 is only exposed by newer engine versions; anything unavailable falls back to zlib.
+	static bool IsBackendAvailable(EChunkCodecBackend Backend);
+
+	static const TCHAR* GetBackendName(EChunkCodecBackend Backend);
+	static const TCHAR* GetPrepassName(EChunkCodecPrepass Prepass);
+
+	// Number of times a buffer owned or filled by the codec has had to grow.
+	static int32 GetAllocationCount();
+};
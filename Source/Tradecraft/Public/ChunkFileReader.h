@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Read-only view of a saved chunk file. The file is memory mapped through the platform file
+ * API when the engine and platform support it, so the codec decompresses straight out of the
+ * page cache. Otherwise it is read into a buffer owned by the reader, which is reused if the
+ * reader is reopened.
+ */
+class TRADECRAFT_API FChunkFileReader
+{
+public:
+	FChunkFileReader();
+	~FChunkFileReader();
+
+	bool Open(const FString& FullFilePath);
+	void Close();
+
+	const uint8* GetData() const { return Data; }
+	int32 GetSize() const { return Size; }
+	bool IsMapped() const { return bMapped; }
+
+	// Number of opens served from a mapping and from a buffered read since startup.
+	static int32 GetMappedOpenCount();
+	static int32 GetBufferedOpenCount();
+
+private:
+	FChunkFileReader(const FChunkFileReader&) = delete;
+	FChunkFileReader& operator=(const FChunkFileReader&) = delete;
+
+	bool OpenMapped(const FString& FullFilePath);
+
+	IMappedFileHandle* MappedHandle = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+
+	TArray<uint8> Buffer;
+
+	const uint8* Data = nullptr;
+	int32 Size = 0;
+	bool bMapped = false;
+};
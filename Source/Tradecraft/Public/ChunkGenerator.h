@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BiomeMap.h"
+#include "VoxelCore/ChunkGenerator.h"
+
+typedef VoxelCore::ChunkGenerationTimings FChunkGenerationTimings;
+
+struct FChunk_Block_Properties;
+
+/**
+ * Game side of VoxelCore::ChunkGenerator, which does the actual generation without any engine
+ * dependency. Adds generating straight into AChunk::ChunkData and keeps the simplex noise
+ * library's copy of the permutation table in step with the core's.
+ */
+class TRADECRAFT_API FChunkGenerator : public VoxelCore::ChunkGenerator
+{
+public:
+	FChunkGenerator(int32 InSeed, int32 InWidthOfChunk = 16, int32 InHeightOfChunk = 128);
+
+	// Seeds the global simplex permutation table. Generate only reads that table, so after this
+	// has run on the game thread any number of chunks can be generated in parallel.
+	static void PrepareNoise(int32 Seed);
+
+	using VoxelCore::ChunkGenerator::Generate;
+
+	// ChunkX/ChunkY are chunk grid coordinates, the ones used in chunk names.
+	void Generate(int32 ChunkX, int32 ChunkY, TArray<FChunk_Block_Properties>& OutChunkData, FChunkGenerationTimings* Timings = nullptr) const;
+
+	// The ids of a chunk's block storage, for handing it to the voxel core.
+	static VoxelCore::BlockIdView MakeBlockIdView(TArray<FChunk_Block_Properties>& ChunkData);
+	static VoxelCore::ConstBlockIdView MakeBlockIdView(const TArray<FChunk_Block_Properties>& ChunkData);
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What the voxel world's memory is spent on. Chunk budgets evict in roughly reverse order:
+// cached saves first, then height tiles, then whole chunks.
+enum class EChunkMemoryTag : uint8
+{
+	// ChunkData and the per-block health table of loaded chunks.
+	BlockData,
+	// The procedural mesh components' CPU copies of their sections.
+	MeshSections,
+	// Vertex and index buffers of those sections on the render side, estimated from their sizes.
+	RenderData,
+	// Cooked collision of the chunk meshes.
+	Collision,
+	// Encoded unloaded chunks in FChunkCache.
+	ChunkCache,
+	HeightTiles,
+
+	Num
+};
+
+struct TRADECRAFT_API FChunkMemoryUsage
+{
+	int64 Bytes[(int32)EChunkMemoryTag::Num];
+
+	FChunkMemoryUsage()
+	{
+		FMemory::Memzero(Bytes);
+	}
+
+	int64& operator[](EChunkMemoryTag Tag) { return Bytes[(int32)Tag]; }
+	int64 operator[](EChunkMemoryTag Tag) const { return Bytes[(int32)Tag]; }
+
+	void Add(const FChunkMemoryUsage& Other);
+	int64 GetTotal() const;
+
+	static const TCHAR* GetTagName(EChunkMemoryTag Tag);
+};
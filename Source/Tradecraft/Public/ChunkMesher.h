@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+
+struct FChunk_Block_Properties;
+
+struct FMeshSection
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+	TArray<FProcMeshTangent> Tangents;
+	TArray<FColor> VertexColors;
+
+	int32 elem_id = 0;
+};
+
+/**
+ * Builds the per-material mesh sections of a chunk from its block data, through
+ * VoxelCore::ChunkMesher. Has no dependency on the chunk actor or the mesh component, so it can
+ * run on any thread.
+ */
+class TRADECRAFT_API FChunkMesher
+{
+public:
+	// One section per material; blocks whose id has no section are skipped with a warning.
+	// Light, in the same layout as ChunkData, bakes each face's light into its vertex color.
+	static void BuildMeshSections(const TArray<FChunk_Block_Properties>& ChunkData, int32 WidthOfChunk, int32 HeightOfChunk, int32 NumSections, TArray<FMeshSection>& OutSections, const TArray<uint8>* Light = nullptr);
+
+	// Collision surface only, merged into as few quads as possible, see VoxelCore::ChunkMesher.
+	static void BuildCollisionMesh(const TArray<FChunk_Block_Properties>& ChunkData, int32 WidthOfChunk, int32 HeightOfChunk, TArray<FVector>& OutVertices, TArray<int32>& OutTriangles);
+
+	// Checks the sections are consistent enough to upload: matching attribute counts and
+	// triangle indices inside the section. Returns false and logs the first problem otherwise.
+	static bool ValidateMeshSections(const TArray<FMeshSection>& Sections, const FString& Context);
+};
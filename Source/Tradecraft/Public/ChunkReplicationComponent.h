@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ChunkReplicationComponent.generated.h"
+
+class AMinecraftWorld;
+
+/**
+ * Streams the voxel world to one client. The server world adds one to every remote player
+ * controller; it sends the chunks within the world's ReplicationRange of that player's pawn as
+ * codec-compressed snapshots, nearest first and within a byte budget, followed by the block edits
+ * made in them as small varint packed deltas. The client builds the chunks' meshes from that data
+ * itself and sends its own edits back through ServerEditBlock.
+ */
+UCLASS(ClassGroup = (Tradecraft))
+class TRADECRAFT_API UChunkReplicationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UChunkReplicationComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// The server world this component streams from, or the client world it feeds.
+	UPROPERTY()
+	AMinecraftWorld* World = nullptr;
+
+	// Client to server: the component exists on the client, so chunks can be sent.
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReady();
+
+	// World block coordinates, see AMinecraftWorld::ApplyBlockEdit. Every request is answered
+	// with a ClientEditResult carrying the same Sequence.
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerEditBlock(FIntVector Block, int32 Id, int32 Sequence);
+
+	UFUNCTION(Client, Reliable)
+	void ClientEditResult(int32 Sequence, bool bAccepted, int32 OldId);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveChunk(int32 ChunkX, int32 ChunkY, const TArray<uint8>& Data);
+
+	UFUNCTION(Client, Reliable)
+	void ClientForgetChunks(const TArray<FIntPoint>& ChunksToForget);
+
+	// Edits packed by PackEdits.
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveBlockEdits(const TArray<uint8>& PackedEdits);
+
+	// Sent or received payload, in bytes, and the rate over the last second or so.
+	int64 GetTotalBytes() const { return SnapshotBytes + EditBytes; }
+	float GetBytesPerSecond() const { return BytesPerSecond; }
+
+	FString GetStatsString() const;
+
+private:
+	struct FBlockEdit
+	{
+		FIntVector Block;
+		int32 Id;
+	};
+
+	// Each edit is its x and y as zigzag deltas from the previous one, then z and the id.
+	static void PackEdits(const TArray<FBlockEdit>& Edits, TArray<uint8>& OutData);
+	static bool UnpackEdits(const TArray<uint8>& Data, TArray<FBlockEdit>& OutEdits);
+
+	void OnBlockChanged(const FIntVector& Block, int32 Id);
+
+	// Chunks to send around Center, nearest first.
+	void UpdateInterest(const FIntPoint& Center);
+
+	void SendSnapshots(float DeltaTime);
+
+	void SendEdits();
+
+	void CountBytes(int32 Bytes);
+
+	bool bClientReady = false;
+
+	// Chunks the client has been sent and not yet told to forget.
+	TSet<FIntPoint> ClientChunks;
+
+	TArray<FIntPoint> WantedChunks;
+
+	FIntPoint LastCenter = FIntPoint(MAX_int32, MAX_int32);
+
+	TArray<FBlockEdit> PendingEdits;
+
+	FDelegateHandle BlockChangedHandle;
+
+	// Bytes the snapshot budget still allows this tick.
+	float ByteAllowance = 0.0f;
+
+	int32 SnapshotsSent = 0;
+	int64 SnapshotBytes = 0;
+	int32 EditsSent = 0;
+	int64 EditBytes = 0;
+
+	float BytesPerSecond = 0.0f;
+	int64 WindowBytes = 0;
+	double WindowStart = 0.0;
+};
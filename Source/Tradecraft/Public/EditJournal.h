@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One block change inside one chunk. Block coordinates are indices into the chunk's
+// extended (border inclusive) block array, the same ones AChunk::AddBlock takes.
+struct FBlockEditRecord
+{
+	int32 ChunkX = 0;
+	int32 ChunkY = 0;
+	uint8 BlockX = 0;
+	uint8 BlockY = 0;
+	uint16 BlockZ = 0;
+	int32 Id = 0;
+};
+
+/**
+ * Append-only log of block edits for one world. Appending only copies a record into the file
+ * writer's buffer and Flush pushes that buffer to the OS once per frame, so journaling is cheap
+ * enough to do on every edit. After a crash the records are replayed on top of the saved chunks.
+ */
+class TRADECRAFT_API FEditJournal
+{
+public:
+	~FEditJournal();
+
+	// Opens the journal for appending, creating it if needed.
+	bool Open(const FString& InPath);
+	void Close();
+
+	void Append(const FBlockEditRecord& Record);
+	void Flush();
+
+	// Replaces the journal's contents with just these records, e.g. once every edit has been saved.
+	// False, with the old journal kept and still open, if the new one could not be put in place.
+	bool Rewrite(const TArray<FBlockEditRecord>& Records);
+
+	int32 GetNumRecords() const { return NumRecords; }
+
+	// Reads every complete record; a record cut short by a crash is dropped.
+	static bool ReadAll(const FString& InPath, TArray<FBlockEditRecord>& OutRecords);
+
+private:
+	static const uint32 Magic = 0x4A454354; // "TCEJ"
+	static const int32 HeaderSize = 8;
+	static const int32 RecordSize = 16;
+
+	static void SerializeRecord(FArchive& Ar, FBlockEditRecord& Record);
+
+	FArchive* Writer = nullptr;
+	FString Path;
+	int32 NumRecords = 0;
+	bool HasUnflushedRecords = false;
+};
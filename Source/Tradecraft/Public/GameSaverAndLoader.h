@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "GameFramework/SaveGame.h"
 #include "Chunk.h"
+#include "ChunkCodec.h"
+#include "ChunkFileReader.h"
 #include "Serialization/Archive.h"
 #include "HAL/FileManager.h"
 #include "Serialization/BufferArchive.h"
@@ -57,6 +59,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 SavedSeed;
 
+	// Generator version the world was created with; saves from before it existed load as 0.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 TerrainVersion;
+
 	TArray<int32> ItemIds;
 	TArray<int32> ItemCounts;
 
@@ -69,6 +75,11 @@ public:
 	bool SaveGameDataToFileCompressed(const FString& FullFilePath, TArray<int32>&  ChunkIds);
 	bool SaveGameDataToFileCompressed(const FString& FullFilePath, TArray<int32>& ItemIds, TArray<int32>& ItemCounts);
 
+	// Chunk saves stream straight between the chunk's block storage and the codec. Saving uses no
+	// object state, so worker threads can call it without touching a UObject.
+	static bool SaveChunkToFile(const FString& FullFilePath, const TArray<FChunk_Block_Properties>& ChunkData);
+	bool LoadChunkFromFile(const FString& FullFilePath, TArray<FChunk_Block_Properties>& ChunkData);
+
 	bool LoadGameDataFromFileCompressed(const FString& FullFilePath, TArray<int32>& ChunkIds);
 	bool LoadGameDataFromFileCompressed(const FString& FullFilePath, TArray<int32>& ItemIds, TArray<int32>& ItemCounts);
 
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GenerationBenchmarkCommandlet.generated.h"
+
+/**
+ * Generates and meshes a fixed block of chunks for a few fixed seeds and every terrain version,
+ * reports how long each stage took, and checks a hash of the blocks and meshes against the
+ * golden values in Config/GenerationGolden.txt. Returns non-zero on any mismatch or missing entry,
+ * so it can gate changes to noise and generation. -UpdateGolden rewrites this platform's entries instead.
+ *
+ * The simplex permutation is shuffled with the C runtime's rand, so golden values are per platform.
+ * VoxelCoreBench -golden <Platform> prints the same hashes from the native build.
+ *
+ * UE4Editor-Cmd Tradecraft.uproject -run=GenerationBenchmark [-Seeds=1,2,3] [-Size=<Chunks>] [-Version=<N>] [-UpdateGolden] -nullrhi
+ */
+UCLASS()
+class TRADECRAFT_API UGenerationBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGenerationBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,10 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BiomeMap.h"
+#include "VoxelCore/HeightTileCache.h"
+
+typedef VoxelCore::HeightTile FHeightTile;
+typedef VoxelCore::HeightTileCache FHeightTileCache;
@@ -10,9 +10,23 @@
 #include "GameSaverAndLoader.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameSaverAndLoader.h"
+#include "ChunkCache.h"
+#include "HeightTileCache.h"
+#include "EditJournal.h"
+#include "BlockTickScheduler.h"
+#include "VoxelCore/FluidSimulation.h"
+#include "WorldLighting.h"
+#include "WorldNavigation.h"
 #include "Misc/Paths.h"
 #include "MinecraftWorld.generated.h"
 
+// World block coordinates and the new block id.
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnWorldBlockChanged, const FIntVector&, int32);
+
+// The id of the block this client broke, once the server has made or turned down the edit.
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnConfirmedBlockBreak, int32, Id);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRejectedBlockBreak, int32, Id);
+
 USTRUCT(BlueprintType)
 struct FBlock_Properties
 {
@@ -44,6 +58,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -56,10 +72,237 @@ public:
 
 	void RecursivelyBuildWorld(FVector pos, int32 radius);
 
+	// Queues every missing chunk in the radius, nearest first; Tick builds them within the budget below.
+	void QueueChunksNear(FVector pos, int32 radius);
+
+	void BuildPendingChunks();
+
+	int32 GetNumPendingChunkBuilds() const { return PendingChunkBuilds.Num() + RemoteChunkRequests.Num(); }
+
+	int32 GetNumLoadedChunks() const { return Chunks.Num(); }
+
 	bool IsSavedWorld = false;
 
 	int32 ChunkRange = 12;
 
+	// Chunks this many rings around the spawn chunk are built, with collision, before the player gets control.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SpawnAreaRings = 1;
+
+	// Queued chunks are built until this much of the frame is used, and at least one per frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ChunkBuildBudgetMs = 4.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxChunkBuildsPerTick = 2;
+
+	// Seconds from BeginPlay to the first frame the player could move in, and to the full radius being built.
+	UPROPERTY(BlueprintReadOnly)
+	float TimeToFirstControllableFrame = -1.0f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float TimeToFullyBuiltRadius = -1.0f;
+
+	// Unloaded chunks are kept compressed in RAM up to these limits before being written to disk.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ChunkCacheSizeMB = 64;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ChunkCacheMaxChunks = 1024;
+
+	const FChunkCache& GetChunkCache() const { return ChunkCache; }
+
+	const FBiomeMap* GetBiomeMap() const { return BiomeMap.Get(); }
+
+	// Shared by chunk generation and anything else that needs terrain heights.
+	const FHeightTileCache* GetHeightTiles() const { return HeightTiles.Get(); }
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 HeightTileCacheMaxTiles = 1024;
+
+	// Memory the voxel world may use, see EChunkMemoryTag; 0 means no limit. When it is exceeded
+	// the chunk cache is trimmed, then the height tiles dropped, then the farthest chunks unloaded
+	// and streaming held back to the distance of the nearest one until usage is well below it again.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 WorldMemoryBudgetMB = 0;
+
+	// Chunks this close to the player are never unloaded to meet the budget.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MemoryBudgetMinChunkRange = 3;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MemoryCheckIntervalSeconds = 0.5f;
+
+	FChunkMemoryUsage GetMemoryUsage() const;
+
+	// Streaming distance in chunks while the memory budget holds it back, otherwise 0.
+	int32 GetMemoryLimitedRange() const { return MemoryLimitedRange; }
+
+	// Records chunk streaming to Saved/Profiling/Tradecraft from BeginPlay on; -TradecraftTrace
+	// on the command line does the same. Replay a trace with -run=ReplayStreamingTrace.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bRecordStreamingTrace = false;
+
+	// Path defaults to Saved/Profiling/Tradecraft/StreamingTrace-<date>.tctrace.
+	bool StartStreamingTrace(const FString& Path = FString());
+	void StopStreamingTrace();
+
+	const FStreamingTrace& GetStreamingTrace() const { return StreamingTrace; }
+
+	// Inverse of BuildChunkName.
+	static bool ParseChunkName(const FString& ChunkName, int32& OutX, int32& OutY);
+
+	// Block updates such as grass spreading run this many game ticks a second and stop for the
+	// frame once they have used BlockTickBudgetMs. Chunks they or light updates changed are
+	// remeshed afterwards, at most MaxBlockTickRemeshesPerTick a frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnableBlockTicks = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BlockTicksPerSecond = 20.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RandomBlockTicksPerSection = 3;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BlockTickBudgetMs = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxBlockTickRemeshesPerTick = 2;
+
+	const FBlockTickScheduler& GetBlockTicks() const { return BlockTicks; }
+
+	// Block ids of the fluids. INDEX_NONE leaves a fluid out.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 WaterSourceBlockId = 8;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FlowingWaterBlockId = 9;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 LavaSourceBlockId = 10;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FlowingLavaBlockId = 11;
+
+	// Used for the fluid ids that have no entry in Materials, which would otherwise not be drawn.
+	// Without one either, the engine's default material stands in.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UMaterialInterface* WaterMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UMaterialInterface* LavaMaterial = nullptr;
+
+	// Places a water or lava source at pos if the block there is air, like AddBlock. False if
+	// that fluid is left out or the block is taken.
+	UFUNCTION(BlueprintCallable)
+	bool PlaceFluidSource(FVector pos, bool bLava);
+
+	const VoxelCore::FluidSimulation& GetFluids() const { return Fluids; }
+
+	// Sky and block light baked into the chunks' vertex colors, see FChunkMesher. Off, faces
+	// are white as before. Off by default since the block materials don't read the vertex
+	// color yet, so the light would cost meshing time without showing.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnableLighting = false;
+
+	const FWorldLighting& GetLighting() const { return Lighting; }
+
+	// A portal graph over the loaded chunks for AI paths. Built on the server only, and off by
+	// default since nothing asks for paths yet. New chunks and the parts of the graph around
+	// edited blocks are rebuilt in the world's tick, within NavigationBudgetMs a frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnableNavigation = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float NavigationBudgetMs = 0.5f;
+
+	FWorldNavigation& GetNavigation() { return Navigation; }
+
+	// Points on the floor of every block from Start to Goal, for an agent two blocks tall.
+	UFUNCTION(BlueprintCallable)
+	bool FindVoxelPath(FVector Start, FVector Goal, TArray<FVector>& Points);
+
+	// On a dedicated server, or with -TradecraftServerChunks, chunks keep only their block data
+	// and a merged collision section within ServerCollisionRange chunks of a player; nothing is
+	// meshed for rendering and nothing is lit.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bMeshFreeChunksOnServer = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ServerCollisionRange = 2;
+
+	bool IsUsingServerChunks() const { return bServerChunks; }
+
+	// On a listen or dedicated server every remote player gets a UChunkReplicationComponent,
+	// which streams the chunks within ReplicationRange of their pawn. A client world builds
+	// nothing itself and meshes what it receives.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ReplicationRange = 8;
+
+	// Snapshot bytes each client may be sent per second, and at most this many chunks a frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ReplicationBytesPerSecond = 256 * 1024;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxSnapshotsPerTick = 4;
+
+	// Edits a client asks for farther than this from its pawn, in world units, are ignored.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MaxClientEditReach = 1000.0f;
+
+	// On a client, BreakBlock returns the id of the block as the client sees it, so existing
+	// callers keep working, and the server answers every break later: OnConfirmedBlockBreak gets
+	// the id it actually broke, OnRejectedBlockBreak the returned id of a break it turned down,
+	// e.g. to take back what was handed out for it.
+	UPROPERTY(BlueprintAssignable)
+	FOnConfirmedBlockBreak OnConfirmedBlockBreak;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnRejectedBlockBreak OnRejectedBlockBreak;
+
+	// Ids a client may ask the server to place: ones with block properties, other than the fluids.
+	bool IsPlaceableBlockId(int32 Id) const;
+
+	bool IsReplicatedClient() const { return bReplicatedClient; }
+
+	// Every block change made on this world, by players, block ticks or the server.
+	FOnWorldBlockChanged OnBlockChanged;
+
+	AChunk* FindChunk(const FIntPoint& Chunk) const;
+
+	// Chunk coordinates of a world position, as used for streaming around the player.
+	FIntPoint GetChunkCoordinatesAt(const FVector& WorldPos) const;
+
+	FIntPoint GetChunkOfBlock(const FIntVector& Block) const;
+
+	// Moves missing chunks to the front of the remote players' build queue, in the order given.
+	// BuildPendingChunks takes turns between it and this player's queue.
+	void RequestChunks(const TArray<FIntPoint>& Wanted);
+
+	// Server: a block edit a client asked for, in world block coordinates.
+	void ApplyBlockEdit(const FIntVector& Block, int32 Id);
+
+	// Client: chunk data and edits from the server.
+	void ReceiveChunk(const FIntPoint& Chunk, const TArray<uint8>& Data);
+	void ForgetReceivedChunk(const FIntPoint& Chunk);
+	void ApplyReplicatedEdit(const FIntVector& Block, int32 Id);
+
+	// Client: the server's answer to the edit request with this sequence number. OldId is what
+	// the server replaced, if it accepted.
+	void OnEditResult(int32 Sequence, bool bAccepted, int32 OldId);
+
+	// Edited chunks are autosaved once they have gone this long without another edit.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AutosaveDelaySeconds = 5.0f;
+
+	// Autosave stops for the frame once it has used this much time or saved this many chunks.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AutosaveBudgetMs = 2.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 AutosaveMaxChunksPerTick = 2;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 seed;
 
@@ -134,6 +377,131 @@ private:
 
 	FVector LastBuildPosition;
 
+	FVector GetChunkPosition(FVector WorldPos) const;
+
+	void BuildSpawnArea(FVector ChunkPos);
+
+	bool BuildingSpawnArea = false;
+
+	// Chunk coordinates waiting to be built, farthest first so the nearest one is popped next.
+	TArray<FIntPoint> PendingChunkBuilds;
+
+	// The same for remote players, see RequestChunks. Kept apart since QueueChunksNear refills
+	// PendingChunkBuilds around this player only.
+	TArray<FIntPoint> RemoteChunkRequests;
+
+	double StartupTime = 0.0;
+
+	AChunk* SpawnChunkAt(FVector pos);
+
+	FChunkCache ChunkCache;
+
+	TSharedPtr<FBiomeMap, ESPMode::ThreadSafe> BiomeMap;
+
+	// Declared after BiomeMap, which it refers to.
+	TSharedPtr<FHeightTileCache, ESPMode::ThreadSafe> HeightTiles;
+
+	void RecordBlockEdit(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, int32 id);
+
+	void ReplayEditJournal();
+
+	void RunAutosave();
+
+	void EnforceMemoryBudget();
+
+	bool UnloadChunkToDisk(const FString& ChunkName);
+
+	double LastMemoryCheckTime = 0.0;
+
+	int32 MemoryLimitedRange = 0;
+
+	bool SaveChunkNow(const FString& ChunkName);
+
+	// Writes recovered journal edits for a chunk that was never built into its file, generating
+	// the chunk if it has none, so the journal can drop them.
+	bool SavePendingJournalEdits(const FString& ChunkName, const TArray<FBlockEditRecord>& Edits);
+
+	FStreamingTrace StreamingTrace;
+
+	FBlockTickScheduler BlockTicks;
+
+	VoxelCore::FluidSimulation Fluids;
+
+	// Loaded chunks by chunk coordinates, for block lookups that shouldn't build a chunk name.
+	TMap<FIntPoint, AChunk*> ChunksByCoordinates;
+
+	// Chunks block ticks or light updates have changed and that still need a new mesh.
+	TSet<AChunk*> ChunksToRemesh;
+
+	// World block coordinates, see FBlockTickScheduler.
+	int32 GetBlockAt(const FIntVector& Block);
+	void SetBlockAt(const FIntVector& Block, int32 Id);
+	void SetBlockInChunk(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, int32 Id);
+
+	void RegisterBlockBehaviors();
+
+	// Gives the fluid ids a material, see WaterMaterial.
+	void SetupFluidMaterials();
+
+	void TickBlocks(float DeltaTime);
+
+	void RemeshChangedChunks();
+
+	FWorldLighting Lighting;
+
+	void SetupLighting();
+
+	FWorldNavigation Navigation;
+
+	void SetupNavigation();
+
+	bool bServerChunks = false;
+
+	bool bReplicatedClient = false;
+
+	// Client: the ids breaks were predicted to return, by the sequence number of their request,
+	// until the server answers.
+	TMap<int32, int32> PendingClientBreaks;
+
+	int32 NextEditSequence = 0;
+
+	void AddReplicationComponents();
+
+	// Loaded neighbours own the blocks in a new chunk's border, which may have been edited since
+	// the chunk was saved or generated.
+	void CopyBordersFromNeighbours(AChunk* Chunk, const FIntPoint& Coordinates);
+
+	// Adds a chunk whose data is filled in to the lookups, lights and meshes it.
+	void AddBuiltChunk(AChunk* Chunk, const FString& ChunkName, const FIntPoint& Coordinates);
+
+	// In cm, ignoring height; MAX_flt without any player.
+	float GetDistanceToNearestPlayer(const FVector& WorldPos) const;
+
+	// Chunk coordinates of every player's pawn, as of the last UpdateServerCollision.
+	TArray<FIntPoint> PlayerChunks;
+
+	void GetPlayerChunks(TArray<FIntPoint>& OutChunks) const;
+
+	bool IsNearPlayer(const FIntPoint& Chunk) const;
+
+	// Gives collision to the chunks players have come near and takes it from the ones they left.
+	void UpdateServerCollision();
+
+	// Drops a chunk that is being unloaded from the lookups above.
+	void ForgetChunk(const FString& ChunkName);
+
+	FVector LastTracedPlayerPosition = FVector::ZeroVector;
+
+	void TraceChunk(EStreamingTraceEvent Type, const FString& ChunkName, double DurationSeconds = 0.0);
+
+	FEditJournal EditJournal;
+
+	// Chunks edited since they were last written, with the time of their latest edit.
+	TMap<FString, double> DirtyChunks;
+
+	// Journal edits recovered at startup for chunks that haven't been built yet.
+	TMap<FString, TArray<FBlockEditRecord>> PendingJournalEdits;
+
 	UGameSaverAndLoader* SaveGameInstance;
 
 	TArray<int32> ItemIds;
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PregenerateWorldCommandlet.generated.h"
+
+/**
+ * Generates and saves every chunk within a radius of the spawn chunk without starting the game,
+ * so large worlds can be built ahead of time. Chunks are written in the normal save format and
+ * are picked up by AMinecraftWorld like any other saved chunk.
+ *
+ * UE4Editor-Cmd Tradecraft.uproject -run=PregenerateWorld -World=<Name> -Seed=<N> -Radius=<Chunks> [-Validate] [-Overwrite] -nullrhi
+ *
+ * -Seed is required for a new world; an existing world always uses the seed it was saved with.
+ */
+UCLASS()
+class TRADECRAFT_API UPregenerateWorldCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPregenerateWorldCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
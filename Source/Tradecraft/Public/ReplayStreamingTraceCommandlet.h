@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ReplayStreamingTraceCommandlet.generated.h"
+
+/**
+ * Replays a streaming trace recorded by AMinecraftWorld (bRecordStreamingTrace, -TradecraftTrace
+ * or Tradecraft.Trace.Start) without a game: every chunk is generated, loaded, meshed and saved
+ * again in the recorded order, on one thread, with the seed and terrain version from the trace.
+ * Reports recorded against replayed time per event type and per frame, so a hitch seen in play
+ * can be reproduced and measured offline. Loads come from -World's save directory when the
+ * chunk is there, and are otherwise replayed as a decode of a freshly generated chunk. Saves go
+ * to a temporary directory. Uploads need a renderer and are only reported as recorded.
+ *
+ * UE4Editor-Cmd Tradecraft.uproject -run=ReplayStreamingTrace -Trace=<Path> [-World=<Name>] [-Report=<Json>] -nullrhi
+ */
+UCLASS()
+class TRADECRAFT_API UReplayStreamingTraceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UReplayStreamingTraceCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -41,6 +41,9 @@ private:
 	static float  grad(int hash, float x, float y, float z, float t);
 
 public:
+	// 512 entries plus zeroed padding, so vector gathers may read 4 bytes at any entry.
+	static const unsigned char* GetPermutationTable() { return perm; }
+
 	UFUNCTION(BlueprintCallable, Category = "SimplexNoise")
 		static int GenerateHeight(int32 x, int32 y, int oct, float pers, float smooth, int maxHeight);
 
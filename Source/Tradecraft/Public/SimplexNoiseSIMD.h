@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelCore/SimplexNoise.h"
+
+typedef VoxelCore::NoiseISA ESimplexNoiseISA;
+
+/**
+ * Batched simplex noise, forwarded to VoxelCore::SimplexNoise. Evaluates 4 (SSE2) or 8 (AVX2)
+ * points per step with the same operations, in the same order, as USimplexNoiseLibrary, so
+ * results match the scalar functions. The widest instruction set the CPU supports is picked at
+ * runtime, capped by the Tradecraft.Noise.MaxISA console variable.
+ */
+class TRADECRAFT_API FSimplexNoiseSIMD
+{
+public:
+	static void Noise2D(const float* X, const float* Y, float* Out, int32 Count);
+	static void Noise3D(const float* X, const float* Y, const float* Z, float* Out, int32 Count);
+
+	// Runs one specific path, for comparisons and benchmarks. Falls back to scalar if the CPU lacks it.
+	static void Noise2D(ESimplexNoiseISA ISA, const float* X, const float* Y, float* Out, int32 Count);
+	static void Noise3D(ESimplexNoiseISA ISA, const float* X, const float* Y, const float* Z, float* Out, int32 Count);
+
+	static bool IsSupported(ESimplexNoiseISA ISA);
+	static ESimplexNoiseISA GetActiveISA();
+	static const TCHAR* GetISAName(ESimplexNoiseISA ISA);
+	static int32 GetWidth(ESimplexNoiseISA ISA);
+};
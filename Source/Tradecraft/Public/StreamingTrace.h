@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EStreamingTraceEvent : uint8
+{
+	// Queued for building; X/Y are chunk coordinates, like every chunk event.
+	ChunkRequested,
+	// Duration is the time the work took.
+	ChunkGenerated,
+	ChunkLoaded,
+	ChunkMeshed,
+	ChunkUploaded,
+	ChunkSaved,
+	ChunkDestroyed,
+	// X/Y/Z in cm.
+	PlayerPosition,
+	// End of a game frame; Duration is the frame's delta time.
+	FrameEnd,
+
+	Num
+};
+
+struct FStreamingTraceEvent
+{
+	EStreamingTraceEvent Type = EStreamingTraceEvent::FrameEnd;
+	// Microseconds since the trace was started.
+	uint64 TimeUs = 0;
+	int32 X = 0;
+	int32 Y = 0;
+	int32 Z = 0;
+	uint32 DurationUs = 0;
+};
+
+// What a replay needs to rebuild the same chunks.
+struct FStreamingTraceHeader
+{
+	int32 Seed = 0;
+	int32 TerrainVersion = 0;
+	int32 WidthOfChunk = 16;
+	int32 HeightOfChunk = 128;
+	int64 StartTicks = 0;
+	FString WorldName;
+};
+
+/**
+ * Compact binary trace of a world's chunk streaming. Each event is a type byte, the time since
+ * the previous event and its fields as varints, usually 5 to 8 bytes; events are buffered and
+ * written once per frame by Flush. -run=ReplayStreamingTrace plays a trace back offline.
+ */
+class TRADECRAFT_API FStreamingTrace
+{
+public:
+	~FStreamingTrace();
+
+	bool Open(const FString& InPath, const FStreamingTraceHeader& Header);
+	void Close();
+
+	bool IsOpen() const { return Writer != nullptr; }
+	const FString& GetPath() const { return Path; }
+
+	void Record(EStreamingTraceEvent Type, int32 X, int32 Y, int32 Z = 0, double DurationSeconds = 0.0);
+
+	void RecordChunk(EStreamingTraceEvent Type, int32 ChunkX, int32 ChunkY, double DurationSeconds = 0.0)
+	{
+		Record(Type, ChunkX, ChunkY, 0, DurationSeconds);
+	}
+
+	void Flush();
+
+	// Reads every complete event; an event cut short at the end of the file is dropped.
+	static bool ReadAll(const FString& InPath, FStreamingTraceHeader& OutHeader, TArray<FStreamingTraceEvent>& OutEvents);
+
+	static const TCHAR* GetEventName(EStreamingTraceEvent Type);
+
+private:
+	static const uint32 Magic = 0x54534354; // "TCST"
+	static const uint32 Version = 1;
+
+	FArchive* Writer = nullptr;
+	FString Path;
+	double StartTime = 0.0;
+	uint64 LastTimeUs = 0;
+	TArray<uint8> Buffer;
+};
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/ThreadSafeBool.h"
+
+DECLARE_STATS_GROUP(TEXT("Tradecraft"), STATGROUP_Tradecraft, STATCAT_Advanced);
+
+// Chunk lifecycle stages. Scopes nest, so e.g. Generate Data is part of Build Pending Chunks.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Pending Chunks"), STAT_Tradecraft_BuildPendingChunks, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Remove Old Chunks"), STAT_Tradecraft_RemoveOldChunks, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Autosave"), STAT_Tradecraft_Autosave, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate Data"), STAT_Tradecraft_GenerateData, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Mesh"), STAT_Tradecraft_UpdateMesh, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Mesh Sections"), STAT_Tradecraft_BuildMeshSections, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Create Mesh Section"), STAT_Tradecraft_CreateMeshSection, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cook Collision (sync)"), STAT_Tradecraft_CookCollisionSync, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Encode Chunk"), STAT_Tradecraft_EncodeChunk, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Chunk"), STAT_Tradecraft_DecodeChunk, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write Chunk File"), STAT_Tradecraft_WriteChunkFile, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Read Chunk File"), STAT_Tradecraft_ReadChunkFile, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Block Ticks"), STAT_Tradecraft_BlockTicks, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Light"), STAT_Tradecraft_ComputeLight, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Light"), STAT_Tradecraft_UpdateLight, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Find Path"), STAT_Tradecraft_FindPath, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Navigation"), STAT_Tradecraft_UpdateNavigation, STATGROUP_Tradecraft, TRADECRAFT_API);
+
+// The generator's own stages run in the voxel core, which reports them as times afterwards.
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Generate: Noise (ms)"), STAT_Tradecraft_GenerateNoise, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Generate: Fill (ms)"), STAT_Tradecraft_GenerateFill, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Generate: Trees (ms)"), STAT_Tradecraft_GenerateTrees, STATGROUP_Tradecraft, TRADECRAFT_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chunks Generated"), STAT_Tradecraft_ChunksGenerated, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chunks Loaded"), STAT_Tradecraft_ChunksLoaded, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chunks Saved"), STAT_Tradecraft_ChunksSaved, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chunks Meshed"), STAT_Tradecraft_ChunksMeshed, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Vertices Emitted"), STAT_Tradecraft_VerticesEmitted, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Triangles Emitted"), STAT_Tradecraft_TrianglesEmitted, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Written"), STAT_Tradecraft_BytesWritten, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Block Ticks Run"), STAT_Tradecraft_BlockTicksRun, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Light Cells Visited"), STAT_Tradecraft_LightCellsVisited, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Replicated"), STAT_Tradecraft_BytesReplicated, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Path Nodes Expanded"), STAT_Tradecraft_PathNodesExpanded, STATGROUP_Tradecraft, TRADECRAFT_API);
+
+// Updated by the world's memory accounting, see EChunkMemoryTag.
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Block Data Memory"), STAT_Tradecraft_BlockDataMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Mesh Section Memory"), STAT_Tradecraft_MeshSectionMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Render Data Memory (est.)"), STAT_Tradecraft_RenderDataMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Collision Memory"), STAT_Tradecraft_CollisionMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Chunk Cache Memory"), STAT_Tradecraft_ChunkCacheMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Height Tile Memory"), STAT_Tradecraft_HeightTileMemory, STATGROUP_Tradecraft, TRADECRAFT_API);
+
+// Same names as the stats above; the first group are times, the rest plain counts.
+enum class ETradecraftStat : uint8
+{
+	BuildPendingChunks,
+	RemoveOldChunks,
+	Autosave,
+	GenerateData,
+	GenerateNoise,
+	GenerateFill,
+	GenerateTrees,
+	UpdateMesh,
+	BuildMeshSections,
+	CreateMeshSection,
+	CookCollisionSync,
+	EncodeChunk,
+	DecodeChunk,
+	WriteChunkFile,
+	ReadChunkFile,
+	BlockTicks,
+	ComputeLight,
+	UpdateLight,
+	FindPath,
+	UpdateNavigation,
+
+	ChunksGenerated,
+	ChunksLoaded,
+	ChunksSaved,
+	ChunksMeshed,
+	VerticesEmitted,
+	TrianglesEmitted,
+	BytesWritten,
+	BlockTicksRun,
+	LightCellsVisited,
+	BytesReplicated,
+	PathNodesExpanded,
+
+	Num
+};
+
+/**
+ * Per-frame copy of the Tradecraft stats that can be written to a CSV file, one row per frame,
+ * since this engine version has no CSV profiler. Works in any build configuration, and only
+ * collects anything while a file is being recorded (Tradecraft.StatsCsv.Start/Stop).
+ */
+class TRADECRAFT_API FTradecraftFrameStats
+{
+public:
+	static bool IsRecording() { return bRecording; }
+
+	// Path defaults to Saved/Profiling/TradecraftStats-<date>.csv.
+	static bool StartCsv(const FString& Path = FString());
+	static void StopCsv();
+
+	static void Add(ETradecraftStat Stat, int64 Amount);
+	static void AddSeconds(ETradecraftStat Stat, double Seconds);
+
+	static const TCHAR* GetStatName(ETradecraftStat Stat);
+
+	// Nearest-rank percentile, 0 to 1, of samples sorted in ascending order; 0 without samples.
+	static float GetPercentile(const TArray<float>& Sorted, float Percentile)
+	{
+		if (Sorted.Num() == 0)
+			return 0.0f;
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Index];
+	}
+
+	struct FScopeTimer
+	{
+		FScopeTimer(ETradecraftStat InStat, bool bCondition = true)
+			: Stat(InStat)
+			, StartCycles(bCondition && IsRecording() ? FPlatformTime::Cycles64() : 0)
+		{
+		}
+
+		~FScopeTimer()
+		{
+			if (StartCycles)
+				Add(Stat, (int64)(FPlatformTime::Cycles64() - StartCycles));
+		}
+
+	private:
+		ETradecraftStat Stat;
+		uint64 StartCycles;
+	};
+
+private:
+	static void WriteFrame();
+
+	static FThreadSafeBool bRecording;
+};
+
+#define TRADECRAFT_SCOPE_CYCLE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Tradecraft_##Name); \
+	FTradecraftFrameStats::FScopeTimer TradecraftScopeTimer_##Name(ETradecraftStat::Name)
+
+#define TRADECRAFT_CONDITIONAL_SCOPE_CYCLE(Name, bCondition) \
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_Tradecraft_##Name, bCondition); \
+	FTradecraftFrameStats::FScopeTimer TradecraftScopeTimer_##Name(ETradecraftStat::Name, bCondition)
+
+#define TRADECRAFT_INC_COUNTER(Name, Amount) \
+	do { INC_DWORD_STAT_BY(STAT_Tradecraft_##Name, Amount); FTradecraftFrameStats::Add(ETradecraftStat::Name, Amount); } while (0)
+
+#define TRADECRAFT_INC_SECONDS(Name, Seconds) \
+	do { INC_FLOAT_STAT_BY(STAT_Tradecraft_##Name, (float)((Seconds) * 1000.0)); FTradecraftFrameStats::AddSeconds(ETradecraftStat::Name, Seconds); } while (0)
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace VoxelCore
+{
+	enum class BiomeType : uint8_t
+	{
+		Plains = 0,
+		Forest = 1,
+		Desert = 2,
+		Mountains = 3,
+		Count = 4
+	};
+
+	struct BiomeSettings
+	{
+		// Applied to the base heightmap before it is floored.
+		float HeightScale = 1.0f;
+		float HeightOffset = 0.0f;
+
+		BlockId TopBlock = Blocks::Grass;
+		BlockId FillerBlock = Blocks::Dirt;
+
+		// Exposed ground at or above this height is bare stone instead of TopBlock.
+		int32_t RockLine = INT32_MAX;
+
+		// Chance of a tree on any column the generator considers.
+		float TreeChance = 0.03f;
+	};
+
+	struct BiomeSample
+	{
+		float Temperature = 0.0f;
+		float Humidity = 0.0f;
+
+		// Sums to one. Only biomes close to a border in climate space share the weight.
+		float Weights[(int32_t)BiomeType::Count];
+
+		BiomeType Dominant = BiomeType::Plains;
+
+		// Settings blended by weight; block ids come from the dominant biome.
+		float HeightScale = 1.0f;
+		float HeightOffset = 0.0f;
+		float TreeChance = 0.0f;
+	};
+
+	/**
+	 * Temperature and humidity for a whole world. Climate is sampled every CellSize blocks in
+	 * RegionSize square regions which are cached with LRU eviction, and everything in between is
+	 * bilinearly interpolated, so one region serves every chunk and every other system that asks
+	 * about it. Safe to query from any thread once the noise seed is set.
+	 */
+	class BiomeMap
+	{
+	public:
+		static const int32_t RegionSize = 128;
+		static const int32_t CellSize = 16;
+
+		explicit BiomeMap(int32_t InSeed, int32_t InMaxRegions = 256);
+
+		BiomeSample Sample(int32_t WorldX, int32_t WorldY) const;
+
+		// SizeX * SizeY samples Step blocks apart into Out[y + (x * SizeY)], the chunk noise layout.
+		// Out must have room for all of them.
+		void SampleArea(int32_t OriginX, int32_t OriginY, int32_t Step, int32_t SizeX, int32_t SizeY, BiomeSample* Out) const;
+
+		void Empty();
+
+		int32_t GetNumCachedRegions() const;
+		int32_t GetNumRegionsBuilt() const { return NumRegionsBuilt.load(); }
+
+		int32_t GetSeed() const { return Seed; }
+
+		static const BiomeSettings& GetSettings(BiomeType Biome);
+		static const char* GetBiomeName(BiomeType Biome);
+
+	private:
+		static const int32_t CellsPerRegion = RegionSize / CellSize;
+		static const int32_t PointsPerSide = CellsPerRegion + 1;
+
+		struct Region
+		{
+			float Temperature[PointsPerSide * PointsPerSide];
+			float Humidity[PointsPerSide * PointsPerSide];
+		};
+		typedef std::shared_ptr<const Region> RegionPtr;
+
+		struct CachedRegion
+		{
+			RegionPtr Data;
+			uint64_t LastUsed = 0;
+		};
+
+		RegionPtr FindOrBuildRegion(int32_t RegionX, int32_t RegionY) const;
+		static BiomeSample SampleRegion(const Region& Source, int32_t LocalX, int32_t LocalY);
+		static void ClassifyClimate(BiomeSample& Sample);
+
+		int32_t Seed;
+		int32_t MaxRegions;
+
+		mutable std::mutex Lock;
+		mutable std::unordered_map<uint64_t, CachedRegion> Regions;
+		mutable uint64_t UseCounter = 0;
+		mutable std::atomic<int32_t> NumRegionsBuilt;
+	};
+
+	// Packs a 2D grid coordinate into one hash map key.
+	inline uint64_t MakeGridKey(int32_t X, int32_t Y)
+	{
+		return ((uint64_t)(uint32_t)X << 32) | (uint32_t)Y;
+	}
+}
@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/RandomStream.h"
+#include "VoxelCore/VoxelTypes.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace VoxelCore
+{
+	// A block in world block coordinates: X and Y count blocks from the world origin, Z is the
+	// height inside the chunk.
+	struct BlockPos
+	{
+		int32_t X, Y, Z;
+
+		bool operator==(const BlockPos& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+		bool operator!=(const BlockPos& Other) const { return !(*this == Other); }
+		BlockPos operator+(const BlockPos& Other) const { return { X + Other.X, Y + Other.Y, Z + Other.Z }; }
+		BlockPos operator-(const BlockPos& Other) const { return { X - Other.X, Y - Other.Y, Z - Other.Z }; }
+	};
+
+	struct BlockPosHash
+	{
+		size_t operator()(const BlockPos& Block) const
+		{
+			return (size_t)(((uint64_t)(uint32_t)Block.X * 73856093u) ^ ((uint64_t)(uint32_t)Block.Y * 19349663u) ^ ((uint64_t)(uint32_t)Block.Z * 83492791u));
+		}
+	};
+
+	class BlockTickScheduler;
+
+	typedef std::function<void(BlockTickScheduler& Scheduler, const BlockPos& Block)> BlockTickFunction;
+
+	// What one tickable block type does.
+	struct BlockTickBehavior
+	{
+		// Called for randomly picked blocks of this type, e.g. for growth or decay.
+		BlockTickFunction OnRandomTick;
+
+		// Called for ticks scheduled with ScheduleTick, if the block is still of this type.
+		BlockTickFunction OnScheduledTick;
+
+		// Game ticks until a scheduled tick after the block or one of its six neighbours changes,
+		// or IndexNone to not react to changes.
+		int32_t NeighborChangeDelay = IndexNone;
+
+		// Also ticks every block of this type, after NeighborChangeDelay, when its chunk or a
+		// neighbouring one loads, since scheduled ticks are dropped with an unloaded chunk.
+		bool bScheduleOnLoad = false;
+	};
+
+	// The world's blocks, and the clock the update budget runs on.
+	class BlockTickAccess
+	{
+	public:
+		virtual ~BlockTickAccess() {}
+
+		// Only called for blocks in added chunks.
+		virtual BlockId GetBlock(const BlockPos& Block) const = 0;
+		virtual void SetBlock(const BlockPos& Block, BlockId Id) = 0;
+
+		// Checked between ticks: once it is true, Update leaves the rest for the next one.
+		virtual bool IsOutOfTime() const = 0;
+	};
+
+	/**
+	 * Runs block updates for the loaded chunks at a fixed game tick rate. Scheduled ticks wait in a
+	 * priority queue keyed by game tick. Random ticks pick RandomTicksPerSection blocks in each 16
+	 * high section of every chunk, but only in sections that hold a random tickable block type,
+	 * so sky and plain stone cost nothing. Update stops once the access is out of time; due ticks
+	 * then wait for the next update and random ticks carry on from the next chunk.
+	 */
+	class BlockTickScheduler
+	{
+	public:
+		static const int32_t SectionHeight = 16;
+
+		void Initialize(BlockTickAccess& InAccess, int32_t Seed, const ChunkLayout& InLayout);
+
+		void RegisterBehavior(BlockId Id, const BlockTickBehavior& Behavior);
+
+		// Counts the chunk's random tickable blocks per section and schedules the blocks that want a
+		// tick on load, in the chunk and along its neighbours' borders. Ticks only run in added chunks.
+		void AddChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView ChunkData);
+		void RemoveChunk(int32_t ChunkX, int32_t ChunkY);
+
+		bool IsBlockLoaded(const BlockPos& Block) const;
+
+		// Air outside the loaded chunks.
+		BlockId GetBlock(const BlockPos& Block) const;
+
+		// Changes the block through the access and wakes it and its neighbours.
+		void SetBlock(const BlockPos& Block, BlockId Id);
+
+		// For edits made without SetBlock, e.g. by the player.
+		void NotifyBlockChanged(const BlockPos& Block, BlockId OldId, BlockId NewId);
+
+		// Ticks the block Delay game ticks from now, unless it already has a tick waiting for the
+		// id it has now; one waiting for an id it no longer has is replaced. IndexNone uses its
+		// behaviour's NeighborChangeDelay.
+		void ScheduleTick(const BlockPos& Block, int32_t Delay);
+
+		// Schedules the six neighbours as if the block had changed, e.g. for a change the block
+		// ids don't show.
+		void WakeNeighbors(const BlockPos& Block);
+
+		// Advances the game tick clock and runs due ticks until the access is out of time.
+		// Returns false if it ran out of time.
+		bool Update(float DeltaTime);
+
+		RandomStream& GetRandom() { return Random; }
+		int64_t GetCurrentTick() const { return CurrentTick; }
+		int32_t GetNumScheduledTicks() const { return (int32_t)ScheduledBlocks.size(); }
+
+		// Random tickable blocks in one section of a loaded chunk, 0 if it is not loaded.
+		int32_t GetSectionCount(int32_t ChunkX, int32_t ChunkY, int32_t Section) const;
+
+		int32_t GetNumSections() const;
+		int32_t GetNumActiveSections() const;
+
+		int64_t GetNumScheduledTicksRun() const { return ScheduledTicksRun; }
+		int64_t GetNumRandomTicksRun() const { return RandomTicksRun; }
+		int64_t GetNumOverBudgetUpdates() const { return OverBudgetUpdates; }
+
+		float TicksPerSecond = 20.0f;
+
+		int32_t RandomTicksPerSection = 3;
+
+		// Game ticks run in one Update at most; time beyond that is dropped rather than caught up.
+		int32_t MaxTicksPerUpdate = 2;
+
+	private:
+		struct ScheduledTick
+		{
+			int64_t Tick;
+			uint32_t Sequence;
+			BlockPos Block;
+			BlockId Id;
+		};
+
+		// For std::push_heap, which keeps the largest element on top: the earliest tick goes first.
+		struct ScheduledTickOrder
+		{
+			bool operator()(const ScheduledTick& A, const ScheduledTick& B) const
+			{
+				return A.Tick != B.Tick ? A.Tick > B.Tick : A.Sequence > B.Sequence;
+			}
+		};
+
+		static uint64_t MakeKey(int32_t X, int32_t Y) { return ((uint64_t)(uint32_t)X << 32) | (uint32_t)Y; }
+
+		uint64_t GetChunkKey(const BlockPos& Block) const { return MakeKey(FloorDiv(Block.X, Layout.Width), FloorDiv(Block.Y, Layout.Width)); }
+
+		const BlockTickBehavior* FindBehavior(BlockId Id) const;
+
+		bool IsRandomTickable(BlockId Id) const { return Id >= 0 && Id < (int32_t)RandomTickable.size() && RandomTickable[Id]; }
+
+		bool IsScheduledOnLoad(BlockId Id) const { return Id >= 0 && Id < (int32_t)ScheduledOnLoad.size() && ScheduledOnLoad[Id]; }
+
+		bool RunScheduledTicks();
+		bool RunRandomTicks();
+
+		BlockTickAccess* Access = nullptr;
+		ChunkLayout Layout;
+
+		std::unordered_map<BlockId, BlockTickBehavior> Behaviors;
+		std::vector<bool> RandomTickable;
+		std::vector<bool> ScheduledOnLoad;
+
+		// Random tickable blocks per section of each loaded chunk.
+		std::unordered_map<uint64_t, std::vector<uint16_t>> Sections;
+
+		// Order random ticks go through the chunks in, so an update that runs out of time doesn't
+		// starve the same chunks every time.
+		std::vector<uint64_t> RandomTickOrder;
+		int32_t RandomTickCursor = 0;
+		bool RandomTickOrderDirty = false;
+
+		// Heap ordered by ScheduledTickOrder. It can hold replaced ticks, which are dropped when
+		// they come due; ScheduledBlocks has the one tick that counts for each block.
+		std::vector<ScheduledTick> Scheduled;
+		std::unordered_map<BlockPos, ScheduledTick, BlockPosHash> ScheduledBlocks;
+		uint32_t NextSequence = 0;
+
+		int64_t CurrentTick = 0;
+		float TickAccumulator = 0.0f;
+		// Chunks still to visit in the current game tick's random tick pass.
+		int32_t RandomChunksLeft = 0;
+
+		RandomStream Random;
+
+		int64_t ScheduledTicksRun = 0;
+		int64_t RandomTicksRun = 0;
+		int64_t OverBudgetUpdates = 0;
+	};
+}
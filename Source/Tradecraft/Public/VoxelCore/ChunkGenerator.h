@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/BiomeMap.h"
+#include "VoxelCore/RandomStream.h"
+#include <vector>
+
+namespace VoxelCore
+{
+	class HeightTileCache;
+
+	// Seconds spent in each generation stage, added to by every Generate call that is given one.
+	struct ChunkGenerationTimings
+	{
+		double NoiseSeconds = 0.0;
+		double FillSeconds = 0.0;
+		double TreeSeconds = 0.0;
+		int32_t NumChunks = 0;
+	};
+
+	/**
+	 * Terrain generation for one chunk. Output uses the ChunkLayout indexing, including the one
+	 * block border, written through a view so callers can generate straight into their own block
+	 * storage. Safe to run on any number of threads at once after PrepareNoise.
+	 */
+	class ChunkGenerator
+	{
+	public:
+		ChunkGenerator(int32_t InSeed, int32_t InWidthOfChunk = 16, int32_t InHeightOfChunk = 128);
+
+		// Seeds the global simplex permutation table, which Generate only reads.
+		static void PrepareNoise(int32_t Seed);
+
+		// ChunkX/ChunkY are chunk grid coordinates, the ones used in chunk names. OutChunkData must
+		// hold GetNumBlocks() blocks; every one of them is written.
+		void Generate(int32_t ChunkX, int32_t ChunkY, BlockIdView OutChunkData, ChunkGenerationTimings* Timings = nullptr) const;
+		void Generate(int32_t ChunkX, int32_t ChunkY, std::vector<BlockId>& OutChunkData, ChunkGenerationTimings* Timings = nullptr) const;
+
+		// Surface height offsets for the extended chunk, indexed y + (x * WidthExt).
+		// ChunkXIndex/ChunkYIndex are the block coordinates of the chunk's origin.
+		void CalculateNoise(int32_t ChunkXIndex, int32_t ChunkYIndex, std::vector<int32_t>& OutNoise) const;
+
+		// The same heights before flooring, WidthExt * WidthExt of them.
+		void CalculateHeights(int32_t ChunkXIndex, int32_t ChunkYIndex, float* OutHeights) const;
+
+		// Unshaped heightmap under SizeX * SizeY block columns from BlockX/BlockY, into Out[y + (x * SizeY)].
+		static void SampleHeightmap(int32_t BlockX, int32_t BlockY, int32_t SizeX, int32_t SizeY, float* Out);
+
+		// Terrain version 2: heights reshaped by each column's blended biome. OutBiomes is indexed like the noise.
+		void CalculateBiomeNoise(int32_t ChunkXIndex, int32_t ChunkYIndex, const BiomeMap& Map, std::vector<int32_t>& OutNoise, std::vector<BiomeSample>& OutBiomes) const;
+
+		// Terrain version 0: solid below the heightmap. OutTreeBases is filled for PlaceTrees.
+		void FillBlocks(const std::vector<int32_t>& NoiseData, BlockIdView ChunkData, std::vector<int32_t>& OutTreeBases) const;
+
+		// Terrain version 1: the heightmap shaped by a 3D density field, which adds overhangs, with
+		// tunnels carved where two cave fields are both near zero. The fields are sampled every
+		// DensityCellSize blocks on a world aligned lattice and trilinearly interpolated in between.
+		// With ColumnBiomes (version 2) surface blocks and tree density follow each column's biome.
+		void FillBlocksWithDensity(int32_t ChunkXIndex, int32_t ChunkYIndex, const std::vector<int32_t>& NoiseData, const std::vector<BiomeSample>* ColumnBiomes, BlockIdView ChunkData, std::vector<int32_t>& OutTreeBases) const;
+
+		// Terrain version 3: stamps every structure that reaches into the chunk, wherever its root is.
+		void PlaceStructures(int32_t ChunkXIndex, int32_t ChunkYIndex, const BiomeMap& Map, BlockIdView ChunkData) const;
+
+		// Surface offset and biome of one block column, through the tile cache when there is one.
+		void GetColumn(int32_t BlockX, int32_t BlockY, const BiomeMap& Map, int32_t& OutNoise, BiomeSample& OutBiome) const;
+
+		// Height a structure rooted on this column starts at: the block above its top solid block
+		// if that is the biome's grass, or IndexNone. Evaluates the density field for just this
+		// column and gives the same answer as FillBlocksWithDensity, so it works for columns outside the chunk.
+		int32_t FindStructureBase(int32_t BlockX, int32_t BlockY, int32_t Noise, BiomeType Biome) const;
+
+		// Grows trees on the columns in TreeBases, which hold the height of the block above the
+		// ground, or IndexNone, indexed like the noise. TreeChances, if given, replaces the flat 3% per column.
+		void PlaceTrees(const std::vector<int32_t>& TreeBases, const std::vector<float>* TreeChances, RandomStream& Random, BlockIdView ChunkData) const;
+
+		int32_t GetNumBlocks() const { return WidthOfChunkExt * WidthOfChunkExt * HeightOfChunk; }
+		ChunkLayout GetLayout() const { return ChunkLayout(WidthOfChunk, HeightOfChunk); }
+
+		// Bumped whenever generation changes in a way that alters an existing seed's terrain. Worlds
+		// keep the version they were created with, so new chunks still line up with saved ones.
+		static const int32_t CurrentTerrainVersion = 3;
+
+		static const int32_t DensityCellSize = 4;
+
+		// Largest extended chunk the noise pass supports without allocating.
+		static const int32_t MaxNoiseSamples = 64 * 64;
+
+		int32_t Seed;
+		int32_t TerrainVersion = CurrentTerrainVersion;
+
+		// World biome cache used from version 2 on. Without one, a private map is built per chunk.
+		const BiomeMap* Biomes = nullptr;
+
+		// World height tile cache. When set, heights and biomes come from it instead of being sampled per chunk.
+		const HeightTileCache* HeightTiles = nullptr;
+
+		int32_t WidthOfChunk;
+		int32_t HeightOfChunk;
+		int32_t WidthOfChunkExt;
+	};
+}
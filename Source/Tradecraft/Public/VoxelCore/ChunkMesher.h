@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <string>
+#include <vector>
+
+namespace VoxelCore
+{
+	struct Vec3
+	{
+		float X, Y, Z;
+	};
+
+	struct Vec2
+	{
+		float X, Y;
+	};
+
+	struct Color
+	{
+		uint8_t R, G, B, A;
+	};
+
+	struct MeshSection
+	{
+		std::vector<Vec3> Vertices;
+		std::vector<int32_t> Triangles;
+		std::vector<Vec3> Normals;
+		std::vector<Vec2> UVs;
+		std::vector<Color> VertexColors;
+
+		int32_t ElementId = 0;
+	};
+
+	/**
+	 * Builds the per-material mesh sections of a chunk: one quad for every block face next to air
+	 * or leaves, in engine units (100 per block). Pure function of the block ids, safe on any thread.
+	 */
+	class ChunkMesher
+	{
+	public:
+		// One section per material, indexed by block id. Returns false if a block id had no
+		// section or the data was smaller than the layout; those columns are skipped.
+		// With Light (LightEngine values in the same layout) each face is coloured by the light in
+		// front of it: R sky, G block light, B the brighter of the two, 0 to 255; A is always the
+		// face index. Without it faces are white.
+		static bool BuildMeshSections(ConstBlockIdView ChunkData, int32_t WidthOfChunk, int32_t HeightOfChunk, int32_t NumSections, std::vector<MeshSection>& OutSections, const uint8_t* Light = nullptr);
+
+		// Collision surface only: the same faces as the render mesh, but in a single section
+		// with faces of any block merged into as few rectangles as possible, and positions
+		// only. Returns false if the data is smaller than the layout.
+		static bool BuildCollisionMesh(ConstBlockIdView ChunkData, int32_t WidthOfChunk, int32_t HeightOfChunk, std::vector<Vec3>& OutVertices, std::vector<int32_t>& OutTriangles);
+
+		// Checks the sections are consistent enough to upload: matching attribute counts and
+		// triangle indices inside the section. Describes the first problem in OutError otherwise.
+		static bool ValidateMeshSections(const std::vector<MeshSection>& Sections, std::string& OutError);
+	};
+}
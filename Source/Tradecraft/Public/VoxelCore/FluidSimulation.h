@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/BlockTickScheduler.h"
+#include <unordered_map>
+#include <vector>
+
+namespace VoxelCore
+{
+	// One fluid's block ids and how far it flows. A source counts as level MaxLevel + 1 and never
+	// drains; flowing cells lose a level for every block they spread sideways.
+	struct FluidType
+	{
+		BlockId SourceId = IndexNone;
+		BlockId FlowingId = IndexNone;
+		int32_t MaxLevel = 7;
+
+		// Game ticks between a change next to a cell and the cell flowing.
+		int32_t TickDelay = 5;
+
+		// What this fluid's sources and flowing cells turn into when another fluid touches them,
+		// IndexNone to stay fluid.
+		BlockId HardenedSourceId = IndexNone;
+		BlockId HardenedFlowingId = IndexNone;
+	};
+
+	/**
+	 * Cellular fluids run by the block tick scheduler. A cell only gets a tick when it or one of its
+	 * neighbours changed, so the cost follows the number of moving cells and a settled pool costs
+	 * nothing. Sources are just their block id; the levels of flowing cells are kept sparsely per
+	 * chunk and are not saved. Fluid blocks are ticked again when their chunk loads, and flowing
+	 * cells then rebuild their levels from the sources around them.
+	 */
+	class FluidSimulation
+	{
+	public:
+		void Initialize(const ChunkLayout& InLayout);
+
+		// False, and not added, if the ids or levels are out of range.
+		bool AddFluid(const FluidType& Fluid);
+
+		// Hooks every added fluid's block ids up to the scheduler, which has to outlive them.
+		void RegisterBehaviors(BlockTickScheduler& Scheduler);
+
+		void RemoveChunk(int32_t ChunkX, int32_t ChunkY);
+
+		// MaxLevel + 1 for a source, the level of a flowing cell, 0 if the block is not a fluid.
+		int32_t GetLevel(const BlockTickScheduler& Ticks, const BlockPos& Block) const;
+
+		int32_t GetNumFlowingCells() const;
+
+		int64_t GetAllocatedSize() const;
+
+	private:
+		typedef std::unordered_map<int32_t, uint8_t> ChunkLevels;
+
+		static uint64_t MakeKey(int32_t X, int32_t Y) { return ((uint64_t)(uint32_t)X << 32) | (uint32_t)Y; }
+
+		void UpdateCell(BlockTickScheduler& Ticks, const BlockPos& Block, int32_t FluidIndex);
+
+		int32_t FindFluid(BlockId Id) const;
+
+		// MaxLevel + 1 for a source, 0 if the block is not this fluid.
+		int32_t GetFluidLevel(const BlockTickScheduler& Ticks, const BlockPos& Block, const FluidType& Fluid) const;
+
+		void SetLevel(const BlockPos& Block, int32_t Level);
+		void ClearLevel(const BlockPos& Block);
+
+		// Sets Block to flowing fluid at Level if it is loaded air.
+		bool FlowInto(BlockTickScheduler& Ticks, const BlockPos& Block, const FluidType& Fluid, int32_t Level);
+
+		uint64_t GetChunkKey(const BlockPos& Block) const { return MakeKey(FloorDiv(Block.X, Layout.Width), FloorDiv(Block.Y, Layout.Width)); }
+
+		// Of the block inside its chunk, without the border.
+		int32_t GetLocalIndex(const BlockPos& Block) const;
+
+		ChunkLayout Layout;
+
+		std::vector<FluidType> Fluids;
+
+		// Levels of flowing cells, by chunk and then by block index inside the chunk.
+		std::unordered_map<uint64_t, ChunkLevels> Levels;
+	};
+}
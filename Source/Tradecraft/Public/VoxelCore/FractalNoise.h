@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/SimplexNoise.h"
+#include <algorithm>
+
+namespace VoxelCore
+{
+	// One layer of fractal noise. The raw simplex value is clamped to [Min, Max] before it is
+	// scaled, which lets an octave contribute only its peaks.
+	struct NoiseOctave
+	{
+		float Frequency = 1.0f;
+		float Amplitude = 1.0f;
+		float Min = -3.4e+38f;
+		float Max = 3.4e+38f;
+	};
+
+	template <int32_t Index, int32_t NumOctaves>
+	struct FractalOctaveSum
+	{
+		static inline float Sum(const NoiseOctave* Octaves, float X, float Y)
+		{
+			const NoiseOctave& Octave = Octaves[Index];
+			const float Value = Clamp(SimplexNoise::Noise2D(X * Octave.Frequency, Y * Octave.Frequency), Octave.Min, Octave.Max) * Octave.Amplitude;
+			return Value + FractalOctaveSum<Index + 1, NumOctaves>::Sum(Octaves, X, Y);
+		}
+	};
+
+	template <int32_t NumOctaves>
+	struct FractalOctaveSum<NumOctaves, NumOctaves>
+	{
+		static inline float Sum(const NoiseOctave* Octaves, float X, float Y)
+		{
+			return 0.0f;
+		}
+	};
+
+	/**
+	 * 2D fractal (fBm) simplex noise with the octave count fixed at compile time, so the octave loop
+	 * is fully unrolled. Only reads the global permutation table, so it is safe to sample from any
+	 * thread once SimplexNoise::SetSeed has run.
+	 */
+	template <int32_t NumOctaves>
+	struct FractalNoise2D
+	{
+		static_assert(NumOctaves > 0, "Fractal noise needs at least one octave.");
+
+		NoiseOctave Octaves[NumOctaves];
+
+		// Classic fBm: every octave multiplies the frequency by Lacunarity and the amplitude by Gain.
+		static FractalNoise2D MakeFBm(float Frequency, float Amplitude, float Lacunarity = 2.0f, float Gain = 0.5f)
+		{
+			FractalNoise2D Noise;
+			for (int32_t i = 0; i < NumOctaves; i++)
+			{
+				Noise.Octaves[i].Frequency = Frequency;
+				Noise.Octaves[i].Amplitude = Amplitude;
+				Frequency *= Lacunarity;
+				Amplitude *= Gain;
+			}
+			return Noise;
+		}
+
+		inline float Sample(float X, float Y) const
+		{
+			return FractalOctaveSum<0, NumOctaves>::Sum(Octaves, X, Y);
+		}
+
+		// Samples SizeX * SizeY points starting at (OriginX, OriginY), Step apart, into Out[y + (x * SizeY)],
+		// the same x-major layout as chunk noise. Points go through the batched noise one octave at a
+		// time; octaves are added last to first, the order Sample sums them in, so the results are
+		// identical to calling Sample per point.
+		void SampleGrid(float OriginX, float OriginY, float Step, int32_t SizeX, int32_t SizeY, float* Out) const
+		{
+			const int32_t BatchSize = 256;
+			float BaseX[BatchSize];
+			float BaseY[BatchSize];
+			float NoiseX[BatchSize];
+			float NoiseY[BatchSize];
+			float Noise[BatchSize];
+
+			const int32_t NumPoints = SizeX * SizeY;
+			for (int32_t Start = 0; Start < NumPoints; Start += BatchSize)
+			{
+				const int32_t Count = std::min(BatchSize, NumPoints - Start);
+				for (int32_t i = 0; i < Count; i++)
+				{
+					const int32_t Index = Start + i;
+					BaseX[i] = OriginX + (Index / SizeY) * Step;
+					BaseY[i] = OriginY + (Index % SizeY) * Step;
+					Out[Index] = 0.0f;
+				}
+
+				for (int32_t o = NumOctaves - 1; o >= 0; o--)
+				{
+					const NoiseOctave& Octave = Octaves[o];
+					for (int32_t i = 0; i < Count; i++)
+					{
+						NoiseX[i] = BaseX[i] * Octave.Frequency;
+						NoiseY[i] = BaseY[i] * Octave.Frequency;
+					}
+
+					SimplexNoise::Noise2D(NoiseX, NoiseY, Noise, Count);
+
+					for (int32_t i = 0; i < Count; i++)
+						Out[Start + i] = Clamp(Noise[i], Octave.Min, Octave.Max) * Octave.Amplitude + Out[Start + i];
+				}
+			}
+		}
+	};
+}
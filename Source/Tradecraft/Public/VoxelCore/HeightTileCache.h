@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/BiomeMap.h"
+#include <string>
+#include <vector>
+
+namespace VoxelCore
+{
+	// Heights and biomes of the block columns of one chunk, indexed y + (x * Size).
+	struct HeightTile
+	{
+		static const int32_t Size = 16;
+
+		// The heightmap before any biome shaping, what terrain versions 0 and 1 floor.
+		float Heights[Size * Size];
+
+		// Heights shaped by each column's biome, the surface offsets of terrain version 2.
+		int32_t BiomeHeights[Size * Size];
+
+		BiomeSample Biomes[Size * Size];
+	};
+
+	/**
+	 * World wide cache of height tiles keyed by chunk coordinate, with LRU eviction. A chunk's
+	 * extended noise grid overlaps its eight neighbours, so with the cache every column is only
+	 * sampled once no matter how many chunks, structure passes or spawn searches ask for it.
+	 * Safe to use from any thread; tiles are built outside the lock.
+	 */
+	class HeightTileCache
+	{
+	public:
+		typedef std::shared_ptr<const HeightTile> TilePtr;
+
+		explicit HeightTileCache(const BiomeMap& InBiomes, int32_t InMaxTiles = 1024);
+
+		TilePtr GetTile(int32_t ChunkX, int32_t ChunkY) const;
+
+		// Surface offset of one block column, as CalculateNoise/CalculateBiomeNoise would give it.
+		int32_t GetColumnHeight(int32_t BlockX, int32_t BlockY, bool bBiomeHeights) const;
+
+		BiomeSample GetColumnBiome(int32_t BlockX, int32_t BlockY) const;
+
+		// SizeX * SizeY columns from block OriginX/OriginY, indexed y + (x * SizeY) like the chunk noise.
+		// OutBiomes is optional.
+		void GatherColumns(int32_t OriginX, int32_t OriginY, int32_t SizeX, int32_t SizeY, bool bBiomeHeights, std::vector<int32_t>& OutHeights, std::vector<BiomeSample>* OutBiomes) const;
+
+		void Empty();
+
+		int32_t GetNumCachedTiles() const;
+		int32_t GetMaxTiles() const { return MaxTiles; }
+		int32_t GetNumHits() const { return NumHits.load(); }
+		int32_t GetNumMisses() const { return NumMisses.load(); }
+		std::string GetStatsString() const;
+
+	private:
+		struct CachedTile
+		{
+			TilePtr Tile;
+			uint64_t LastUsed = 0;
+		};
+
+		TilePtr BuildTile(int32_t ChunkX, int32_t ChunkY) const;
+
+		const BiomeMap& Biomes;
+		int32_t MaxTiles;
+
+		mutable std::mutex Lock;
+		mutable std::unordered_map<uint64_t, CachedTile> Tiles;
+		mutable uint64_t UseCounter = 0;
+
+		mutable std::atomic<int32_t> NumHits;
+		mutable std::atomic<int32_t> NumMisses;
+	};
+}
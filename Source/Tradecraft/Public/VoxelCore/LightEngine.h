@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <vector>
+
+namespace VoxelCore
+{
+	// Sky light in the high nibble, block light in the low one.
+	typedef uint8_t LightValue;
+
+	const int32_t MaxLight = 15;
+
+	inline int32_t GetSkyLight(LightValue Light) { return Light >> 4; }
+	inline int32_t GetBlockLight(LightValue Light) { return Light & 15; }
+	inline LightValue MakeLight(int32_t Sky, int32_t Block) { return (LightValue)((Sky << 4) | Block); }
+
+	// How much light each block id stops and gives off. Light loses max(1, Opacity) per block
+	// it passes into, so MaxLight is fully opaque; sky light at full strength goes straight down
+	// through fully transparent blocks.
+	struct LightProperties
+	{
+		static const int32_t NumIds = 256;
+
+		uint8_t Opacity[NumIds];
+		uint8_t Emission[NumIds];
+
+		// Air is transparent, leaves let light through at a cost, everything else is opaque.
+		LightProperties();
+
+		int32_t GetOpacity(BlockId Id) const { return Id >= 0 && Id < NumIds ? Opacity[Id] : MaxLight; }
+		int32_t GetEmission(BlockId Id) const { return Id >= 0 && Id < NumIds ? Emission[Id] : 0; }
+	};
+
+	// Blocks and light across chunks, for updates that cross chunk borders. X and Y are world
+	// block coordinates, Z the height inside the chunk.
+	class LightAccess
+	{
+	public:
+		virtual ~LightAccess() {}
+
+		virtual bool IsLoaded(int32_t X, int32_t Y, int32_t Z) const = 0;
+		virtual BlockId GetBlock(int32_t X, int32_t Y, int32_t Z) const = 0;
+		virtual LightValue GetLight(int32_t X, int32_t Y, int32_t Z) const = 0;
+		virtual void SetLight(int32_t X, int32_t Y, int32_t Z, LightValue Light) = 0;
+	};
+
+	/**
+	 * Queue based flood fill of sky and block light. ComputeChunk lights a freshly generated or
+	 * loaded chunk on its own; the incremental updates then only visit the cells whose light
+	 * depends on what changed, with a removal pass that darkens everything the old light reached
+	 * followed by a pass that floods back in from the light still around it.
+	 */
+	class LightEngine
+	{
+	public:
+		explicit LightEngine(const LightProperties& InProperties) : Properties(InProperties) {}
+
+		// Lights a chunk's extended layout from its own blocks only: the border gets the light
+		// this chunk's blocks give it, and neighbours are stitched in afterwards with AddSeed.
+		// OutLight holds Layout.NumBlocks() values.
+		void ComputeChunk(ConstBlockIdView ChunkData, const ChunkLayout& Layout, LightValue* OutLight);
+
+		// Relights around a block whose id has already changed.
+		void OnBlockChanged(LightAccess& Access, int32_t X, int32_t Y, int32_t Z);
+
+		// Queues a lit cell to spread its light from on the next Propagate, e.g. along the border
+		// of a chunk that has just loaded.
+		void AddSeed(int32_t X, int32_t Y, int32_t Z);
+		void Propagate(LightAccess& Access);
+
+		// Cells the last update visited, a measure of its cost.
+		int32_t GetLastNumVisited() const { return LastNumVisited; }
+
+	private:
+		struct Node
+		{
+			int32_t X, Y, Z;
+			int32_t Light;
+		};
+
+		template <typename AccessType>
+		void RunAdd(AccessType& Access, int32_t Channel);
+
+		template <typename AccessType>
+		void RunRemove(AccessType& Access, int32_t Channel);
+
+		const LightProperties& Properties;
+
+		// Sky and block light are flooded separately.
+		std::vector<Node> AddQueue[2];
+		std::vector<Node> RemoveQueue[2];
+
+		int32_t LastNumVisited = 0;
+	};
+}
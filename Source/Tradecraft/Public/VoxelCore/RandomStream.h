@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <cstring>
+
+namespace VoxelCore
+{
+	// The engine's FRandomStream, reproduced exactly so generation gives the same worlds in and
+	// out of the engine.
+	class RandomStream
+	{
+	public:
+		explicit RandomStream(int32_t InSeed = 0) : Seed((uint32_t)InSeed) {}
+
+		void Initialize(int32_t InSeed) { Seed = (uint32_t)InSeed; }
+
+		// [0, 1), built from the low mantissa bits of the state.
+		float GetFraction()
+		{
+			Mutate();
+			const uint32_t Bits = 0x3F800000u | (Seed & 0x007FFFFFu);
+			float Result;
+			std::memcpy(&Result, &Bits, sizeof(Result));
+			return Result - 1.0f;
+		}
+
+		float FRand() { return GetFraction(); }
+
+		int32_t RandHelper(int32_t A) { return A > 0 ? (int32_t)(GetFraction() * (float)A) : 0; }
+
+		int32_t RandRange(int32_t Min, int32_t Max) { return Min + RandHelper((Max - Min) + 1); }
+
+		float FRandRange(float Min, float Max) { return Min + (Max - Min) * FRand(); }
+
+	private:
+		void Mutate() { Seed = Seed * 196314165u + 907633515u; }
+
+		uint32_t Seed;
+	};
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+
+namespace VoxelCore
+{
+	// The run-length pre-pass of the chunk codec: each run is a zigzag varint id followed by a
+	// varint length. Chunk data is laid out with z innermost, so runs follow the vertical columns.
+	namespace RunLength
+	{
+		template <typename PutByteType>
+		inline void WriteVarUInt(PutByteType& PutByte, uint32_t Value)
+		{
+			while (Value >= 0x80)
+			{
+				PutByte((uint8_t)(Value | 0x80));
+				Value >>= 7;
+			}
+			PutByte((uint8_t)Value);
+		}
+
+		inline bool ReadVarUInt(const uint8_t*& Cursor, const uint8_t* End, uint32_t& OutValue)
+		{
+			OutValue = 0;
+			for (int32_t Shift = 0; Shift < 35 && Cursor < End; Shift += 7)
+			{
+				const uint8_t Byte = *Cursor++;
+				OutValue |= (uint32_t)(Byte & 0x7F) << Shift;
+				if (!(Byte & 0x80))
+					return true;
+			}
+			return false;
+		}
+
+		// Ids are written zigzag encoded so a stray negative id doesn't cost five bytes.
+		inline uint32_t ZigZag(int32_t Value)
+		{
+			return ((uint32_t)Value << 1) ^ (uint32_t)(Value >> 31);
+		}
+
+		inline int32_t UnZigZag(uint32_t Value)
+		{
+			return (int32_t)(Value >> 1) ^ -(int32_t)(Value & 1);
+		}
+
+		// GetId(Index) reads the value at Index; PutByte(Byte) appends to the output.
+		template <typename GetIdType, typename PutByteType>
+		inline void Encode(int32_t Num, GetIdType GetId, PutByteType PutByte)
+		{
+			int32_t i = 0;
+			while (i < Num)
+			{
+				const int32_t Id = GetId(i);
+				int32_t Run = 1;
+				while (i + Run < Num && GetId(i + Run) == Id)
+					Run++;
+
+				WriteVarUInt(PutByte, ZigZag(Id));
+				WriteVarUInt(PutByte, (uint32_t)Run);
+				i += Run;
+			}
+		}
+
+		// SetRun(Offset, Count, Value) receives each run. Fails on truncated data or a stream that
+		// doesn't decode to exactly NumValues values.
+		template <typename SetRunType>
+		inline bool Decode(const uint8_t* Data, int32_t Size, int32_t NumValues, SetRunType SetRun)
+		{
+			const uint8_t* Cursor = Data;
+			const uint8_t* End = Data + Size;
+			int32_t Written = 0;
+
+			while (Cursor < End)
+			{
+				uint32_t Id, Run;
+				if (!ReadVarUInt(Cursor, End, Id) || !ReadVarUInt(Cursor, End, Run))
+					return false;
+				if (Run > (uint32_t)(NumValues - Written))
+					return false;
+
+				SetRun(Written, (int32_t)Run, UnZigZag(Id));
+				Written += Run;
+			}
+			return Written == NumValues;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+
+namespace VoxelCore
+{
+	enum class NoiseISA : uint8_t
+	{
+		Scalar = 0,
+		SSE2 = 1,
+		AVX2 = 2
+	};
+
+	/**
+	 * Simplex noise over one global permutation table. The scalar functions are the reference;
+	 * the batched ones evaluate 4 (SSE2) or 8 (AVX2) points per step with the same operations in
+	 * the same order, so they give bit-identical results. Everything except SetSeed only reads
+	 * the table and is safe from any thread.
+	 */
+	class SimplexNoise
+	{
+	public:
+		// Shuffles the table with the C runtime's srand/rand, so a seed gives the same table as the
+		// engine's FMath::RandInit/RandRange on the same platform, but not across platforms.
+		static void SetSeed(int32_t Seed);
+
+		// 512 entries plus zeroed padding, so vector gathers may read 4 bytes at any entry.
+		static const unsigned char* GetPermutationTable();
+
+		static float Noise2D(float X, float Y);
+		static float Noise3D(float X, float Y, float Z);
+
+		// Batched, with the widest instruction set allowed by SetMaxISA that the CPU supports.
+		static void Noise2D(const float* X, const float* Y, float* Out, int32_t Count);
+		static void Noise3D(const float* X, const float* Y, const float* Z, float* Out, int32_t Count);
+
+		// Runs one specific path, for comparisons and benchmarks. Falls back to scalar if the CPU lacks it.
+		static void Noise2D(NoiseISA ISA, const float* X, const float* Y, float* Out, int32_t Count);
+		static void Noise3D(NoiseISA ISA, const float* X, const float* Y, const float* Z, float* Out, int32_t Count);
+
+		static bool IsSupported(NoiseISA ISA);
+		static void SetMaxISA(NoiseISA ISA);
+		static NoiseISA GetActiveISA();
+		static const char* GetISAName(NoiseISA ISA);
+		static int32_t GetWidth(NoiseISA ISA);
+	};
+}
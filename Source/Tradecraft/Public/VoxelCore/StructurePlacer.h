@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <vector>
+
+namespace VoxelCore
+{
+	// One block of a structure, relative to the block the structure is rooted on.
+	struct StructureBlock
+	{
+		int8_t X;
+		int8_t Y;
+		int16_t Z;
+		uint8_t Id;
+
+		// Overwrites whatever is there; otherwise the block only fills air.
+		bool bReplace;
+	};
+
+	struct StructureShape
+	{
+		std::vector<StructureBlock> Blocks;
+	};
+
+	// A place a structure may go, before the terrain has been asked whether it fits.
+	struct StructureCandidate
+	{
+		int32_t X;
+		int32_t Y;
+
+		// Uniform in [0, 1), compared against the column's density to decide if it is placed.
+		float Roll;
+
+		int32_t Shape;
+	};
+
+	/**
+	 * Decides where structures go independently of chunk boundaries. Every RegionSize square of
+	 * blocks gets its own random stream from a hash of the world seed and the region coordinates,
+	 * which puts one candidate somewhere in each CandidateCellSize cell. Any chunk can therefore
+	 * work out every structure that reaches into it and stamp just the overlapping blocks, without
+	 * its neighbours being generated.
+	 */
+	class StructurePlacer
+	{
+	public:
+		static const int32_t RegionSize = 32;
+		static const int32_t CandidateCellSize = 4;
+		static const int32_t CandidateArea = CandidateCellSize * CandidateCellSize;
+
+		// No shape extends further than this from its root column.
+		static const int32_t MaxShapeRadius = 3;
+
+		// Candidates whose root column is inside [MinX, MaxX] x [MinY, MaxY], in region order.
+		static void GatherCandidates(int32_t Seed, int32_t MinX, int32_t MinY, int32_t MaxX, int32_t MaxY, std::vector<StructureCandidate>& OutCandidates);
+
+		static const StructureShape& GetShape(int32_t Index);
+		static int32_t GetNumShapes();
+
+		// Writes the blocks of Shape rooted at world block RootX/RootY/RootZ that fall inside the
+		// extended chunk whose index 0 is at world block BaseX/BaseY.
+		static void Stamp(const StructureShape& Shape, int32_t RootX, int32_t RootY, int32_t RootZ, int32_t BaseX, int32_t BaseY, const ChunkLayout& Layout, BlockIdView ChunkData);
+
+		static uint32_t HashRegion(int32_t Seed, int32_t RegionX, int32_t RegionY);
+	};
+}
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VoxelCore/VoxelTypes.h"
+#include <unordered_map>
+#include <vector>
+
+namespace VoxelCore
+{
+	// A cell an agent two blocks tall can stand in: X and Y are world block coordinates, Z the
+	// height inside the chunk of the block its feet are in.
+	struct PathCell
+	{
+		int32_t X, Y, Z;
+
+		bool operator==(const PathCell& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+		bool operator!=(const PathCell& Other) const { return !(*this == Other); }
+	};
+
+	// How agents treat each block id. Open blocks can be walked through, Solid ones stood on,
+	// Blocked ones neither, e.g. lava.
+	struct PathProperties
+	{
+		static const int32_t NumIds = 256;
+
+		enum Kind : uint8_t
+		{
+			Open,
+			Solid,
+			Blocked
+		};
+
+		uint8_t Kinds[NumIds];
+
+		// Agents step up one block and drop down at most this many.
+		int32_t MaxDrop = 3;
+
+		// Air is open, everything else solid.
+		PathProperties();
+
+		Kind GetKind(BlockId Id) const { return Id >= 0 && Id < NumIds ? (Kind)Kinds[Id] : Solid; }
+	};
+
+	// The loaded chunks' blocks, in their extended layout, border included.
+	class PathAccess
+	{
+	public:
+		virtual ~PathAccess() {}
+
+		virtual bool GetChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView& OutBlocks) const = 0;
+	};
+
+	/**
+	 * Hierarchical (HPA*) pathfinding over the block world. Each chunk is a cluster: every run of
+	 * walkable cells along a chunk border gets one portal on either side, and the portals inside a
+	 * chunk are joined by edges costing the length of the shortest path between them in that chunk.
+	 * A query searches that graph from the start to the goal chunk, then refines each step with a
+	 * search bounded to a single chunk. An edit only rebuilds the portals on the borders it touches
+	 * and the edges of the chunks on either side of them.
+	 *
+	 * Moves go to one of the four horizontal neighbours, stepping up one block or dropping down at
+	 * most MaxDrop, and cost 1 each. Not thread safe: queries share scratch buffers.
+	 */
+	class VoxelPathfinder
+	{
+	public:
+		// Properties are read as queries and updates run, so set them before adding chunks.
+		VoxelPathfinder(const PathProperties& InProperties, const ChunkLayout& InLayout);
+
+		// For a chunk that has just been loaded, and the portals it shares with loaded neighbours.
+		void AddChunk(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY);
+		void RemoveChunk(int32_t ChunkX, int32_t ChunkY);
+
+		// After a block, and the border copies of it, changed.
+		void OnBlockChanged(const PathAccess& Access, int32_t X, int32_t Y, int32_t Z);
+
+		bool IsWalkable(const PathAccess& Access, const PathCell& Cell) const;
+
+		// Every cell from Start to Goal, both included. Paths within one chunk are optimal; longer
+		// ones go through portals and usually come out a few percent longer.
+		bool FindPath(const PathAccess& Access, const PathCell& Start, const PathCell& Goal, std::vector<PathCell>& OutPath);
+
+		int32_t GetNumNodes() const { return (int32_t)(Nodes.size() - FreeNodes.size()); }
+		int32_t GetNumEdges() const;
+		int32_t GetNumChunks() const { return (int32_t)Chunks.size(); }
+
+		// Graph nodes and chunk cells the last FindPath expanded, a measure of its cost.
+		int32_t GetLastNumExpanded() const { return LastNumExpanded; }
+
+	private:
+		struct Edge
+		{
+			int32_t To;
+			int32_t Cost;
+		};
+
+		struct Node
+		{
+			PathCell Cell;
+			int32_t ChunkX, ChunkY;
+			std::vector<Edge> Edges;
+			bool bUsed;
+		};
+
+		// Cells with costs, from a search bounded to one chunk.
+		struct LocalCost
+		{
+			int32_t Node;
+			int32_t Cost;
+		};
+
+		static uint64_t MakeKey(int32_t X, int32_t Y) { return ((uint64_t)(uint32_t)X << 32) | (uint32_t)Y; }
+
+		PathProperties::Kind GetKind(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z) const;
+
+		// In the chunk's extended coordinates.
+		bool IsWalkableLocal(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z) const;
+
+		// Height the move from a walkable cell into the next column ends at, or IndexNone.
+		int32_t FindMove(ConstBlockIdView Blocks, int32_t x, int32_t y, int32_t z, int32_t ToX, int32_t ToY) const;
+
+		int32_t AllocateNode(const PathCell& Cell, int32_t ChunkX, int32_t ChunkY);
+
+		// The portals on the border between a chunk and the next one along +X (Axis 0) or +Y.
+		void BuildBorder(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY, int32_t Axis);
+		void ClearBorder(int32_t ChunkX, int32_t ChunkY, int32_t Axis);
+		void BuildChunkEdges(const PathAccess& Access, int32_t ChunkX, int32_t ChunkY);
+
+		// Drops edges to nodes that were freed.
+		void RemoveDeadEdges(int32_t ChunkX, int32_t ChunkY);
+
+		// Breadth first from a cell through one chunk, forwards or against the moves, to the given nodes.
+		void SearchChunk(ConstBlockIdView Blocks, int32_t ChunkX, int32_t ChunkY, const PathCell& From, bool bReverse, const std::vector<int32_t>& Targets, std::vector<LocalCost>& OutCosts);
+
+		// A* from Start to Goal inside one chunk; appends the cells after Start.
+		bool FindLocalPath(ConstBlockIdView Blocks, int32_t ChunkX, int32_t ChunkY, const PathCell& Start, const PathCell& Goal, std::vector<PathCell>& OutPath);
+
+		int32_t LocalIndex(int32_t ChunkX, int32_t ChunkY, const PathCell& Cell) const;
+		PathCell LocalCell(int32_t ChunkX, int32_t ChunkY, int32_t Index) const;
+
+		// Starts a search over the chunk scratch buffers.
+		void ResetLocal();
+
+		const PathProperties& Properties;
+		ChunkLayout Layout;
+
+		std::vector<Node> Nodes;
+		std::vector<int32_t> FreeNodes;
+
+		// Nodes by chunk, and by the border they are on, keyed by the lower chunk's coordinates.
+		std::unordered_map<uint64_t, std::vector<int32_t>> Chunks;
+		std::unordered_map<uint64_t, std::vector<int32_t>> Borders[2];
+
+		// Per chunk cell, valid where Stamps matches Stamp.
+		std::vector<int32_t> LocalCosts;
+		std::vector<int32_t> LocalParents;
+		std::vector<uint32_t> LocalStamps;
+		uint32_t LocalStamp = 0;
+		std::vector<int32_t> LocalQueue;
+
+		// Per graph node, the same way.
+		std::vector<int32_t> NodeCosts;
+		std::vector<int32_t> NodeParents;
+		std::vector<uint32_t> NodeStamps;
+		uint32_t NodeStamp = 0;
+
+		int32_t LastNumExpanded = 0;
+	};
+}
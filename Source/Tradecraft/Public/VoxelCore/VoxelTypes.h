@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Plain C++ core of the voxel world: no engine headers anywhere under VoxelCore, so it builds
+// both inside the game module and on its own (Tools/VoxelCore).
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace VoxelCore
+{
+	typedef int32_t BlockId;
+
+	const int32_t IndexNone = -1;
+
+	namespace Blocks
+	{
+		const BlockId Air = 0;
+		const BlockId Grass = 1;
+		const BlockId Dirt = 2;
+		const BlockId Stone = 3;
+		const BlockId Trunk = 4;
+		const BlockId Leaves = 5;
+		const BlockId Cobblestone = 6;
+		const BlockId Planks = 7;
+	}
+
+	inline int32_t FloorDiv(int32_t Value, int32_t Divisor)
+	{
+		return Value >= 0 ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+	}
+
+	inline int32_t FloorToInt(float Value)
+	{
+		return (int32_t)std::floor(Value);
+	}
+
+	template <typename T>
+	inline T Lerp(const T& A, const T& B, float Alpha)
+	{
+		return (T)(A + Alpha * (B - A));
+	}
+
+	// Same argument order as the engine's BiLerp: the two x neighbours first, then the next row.
+	inline float BiLerp(float P00, float P10, float P01, float P11, float FracX, float FracY)
+	{
+		return Lerp(Lerp(P00, P10, FracX), Lerp(P01, P11, FracX), FracY);
+	}
+
+	template <typename T>
+	inline T Clamp(const T& Value, const T& Min, const T& Max)
+	{
+		return Value < Min ? Min : Value < Max ? Value : Max;
+	}
+
+	// A chunk's blocks plus the one block border shared with its neighbours, z innermost:
+	// index = z + (y * Height) + (x * WidthExt * Height), where x and y include the border.
+	struct ChunkLayout
+	{
+		int32_t Width;
+		int32_t Height;
+		int32_t WidthExt;
+
+		ChunkLayout(int32_t InWidth = 16, int32_t InHeight = 128)
+			: Width(InWidth)
+			, Height(InHeight)
+			, WidthExt(InWidth + 2)
+		{
+		}
+
+		int32_t Index(int32_t x, int32_t y, int32_t z) const { return z + (y * Height) + (x * WidthExt * Height); }
+		int32_t ColumnIndex(int32_t x, int32_t y) const { return y + (x * WidthExt); }
+		int32_t NumBlocks() const { return WidthExt * WidthExt * Height; }
+		int32_t NumColumns() const { return WidthExt * WidthExt; }
+	};
+
+	// Block ids stored every Stride ints, so the core can work in place on the game's
+	// per-block structs as well as on a plain id array.
+	struct BlockIdView
+	{
+		BlockId* Data = nullptr;
+		int32_t Stride = 1;
+		int32_t Num = 0;
+
+		BlockIdView() {}
+		BlockIdView(BlockId* InData, int32_t InNum, int32_t InStride = 1) : Data(InData), Stride(InStride), Num(InNum) {}
+
+		BlockId& operator[](int32_t Index) const { return Data[Index * Stride]; }
+		bool IsValidIndex(int32_t Index) const { return Index >= 0 && Index < Num; }
+	};
+
+	struct ConstBlockIdView
+	{
+		const BlockId* Data = nullptr;
+		int32_t Stride = 1;
+		int32_t Num = 0;
+
+		ConstBlockIdView() {}
+		ConstBlockIdView(const BlockId* InData, int32_t InNum, int32_t InStride = 1) : Data(InData), Stride(InStride), Num(InNum) {}
+		ConstBlockIdView(const BlockIdView& View) : Data(View.Data), Stride(View.Stride), Num(View.Num) {}
+
+		BlockId operator[](int32_t Index) const { return Data[Index * Stride]; }
+		bool IsValidIndex(int32_t Index) const { return Index >= 0 && Index < Num; }
+	};
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelCore/LightEngine.h"
+
+class AChunk;
+
+/**
+ * Keeps the loaded chunks' light up to date across chunk borders. Each chunk lights itself when
+ * it is built; StitchChunk then floods light across its seams, and OnBlockChanged relights only
+ * the cells that depend on an edited block. Chunks whose light changed are handed to the
+ * OnChunkChanged callback to be remeshed.
+ */
+class TRADECRAFT_API FWorldLighting : public VoxelCore::LightAccess
+{
+public:
+	FWorldLighting();
+
+	void Initialize(int32 InWidthOfChunk, int32 InHeightOfChunk, const TMap<FIntPoint, AChunk*>* InChunks, TFunction<void(AChunk*)> InOnChunkChanged);
+
+	// Set what blocks let through and emit before any chunk is lit.
+	VoxelCore::LightProperties& GetProperties() { return Properties; }
+	const VoxelCore::LightProperties& GetProperties() const { return Properties; }
+
+	// For a chunk that has just been lit and added to the world.
+	void StitchChunk(int32 ChunkX, int32 ChunkY);
+
+	// World block coordinates, after the block's id has changed.
+	void OnBlockChanged(const FIntVector& Block);
+
+	// VoxelCore::LightAccess
+	virtual bool IsLoaded(int32_t X, int32_t Y, int32_t Z) const override;
+	virtual VoxelCore::BlockId GetBlock(int32_t X, int32_t Y, int32_t Z) const override;
+	virtual VoxelCore::LightValue GetLight(int32_t X, int32_t Y, int32_t Z) const override;
+	virtual void SetLight(int32_t X, int32_t Y, int32_t Z, VoxelCore::LightValue Light) override;
+
+	int64 GetNumCellsVisited() const { return NumCellsVisited; }
+
+private:
+	// The lit chunk holding a world block, and the block's index in it.
+	AChunk* FindChunk(int32 X, int32 Y, int32 Z, int32& OutIndex) const;
+
+	void SetLightInChunk(int32 ChunkX, int32 ChunkY, int32 x, int32 y, int32 z, VoxelCore::LightValue Light);
+
+	VoxelCore::LightProperties Properties;
+	VoxelCore::LightEngine Engine;
+
+	int32 WidthOfChunk = 16;
+	int32 HeightOfChunk = 128;
+
+	const TMap<FIntPoint, AChunk*>* Chunks = nullptr;
+	TFunction<void(AChunk*)> OnChunkChanged;
+
+	int64 NumCellsVisited = 0;
+};
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelCore/VoxelPathfinder.h"
+
+class AChunk;
+
+/**
+ * Paths over the loaded chunks for AI, from VoxelCore::VoxelPathfinder's chunk portal graph,
+ * which follows block edits without the engine navmesh having to be rebuilt. Positions are in
+ * world space; a path's points are on the floor of each block along it.
+ */
+class TRADECRAFT_API FWorldNavigation : public VoxelCore::PathAccess
+{
+public:
+	void Initialize(int32 InWidthOfChunk, int32 InHeightOfChunk, const TMap<FIntPoint, AChunk*>* InChunks);
+
+	bool IsInitialized() const { return Pathfinder.IsValid(); }
+
+	// Set what agents can walk through and stand on before Initialize.
+	VoxelCore::PathProperties& GetProperties() { return Properties; }
+
+	// Queued: the chunk joins the graph, and edits are applied to it, in Update.
+	void AddChunk(int32 ChunkX, int32 ChunkY);
+	void RemoveChunk(int32 ChunkX, int32 ChunkY);
+
+	// World block coordinates, after the block and its border copies changed. Marks the part of
+	// the graph around it for the next Update; edits to the same chunk side share one rebuild.
+	void MarkBlockChanged(const FIntVector& Block);
+
+	// Rebuilds the graph around Block right away.
+	void OnBlockChanged(const FIntVector& Block);
+
+	// Adds queued chunks and rebuilds around changed blocks until BudgetSeconds have been used,
+	// at least one of each so the queue always drains.
+	void Update(double BudgetSeconds);
+
+	int32 GetNumPendingUpdates() const { return PendingChunks.Num() + DirtyBlocks.Num(); }
+
+	// Start is where an agent's feet are; it and Goal snap to the nearest cell to stand in below
+	// or just above them.
+	bool FindPath(const FVector& Start, const FVector& Goal, TArray<FVector>& OutPoints);
+	bool FindPath(const FIntVector& Start, const FIntVector& Goal, TArray<FIntVector>& OutCells);
+
+	bool FindStandingCell(const FVector& Position, FIntVector& OutCell) const;
+
+	// Times OnBlockChanged and FindPath between random cells within Radius chunks of Center.
+	// Updates rebuild the graph around unchanged blocks, so nothing in the world is edited.
+	FString RunBenchmark(const FIntPoint& Center, int32 Radius, int32 NumQueries, int32 NumUpdates);
+
+	FString GetStatsString() const;
+
+	// VoxelCore::PathAccess
+	virtual bool GetChunk(int32_t ChunkX, int32_t ChunkY, VoxelCore::ConstBlockIdView& OutBlocks) const override;
+
+private:
+	FVector GetCellFloor(const FIntVector& Cell) const;
+
+	void RebuildAround(const FIntVector& Block);
+
+	VoxelCore::PathProperties Properties;
+	TUniquePtr<VoxelCore::VoxelPathfinder> Pathfinder;
+
+	int32 WidthOfChunk = 16;
+	int32 HeightOfChunk = 128;
+
+	const TMap<FIntPoint, AChunk*>* Chunks = nullptr;
+
+	TArray<FIntPoint> PendingChunks;
+
+	// One block per chunk side, or corner, or the middle, that changed since the last Update.
+	TSet<FIntVector> DirtyBlocks;
+
+	int64 NumQueries = 0;
+	int64 NumPathsFound = 0;
+	int64 NumNodesExpanded = 0;
+	int64 NumUpdates = 0;
+	double UpdateSeconds = 0.0;
+};
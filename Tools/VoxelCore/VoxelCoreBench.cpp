@@ -0,0 +1,338 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Times the voxel core stages outside the engine: batched noise per instruction set, chunk
+// generation per terrain version, meshing, the run-length pre-pass and pathfinding.
+//
+//   VoxelCoreBench [-seed N] [-size Chunks] [-version N] [-points NoisePoints] [-paths Queries]
+//
+// With -golden it only prints the hashes -run=GenerationBenchmark checks, in the format of
+// Config/GenerationGolden.txt, for that commandlet's default seeds and size.
+//
+//   VoxelCoreBench -golden <Platform>
+
+#include "VoxelCore/ChunkGenerator.h"
+#include "VoxelCore/ChunkMesher.h"
+#include "VoxelCore/HeightTileCache.h"
+#include "VoxelCore/RunLength.h"
+#include "VoxelCore/SimplexNoise.h"
+#include "VoxelCore/VoxelPathfinder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace VoxelCore;
+
+static double GetSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void BenchmarkNoise(int32_t NumPoints)
+{
+	RandomStream Random(1234);
+	std::vector<float> X(NumPoints), Y(NumPoints), Z(NumPoints), Out(NumPoints);
+	for (int32_t i = 0; i < NumPoints; i++)
+	{
+		X[i] = Random.FRandRange(-300.0f, 300.0f);
+		Y[i] = Random.FRandRange(-300.0f, 300.0f);
+		Z[i] = Random.FRandRange(-2.0f, 2.0f);
+	}
+
+	for (NoiseISA ISA : { NoiseISA::Scalar, NoiseISA::SSE2, NoiseISA::AVX2 })
+	{
+		if (!SimplexNoise::IsSupported(ISA))
+			continue;
+
+		double Start = GetSeconds();
+		SimplexNoise::Noise2D(ISA, X.data(), Y.data(), Out.data(), NumPoints);
+		const double Seconds2D = GetSeconds() - Start;
+
+		Start = GetSeconds();
+		SimplexNoise::Noise3D(ISA, X.data(), Y.data(), Z.data(), Out.data(), NumPoints);
+		const double Seconds3D = GetSeconds() - Start;
+
+		printf("noise %-6s 2D %7.1f Mpoints/s, 3D %7.1f Mpoints/s\n", SimplexNoise::GetISAName(ISA),
+			NumPoints / Seconds2D / 1e6, NumPoints / Seconds3D / 1e6);
+	}
+}
+
+static void BenchmarkGeneration(int32_t Seed, int32_t Version, int32_t Size)
+{
+	ChunkGenerator::PrepareNoise(Seed);
+	BiomeMap Map(Seed);
+	HeightTileCache Tiles(Map);
+	ChunkGenerator Generator(Seed);
+	Generator.TerrainVersion = Version;
+	Generator.Biomes = &Map;
+	Generator.HeightTiles = &Tiles;
+
+	ChunkGenerationTimings Timings;
+	double MeshSeconds = 0.0;
+	double EncodeSeconds = 0.0;
+	size_t NumTriangles = 0;
+	size_t EncodedBytes = 0;
+
+	// The same square straddling the origin as the engine's GenerationBenchmark commandlet.
+	std::vector<BlockId> ChunkData;
+	std::vector<MeshSection> Sections;
+	std::vector<uint8_t> Stream;
+	for (int32_t x = -Size / 2; x < Size - Size / 2; x++)
+	{
+		for (int32_t y = -Size / 2; y < Size - Size / 2; y++)
+		{
+			Generator.Generate(x, y, ChunkData, &Timings);
+
+			double Start = GetSeconds();
+			ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Generator.WidthOfChunk, Generator.HeightOfChunk, 8, Sections);
+			MeshSeconds += GetSeconds() - Start;
+			for (const MeshSection& Section : Sections)
+				NumTriangles += Section.Triangles.size() / 3;
+
+			Start = GetSeconds();
+			Stream.clear();
+			RunLength::Encode((int32_t)ChunkData.size(), [&](int32_t i) { return ChunkData[i]; }, [&](uint8_t Byte) { Stream.push_back(Byte); });
+			EncodeSeconds += GetSeconds() - Start;
+			EncodedBytes += Stream.size();
+		}
+	}
+
+	const int32_t NumChunks = Timings.NumChunks;
+	const double TotalSeconds = Timings.NoiseSeconds + Timings.FillSeconds + Timings.TreeSeconds + MeshSeconds;
+	printf("seed %d version %d: %d chunks, %.1f chunks/s, per chunk noise %.3fms fill %.3fms trees %.3fms mesh %.3fms rle %.3fms, %zu triangles, %.1f RLE bytes/chunk\n",
+		Seed, Version, NumChunks, NumChunks / TotalSeconds,
+		1000.0 * Timings.NoiseSeconds / NumChunks, 1000.0 * Timings.FillSeconds / NumChunks, 1000.0 * Timings.TreeSeconds / NumChunks,
+		1000.0 * MeshSeconds / NumChunks, 1000.0 * EncodeSeconds / NumChunks, NumTriangles, (double)EncodedBytes / NumChunks);
+	printf("  %s\n", Tiles.GetStatsString().c_str());
+}
+
+// zlib's CRC-32, which is what FCrc::MemCrc32 computes.
+static uint32_t Crc32(const void* Data, size_t Size, uint32_t Crc)
+{
+	static uint32_t Table[256];
+	if (!Table[1])
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t Value = i;
+			for (int32_t Bit = 0; Bit < 8; Bit++)
+				Value = (Value & 1) ? 0xEDB88320u ^ (Value >> 1) : Value >> 1;
+			Table[i] = Value;
+		}
+	}
+
+	Crc = ~Crc;
+	const uint8_t* Bytes = (const uint8_t*)Data;
+	for (size_t i = 0; i < Size; i++)
+		Crc = Table[(Crc ^ Bytes[i]) & 0xFF] ^ (Crc >> 8);
+	return ~Crc;
+}
+
+// The same chunks, block bytes and mesh arrays, in the same order, as the GenerationBenchmark
+// commandlet hashes.
+static void PrintGoldenHashes(const char* Platform)
+{
+	const int32_t Size = 8;
+	const int32_t NumSections = 8;
+	for (int32_t Seed : { 1, 1337, 424242 })
+	{
+		for (int32_t Version = 0; Version <= ChunkGenerator::CurrentTerrainVersion; Version++)
+		{
+			ChunkGenerator::PrepareNoise(Seed);
+			BiomeMap Map(Seed);
+			HeightTileCache Tiles(Map);
+			ChunkGenerator Generator(Seed);
+			Generator.TerrainVersion = Version;
+			Generator.Biomes = &Map;
+			Generator.HeightTiles = &Tiles;
+
+			uint32_t BlockHash = 0;
+			uint32_t MeshHash = 0;
+			std::vector<BlockId> ChunkData;
+			std::vector<uint8_t> BlockBytes;
+			std::vector<MeshSection> Sections;
+			for (int32_t x = -Size / 2; x < Size - Size / 2; x++)
+			{
+				for (int32_t y = -Size / 2; y < Size - Size / 2; y++)
+				{
+					Generator.Generate(x, y, ChunkData);
+					BlockBytes.assign(ChunkData.begin(), ChunkData.end());
+					BlockHash = Crc32(BlockBytes.data(), BlockBytes.size(), BlockHash);
+
+					ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Generator.WidthOfChunk, Generator.HeightOfChunk, NumSections, Sections);
+					for (const MeshSection& Section : Sections)
+					{
+						MeshHash = Crc32(Section.Vertices.data(), Section.Vertices.size() * sizeof(Vec3), MeshHash);
+						MeshHash = Crc32(Section.Triangles.data(), Section.Triangles.size() * sizeof(int32_t), MeshHash);
+						MeshHash = Crc32(Section.UVs.data(), Section.UVs.size() * sizeof(Vec2), MeshHash);
+					}
+				}
+			}
+			printf("%s %d %d %d %08x %08x\n", Platform, Seed, Version, Size, BlockHash, MeshHash);
+		}
+	}
+}
+
+// Generated chunks in a square from the origin, with edits copied into the neighbours' borders.
+struct BenchPathAccess : PathAccess
+{
+	ChunkLayout Layout;
+	int32_t Size;
+	std::vector<std::vector<BlockId>> Chunks;
+
+	explicit BenchPathAccess(int32_t InSize) : Size(InSize), Chunks(InSize * InSize) {}
+
+	bool GetChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView& OutBlocks) const override
+	{
+		if (ChunkX < 0 || ChunkY < 0 || ChunkX >= Size || ChunkY >= Size)
+			return false;
+		const std::vector<BlockId>& Data = Chunks[ChunkX + ChunkY * Size];
+		OutBlocks = ConstBlockIdView(Data.data(), (int32_t)Data.size());
+		return true;
+	}
+
+	void SetBlock(int32_t X, int32_t Y, int32_t Z, BlockId Id)
+	{
+		const int32_t ChunkX = FloorDiv(X, Layout.Width);
+		const int32_t ChunkY = FloorDiv(Y, Layout.Width);
+		for (int32_t NeighbourX = ChunkX - 1; NeighbourX <= ChunkX + 1; NeighbourX++)
+		{
+			for (int32_t NeighbourY = ChunkY - 1; NeighbourY <= ChunkY + 1; NeighbourY++)
+			{
+				const int32_t x = X - NeighbourX * Layout.Width + 1;
+				const int32_t y = Y - NeighbourY * Layout.Width + 1;
+				if (NeighbourX >= 0 && NeighbourY >= 0 && NeighbourX < Size && NeighbourY < Size && x >= 0 && y >= 0 && x < Layout.WidthExt && y < Layout.WidthExt)
+					Chunks[NeighbourX + NeighbourY * Size][Layout.Index(x, y, Z)] = Id;
+			}
+		}
+	}
+};
+
+static void BenchmarkPathfinding(int32_t Seed, int32_t Size, int32_t NumQueries)
+{
+	ChunkGenerator::PrepareNoise(Seed);
+	ChunkGenerator Generator(Seed);
+	BenchPathAccess Access(Size);
+	for (int32_t ChunkX = 0; ChunkX < Size; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < Size; ChunkY++)
+			Generator.Generate(ChunkX, ChunkY, Access.Chunks[ChunkX + ChunkY * Size]);
+
+	const PathProperties Properties;
+	VoxelPathfinder Pathfinder(Properties, Access.Layout);
+	double Start = GetSeconds();
+	for (int32_t ChunkX = 0; ChunkX < Size; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < Size; ChunkY++)
+			Pathfinder.AddChunk(Access, ChunkX, ChunkY);
+	const double BuildSeconds = GetSeconds() - Start;
+
+	// The highest cell to stand in of a random column, i.e. mostly the surface.
+	RandomStream Random(Seed);
+	const int32_t NumBlocks = Size * Access.Layout.Width;
+	auto RandomCell = [&](PathCell& OutCell)
+	{
+		const int32_t X = Random.RandRange(0, NumBlocks - 1);
+		const int32_t Y = Random.RandRange(0, NumBlocks - 1);
+		for (int32_t Z = Access.Layout.Height - 2; Z > 0; Z--)
+		{
+			if (Pathfinder.IsWalkable(Access, { X, Y, Z }))
+			{
+				OutCell = { X, Y, Z };
+				return true;
+			}
+		}
+		return false;
+	};
+
+	int32_t Queries = 0;
+	int32_t Found = 0;
+	int64_t Expanded = 0;
+	int64_t PathCells = 0;
+	double QuerySeconds = 0.0;
+	std::vector<PathCell> Path;
+	for (int32_t i = 0; i < NumQueries; i++)
+	{
+		PathCell From, To;
+		if (!RandomCell(From) || !RandomCell(To))
+			continue;
+
+		Start = GetSeconds();
+		const bool bFound = Pathfinder.FindPath(Access, From, To, Path);
+		QuerySeconds += GetSeconds() - Start;
+		Queries++;
+		Found += bFound ? 1 : 0;
+		Expanded += Pathfinder.GetLastNumExpanded();
+		PathCells += bFound ? (int64_t)Path.size() : 0;
+	}
+
+	// Digging into or building on the surface, as players do.
+	int32_t Updates = 0;
+	double UpdateSeconds = 0.0;
+	double MaxUpdateSeconds = 0.0;
+	for (int32_t i = 0; i < NumQueries; i++)
+	{
+		PathCell Cell;
+		if (!RandomCell(Cell))
+			continue;
+
+		const bool bDig = Random.RandRange(0, 1) != 0;
+		const int32_t Z = bDig ? Cell.Z - 1 : Cell.Z;
+		Access.SetBlock(Cell.X, Cell.Y, Z, bDig ? Blocks::Air : Blocks::Stone);
+		Start = GetSeconds();
+		Pathfinder.OnBlockChanged(Access, Cell.X, Cell.Y, Z);
+		const double Seconds = GetSeconds() - Start;
+		UpdateSeconds += Seconds;
+		MaxUpdateSeconds = Seconds > MaxUpdateSeconds ? Seconds : MaxUpdateSeconds;
+		Updates++;
+	}
+
+	printf("paths seed %d: %d chunks built in %.1fms, %d portals %d edges; %d queries %.0f/s, %d found, %.1f cells %.0f expanded per query; %d edits %.3fms avg %.3fms max\n",
+		Seed, Size * Size, BuildSeconds * 1000.0, Pathfinder.GetNumNodes(), Pathfinder.GetNumEdges(),
+		Queries, Queries / (QuerySeconds > 0.0 ? QuerySeconds : 1e-9), Found, Found > 0 ? (double)PathCells / Found : 0.0,
+		Queries > 0 ? (double)Expanded / Queries : 0.0, Updates, Updates > 0 ? UpdateSeconds * 1000.0 / Updates : 0.0, MaxUpdateSeconds * 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 3 && !strcmp(argv[1], "-golden"))
+	{
+		PrintGoldenHashes(argv[2]);
+		return 0;
+	}
+
+	int32_t Seed = 1337;
+	int32_t Size = 16;
+	int32_t OnlyVersion = IndexNone;
+	int32_t NumPoints = 1 << 22;
+	int32_t NumPathQueries = 2000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-seed"))
+			Seed = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-size"))
+			Size = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-version"))
+			OnlyVersion = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-points"))
+			NumPoints = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-paths"))
+			NumPathQueries = atoi(argv[i + 1]);
+	}
+	if (Size <= 0 || NumPoints <= 0 || NumPathQueries < 0 || OnlyVersion > ChunkGenerator::CurrentTerrainVersion)
+	{
+		printf("Usage: VoxelCoreBench [-seed N] [-size Chunks] [-version N] [-points NoisePoints] [-paths Queries]\n");
+		return 1;
+	}
+
+	printf("batched noise uses %s\n", SimplexNoise::GetISAName(SimplexNoise::GetActiveISA()));
+	BenchmarkNoise(NumPoints);
+
+	for (int32_t Version = 0; Version <= ChunkGenerator::CurrentTerrainVersion; Version++)
+	{
+		if (OnlyVersion == IndexNone || Version == OnlyVersion)
+			BenchmarkGeneration(Seed, Version, Size);
+	}
+
+	BenchmarkPathfinding(Seed, Size, NumPathQueries);
+	return 0;
+}
@@ -0,0 +1,968 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Checks for the voxel core that don't need the engine. Returns non-zero if any check fails.
+
+#include "VoxelCore/BlockTickScheduler.h"
+#include "VoxelCore/ChunkGenerator.h"
+#include "VoxelCore/ChunkMesher.h"
+#include "VoxelCore/FluidSimulation.h"
+#include "VoxelCore/FractalNoise.h"
+#include "VoxelCore/HeightTileCache.h"
+#include "VoxelCore/LightEngine.h"
+#include "VoxelCore/RunLength.h"
+#include "VoxelCore/SimplexNoise.h"
+#include "VoxelCore/StructurePlacer.h"
+#include "VoxelCore/VoxelPathfinder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace VoxelCore;
+
+static int32_t NumChecks = 0;
+static int32_t NumFailures = 0;
+
+#define VC_CHECK(Condition) \
+	do \
+	{ \
+		NumChecks++; \
+		if (!(Condition)) \
+		{ \
+			NumFailures++; \
+			printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #Condition); \
+		} \
+	} while (0)
+
+static void TestMath()
+{
+	VC_CHECK(FloorDiv(0, 16) == 0);
+	VC_CHECK(FloorDiv(15, 16) == 0);
+	VC_CHECK(FloorDiv(16, 16) == 1);
+	VC_CHECK(FloorDiv(-1, 16) == -1);
+	VC_CHECK(FloorDiv(-16, 16) == -1);
+	VC_CHECK(FloorDiv(-17, 16) == -2);
+	VC_CHECK(FloorToInt(-0.5f) == -1);
+	VC_CHECK(FloorToInt(2.99f) == 2);
+
+	const ChunkLayout Layout;
+	VC_CHECK(Layout.WidthExt == 18);
+	VC_CHECK(Layout.NumBlocks() == 18 * 18 * 128);
+	VC_CHECK(Layout.Index(1, 2, 3) == 3 + 2 * 128 + 1 * 18 * 128);
+	VC_CHECK(Layout.ColumnIndex(1, 2) == 2 + 18);
+}
+
+static void TestRandomStream()
+{
+	RandomStream A(42);
+	RandomStream B(42);
+	bool Same = true;
+	bool InRange = true;
+	for (int32_t i = 0; i < 1000; i++)
+	{
+		const float Value = A.FRand();
+		Same &= Value == B.FRand();
+		InRange &= Value >= 0.0f && Value < 1.0f;
+
+		const int32_t Ranged = A.RandRange(-3, 3);
+		B.RandRange(-3, 3);
+		InRange &= Ranged >= -3 && Ranged <= 3;
+	}
+	VC_CHECK(Same);
+	VC_CHECK(InRange);
+}
+
+static void TestNoise()
+{
+	SimplexNoise::SetSeed(1337);
+
+	// Terrain-like coordinates, including negatives and exact integers where the fast floor differs from floor.
+	const int32_t NumPoints = 4099;
+	RandomStream Random(1234);
+	std::vector<float> X(NumPoints), Y(NumPoints), Z(NumPoints), Result(NumPoints);
+	for (int32_t i = 0; i < NumPoints; i++)
+	{
+		const bool OnLattice = (i % 16) == 0;
+		X[i] = OnLattice ? (float)Random.RandRange(-300, 300) : Random.FRandRange(-300.0f, 300.0f);
+		Y[i] = OnLattice ? (float)Random.RandRange(-300, 300) : Random.FRandRange(-300.0f, 300.0f);
+		Z[i] = Random.FRandRange(-2.0f, 2.0f);
+	}
+
+	for (NoiseISA ISA : { NoiseISA::Scalar, NoiseISA::SSE2, NoiseISA::AVX2 })
+	{
+		if (!SimplexNoise::IsSupported(ISA))
+		{
+			printf("  %s not supported on this CPU, skipped\n", SimplexNoise::GetISAName(ISA));
+			continue;
+		}
+
+		int32_t Mismatches = 0;
+		SimplexNoise::Noise2D(ISA, X.data(), Y.data(), Result.data(), NumPoints);
+		for (int32_t i = 0; i < NumPoints; i++)
+			Mismatches += Result[i] != SimplexNoise::Noise2D(X[i], Y[i]) ? 1 : 0;
+		SimplexNoise::Noise3D(ISA, X.data(), Y.data(), Z.data(), Result.data(), NumPoints);
+		for (int32_t i = 0; i < NumPoints; i++)
+			Mismatches += Result[i] != SimplexNoise::Noise3D(X[i], Y[i], Z[i]) ? 1 : 0;
+		VC_CHECK(Mismatches == 0);
+	}
+
+	// The grid path batches and reorders work but has to give what Sample gives point by point.
+	const FractalNoise2D<3> Noise = FractalNoise2D<3>::MakeFBm(0.01f, 1.0f);
+	const int32_t Size = 19;
+	std::vector<float> Grid(Size * Size);
+	Noise.SampleGrid(-7.0f, 3.0f, 1.5f, Size, Size, Grid.data());
+	int32_t GridMismatches = 0;
+	for (int32_t x = 0; x < Size; x++)
+		for (int32_t y = 0; y < Size; y++)
+			GridMismatches += Grid[y + x * Size] != Noise.Sample(-7.0f + x * 1.5f, 3.0f + y * 1.5f) ? 1 : 0;
+	VC_CHECK(GridMismatches == 0);
+
+	// Reseeding gives the same table back.
+	std::vector<unsigned char> First(SimplexNoise::GetPermutationTable(), SimplexNoise::GetPermutationTable() + 512);
+	SimplexNoise::SetSeed(7);
+	SimplexNoise::SetSeed(1337);
+	VC_CHECK(std::equal(First.begin(), First.end(), SimplexNoise::GetPermutationTable()));
+}
+
+static void TestBiomes()
+{
+	SimplexNoise::SetSeed(1);
+	BiomeMap Map(1, 2);
+
+	bool WeightsSumToOne = true;
+	for (int32_t i = -1000; i < 1000; i += 37)
+	{
+		const BiomeSample Sample = Map.Sample(i, i * 3);
+		float Total = 0.0f;
+		for (float Weight : Sample.Weights)
+			Total += Weight;
+		WeightsSumToOne &= std::fabs(Total - 1.0f) < 1e-4f;
+	}
+	VC_CHECK(WeightsSumToOne);
+	VC_CHECK(Map.GetNumCachedRegions() <= 2);
+
+	// Evicted regions come back identical.
+	const BiomeSample Before = Map.Sample(-5, 9);
+	Map.Empty();
+	const BiomeSample After = Map.Sample(-5, 9);
+	VC_CHECK(Before.Temperature == After.Temperature && Before.Humidity == After.Humidity && Before.Dominant == After.Dominant);
+}
+
+// The tile cache must not change a single block, for any terrain version.
+static void TestHeightTileCache()
+{
+	const int32_t Seed = 424242;
+	ChunkGenerator::PrepareNoise(Seed);
+	BiomeMap Map(Seed);
+	HeightTileCache Tiles(Map, 4);
+
+	std::vector<BlockId> Direct, Cached;
+	for (int32_t Version = 0; Version <= ChunkGenerator::CurrentTerrainVersion; Version++)
+	{
+		ChunkGenerator Generator(Seed);
+		Generator.TerrainVersion = Version;
+		Generator.Biomes = &Map;
+
+		int32_t Differences = 0;
+		for (int32_t ChunkX = -1; ChunkX <= 1; ChunkX++)
+		{
+			for (int32_t ChunkY = -1; ChunkY <= 1; ChunkY++)
+			{
+				Generator.HeightTiles = nullptr;
+				Generator.Generate(ChunkX, ChunkY, Direct);
+				Generator.HeightTiles = &Tiles;
+				Generator.Generate(ChunkX, ChunkY, Cached);
+				Differences += Direct != Cached ? 1 : 0;
+			}
+		}
+		VC_CHECK(Differences == 0);
+	}
+	VC_CHECK(Tiles.GetNumCachedTiles() <= 4);
+}
+
+// From version 3 neighbouring chunks have to agree on every block of the columns they share.
+static void TestChunkBorders()
+{
+	const int32_t Seed = 1;
+	ChunkGenerator::PrepareNoise(Seed);
+	BiomeMap Map(Seed);
+	ChunkGenerator Generator(Seed);
+	Generator.Biomes = &Map;
+	const ChunkLayout Layout = Generator.GetLayout();
+
+	int32_t Differences = 0;
+	int32_t NumTrunks = 0;
+	std::vector<BlockId> Left, Right;
+	for (int32_t ChunkY = -2; ChunkY < 2; ChunkY++)
+	{
+		Generator.Generate(-1, ChunkY, Left);
+		Generator.Generate(0, ChunkY, Right);
+
+		// Extended x Width and Width + 1 of the left chunk are x 0 and 1 of the right one.
+		for (int32_t Shared = 0; Shared < 2; Shared++)
+			for (int32_t y = 0; y < Layout.WidthExt; y++)
+				for (int32_t z = 0; z < Layout.Height; z++)
+				{
+					const BlockId Id = Left[Layout.Index(Layout.Width + Shared, y, z)];
+					Differences += Id != Right[Layout.Index(Shared, y, z)] ? 1 : 0;
+					NumTrunks += Id == Blocks::Trunk ? 1 : 0;
+				}
+	}
+	VC_CHECK(Differences == 0);
+	printf("  %d trunk blocks on the shared border\n", NumTrunks);
+
+	// A structure stamped partly outside the chunk only writes what is inside.
+	std::vector<BlockId> ChunkData(Layout.NumBlocks(), Blocks::Air);
+	const StructureShape& Shape = StructurePlacer::GetShape(0);
+	StructurePlacer::Stamp(Shape, -2, 5, 40, 0, 0, Layout, BlockIdView(ChunkData.data(), (int32_t)ChunkData.size()));
+	int32_t NumStamped = 0;
+	for (BlockId Id : ChunkData)
+		NumStamped += Id != Blocks::Air ? 1 : 0;
+	VC_CHECK(NumStamped > 0 && NumStamped < (int32_t)Shape.Blocks.size());
+}
+
+static void TestMesher()
+{
+	const ChunkLayout Layout;
+	std::vector<BlockId> ChunkData(Layout.NumBlocks(), Blocks::Air);
+	std::vector<MeshSection> Sections;
+	std::string Error;
+
+	// One stone block in the open: six faces.
+	ChunkData[Layout.Index(5, 5, 10)] = Blocks::Stone;
+	VC_CHECK(ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections));
+	VC_CHECK(Sections[Blocks::Stone].Vertices.size() == 24);
+	VC_CHECK(Sections[Blocks::Stone].Triangles.size() == 36);
+	VC_CHECK(ChunkMesher::ValidateMeshSections(Sections, Error));
+
+	// A dirt block on top hides one face of each; leaves beside it hide nothing.
+	ChunkData[Layout.Index(5, 5, 11)] = Blocks::Dirt;
+	ChunkData[Layout.Index(6, 5, 10)] = Blocks::Leaves;
+	ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections);
+	VC_CHECK(Sections[Blocks::Stone].Vertices.size() == 20);
+	VC_CHECK(Sections[Blocks::Dirt].Vertices.size() == 20);
+	VC_CHECK(Sections[Blocks::Leaves].Vertices.size() == 20);
+	VC_CHECK(ChunkMesher::ValidateMeshSections(Sections, Error));
+
+	// Ids without a section are reported.
+	ChunkData[Layout.Index(8, 8, 8)] = 42;
+	VC_CHECK(!ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections));
+
+	// Generated terrain meshes into valid sections.
+	ChunkGenerator::PrepareNoise(1);
+	ChunkGenerator Generator(1);
+	Generator.Generate(0, 0, ChunkData);
+	VC_CHECK(ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections));
+	VC_CHECK(ChunkMesher::ValidateMeshSections(Sections, Error));
+	VC_CHECK(!Sections[Blocks::Grass].Triangles.empty());
+}
+
+static void TestCollisionMesh()
+{
+	const ChunkLayout Layout;
+	std::vector<BlockId> ChunkData(Layout.NumBlocks(), Blocks::Air);
+	std::vector<Vec3> Vertices;
+	std::vector<int32_t> Triangles;
+
+	// A full layer of mixed blocks is a single box.
+	for (int32_t x = 1; x <= Layout.Width; x++)
+		for (int32_t y = 1; y <= Layout.Width; y++)
+			ChunkData[Layout.Index(x, y, 10)] = (x + y) % 2 ? Blocks::Stone : Blocks::Dirt;
+	VC_CHECK(ChunkMesher::BuildCollisionMesh(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, Vertices, Triangles));
+	VC_CHECK(Vertices.size() == 24);
+	VC_CHECK(Triangles.size() == 36);
+
+	// Scattered blocks cover exactly the area of the render mesh's faces, in fewer quads.
+	RandomStream Random(3);
+	for (BlockId& Id : ChunkData)
+		Id = Blocks::Air;
+	for (int32_t i = 0; i < 3000; i++)
+		ChunkData[Layout.Index(Random.RandRange(1, Layout.Width), Random.RandRange(1, Layout.Width), Random.RandRange(20, 40))] = Random.RandRange(1, 5);
+	std::vector<MeshSection> Sections;
+	ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections);
+	size_t RenderQuads = 0;
+	for (const MeshSection& Section : Sections)
+		RenderQuads += Section.Vertices.size() / 4;
+
+	ChunkMesher::BuildCollisionMesh(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, Vertices, Triangles);
+	double Area = 0.0;
+	for (size_t q = 0; q < Vertices.size(); q += 4)
+	{
+		const Vec3& A = Vertices[q];
+		const Vec3& B = Vertices[q + 1];
+		const Vec3& C = Vertices[q + 2];
+		const double Side1 = std::sqrt((double)(B.X - A.X) * (B.X - A.X) + (double)(B.Y - A.Y) * (B.Y - A.Y) + (double)(B.Z - A.Z) * (B.Z - A.Z));
+		const double Side2 = std::sqrt((double)(C.X - B.X) * (C.X - B.X) + (double)(C.Y - B.Y) * (C.Y - B.Y) + (double)(C.Z - B.Z) * (C.Z - B.Z));
+		Area += Side1 * Side2;
+	}
+	VC_CHECK(std::fabs(Area - RenderQuads * 100.0 * 100.0) < 1.0);
+	VC_CHECK(Vertices.size() / 4 < RenderQuads);
+
+	// Terrain merges far better than scattered blocks.
+	ChunkGenerator::PrepareNoise(2);
+	ChunkGenerator Generator(2);
+	Generator.Generate(0, 0, ChunkData);
+	ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 8, Sections);
+	RenderQuads = 0;
+	for (const MeshSection& Section : Sections)
+		RenderQuads += Section.Vertices.size() / 4;
+	ChunkMesher::BuildCollisionMesh(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, Vertices, Triangles);
+	VC_CHECK(Vertices.size() / 4 < RenderQuads / 2);
+	printf("  generated chunk: %d render quads, %d collision quads\n", (int)RenderQuads, (int)(Vertices.size() / 4));
+}
+
+static void TestLight()
+{
+	const ChunkLayout Layout;
+	const BlockId Torch = 9;
+	LightProperties Properties;
+	Properties.Emission[Torch] = 14;
+	LightEngine Engine(Properties);
+
+	std::vector<BlockId> ChunkData(Layout.NumBlocks(), Blocks::Air);
+	std::vector<LightValue> Light(Layout.NumBlocks());
+	auto Compute = [&](std::vector<LightValue>& Out)
+	{
+		Engine.ComputeChunk(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout, Out.data());
+	};
+
+	// Open sky reaches the ground at full strength; a roof darkens what is under it by distance
+	// to its edge, and a torch falls off by one per block.
+	for (int32_t x = 4; x < 12; x++)
+		for (int32_t y = 4; y < 12; y++)
+			ChunkData[Layout.Index(x, y, 20)] = Blocks::Stone;
+	ChunkData[Layout.Index(2, 2, 5)] = Torch;
+	Compute(Light);
+	VC_CHECK(GetSkyLight(Light[Layout.Index(1, 1, 0)]) == MaxLight);
+	VC_CHECK(GetSkyLight(Light[Layout.Index(4, 8, 19)]) == MaxLight - 1);
+	VC_CHECK(GetSkyLight(Light[Layout.Index(7, 7, 19)]) == MaxLight - 4);
+	VC_CHECK(GetSkyLight(Light[Layout.Index(8, 8, 20)]) == 0);
+	VC_CHECK(GetBlockLight(Light[Layout.Index(2, 2, 5)]) == 14);
+	VC_CHECK(GetBlockLight(Light[Layout.Index(2, 5, 5)]) == 11);
+
+	// Incremental updates give the same light as relighting from scratch, and only visit the
+	// cells around the change.
+	struct ArrayAccess : LightAccess
+	{
+		const ChunkLayout& Layout;
+		std::vector<BlockId>& Blocks;
+		std::vector<LightValue>& Values;
+
+		ArrayAccess(const ChunkLayout& InLayout, std::vector<BlockId>& InBlocks, std::vector<LightValue>& InValues) : Layout(InLayout), Blocks(InBlocks), Values(InValues) {}
+
+		bool IsLoaded(int32_t X, int32_t Y, int32_t Z) const override
+		{
+			return X >= 0 && Y >= 0 && Z >= 0 && X < Layout.WidthExt && Y < Layout.WidthExt && Z < Layout.Height;
+		}
+		BlockId GetBlock(int32_t X, int32_t Y, int32_t Z) const override { return Blocks[Layout.Index(X, Y, Z)]; }
+		LightValue GetLight(int32_t X, int32_t Y, int32_t Z) const override { return Values[Layout.Index(X, Y, Z)]; }
+		void SetLight(int32_t X, int32_t Y, int32_t Z, LightValue Value) override { Values[Layout.Index(X, Y, Z)] = Value; }
+	};
+
+	ChunkGenerator::PrepareNoise(7);
+	ChunkGenerator Generator(7);
+	Generator.Generate(1, 1, ChunkData);
+	Compute(Light);
+	ArrayAccess Access(Layout, ChunkData, Light);
+
+	const BlockId Edits[] = { Blocks::Air, Blocks::Stone, Blocks::Leaves, Torch };
+	RandomStream Random(99);
+	std::vector<LightValue> Expected(Layout.NumBlocks());
+	int32_t Mismatches = 0;
+	int32_t MaxVisited = 0;
+	for (int32_t i = 0; i < 200; i++)
+	{
+		const int32_t X = Random.RandRange(0, Layout.WidthExt - 1);
+		const int32_t Y = Random.RandRange(0, Layout.WidthExt - 1);
+		const int32_t Z = Random.RandRange(40, 90);
+		ChunkData[Layout.Index(X, Y, Z)] = Edits[Random.RandRange(0, 3)];
+		Engine.OnBlockChanged(Access, X, Y, Z);
+		MaxVisited = std::max(MaxVisited, Engine.GetLastNumVisited());
+
+		Compute(Expected);
+		Mismatches += Expected == Light ? 0 : 1;
+	}
+	VC_CHECK(Mismatches == 0);
+	VC_CHECK(MaxVisited < Layout.NumBlocks() / 4);
+
+	// The mesher colours faces by the light in front of them.
+	std::fill(ChunkData.begin(), ChunkData.end(), Blocks::Air);
+	ChunkData[Layout.Index(5, 5, 10)] = Blocks::Stone;
+	ChunkData[Layout.Index(5, 5, 11)] = Blocks::Stone;
+	ChunkData[Layout.Index(5, 6, 10)] = Torch;
+	Compute(Light);
+	std::vector<MeshSection> Sections;
+	ChunkMesher::BuildMeshSections(ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()), Layout.Width, Layout.Height, 10, Sections, Light.data());
+	bool TopIsSkyLit = false;
+	bool BottomIsDark = false;
+	for (const Color& FaceColor : Sections[Blocks::Stone].VertexColors)
+	{
+		TopIsSkyLit |= FaceColor.A == 0 && FaceColor.R == 255;
+		BottomIsDark |= FaceColor.A == 1 && FaceColor.R < 255 && FaceColor.G == 12 * 17;
+	}
+	VC_CHECK(TopIsSkyLit);
+	VC_CHECK(BottomIsDark);
+}
+
+// A square of chunks from (0, 0), with the border copies kept in sync like the game does.
+struct GridPathAccess : PathAccess
+{
+	ChunkLayout Layout;
+	int32_t Size;
+	std::vector<std::vector<BlockId>> Chunks;
+
+	explicit GridPathAccess(int32_t InSize) : Size(InSize), Chunks(InSize * InSize, std::vector<BlockId>(Layout.NumBlocks(), Blocks::Air)) {}
+
+	bool GetChunk(int32_t ChunkX, int32_t ChunkY, ConstBlockIdView& OutBlocks) const override
+	{
+		if (ChunkX < 0 || ChunkY < 0 || ChunkX >= Size || ChunkY >= Size)
+			return false;
+		const std::vector<BlockId>& Data = Chunks[ChunkX + ChunkY * Size];
+		OutBlocks = ConstBlockIdView(Data.data(), (int32_t)Data.size());
+		return true;
+	}
+
+	void SetBlock(int32_t X, int32_t Y, int32_t Z, BlockId Id)
+	{
+		for (int32_t ChunkX = 0; ChunkX < Size; ChunkX++)
+		{
+			for (int32_t ChunkY = 0; ChunkY < Size; ChunkY++)
+			{
+				const int32_t x = X - ChunkX * Layout.Width + 1;
+				const int32_t y = Y - ChunkY * Layout.Width + 1;
+				if (x >= 0 && y >= 0 && x < Layout.WidthExt && y < Layout.WidthExt)
+					Chunks[ChunkX + ChunkY * Size][Layout.Index(x, y, Z)] = Id;
+			}
+		}
+	}
+};
+
+static void TestPathfinding()
+{
+	const PathProperties Properties;
+	GridPathAccess Access(3);
+	const int32_t Floor = 10;
+	for (int32_t X = -1; X <= 48; X++)
+		for (int32_t Y = -1; Y <= 48; Y++)
+			for (int32_t Z = 0; Z <= Floor; Z++)
+				Access.SetBlock(X, Y, Z, Blocks::Stone);
+
+	VoxelPathfinder Pathfinder(Properties, Access.Layout);
+	for (int32_t ChunkX = 0; ChunkX < 3; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < 3; ChunkY++)
+			Pathfinder.AddChunk(Access, ChunkX, ChunkY);
+
+	auto IsValidPath = [&](const VoxelPathfinder& Pathfinder, const PathAccess& Access, const std::vector<PathCell>& Path, const PathCell& Start, const PathCell& Goal)
+	{
+		if (Path.empty() || Path.front() != Start || Path.back() != Goal)
+			return false;
+		for (size_t i = 1; i < Path.size(); i++)
+		{
+			const int32_t Step = std::abs(Path[i].X - Path[i - 1].X) + std::abs(Path[i].Y - Path[i - 1].Y);
+			const int32_t Climb = Path[i].Z - Path[i - 1].Z;
+			if (Step != 1 || Climb > 1 || Climb < -Properties.MaxDrop || !Pathfinder.IsWalkable(Access, Path[i]))
+				return false;
+		}
+		return true;
+	};
+
+	// Across open ground the path through the portals stays close to the straight one.
+	std::vector<PathCell> Path;
+	const PathCell Start = { 1, 1, Floor + 1 };
+	const PathCell Goal = { 46, 45, Floor + 1 };
+	VC_CHECK(Pathfinder.FindPath(Access, Start, Goal, Path));
+	VC_CHECK(IsValidPath(Pathfinder, Access, Path, Start, Goal));
+	VC_CHECK(Path.size() - 1 <= (90 * 5) / 4);
+	VC_CHECK(!Pathfinder.FindPath(Access, Start, { 46, 45, Floor + 3 }, Path));
+
+	// Steps up one block and drops down, but not up two.
+	Access.SetBlock(5, 3, Floor + 1, Blocks::Stone);
+	Access.SetBlock(6, 3, Floor + 1, Blocks::Stone);
+	Access.SetBlock(6, 3, Floor + 2, Blocks::Stone);
+	Pathfinder.OnBlockChanged(Access, 5, 3, Floor + 1);
+	Pathfinder.OnBlockChanged(Access, 6, 3, Floor + 2);
+	VC_CHECK(Pathfinder.FindPath(Access, { 4, 3, Floor + 1 }, { 5, 3, Floor + 2 }, Path) && Path.size() == 2);
+	VC_CHECK(Pathfinder.FindPath(Access, { 5, 3, Floor + 2 }, { 4, 3, Floor + 1 }, Path) && Path.size() == 2);
+	VC_CHECK(Pathfinder.FindPath(Access, { 6, 3, Floor + 3 }, { 7, 3, Floor + 1 }, Path) && Path.size() == 2);
+	VC_CHECK(Pathfinder.FindPath(Access, { 7, 3, Floor + 1 }, { 6, 3, Floor + 3 }, Path) && Path.size() > 3);
+
+	// A wall two blocks high through the middle chunk leaves one gap, which edits open and close.
+	for (int32_t Y = 0; Y < 48; Y++)
+	{
+		for (int32_t Z = Floor + 1; Z <= Floor + 2; Z++)
+		{
+			Access.SetBlock(24, Y, Z, Y == 40 ? Blocks::Air : Blocks::Stone);
+			Pathfinder.OnBlockChanged(Access, 24, Y, Z);
+		}
+	}
+	const PathCell West = { 20, 5, Floor + 1 };
+	const PathCell East = { 28, 5, Floor + 1 };
+	VC_CHECK(Pathfinder.FindPath(Access, West, East, Path));
+	VC_CHECK(IsValidPath(Pathfinder, Access, Path, West, East));
+	VC_CHECK(std::find(Path.begin(), Path.end(), PathCell{ 24, 40, Floor + 1 }) != Path.end());
+
+	Access.SetBlock(24, 40, Floor + 1, Blocks::Stone);
+	Access.SetBlock(24, 40, Floor + 2, Blocks::Stone);
+	Pathfinder.OnBlockChanged(Access, 24, 40, Floor + 2);
+	VC_CHECK(!Pathfinder.FindPath(Access, West, East, Path));
+
+	// Incremental updates leave the same graph as building it again, on generated terrain with
+	// random edits that hit the borders too.
+	GridPathAccess Terrain(3);
+	ChunkGenerator::PrepareNoise(11);
+	ChunkGenerator Generator(11);
+	for (int32_t ChunkX = 0; ChunkX < 3; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < 3; ChunkY++)
+			Generator.Generate(ChunkX, ChunkY, Terrain.Chunks[ChunkX + ChunkY * 3]);
+
+	VoxelPathfinder Incremental(Properties, Terrain.Layout);
+	for (int32_t ChunkX = 0; ChunkX < 3; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < 3; ChunkY++)
+			Incremental.AddChunk(Terrain, ChunkX, ChunkY);
+	VC_CHECK(Incremental.GetNumNodes() > 0);
+
+	auto SurfaceCell = [&](int32_t X, int32_t Y)
+	{
+		for (int32_t Z = Terrain.Layout.Height - 2; Z > 0; Z--)
+		{
+			if (Incremental.IsWalkable(Terrain, { X, Y, Z }))
+				return PathCell{ X, Y, Z };
+		}
+		return PathCell{ X, Y, -1 };
+	};
+
+	RandomStream Random(21);
+	for (int32_t i = 0; i < 300; i++)
+	{
+		const int32_t X = Random.RandRange(0, 47);
+		const int32_t Y = Random.RandRange(0, 47);
+		const PathCell Surface = SurfaceCell(X, Y);
+		if (Surface.Z < 0)
+			continue;
+		const int32_t Z = Surface.Z + Random.RandRange(-1, 1);
+		Terrain.SetBlock(X, Y, Z, Random.RandRange(0, 1) ? Blocks::Air : Blocks::Stone);
+		Incremental.OnBlockChanged(Terrain, X, Y, Z);
+	}
+	Incremental.RemoveChunk(1, 1);
+	Incremental.AddChunk(Terrain, 1, 1);
+
+	VoxelPathfinder Rebuilt(Properties, Terrain.Layout);
+	for (int32_t ChunkX = 0; ChunkX < 3; ChunkX++)
+		for (int32_t ChunkY = 0; ChunkY < 3; ChunkY++)
+			Rebuilt.AddChunk(Terrain, ChunkX, ChunkY);
+	VC_CHECK(Incremental.GetNumNodes() == Rebuilt.GetNumNodes());
+	VC_CHECK(Incremental.GetNumEdges() == Rebuilt.GetNumEdges());
+
+	int32_t Found = 0;
+	int32_t Mismatches = 0;
+	int32_t Invalid = 0;
+	std::vector<PathCell> Other;
+	for (int32_t i = 0; i < 50; i++)
+	{
+		const PathCell From = SurfaceCell(Random.RandRange(0, 47), Random.RandRange(0, 47));
+		const PathCell To = SurfaceCell(Random.RandRange(0, 47), Random.RandRange(0, 47));
+		const bool bFound = Incremental.FindPath(Terrain, From, To, Path);
+		const bool bFoundRebuilt = Rebuilt.FindPath(Terrain, From, To, Other);
+		Found += bFound ? 1 : 0;
+		Mismatches += bFound != bFoundRebuilt || Path.size() != Other.size() ? 1 : 0;
+		Invalid += bFound && !IsValidPath(Incremental, Terrain, Path, From, To) ? 1 : 0;
+	}
+	VC_CHECK(Found > 25);
+	VC_CHECK(Mismatches == 0);
+	VC_CHECK(Invalid == 0);
+}
+
+static void TestRunLength()
+{
+	// A run of 300 zeros, then -1: zigzag(0) = 0, 300 = 0xAC 0x02, zigzag(-1) = 1, 1.
+	std::vector<int32_t> Values(300, 0);
+	Values.push_back(-1);
+
+	std::vector<uint8_t> Stream;
+	RunLength::Encode((int32_t)Values.size(), [&](int32_t i) { return Values[i]; }, [&](uint8_t Byte) { Stream.push_back(Byte); });
+	const std::vector<uint8_t> Expected = { 0x00, 0xAC, 0x02, 0x01, 0x01 };
+	VC_CHECK(Stream == Expected);
+
+	// A generated chunk round trips.
+	ChunkGenerator::PrepareNoise(5);
+	ChunkGenerator Generator(5);
+	std::vector<BlockId> ChunkData, Decoded;
+	Generator.Generate(3, -2, ChunkData);
+	Stream.clear();
+	RunLength::Encode((int32_t)ChunkData.size(), [&](int32_t i) { return ChunkData[i]; }, [&](uint8_t Byte) { Stream.push_back(Byte); });
+	Decoded.assign(ChunkData.size(), -1);
+	const bool Decodes = RunLength::Decode(Stream.data(), (int32_t)Stream.size(), (int32_t)Decoded.size(), [&](int32_t Offset, int32_t Count, int32_t Value)
+	{
+		std::fill(Decoded.begin() + Offset, Decoded.begin() + Offset + Count, Value);
+	});
+	VC_CHECK(Decodes);
+	VC_CHECK(Decoded == ChunkData);
+
+	// Truncated streams and wrong counts are rejected.
+	auto Ignore = [](int32_t, int32_t, int32_t) {};
+	VC_CHECK(!RunLength::Decode(Stream.data(), (int32_t)Stream.size() - 1, (int32_t)ChunkData.size(), Ignore));
+	VC_CHECK(!RunLength::Decode(Stream.data(), (int32_t)Stream.size(), (int32_t)ChunkData.size() - 1, Ignore));
+	VC_CHECK(!RunLength::Decode(Stream.data(), (int32_t)Stream.size(), (int32_t)ChunkData.size() + 1, Ignore));
+}
+
+// Blocks in a map, with a clock that runs out after a set number of checks.
+struct MapTickAccess : BlockTickAccess
+{
+	ChunkLayout Layout = ChunkLayout(16, 32);
+	std::unordered_map<BlockPos, BlockId, BlockPosHash> World;
+
+	// Checks IsOutOfTime passes before it fails, or IndexNone for no limit.
+	mutable int32_t ChecksLeft = IndexNone;
+
+	BlockId GetBlock(const BlockPos& Block) const override
+	{
+		auto Found = World.find(Block);
+		return Found != World.end() ? Found->second : Blocks::Air;
+	}
+
+	void SetBlock(const BlockPos& Block, BlockId Id) override { World[Block] = Id; }
+
+	bool IsOutOfTime() const override
+	{
+		if (ChecksLeft == IndexNone)
+			return false;
+		if (ChecksLeft == 0)
+			return true;
+		ChecksLeft--;
+		return false;
+	}
+
+	void AddChunk(BlockTickScheduler& Scheduler, int32_t ChunkX, int32_t ChunkY) const
+	{
+		std::vector<BlockId> ChunkData(Layout.NumBlocks());
+		for (int32_t x = 0; x < Layout.WidthExt; x++)
+			for (int32_t y = 0; y < Layout.WidthExt; y++)
+				for (int32_t z = 0; z < Layout.Height; z++)
+					ChunkData[Layout.Index(x, y, z)] = GetBlock({ ChunkX * Layout.Width + x - 1, ChunkY * Layout.Width + y - 1, z });
+		Scheduler.AddChunk(ChunkX, ChunkY, ConstBlockIdView(ChunkData.data(), (int32_t)ChunkData.size()));
+	}
+};
+
+static void TestBlockTicks()
+{
+	const float GameTick = 1.0f / 20.0f;
+	const BlockId Fluid = 9;
+
+	// Random tickable blocks are counted per section, without the border copies, and a stale
+	// old id can't wrap a count below zero.
+	{
+		MapTickAccess Access;
+		BlockTickScheduler Scheduler;
+		Scheduler.Initialize(Access, 1, Access.Layout);
+		BlockTickBehavior Grass;
+		Grass.OnRandomTick = [](BlockTickScheduler&, const BlockPos&) {};
+		Scheduler.RegisterBehavior(Blocks::Grass, Grass);
+
+		for (int32_t X = 0; X < 3; X++)
+			Access.World[{ X, 2, 5 }] = Blocks::Grass;
+		Access.World[{ 4, 4, 20 }] = Blocks::Grass;
+		Access.World[{ -1, 4, 5 }] = Blocks::Grass;
+		Access.World[{ 16, 4, 20 }] = Blocks::Grass;
+		Access.AddChunk(Scheduler, 0, 0);
+		VC_CHECK(Scheduler.GetNumSections() == 2);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 0) == 3);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 1) == 1);
+
+		Scheduler.SetBlock({ 4, 4, 20 }, Blocks::Dirt);
+		Scheduler.SetBlock({ 4, 4, 2 }, Blocks::Grass);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 0) == 4);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 1) == 0);
+		VC_CHECK(Scheduler.GetNumActiveSections() == 1);
+
+		Scheduler.NotifyBlockChanged({ 4, 4, 20 }, Blocks::Grass, Blocks::Air);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 1) == 0);
+		Scheduler.NotifyBlockChanged({ 4, 4, 200 }, Blocks::Grass, Blocks::Air);
+		Scheduler.NotifyBlockChanged({ 4, 4, -1 }, Blocks::Grass, Blocks::Air);
+		Scheduler.NotifyBlockChanged({ 40, 4, 5 }, Blocks::Air, Blocks::Grass);
+		VC_CHECK(Scheduler.GetSectionCount(0, 0, 0) == 4);
+		VC_CHECK(Scheduler.GetSectionCount(2, 0, 0) == 0);
+
+		Scheduler.RemoveChunk(0, 0);
+		VC_CHECK(Scheduler.GetNumSections() == 0);
+		VC_CHECK(!Scheduler.IsBlockLoaded({ 4, 4, 2 }));
+	}
+
+	// Scheduled ticks run in order of game tick, once per block, and only if the block is still
+	// of the type that asked for them.
+	{
+		MapTickAccess Access;
+		BlockTickScheduler Scheduler;
+		Scheduler.Initialize(Access, 1, Access.Layout);
+		std::vector<BlockPos> Ticked;
+		BlockTickBehavior Behavior;
+		Behavior.OnScheduledTick = [&](BlockTickScheduler&, const BlockPos& Block) { Ticked.push_back(Block); };
+		Behavior.NeighborChangeDelay = 3;
+		Scheduler.RegisterBehavior(Fluid, Behavior);
+		Access.AddChunk(Scheduler, 0, 0);
+
+		const BlockPos A = { 1, 1, 1 };
+		const BlockPos B = { 5, 5, 5 };
+		const BlockPos C = { 8, 8, 8 };
+		Scheduler.SetBlock(A, Fluid);
+		Access.World[B] = Fluid;
+		Scheduler.ScheduleTick(B, 1);
+		Scheduler.ScheduleTick(B, 1);
+		Access.World[C] = Fluid;
+		Scheduler.ScheduleTick(C, 2);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 3);
+		Access.World[C] = Blocks::Stone;
+
+		Scheduler.Update(GameTick);
+		VC_CHECK(Ticked.size() == 1 && Ticked[0] == B);
+		Scheduler.Update(GameTick);
+		Scheduler.Update(GameTick);
+		VC_CHECK(Scheduler.GetCurrentTick() == 3);
+		VC_CHECK(Ticked.size() == 2 && Ticked[1] == A);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 0);
+		VC_CHECK(Scheduler.GetNumScheduledTicksRun() == 2);
+
+		// A neighbour's change wakes the block; an unloaded chunk drops its ticks.
+		Scheduler.SetBlock(A + BlockPos{ 0, 0, 1 }, Blocks::Stone);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 1);
+		Scheduler.RemoveChunk(0, 0);
+		Scheduler.Update(1.0f);
+		Scheduler.Update(1.0f);
+		VC_CHECK(Scheduler.GetCurrentTick() == 3 + 2 * Scheduler.MaxTicksPerUpdate);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 0);
+		VC_CHECK(Ticked.size() == 2);
+	}
+
+	// A tick queued for an id the block no longer has is replaced rather than blocking the new
+	// one, which would leave the block frozen once the old tick is dropped.
+	{
+		MapTickAccess Access;
+		BlockTickScheduler Scheduler;
+		Scheduler.Initialize(Access, 1, Access.Layout);
+		const BlockId Source = Fluid - 1;
+		std::vector<BlockId> Ticked;
+		BlockTickBehavior Behavior;
+		Behavior.OnScheduledTick = [&](BlockTickScheduler& Ticks, const BlockPos& Block) { Ticked.push_back(Ticks.GetBlock(Block)); };
+		Behavior.NeighborChangeDelay = 1;
+		Scheduler.RegisterBehavior(Fluid, Behavior);
+		Scheduler.RegisterBehavior(Source, Behavior);
+		Access.AddChunk(Scheduler, 0, 0);
+
+		const BlockPos A = { 3, 3, 3 };
+		Access.World[A] = Fluid;
+		Scheduler.ScheduleTick(A, 4);
+		Access.World[A] = Source;
+		Scheduler.ScheduleTick(A, IndexNone);
+		Scheduler.ScheduleTick(A, IndexNone);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 1);
+
+		for (int32_t i = 0; i < 5; i++)
+			Scheduler.Update(GameTick);
+		VC_CHECK(Ticked.size() == 1 && Ticked[0] == Source);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 0);
+	}
+
+	// Blocks that want a tick on load get one, including the neighbours' border copies.
+	{
+		MapTickAccess Access;
+		BlockTickScheduler Scheduler;
+		Scheduler.Initialize(Access, 1, Access.Layout);
+		BlockTickBehavior Behavior;
+		Behavior.OnScheduledTick = [](BlockTickScheduler&, const BlockPos&) {};
+		Behavior.NeighborChangeDelay = 1;
+		Behavior.bScheduleOnLoad = true;
+		Scheduler.RegisterBehavior(Fluid, Behavior);
+		Access.World[{ 15, 3, 3 }] = Fluid;
+		Access.AddChunk(Scheduler, 0, 0);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 1);
+		Scheduler.Update(GameTick);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 0);
+		Access.AddChunk(Scheduler, 1, 0);
+		VC_CHECK(Scheduler.GetNumScheduledTicks() == 1);
+	}
+
+	// Once out of time an update stops; the next one first finishes the due scheduled ticks and
+	// the chunks the random tick pass had left, without moving the clock on.
+	{
+		MapTickAccess Access;
+		BlockTickScheduler Scheduler;
+		Scheduler.Initialize(Access, 1, Access.Layout);
+		std::unordered_map<int32_t, int32_t> RandomTicksPerChunk;
+		int32_t NumScheduled = 0;
+		BlockTickBehavior Grass;
+		Grass.OnRandomTick = [&](BlockTickScheduler&, const BlockPos& Block) { RandomTicksPerChunk[FloorDiv(Block.X, 16)]++; };
+		Scheduler.RegisterBehavior(Blocks::Grass, Grass);
+		BlockTickBehavior Behavior;
+		Behavior.OnScheduledTick = [&](BlockTickScheduler&, const BlockPos&) { NumScheduled++; };
+		Scheduler.RegisterBehavior(Fluid, Behavior);
+
+		// Grass fills the lowest section of four chunks, so every random pick hits.
+		for (int32_t X = 0; X < 4 * 16; X++)
+			for (int32_t Y = 0; Y < 16; Y++)
+				for (int32_t Z = 0; Z < BlockTickScheduler::SectionHeight; Z++)
+					Access.World[{ X, Y, Z }] = Blocks::Grass;
+		for (int32_t Z = 16; Z < 26; Z++)
+			Access.World[{ 1, 1, Z }] = Fluid;
+		for (int32_t ChunkX = 0; ChunkX < 4; ChunkX++)
+			Access.AddChunk(Scheduler, ChunkX, 0);
+		for (int32_t Z = 16; Z < 26; Z++)
+			Scheduler.ScheduleTick({ 1, 1, Z }, 1);
+
+		Access.ChecksLeft = 12;
+		VC_CHECK(!Scheduler.Update(GameTick));
+		VC_CHECK(NumScheduled == 10);
+		VC_CHECK(RandomTicksPerChunk.size() == 2);
+		VC_CHECK(Scheduler.GetNumOverBudgetUpdates() == 1);
+
+		Access.ChecksLeft = IndexNone;
+		VC_CHECK(Scheduler.Update(0.0f));
+		VC_CHECK(Scheduler.GetCurrentTick() == 1);
+		VC_CHECK(RandomTicksPerChunk.size() == 4);
+		bool EachChunkOnce = true;
+		for (const auto& Elem : RandomTicksPerChunk)
+			EachChunkOnce &= Elem.second == Scheduler.RandomTicksPerSection;
+		VC_CHECK(EachChunkOnce);
+		VC_CHECK(Scheduler.GetNumRandomTicksRun() == 4 * Scheduler.RandomTicksPerSection);
+
+		// Nothing is left over, so a zero length update does nothing.
+		VC_CHECK(Scheduler.Update(0.0f));
+		VC_CHECK(Scheduler.GetNumRandomTicksRun() == 4 * Scheduler.RandomTicksPerSection);
+	}
+}
+
+static void TestFluids()
+{
+	const float GameTick = 1.0f / 20.0f;
+	const BlockId WaterSource = 8;
+	const BlockId FlowingWater = 9;
+	const BlockId LavaSource = 10;
+	const BlockId FlowingLava = 11;
+
+	// Two by two chunks with a stone floor at z = 10, around the corner where they meet.
+	MapTickAccess Access;
+	const int32_t Floor = 10;
+	for (int32_t X = -16; X < 16; X++)
+		for (int32_t Y = -16; Y < 16; Y++)
+			for (int32_t Z = 0; Z <= Floor; Z++)
+				Access.World[{ X, Y, Z }] = Blocks::Stone;
+
+	BlockTickScheduler Scheduler;
+	Scheduler.Initialize(Access, 1, Access.Layout);
+	FluidSimulation Fluids;
+	Fluids.Initialize(Access.Layout);
+	FluidType Water;
+	Water.SourceId = WaterSource;
+	Water.FlowingId = FlowingWater;
+	Water.MaxLevel = 7;
+	Water.TickDelay = 5;
+	VC_CHECK(Fluids.AddFluid(Water));
+	FluidType Lava;
+	Lava.SourceId = LavaSource;
+	Lava.FlowingId = FlowingLava;
+	Lava.MaxLevel = 3;
+	Lava.TickDelay = 30;
+	Lava.HardenedSourceId = Blocks::Stone;
+	Lava.HardenedFlowingId = Blocks::Stone;
+	VC_CHECK(Fluids.AddFluid(Lava));
+	VC_CHECK(!Fluids.AddFluid(FluidType()));
+	Fluids.RegisterBehaviors(Scheduler);
+	for (int32_t ChunkX = -1; ChunkX <= 0; ChunkX++)
+		for (int32_t ChunkY = -1; ChunkY <= 0; ChunkY++)
+			Access.AddChunk(Scheduler, ChunkX, ChunkY);
+
+	// Game ticks until nothing is scheduled any more, or -1 if it doesn't settle.
+	auto RunUntilSettled = [&]()
+	{
+		for (int32_t Tick = 0; Tick < 2000; Tick++)
+		{
+			if (Scheduler.GetNumScheduledTicks() == 0)
+				return Tick;
+			Scheduler.Update(GameTick);
+		}
+		return -1;
+	};
+	auto CountBlocks = [&](BlockId Id)
+	{
+		int32_t Count = 0;
+		for (const auto& Elem : Access.World)
+			Count += Elem.second == Id ? 1 : 0;
+		return Count;
+	};
+
+	// A source dropped from above falls, then spreads over the floor across the chunk borders
+	// losing a level per block, and settles.
+	const BlockPos Source = { 0, 0, Floor + 4 };
+	Scheduler.SetBlock(Source, WaterSource);
+	VC_CHECK(RunUntilSettled() > 0);
+	const BlockPos Landed = { 0, 0, Floor + 1 };
+	VC_CHECK(Access.GetBlock({ 0, 0, Floor + 2 }) == FlowingWater);
+	VC_CHECK(Fluids.GetLevel(Scheduler, Landed) == Water.MaxLevel);
+	VC_CHECK(Fluids.GetLevel(Scheduler, Landed + BlockPos{ -1, 0, 0 }) == Water.MaxLevel - 1);
+	VC_CHECK(Fluids.GetLevel(Scheduler, Landed + BlockPos{ -3, -3, 0 }) == Water.MaxLevel - 6);
+	VC_CHECK(Fluids.GetLevel(Scheduler, Landed + BlockPos{ 3, 3, 0 }) == Water.MaxLevel - 6);
+	VC_CHECK(Access.GetBlock(Landed + BlockPos{ -4, -3, 0 }) == Blocks::Air);
+	VC_CHECK(Access.GetBlock(Landed + BlockPos{ 0, 0, 1 }) == FlowingWater);
+	VC_CHECK(Access.GetBlock(Landed + BlockPos{ 1, 0, 1 }) == Blocks::Air);
+
+	// A diamond of 1 + 2 * 6 * 7 cells on the floor, plus the two falling ones.
+	const int32_t Spread = 1 + 2 * (Water.MaxLevel - 1) * Water.MaxLevel;
+	VC_CHECK(CountBlocks(FlowingWater) == Spread + 2);
+	VC_CHECK(Fluids.GetNumFlowingCells() == Spread + 2);
+
+	// Settled, it costs nothing.
+	const int64_t TicksRun = Scheduler.GetNumScheduledTicksRun();
+	for (int32_t i = 0; i < 100; i++)
+		Scheduler.Update(GameTick);
+	VC_CHECK(Scheduler.GetNumScheduledTicksRun() == TicksRun);
+
+	// Without its source the water drains away, levels included.
+	Scheduler.SetBlock(Source, Blocks::Air);
+	VC_CHECK(RunUntilSettled() > 0);
+	VC_CHECK(CountBlocks(FlowingWater) == 0);
+	VC_CHECK(Fluids.GetNumFlowingCells() == 0);
+
+	// Lava that reaches water turns to stone, and the water flows on around it.
+	Scheduler.SetBlock({ -8, -8, Floor + 1 }, WaterSource);
+	Scheduler.SetBlock({ -8, -4, Floor + 1 }, LavaSource);
+	VC_CHECK(RunUntilSettled() > 0);
+	VC_CHECK(CountBlocks(LavaSource) == 0);
+	VC_CHECK(Access.GetBlock({ -8, -4, Floor + 1 }) == Blocks::Stone);
+	VC_CHECK(CountBlocks(WaterSource) == 1);
+	VC_CHECK(CountBlocks(FlowingLava) == 0);
+}
+
+int main()
+{
+	struct TestCase
+	{
+		const char* Name;
+		void (*Run)();
+	};
+	const TestCase Tests[] =
+	{
+		{ "Math", &TestMath },
+		{ "RandomStream", &TestRandomStream },
+		{ "Noise", &TestNoise },
+		{ "Biomes", &TestBiomes },
+		{ "HeightTileCache", &TestHeightTileCache },
+		{ "ChunkBorders", &TestChunkBorders },
+		{ "Mesher", &TestMesher },
+		{ "CollisionMesh", &TestCollisionMesh },
+		{ "Light", &TestLight },
+		{ "Pathfinding", &TestPathfinding },
+		{ "RunLength", &TestRunLength },
+		{ "BlockTicks", &TestBlockTicks },
+		{ "Fluids", &TestFluids }
+	};
+
+	for (const TestCase& Test : Tests)
+	{
+		const int32_t FailuresBefore = NumFailures;
+		printf("%s\n", Test.Name);
+		Test.Run();
+		printf("  %s\n", NumFailures == FailuresBefore ? "ok" : "FAILED");
+	}
+
+	printf("%d checks, %d failed\n", NumChecks, NumFailures);
+	return NumFailures == 0 ? 0 : 1;
+}